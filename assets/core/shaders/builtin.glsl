@@ -17,6 +17,7 @@ layout(std140, binding=2) uniform ModelUBO
    mat4 mat_invmodel;
    mat4 mat_mvp;
    mat4 mat_normal_model_u_color;
+   uvec4 u_material_info;
 
 };
 
@@ -74,6 +75,18 @@ void main()
 
 layout(binding=0) uniform sampler2D tex_color;
 
+// 16 vec4s per material, slot 0 is the default (all zeros)
+layout(std430, binding=3) restrict readonly buffer MaterialSSBO
+{
+   vec4 material_params[];
+
+};
+
+vec4 MaterialParam(uint index)
+{
+   return material_params[u_material_info.x * 16u + index];
+}
+
 in vec2 v2f_texcoord;
 
 #ifdef USE_LIGHTING
@@ -292,7 +305,9 @@ float Distribution(float nDh, float r)
 float SampleShadow(float depth, vec3 shadowmap_coords, int shadow_id)
 {
    vec4 sm = vec4(shadowmap_coords, float(shadow_id));
-   float shadowmap = texture(tex_pointlight_shadows, sm, depth);
+   // shadow maps are stored flipped with reverse-z, the sampler compares with GEQUAL to match
+   float ref_depth = (u_proj_info.y > 0.5) ? 1.0 - depth : depth;
+   float shadowmap = texture(tex_pointlight_shadows, sm, ref_depth);
 
    return shadowmap;
 }
@@ -370,6 +385,7 @@ void main()
 
    vec2 tile_size = vec2(u_screen_size) / vec2(u_cluster_dimensions.xy);
    uint z_id = uint((log(abs(surf_data.position_vs.z) / u_near_far.x) * u_cluster_dimensions.z) / log(u_near_far.y / u_near_far.x));
+   z_id = min(z_id, u_cluster_dimensions.z - 1u); // with an infinite far plane there's geometry past the last slice
    uvec3 tile = uvec3(gl_FragCoord.xy / tile_size, z_id);
    uint tile_id = (tile.y * u_cluster_dimensions.x) + (tile.z * u_cluster_dimensions.x * u_cluster_dimensions.y) + tile.x;
 
@@ -405,7 +421,7 @@ void main()
    frg_color.a = color.a;
 
 #ifdef SHADOW_CASTER
-   gl_FragDepth = v2f_depth;
+   gl_FragDepth = (u_proj_info.y > 0.5) ? 1.0 - v2f_depth : v2f_depth;
 #endif
 
 }
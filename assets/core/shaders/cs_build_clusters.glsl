@@ -31,8 +31,8 @@ layout(std430, binding=1) restrict buffer ClusterSSBO
 
 vec3 ToViewSpace(vec2 point_ss)
 {
-   // conversion to normalized device coordinates
-   vec4 ndc = vec4(point_ss / vec2(u_screen_size) * 2.0 - 1.0, -1.0, 1.0);
+   // conversion to normalized device coordinates, u_proj_info.x is the depth of the near plane
+   vec4 ndc = vec4(point_ss / vec2(u_screen_size) * 2.0 - 1.0, u_proj_info.x, 1.0);
    vec4 point_vs = mat_invproj * ndc;
    point_vs /= point_vs.w;
    return point_vs.xyz;
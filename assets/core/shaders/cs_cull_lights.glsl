@@ -68,6 +68,14 @@ layout(std430, binding=2) restrict buffer LightSSBO
 
 };
 
+// lights whose bounds touch the camera frustum, gathered on the cpu
+layout(std430, binding=8) restrict readonly buffer VisibleLightSSBO
+{
+   uvec4 u_visible_info; // visible light count
+   uint visible_lights[];
+
+};
+
 vec3 DecodeColor(uint rgbe_color)
 {
    if (rgbe_color == 0) return vec3(0.0);
@@ -119,7 +127,7 @@ bool SphereTest(vec3 s_origin, float s_radius, vec3 center, vec3 extents)
    return (dot(diff, diff) <= s_radius * s_radius);
 }
 
-bool LightTest(int light_idx, Cluster cluster, out int next_light_idx)
+bool LightTest(int light_idx, Cluster cluster)
 {
    PackedLight packed_light = lights[light_idx];
    LightData light = DecodeLightData(packed_light);
@@ -130,10 +138,7 @@ bool LightTest(int light_idx, Cluster cluster, out int next_light_idx)
    vec3 center = cluster.center.xyz;
    vec3 extents = cluster.extents.xyz;
 
-   bool test = SphereTest(s_origin, s_radius, center, extents);
-   next_light_idx = light_idx + light.next_light;
-
-   return test;
+   return SphereTest(s_origin, s_radius, center, extents);
 }
 
 void main()
@@ -142,19 +147,15 @@ void main()
    Cluster cluster = clusters[tile_id];
    cluster.light_count.w = 0;
 
-   int light_idx = u_light_list.x;
-
-   while (light_idx > -1)
-   {  
-      int next_light_idx = 0;
-      if (LightTest(light_idx, cluster, next_light_idx))
+   for (uint visible_i = 0u; visible_i < u_visible_info.x; visible_i++)
+   {
+      int light_idx = int(visible_lights[visible_i]);
+      if (LightTest(light_idx, cluster))
          cluster.indices[cluster.light_count.w++] = uint(light_idx);
-      
-      if (cluster.light_count.w >= LIGHTS_PER_CLUSTER || next_light_idx == light_idx)
+
+      if (cluster.light_count.w >= LIGHTS_PER_CLUSTER)
          break;
-      
-      light_idx = next_light_idx;
-      
+
    }
 
    clusters[tile_id] = cluster;
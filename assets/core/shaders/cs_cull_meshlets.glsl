@@ -0,0 +1,187 @@
+#define MESHLET_CULL_CONE 1u
+#define MESHLET_CULL_OCCLUSION 2u
+#define MESHLET_REVERSE_Z 4u
+
+layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
+
+struct Meshlet
+{
+   vec4 bounding_sphere;
+   vec4 cone_apex;
+   vec4 cone_axis_cutoff;
+   uint first_index;
+   uint index_count;
+   uvec2 mem_unused_;
+
+};
+
+layout(std140, binding=2) uniform ModelUBO
+{
+   mat4 mat_model;
+   mat4 mat_invmodel;
+   mat4 mat_mvp;
+   mat4 mat_normal_model_u_color;
+   uvec4 u_material_info;
+
+};
+
+layout(std140, binding=4) uniform MeshletCullUBO
+{
+   mat4 mat_occlusion_mvp;
+   vec4 u_camera_origin;
+   uvec4 u_cull_info; // meshlet count, flags, pyramid size
+   uvec4 u_pyramid_info; // mip count
+
+};
+
+layout(std430, binding=4) restrict readonly buffer MeshletSSBO
+{
+   Meshlet meshlets[];
+
+};
+
+layout(std430, binding=5) restrict readonly buffer SourceIndexSSBO
+{
+   uint source_indices[];
+
+};
+
+layout(std430, binding=6) restrict writeonly buffer DrawIndexSSBO
+{
+   uint draw_indices[];
+
+};
+
+layout(std430, binding=7) restrict buffer DrawCommandSSBO
+{
+   uint index_count;
+   uint instance_count;
+   uint first_index;
+   int base_vertex;
+   uint base_instance;
+
+};
+
+layout(binding=8) uniform sampler2D tex_depth_pyramid;
+
+shared bool is_visible;
+shared uint write_offset;
+
+bool IsInsideFrustum(vec4 sphere)
+{
+   // side planes only, straight from the object space mvp rows. near and far are left to the rasterizer
+   mat4 m = transpose(mat_mvp);
+   vec4 planes[4] = vec4[4](m[3] + m[0], m[3] - m[0], m[3] + m[1], m[3] - m[1]);
+
+   for (int plane_i = 0; plane_i < 4; plane_i++)
+   {
+      vec4 plane = planes[plane_i];
+      if (dot(plane.xyz, sphere.xyz) + plane.w < -sphere.w * length(plane.xyz))
+         return false;
+
+   }
+
+   return true;
+}
+
+bool IsBackfacing(Meshlet meshlet)
+{
+   if (meshlet.cone_axis_cutoff.w >= 1.0)
+      return false;
+
+   vec3 to_apex = meshlet.cone_apex.xyz - u_camera_origin.xyz;
+   float apex_distance = length(to_apex);
+   if (apex_distance <= 0.0)
+      return false;
+
+   return dot(to_apex / apex_distance, meshlet.cone_axis_cutoff.xyz) >= meshlet.cone_axis_cutoff.w;
+}
+
+bool IsOccluded(vec4 sphere)
+{
+   bool is_reverse_z = (u_cull_info.y & MESHLET_REVERSE_Z) != 0u;
+
+   vec2 rect_min = vec2(1.0);
+   vec2 rect_max = vec2(0.0);
+   float nearest_depth = is_reverse_z ? 0.0 : 1.0;
+
+   for (int corner_i = 0; corner_i < 8; corner_i++)
+   {
+      vec3 corner = sphere.xyz + sphere.w * vec3(
+         ((corner_i & 1) != 0) ? 1.0 : -1.0,
+         ((corner_i & 2) != 0) ? 1.0 : -1.0,
+         ((corner_i & 4) != 0) ? 1.0 : -1.0
+      );
+
+      vec4 clip = mat_occlusion_mvp * vec4(corner, 1.0);
+
+      // anything reaching behind the camera could cover the whole screen
+      if (clip.w <= 0.0)
+         return false;
+
+      vec3 ndc = clip.xyz / clip.w;
+      float depth = is_reverse_z ? ndc.z : ndc.z * 0.5 + 0.5;
+
+      rect_min = min(rect_min, ndc.xy * 0.5 + 0.5);
+      rect_max = max(rect_max, ndc.xy * 0.5 + 0.5);
+      nearest_depth = is_reverse_z ? max(nearest_depth, depth) : min(nearest_depth, depth);
+
+   }
+
+   rect_min = clamp(rect_min, 0.0, 1.0);
+   rect_max = clamp(rect_max, 0.0, 1.0);
+   if (any(greaterThanEqual(rect_min, rect_max)))
+      return false;
+
+   // pick the mip where the rect spans at most two texels each way, so a 2x2 fetch covers all of it
+   vec2 pyramid_size = vec2(u_cull_info.zw);
+   vec2 rect_size = (rect_max - rect_min) * pyramid_size;
+   int mip = int(ceil(log2(max(max(rect_size.x, rect_size.y), 1.0))));
+   mip = clamp(mip, 0, int(u_pyramid_info.x) - 1);
+
+   ivec2 mip_size = textureSize(tex_depth_pyramid, mip);
+   ivec2 texel_min = clamp(ivec2(rect_min * vec2(mip_size)), ivec2(0), mip_size - 1);
+   ivec2 texel_max = min(texel_min + 1, mip_size - 1);
+
+   float depth_00 = texelFetch(tex_depth_pyramid, texel_min, mip).r;
+   float depth_10 = texelFetch(tex_depth_pyramid, ivec2(texel_max.x, texel_min.y), mip).r;
+   float depth_01 = texelFetch(tex_depth_pyramid, ivec2(texel_min.x, texel_max.y), mip).r;
+   float depth_11 = texelFetch(tex_depth_pyramid, texel_max, mip).r;
+
+   if (is_reverse_z)
+      return nearest_depth < min(min(depth_00, depth_10), min(depth_01, depth_11));
+
+   return nearest_depth > max(max(depth_00, depth_10), max(depth_01, depth_11));
+}
+
+void main()
+{
+   uint meshlet_id = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+   if (meshlet_id >= u_cull_info.x)
+      return;
+
+   Meshlet meshlet = meshlets[meshlet_id];
+
+   if (gl_LocalInvocationIndex == 0u)
+   {
+      is_visible = IsInsideFrustum(meshlet.bounding_sphere);
+
+      if (is_visible && (u_cull_info.y & MESHLET_CULL_CONE) != 0u)
+         is_visible = !IsBackfacing(meshlet);
+
+      if (is_visible && (u_cull_info.y & MESHLET_CULL_OCCLUSION) != 0u)
+         is_visible = !IsOccluded(meshlet.bounding_sphere);
+
+      write_offset = is_visible ? atomicAdd(index_count, meshlet.index_count) : 0u;
+
+   }
+
+   barrier();
+
+   if (!is_visible)
+      return;
+
+   for (uint index_i = gl_LocalInvocationIndex; index_i < meshlet.index_count; index_i += gl_WorkGroupSize.x)
+      draw_indices[write_offset + index_i] = source_indices[meshlet.first_index + index_i];
+
+}
@@ -59,6 +59,15 @@ function Ector.RadiansToTurns(angle_radians) end
 ---@return number
 function Ector.TurnsToRadians(angle_turns) end
 
+--- Cast a ray against the bounds of every drawable and get the closest hit. Lights are never hit.
+---@param origin Ector.Vector
+---@param direction Ector.Vector # distances are in units of its length
+---@param max_distance? number # defaults to 1000
+---@return number? distance # nil if nothing was hit
+---@return Ector.Vector? point
+---@return integer? drawable # the whole Drawable handle, its type included
+function Ector.Raycast(origin, direction, max_distance) end
+
 --- Namespace of input-related functionality.
 ---@class Ector.Input
 Ector.Input = {}
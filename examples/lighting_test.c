@@ -86,7 +86,7 @@ int main(int argc, char* argv[])
       "SHADOW_CASTER"
    };
 
-   Shader shadow_caster_shader = Renderer_LoadShader(renderer, "assets/core/shaders/builtin.glsl", defs, 1, false);
+   Shader shadow_caster_shader = Renderer_GetShaderVariant(renderer, "assets/core/shaders/builtin.glsl", defs, 1, 0);
 
    Surface unlit_surf = Renderer_AddSurface(renderer, "Unlit", &(SurfaceDesc){
       .pass_count = 2,
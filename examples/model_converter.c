@@ -0,0 +1,104 @@
+#include <util/types.h>
+#include <util/files.h>
+#include <util/jobs.h>
+#include <mesh.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// offline EBMF converter, rewrites a v1 or v2 model as v2 with compressed vertex and index streams.
+// usage: ModelConverter <input.ebmf> <output.ebmf> [--raw] [--precision <mantissa bits>] [--meshlets]
+//   --raw        keep the streams uncompressed, so they can be mapped straight into memory
+//   --precision  round float attributes to this many mantissa bits (lossy, 16 is plenty for most models)
+//   --meshlets   build meshlets with culling bounds and store them in the file
+
+int main(int argc, char* argv[])
+{
+   if (argc < 3)
+   {
+      printf("usage: %s <input.ebmf> <output.ebmf> [--raw] [--precision <mantissa bits>] [--meshlets]\n", argv[0]);
+      return 1;
+   }
+
+   bool compress_streams = true;
+   bool build_meshlets = false;
+   i32 mantissa_bits = 23;
+
+   for (i32 arg_i = 3; arg_i < argc; arg_i++)
+   {
+      if (strcmp(argv[arg_i], "--raw") == 0)
+      {
+         compress_streams = false;
+         continue;
+      }
+
+      if (strcmp(argv[arg_i], "--meshlets") == 0)
+      {
+         build_meshlets = true;
+         continue;
+      }
+
+      if (strcmp(argv[arg_i], "--precision") == 0 && arg_i + 1 < argc)
+      {
+         mantissa_bits = atoi(argv[++arg_i]);
+         if (mantissa_bits < 1 || mantissa_bits > 23)
+         {
+            printf("precision has to be between 1 and 23 bits\n");
+            return 1;
+         }
+
+         continue;
+      }
+
+      printf("unknown option '%s'\n", argv[arg_i]);
+      return 1;
+   }
+
+   memblob file_data = Util_LoadFileIntoMemory(argv[1], true);
+   Model model = Mesh_LoadEctorModel(file_data);
+   uS input_size = file_data.size;
+   free(file_data.data);
+
+   if (model.meshes == NULL)
+   {
+      printf("couldn't load '%s' as an EBMF model\n", argv[1]);
+      return 1;
+   }
+
+   f64 start_time = Util_MonotonicTime();
+
+   for (u32 mesh_i = 0; mesh_i < model.mesh_count; mesh_i++)
+   {
+      Mesh_OptimizeVertexFetch(&model.meshes[mesh_i]);
+      Mesh_RoundVertexPrecision(&model.meshes[mesh_i], (u8)mantissa_bits);
+
+   }
+
+   // after the vertex fetch optimization, it renumbers the vertices the meshlets point at. meshlets the input already had
+   // would be stale now, so those get rebuilt too
+   build_meshlets = (build_meshlets || model.meshlets.meshlet_count > 0);
+   if (build_meshlets && !Model_BuildMeshlets(&model, NULL))
+   {
+      printf("couldn't build meshlets for '%s'\n", argv[1]);
+      Model_Free(&model);
+      return 1;
+   }
+
+   memblob output_data = Mesh_WriteEctorModel(model, compress_streams);
+
+   f64 encode_ms = (Util_MonotonicTime() - start_time) * 1000.0;
+   Model_Free(&model);
+
+   if (output_data.data == NULL || !Util_SaveMemoryToFile(argv[2], output_data))
+   {
+      printf("couldn't write '%s'\n", argv[2]);
+      free(output_data.data);
+      return 1;
+   }
+
+   printf("wrote %s (%zu -> %zu bytes, %.2fx, encoded in %.1f ms)\n", argv[2], (size_t)input_size, (size_t)output_data.size, (f64)input_size / (f64)output_data.size, encode_ms);
+   free(output_data.data);
+
+   return 0;
+}
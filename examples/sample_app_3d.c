@@ -31,7 +31,7 @@ int main(int argc, char* argv[])
    Texture rock1_texture = Renderer_LoadTexture(renderer, "assets/textures/rock1_albedo.png", (res2D){ 0 }, true, true);
    Texture rock2_texture = Renderer_LoadTexture(renderer, "assets/textures/rock2_albedo.png", (res2D){ 0 }, true, true);
    Texture floor_texture = Renderer_LoadTexture(renderer, "assets/textures/grass.png", (res2D){ 0 }, true, true);
-   Shader shader = Renderer_LoadShader(renderer, "assets/core/shaders/builtin.glsl", NULL, 0, false);
+   Shader shader = Renderer_GetShaderVariant(renderer, "assets/core/shaders/builtin.glsl", NULL, 0, 0);
    Surface surface = Renderer_AddSurface(renderer, "Basic", &(SurfaceDesc){
       .pass_count = 1,
       .passes[0] = {
@@ -43,32 +43,45 @@ int main(int argc, char* argv[])
    for (u32 mesh_i = 0; mesh_i < model.mesh_count; mesh_i++)
    {
       Mesh mesh = model.meshes[mesh_i];
-      Geometry geometry = Graphics_CreateGeometry(graphics, mesh, GFX_DRAWMODE_STATIC);
+      Node node = (mesh.node_id > -1) ? model.nodes[mesh.node_id] : (Node){ .name = "", .transform = Util_IdentityTransform() };
 
-      Drawable drawable = Renderer_CreateDrawable(renderer, GEOMETRY_DRAWABLE_TYPE);
-      GeometryDrawable* drawable_data = Renderer_GetDrawableData(renderer, drawable);
-      drawable_data->geometry = geometry;
-      drawable_data->material.surface = surface;
+      // the rocks go through the gpu meshlet culling, the floor is just one big plane so it stays a regular geometry
+      Drawable drawable = { 0 };
+      SurfaceMaterial* material = NULL;
 
-      if (mesh.node_id > -1)
+      if (strncmp(node.name, "Floor", 64) != 0)
       {
-         Node node = model.nodes[mesh.node_id];
+         drawable = Renderer_CreateDrawable(renderer, MESHLET_DRAWABLE_TYPE);
+         MeshletDrawable* drawable_data = Renderer_GetDrawableData(renderer, drawable);
          drawable_data->transform = node.transform;
+         material = &drawable_data->material;
 
-         if (strncmp(node.name, "Floor", 64) != 0) {
-            if (strncmp(node.name, "Rock0", 64) == 0)
-               Renderer_SetSurfaceMaterialTexture(&drawable_data->material, 0, 0, rock0_texture);
+         MeshletData meshlets = Mesh_BuildMeshlets(mesh);
+         Renderer_SetMeshletDrawableMesh(renderer, drawable, mesh, meshlets);
+         Mesh_FreeMeshlets(&meshlets);
 
-            if (strncmp(node.name, "Rock1", 64) == 0)
-               Renderer_SetSurfaceMaterialTexture(&drawable_data->material, 0, 0, rock1_texture);
+      } else {
+         drawable = Renderer_CreateDrawable(renderer, GEOMETRY_DRAWABLE_TYPE);
+         GeometryDrawable* drawable_data = Renderer_GetDrawableData(renderer, drawable);
+         drawable_data->geometry = Graphics_CreateGeometry(graphics, mesh, GFX_DRAWMODE_STATIC);
+         drawable_data->transform = node.transform;
+         material = &drawable_data->material;
 
-            if (strncmp(node.name, "Rock2", 64) == 0)
-               Renderer_SetSurfaceMaterialTexture(&drawable_data->material, 0, 0, rock2_texture);
+      }
 
-         } else
-            Renderer_SetSurfaceMaterialTexture(&drawable_data->material, 0, 0, floor_texture);
+      material->surface = surface;
 
-      }
+      if (strncmp(node.name, "Rock0", 64) == 0)
+         Renderer_SetSurfaceMaterialTexture(material, 0, 0, rock0_texture);
+
+      if (strncmp(node.name, "Rock1", 64) == 0)
+         Renderer_SetSurfaceMaterialTexture(material, 0, 0, rock1_texture);
+
+      if (strncmp(node.name, "Rock2", 64) == 0)
+         Renderer_SetSurfaceMaterialTexture(material, 0, 0, rock2_texture);
+
+      if (strncmp(node.name, "Floor", 64) == 0)
+         Renderer_SetSurfaceMaterialTexture(material, 0, 0, floor_texture);
 
    }
    Model_Free(&model);
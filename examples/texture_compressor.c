@@ -0,0 +1,93 @@
+#include <util/types.h>
+#include <util/files.h>
+#include <util/jobs.h>
+#include <image.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// offline BCn encoder, turns a png (or anything stb_image reads) into a ktx2 file with a full mip chain.
+// usage: TextureCompressor <input> <output.ktx2> [bc1|bc3|bc4|bc5] [--srgb]
+
+static u8 ParseFormat(const char* name)
+{
+   if (strcmp(name, "bc1") == 0)
+      return IMG_FORMAT_BC1;
+
+   if (strcmp(name, "bc3") == 0)
+      return IMG_FORMAT_BC3;
+
+   if (strcmp(name, "bc4") == 0)
+      return IMG_FORMAT_BC4;
+
+   if (strcmp(name, "bc5") == 0)
+      return IMG_FORMAT_BC5;
+
+   return UINT8_MAX;
+}
+
+int main(int argc, char* argv[])
+{
+   if (argc < 3)
+   {
+      printf("usage: %s <input> <output.ktx2> [bc1|bc3|bc4|bc5] [--srgb]\n", argv[0]);
+      return 1;
+   }
+
+   u8 compressed_format = IMG_FORMAT_BC1;
+   bool is_srgb = false;
+
+   for (i32 arg_i = 3; arg_i < argc; arg_i++)
+   {
+      if (strcmp(argv[arg_i], "--srgb") == 0)
+      {
+         is_srgb = true;
+         continue;
+      }
+
+      compressed_format = ParseFormat(argv[arg_i]);
+      if (compressed_format == UINT8_MAX)
+      {
+         printf("unknown format '%s'\n", argv[arg_i]);
+         return 1;
+      }
+
+   }
+
+   memblob file_data = Util_LoadFileIntoMemory(argv[1], true);
+   Image image = Image_CreateImage(file_data, IMG_TYPE_2D, (res2D){ 0 }, is_srgb);
+   free(file_data.data);
+
+   if (image.data == NULL || Image_IsCompressed(image.image_format))
+   {
+      printf("couldn't load '%s' as an uncompressed image\n", argv[1]);
+      return 1;
+   }
+
+   Image_GenerateMipmaps(&image);
+
+   JobPool* jobs = Util_CreateJobPool(0);
+   f64 start_time = Util_MonotonicTime();
+
+   Image compressed = Image_CompressImage(&image, compressed_format, jobs);
+
+   f64 encode_ms = (Util_MonotonicTime() - start_time) * 1000.0;
+   Util_FreeJobPool(jobs);
+   Image_Free(&image);
+
+   memblob ktx2_data = Image_SaveKTX2(&compressed);
+   Image_Free(&compressed);
+
+   if (ktx2_data.data == NULL || !Util_SaveMemoryToFile(argv[2], ktx2_data))
+   {
+      printf("couldn't write '%s'\n", argv[2]);
+      free(ktx2_data.data);
+      return 1;
+   }
+
+   printf("wrote %s (%zu bytes, encoded in %.1f ms)\n", argv[2], (size_t)ktx2_data.size, encode_ms);
+   free(ktx2_data.data);
+
+   return 0;
+}
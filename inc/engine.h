@@ -12,6 +12,14 @@ enum {
 #define ERR_FLAG_WINDOW_INIT_FAILED (1u << 0)
 #define ERR_FLAG_WINDOW_CREATION_FAILED (1u << 1)
 #define ERR_FLAG_ENGINE_ALLOC_FAILED (1u << 2)
+#define ERR_FLAG_HEADLESS_CONTEXT_FAILED (1u << 3)
+
+enum {
+   ENG_HEADLESS_AUTO = 0, // EGL if it works, OSMesa otherwise
+   ENG_HEADLESS_EGL,
+   ENG_HEADLESS_OSMESA
+
+};
 
 typedef enum MouseMode_t
 {
@@ -38,11 +46,28 @@ typedef struct EngineDesc_t
 
    } renderer;
 
+   // no window and no display server. GL draws into an offscreen surface the size of window.size,
+   // through a surfaceless EGL pbuffer or OSMesa's software rasterizer. there's no input in this mode.
+   struct {
+      bool enabled;
+      u8 backend;
+
+   } headless;
+
+   // when set, Engine_Present reads back every frame and writes it into this directory as a numbered tga.
+   // readback and file writing both happen in the background, frames get dropped rather than stalling if they can't keep up.
+   struct {
+      const char* directory;
+
+   } frame_dump;
+
 } EngineDesc;
 
 
 typedef struct Engine_t Engine;
 
+typedef void* (*EngineLoadFunc)(const char* proc_name);
+
 struct Module_t;
 typedef error (*ModuleFunc)(struct Module_t* self, Engine* engine);
 
@@ -72,6 +97,9 @@ void Engine_SetRawMouseInput(Engine* engine, bool raw_mouse_input);
 void Engine_SetMouseMode(Engine* engine, MouseMode mouse_mode);
 
 void Engine_Present(Engine* engine);
+bool Engine_IsHeadless(Engine* engine);
+// looks up GL functions from whichever context the engine created.
+EngineLoadFunc Engine_GetLoadFunc(Engine* engine);
 
 res2D Engine_GetFrameSize(Engine* engine);
 f64 Engine_GetFrameDelta(Engine* engine);
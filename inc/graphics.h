@@ -14,6 +14,7 @@ typedef handle Buffer;
 typedef handle Geometry;
 typedef handle Texture;
 typedef handle Framebuffer;
+typedef handle Readback;
 
 enum {
    ERR_GFX_CONTEXT_FAILED = 0x2001,
@@ -25,7 +26,8 @@ enum {
    ERR_GFX_FRAMEBUFFER_IS_INCOMPLETE,
    ERR_GFX_FRAMEBUFFER_ATTACHMENT_FAILED,
    ERR_GFX_SHADER_COMPILATION_FAILED,
-   ERR_GFX_SHADER_WRONG_TYPE
+   ERR_GFX_SHADER_WRONG_TYPE,
+   ERR_GFX_FEATURE_UNSUPPORTED
 
 };
 
@@ -37,6 +39,20 @@ enum {
 // framebuffer error flags
 #define ERR_FLAG_ATTEMPTED_LAYERED_ATTACHMENT (1u << 0)
 
+enum {
+   GFX_READBACKSTATUS_INVALID = 0,
+   GFX_READBACKSTATUS_PENDING,
+   GFX_READBACKSTATUS_READY
+
+};
+
+enum {
+   GFX_SHADERSTATUS_READY = 0,
+   GFX_SHADERSTATUS_PENDING,
+   GFX_SHADERSTATUS_FAILED
+
+};
+
 enum {
    GFX_INDEXTYPE_16BIT = 0,
    GFX_INDEXTYPE_32BIT
@@ -175,7 +191,11 @@ enum {
 
    // High Dynamic Range Block Compression Formats
    GFX_TEXTUREFORMAT_RGB_SIGNED_BC6,
-   GFX_TEXTUREFORMAT_RGB_UNSIGNED_BC6
+   GFX_TEXTUREFORMAT_RGB_UNSIGNED_BC6,
+
+   // Single and Two Channel Block Compression Formats
+   GFX_TEXTUREFORMAT_R_BC4,
+   GFX_TEXTUREFORMAT_RG_BC5
 
 };
 
@@ -190,6 +210,13 @@ enum {
 
 };
 
+enum {
+   GFX_STAGE_OK = 0,
+   GFX_STAGE_BUSY,
+   GFX_STAGE_INVALID
+
+};
+
 enum {
    GFX_TEXTUREWRAP_REPEAT = 0,
    GFX_TEXTUREWRAP_REPEAT_MIRRORED,
@@ -225,6 +252,18 @@ enum {
 
 };
 
+enum {
+   GFX_MIPFILTER_DEFAULT = 0, // glGenerateMipmap, whatever the driver does
+   GFX_MIPFILTER_BOX, // 2x2 average done in linear space, srgb textures get decoded and re-encoded
+   GFX_MIPFILTER_ALPHA_WEIGHTED, // like box but color is weighted by alpha, so cutout edges don't bleed in dark fringes
+   GFX_MIPFILTER_NORMAL_MAP, // averages and renormalizes tangent space normals
+   GFX_MIPFILTER_DEPTH_MAX, // farthest of the footprint for a hi-z pyramid, odd edges fold into the last texel so nothing is lost
+   GFX_MIPFILTER_DEPTH_MIN, // same but the nearest, for reverse-z depth
+
+   GFX_MIPFILTER_COUNT
+
+};
+
 typedef struct AdvancedBindOptions_t
 {
    u32 mip_level;
@@ -281,6 +320,17 @@ typedef struct TextureDesc_t
 
 } TextureDesc;
 
+// capacities below the mesh's own counts are bumped up to them. a ring_count over 1 keeps that many copies of the
+// geometry, every Graphics_ReuseGeometry fills the next one so the gpu can keep drawing from the older ones.
+typedef struct GeometryDesc_t
+{
+   u32 vertex_capacity;
+   u32 index_capacity;
+   u8 draw_mode;
+   u8 ring_count;
+
+} GeometryDesc;
+
 typedef struct TextureInterpolation_t
 {
    u16 texture_anisotropy;
@@ -289,9 +339,41 @@ typedef struct TextureInterpolation_t
 
 } TextureInterpolation;
 
+// counted since the last Graphics_ResetStats, only things that actually reach GL are counted.
+typedef struct GraphicsStats_t
+{
+   u32 draw_calls;
+   u32 instances;
+   u64 primitives;
+   u32 dispatches;
+   u32 state_changes;
+   u32 shader_binds;
+   u32 texture_binds;
+   u32 sampler_binds;
+   u32 buffer_uploads;
+   u64 buffer_upload_bytes;
+
+} GraphicsStats;
+
+// gpu timers are read back this many frames late so the results never stall the pipeline.
+#define GFX_GPU_TIMER_LATENCY 3
+#define GFX_MAX_GPU_TIMERS 128
+#define GFX_GPU_TIMER_NOT_READY UINT64_MAX
+
+// how many readbacks can be in flight at once. a request past this fails instead of waiting on an older one.
+#define GFX_MAX_READBACKS 8
+
+#define GFX_MAX_GEOMETRY_RING 4
+
 typedef struct Graphics_t Graphics;
 
+// looks up a GL function by name, like glfwGetProcAddress or eglGetProcAddress.
+typedef void* (*GraphicsLoadFunc)(const char* proc_name);
+
+// loads GL through GLFW, so a GLFW context has to be current.
 Graphics* Graphics_Init(void);
+// same, for contexts that didn't come from GLFW.
+Graphics* Graphics_InitWithLoader(GraphicsLoadFunc load_func);
 void Graphics_Free(Graphics* graphics);
 void Graphics_CheckErrors(Graphics* graphics);
 
@@ -299,8 +381,20 @@ Shader Graphics_CreateShader(Graphics* graphics, const char* vertex_shader, cons
 Shader Graphics_CreateComputeShader(Graphics* graphics, const char* compute_shader);
 Shader Graphics_LoadShaderFromFile(Graphics* graphics, const char* file_path, const char* defines[], const u32 define_count, bool is_compute);
 void Graphics_FreeShader(Graphics* graphics, Shader res_shader);
+
+// these return right away with the shader still compiling, it can't be used until its status is GFX_SHADERSTATUS_READY.
+// a failed shader keeps its handle so it can still be freed.
+Shader Graphics_CreateShaderAsync(Graphics* graphics, const char* vertex_shader, const char* fragment_shader);
+Shader Graphics_CreateComputeShaderAsync(Graphics* graphics, const char* compute_shader);
+Shader Graphics_LoadShaderFromFileAsync(Graphics* graphics, const char* file_path, const char* defines[], const u32 define_count, bool is_compute);
+u8 Graphics_GetShaderStatus(Graphics* graphics, Shader res_shader);
+u8 Graphics_WaitForShader(Graphics* graphics, Shader res_shader);
+
+// linked programs are saved here and reused when the same sources are compiled on the same driver. NULL turns it off.
+void Graphics_SetShaderCacheDirectory(Graphics* graphics, const char* directory_path);
 void Graphics_SetUniform(Graphics* graphics, Uniform uniform);
 void Graphics_Dispatch(Graphics* graphics, Shader res_shader, u32 size_x, u32 size_y, u32 size_z, UniformBlockList uniform_blocks);
+// makes what dispatches wrote visible to everything after, including index buffers and indirect draw commands.
 void Graphics_DispatchBarrier(Graphics* graphics);
 
 Buffer Graphics_CreateBuffer(Graphics* graphics, void* data, u32 length, uS type_size, u8 draw_mode, u8 buffer_type);
@@ -312,21 +406,78 @@ void Graphics_UpdateBufferExplicit(Graphics* graphics, Buffer res_buffer, void*
 void Graphics_BindBuffer(Graphics* graphics, Buffer res_buffer, u32 slot);
 
 Geometry Graphics_CreateGeometry(Graphics* graphics, Mesh mesh, u8 draw_mode);
+// buffers are sized for desc's capacities so later updates can happen in place. mesh's vertex and index buffers can be NULL,
+// only its attribute layout and index type are needed up front.
+Geometry Graphics_CreateDynamicGeometry(Graphics* graphics, Mesh mesh, GeometryDesc desc);
+// replaces the geometry's contents while keeping its vao and buffers. the buffers are only reallocated when the mesh doesn't fit
+// or its layout changed, otherwise the old storage is orphaned (or the ring moves on) so the upload never waits on the gpu.
+void Graphics_ReuseGeometry(Graphics* graphics, Mesh mesh, u8 draw_mode, Geometry res_geometry);
+// overwrites mesh.vertex_count vertices from first_vertex and mesh.index_count indices from first_index, in the copy that's
+// currently drawn. mesh has to match the geometry's layout, returns false if it doesn't or the range is past the capacity.
+// with is_tail the range becomes the end of the geometry, so the draw count can shrink, otherwise it only grows to cover the range.
+bool Graphics_UpdateGeometryRange(Graphics* graphics, Geometry res_geometry, Mesh mesh, u32 first_vertex, u32 first_index, bool is_tail);
 void Graphics_FreeGeometry(Graphics* graphics, Geometry res_geometry);
 void Graphics_SetGeometryFaceCullMode(Graphics* graphics, Geometry res_geometry, u8 face_cull_mode);
+// binds the geometry's index buffer as a storage buffer, so a compute shader can write the indices it gets drawn with.
+// only works for geometry without a ring.
+bool Graphics_BindGeometryIndexBuffer(Graphics* graphics, Geometry res_geometry, u32 slot);
 
 Texture Graphics_CreateTexture(Graphics* graphics, u8* data, TextureDesc desc);
 void Graphics_FreeTexture(Graphics* graphics, Texture res_texture);
 void Graphics_UpdateTexture(Graphics* graphics, u8* data, Texture res_texture);
+// gives the texture new (empty) storage, the handle stays the same.
+void Graphics_ReallocateTexture(Graphics* graphics, Texture res_texture, TextureDesc desc);
+// only the base level is read from data, the rest of the chain is filled in on the gpu. a mipmap_count of 0 means the whole chain.
+Texture Graphics_CreateTextureWithMips(Graphics* graphics, u8* data, TextureDesc desc, u8 mip_filter);
+// rebuilds mips 1 and up from the base level. filters other than default run as a compute pass on 2D textures
+// with an image-storable format, everything else falls back to glGenerateMipmap.
+void Graphics_GenerateMipmaps(Graphics* graphics, Texture res_texture, u8 mip_filter);
+// only mips in [base_mip, max_mip] get sampled, for textures that are still being filled in.
+void Graphics_SetTextureMipRange(Graphics* graphics, Texture res_texture, u32 base_mip, u32 max_mip);
+// throws away the top drop_count mips of a 2D texture, what's left moves up to become the new chain. the handle stays the same.
+// returns false if the texture isn't 2D or doesn't have more than drop_count mips.
+bool Graphics_DropTextureMips(Graphics* graphics, Texture res_texture, u32 drop_count);
+TextureDesc Graphics_GetTextureDesc(Graphics* graphics, Texture res_texture);
+// bytes the texture's storage takes up on the gpu, worked out from its format, size and mips.
+uS Graphics_GetTextureSize(Graphics* graphics, Texture res_texture);
+// same as above but summed over every texture that's alive.
+uS Graphics_GetTextureMemory(Graphics* graphics);
+// copies one mip of a 2D texture through a ring of pixel unpack buffers, so the driver doesn't have to stall on the copy.
+// GFX_STAGE_BUSY means the part of the ring it needs is still in use by the gpu and nothing happened, try again next frame.
+// GFX_STAGE_INVALID means the mip can never go into this texture.
+u8 Graphics_StageTextureMip(Graphics* graphics, Texture res_texture, u32 mip_level, const u8* data, uS size);
+// same as above, but gives the texture new storage from desc first. the texture is only touched once the mip is known to fit
+// and the ring has room for it, so anything but GFX_STAGE_OK leaves the old storage alone.
+u8 Graphics_ReallocateTextureStaged(Graphics* graphics, Texture res_texture, TextureDesc desc, u32 mip_level, const u8* data, uS size);
 void Graphics_BindTexture(Graphics* graphics, Texture res_texture, u32 bind_slot);
 void Graphics_BindTextureView(Graphics* graphics, Texture res_texture, u32 bind_slot, const AdvancedBindOptions* bind_options);
 void Graphics_UnbindTextures(Graphics* graphics, u8 texture_type);
 void Graphics_SetTextureInterpolation(Graphics* graphics, Texture res_texture, TextureInterpolation interpolation_settings);
 void Graphics_SetTextureShadowSampler(Graphics* graphics, Texture res_texture, bool is_tex_shadow);
 
+// sampler objects override the texture's own parameters while bound. they're created once per unique setting and cached.
+void Graphics_BindSampler(Graphics* graphics, TextureInterpolation interpolation_settings, bool is_tex_shadow, u32 bind_slot);
+void Graphics_UnbindSampler(Graphics* graphics, u32 bind_slot);
+
 // NOTE: this function allocates memory.
 Image Graphics_GetTextureImageData(Graphics* graphics, Texture res_texture, u32 mip_level, u8 cubemap_face);
 
+// readbacks copy into a pixel pack buffer and return right away, the data shows up a frame or two later without stalling anything.
+// the returned Readback is NULLHANDLE if all GFX_MAX_READBACKS slots are taken, so a capture that can't keep up drops frames instead of blocking.
+Readback Graphics_RequestTextureReadback(Graphics* graphics, Texture res_texture, u32 mip_level, u8 cubemap_face);
+// reads an rgba8 color attachment, rows bottom to top. an invalid framebuffer reads the default one.
+Readback Graphics_RequestFramebufferReadback(Graphics* graphics, Framebuffer res_framebuffer, u8 attachment_slot, res2D size);
+u8 Graphics_GetReadbackStatus(Graphics* graphics, Readback res_readback);
+// blocks until the readback is done or timeout_ns runs out, for when stalling is fine (shutdown, tools).
+u8 Graphics_WaitReadback(Graphics* graphics, Readback res_readback, u64 timeout_ns);
+// the oldest readback that's done, NULLHANDLE if there aren't any. for streams that request one every frame.
+Readback Graphics_NextReadyReadback(Graphics* graphics);
+// the image's data points straight into the mapped buffer, it's only valid until Graphics_ReleaseReadback and shouldn't be freed.
+// returns an image with NULL data if the readback isn't ready yet.
+Image Graphics_MapReadback(Graphics* graphics, Readback res_readback);
+// gives the slot back, readbacks that are still pending are dropped.
+void Graphics_ReleaseReadback(Graphics* graphics, Readback res_readback);
+
 Framebuffer Graphics_CreateFramebuffer(Graphics* graphics, res2D size, bool depthstencil_renderbuffer);
 void Graphics_FreeFramebuffer(Graphics* graphics, Framebuffer res_framebuffer);
 void Graphics_DrawToFramebufferTargets(Graphics* graphics, Framebuffer res_framebuffer, u32 target_count, u8 target_ids[]);
@@ -348,7 +499,27 @@ void Graphics_SetBlending(Graphics* graphics, u8 blend_mode);
 void Graphics_SetDepthTest(Graphics* graphics, u8 depth_mode);
 void Graphics_SetDepthMask(Graphics* graphics, bool depth_mask);
 
+// reverse-z maps the near plane to depth 1 and the far plane to depth 0, with a [0, 1] clip range.
+// while enabled the less/greater depth modes and the clear depth are flipped, so passes written for regular depth keep working.
+// framebuffers created while it's enabled get a floating-point depth buffer. needs GL 4.5, returns false if unavailable.
+bool Graphics_EnableReverseZ(Graphics* graphics, bool enable_reverse_z);
+bool Graphics_IsReverseZ(Graphics* graphics);
+
+GraphicsStats Graphics_GetStats(Graphics* graphics);
+void Graphics_ResetStats(Graphics* graphics);
+
+// timers are numbered in the order they're started within a frame. timestamps are used, so they can overlap or nest.
+// Graphics_NextGpuTimerFrame starts a new frame and collects the frame from GFX_GPU_TIMER_LATENCY - 1 frames ago,
+// which Graphics_GetGpuTimerResults then returns in nanoseconds (or GFX_GPU_TIMER_NOT_READY).
+u32 Graphics_BeginGpuTimer(Graphics* graphics);
+void Graphics_EndGpuTimer(Graphics* graphics, u32 timer_id);
+void Graphics_NextGpuTimerFrame(Graphics* graphics);
+u32 Graphics_GetGpuTimerResults(Graphics* graphics, u64* out_results, u32 max_results);
+
 void Graphics_Draw(Graphics* graphics, Shader res_shader, Geometry res_geometry, UniformBlockList uniform_blocks);
 void Graphics_DrawInstanced(Graphics* graphics, Shader res_shader, Geometry res_geometry, u32 instance_count, UniformBlockList uniform_blocks);
+// draws indexed geometry with the count, first index and instance count read from command_buffer at command_offset, laid out
+// like GL's DrawElementsIndirectCommand. the primitives are on the gpu, so they don't show up in the stats.
+void Graphics_DrawIndirect(Graphics* graphics, Shader res_shader, Geometry res_geometry, Buffer command_buffer, uS command_offset, UniformBlockList uniform_blocks);
 
 #endif
@@ -2,6 +2,9 @@
 #define ECT_IMAGE_H
 
 #include "util/types.h"
+#include "util/jobs.h"
+
+#define IMAGE_MODULE "Image"
 
 enum {
    IMG_TYPE_2D = 0,
@@ -12,7 +15,24 @@ enum {
    // Standard Color Formats
    IMG_FORMAT_U8 = 0,
    IMG_FORMAT_U8_SRGB,
-   IMG_FORMAT_F32
+   IMG_FORMAT_F32,
+
+   // Block Compressed Formats, data is whole 4x4 blocks and channel_count is what they decode to
+   IMG_FORMAT_BC1,
+   IMG_FORMAT_BC1_SRGB,
+   IMG_FORMAT_BC3,
+   IMG_FORMAT_BC3_SRGB,
+   IMG_FORMAT_BC4,
+   IMG_FORMAT_BC5,
+   IMG_FORMAT_BC6H,
+   IMG_FORMAT_BC7,
+   IMG_FORMAT_BC7_SRGB
+};
+
+enum {
+   ERR_IMG_UNSUPPORTED_CONTAINER = 1,
+   ERR_IMG_UNSUPPORTED_FORMAT,
+   ERR_IMG_TRUNCATED_FILE
 };
 
 typedef struct Image_t
@@ -27,9 +47,26 @@ typedef struct Image_t
 
 } Image;
 
+static inline bool Image_IsCompressed(u8 image_format)
+{
+   return (image_format >= IMG_FORMAT_BC1);
+}
+
+// KTX2 and DDS files go through Image_LoadContainer, slicing doesn't apply to them.
 Image Image_CreateImage(memblob memory, u8 image_type, res2D slice_size, bool is_srgb);
 void Image_Free(Image* image);
 
+// compressed images bring their own mips, this leaves them alone.
 void Image_GenerateMipmaps(Image* image);
+// size in bytes of one mip, mips are packed one after the other starting from the largest.
+uS Image_MipSize(const Image* image, u32 mip_level);
+
+// 2D textures only. mips stored in the file are kept, is_srgb is only used when the file doesn't say.
+Image Image_LoadContainer(memblob memory, bool is_srgb);
+memblob Image_SaveKTX2(const Image* image);
+// 8 bit images with 1, 3 or 4 channels. is_bottom_up marks the first row as the bottom one, which is how GL reads pixels back.
+memblob Image_SaveTGA(const Image* image, bool is_bottom_up);
+// encodes every mip of an 8 bit rgba image into BC1, BC3, BC4 or BC5. jobs can be NULL to encode on the calling thread.
+Image Image_CompressImage(const Image* image, u8 compressed_format, JobPool* jobs);
 
 #endif
@@ -3,9 +3,15 @@
 
 #include "util/types.h"
 #include "util/extra_types.h"
+#include "util/jobs.h"
+#include "util/files.h"
 
 #define MESH_MAX_ATTRIBUTES 8
 
+// sized so a meshlet's vertices fit in a single 64 wide workgroup and its local indices in a byte
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+
 enum {
    MESH_ATTRIBUTE_1_CHANNEL = 0,
    MESH_ATTRIBUTE_2_CHANNEL,
@@ -39,6 +45,16 @@ typedef struct Node_t
 
 } Node;
 
+// a lower detail version of a mesh, drawn with a range of the mesh's own index buffer.
+// error is roughly how far (in model units) it strays from the full mesh.
+typedef struct MeshLod_t
+{
+   u32 first_index;
+   u32 index_count;
+   f32 error;
+
+} MeshLod;
+
 typedef struct Mesh_t
 {
    u8* vertex_buffer;
@@ -48,13 +64,90 @@ typedef struct Mesh_t
    u32 index_count;
    i32 node_id;
    i16 material_id;
-   u8 primitive: 7;
+   u8 primitive: 6;
    u8 index_type: 1;
+   u8 is_borrowed: 1; // the buffers point into memory the mesh doesn't own (like a mapped file), Mesh_Free leaves them alone
    u8 attribute_count;
    u8 attributes[MESH_MAX_ATTRIBUTES];
 
+   BBox bounds; // zero sized if nothing has filled them in
+   vec4 bounding_sphere; // xyz is the center, w the radius
+   u32 first_lod; // into the lods of the model the mesh came from
+   u32 lod_count;
+   u32 first_meshlet; // into the meshlets of the model the mesh came from
+   u32 meshlet_count;
+
 } Mesh;
 
+// a small cluster of a mesh's triangles that can be culled on its own. none of its triangles face a camera at
+// camera_pos when dot(normalize(cone_apex - camera_pos), cone_axis) >= cone_cutoff.
+typedef struct Meshlet_t
+{
+   u32 vertex_offset; // into MeshletData.vertices
+   u32 triangle_offset; // into MeshletData.triangles, counted in triangles so the bytes start at triangle_offset * 3
+   u32 vertex_count;
+   u32 triangle_count;
+
+   vec4 bounding_sphere; // xyz is the center, w the radius
+   vec3 cone_apex;
+   vec3 cone_axis;
+   f32 cone_cutoff; // 1 when the triangles face too many ways for the cone to ever cull them
+
+} Meshlet;
+
+// the vertices are indices into the mesh's own vertices, the triangles are 3 bytes each indexing into the meshlet's vertices.
+typedef struct MeshletData_t
+{
+   Meshlet* meshlets;
+   u32* vertices;
+   u8* triangles;
+
+   u32 meshlet_count;
+   u32 vertex_count;
+   u32 triangle_count;
+
+} MeshletData;
+
+// grows its streams ahead of time instead of reallocating the whole mesh on every append. the streams match the
+// layout the procedural functions use: position, normal, texcoord and tangent, with 32 bit indices.
+typedef struct MeshBuilder_t
+{
+   vec3* position;
+   vec3* normal;
+   vec2* texcoord;
+   vec4* tangent;
+   u32* indices;
+
+   u32 vertex_count;
+   u32 vertex_capacity;
+   u32 index_count;
+   u32 index_capacity;
+
+} MeshBuilder;
+
+// how far apart two vertices can be and still get merged. attributes after the position are compared per channel,
+// 3 and 4 channel ones (normals, tangents) against normal_tolerance and 1 and 2 channel ones (uvs) against texcoord_tolerance.
+// colors always have to match exactly.
+typedef struct MeshWeldDesc_t
+{
+   f32 position_tolerance;
+   f32 normal_tolerance;
+   f32 texcoord_tolerance;
+
+} MeshWeldDesc;
+
+// extra work done on every mesh while the model loads, on the same worker that decoded it. narrowing only
+// happens for meshes with few enough vertices, and tangents only for the position, normal, texcoord layout.
+// v1 meshes always get their bounds calculated since the file doesn't store any.
+typedef struct MeshLoadDesc_t
+{
+   bool narrow_indices;
+   bool widen_indices;
+   bool calculate_bounds;
+   bool generate_tangents;
+
+} MeshLoadDesc;
+
 typedef struct MeshInterface_t
 {
    Mesh* mesh;
@@ -109,12 +202,19 @@ typedef struct Model_t
    Node* nodes;
    Mesh* meshes;
    Material* materials;
+   MeshLod* lods;
+   MeshletData meshlets;
 
    u16 version;
    i16 root_bone_id;
    u32 node_count;
    u32 mesh_count;
    u32 material_count;
+   u32 lod_count;
+
+   MmapBlob source; // what the meshes borrow from, unmapped by Model_Free
+   memblob material_strings; // every material string points in here, freed by Model_Free
+   MmapBlob material_source; // the .matb material_strings sits in, if the materials came from one
 
 } Model;
 
@@ -164,10 +264,48 @@ static inline bool Mesh_InterfaceIsValid(MeshInterface mesh_interface, bool need
 
 void Model_Free(Model* model);
 void Mesh_Free(Mesh* mesh);
+// copies borrowed buffers into memory the mesh owns, so it can be resized or outlive what it borrowed from.
+bool Mesh_MakeOwned(Mesh* mesh);
+
+// fills in bounds and bounding_sphere from the positions (the first attribute).
+void Mesh_CalculateBounds(Mesh* mesh);
+
+// splits the triangles into meshlets of up to MESHLET_MAX_VERTICES vertices and MESHLET_MAX_TRIANGLES triangles, growing
+// each one through the triangles it shares vertices with so they stay compact. they refer to vertices by index, so run
+// this after anything that renumbers them (like Mesh_OptimizeVertexFetch). free the result with Mesh_FreeMeshlets.
+MeshletData Mesh_BuildMeshlets(Mesh mesh);
+void Mesh_FreeMeshlets(MeshletData* meshlets);
+// builds meshlets for every mesh across the pool's workers and gathers them into the model's table, replacing any it had.
+// a NULL pool runs it all on the calling thread.
+bool Model_BuildMeshlets(Model* model, JobPool* jobs);
 
 void Mesh_SetIndexInBuffer(Mesh* mesh, u32 at_index, u32 index_value);
 u32 Mesh_GetIndexFromBuffer(Mesh mesh, u32 at_index);
 
+// finds vertices whose positions are within tolerance of each other. out_remap needs vertex_count entries, out_remap[i] gets
+// the lowest index i lines up with (i itself if none do). returns how many distinct positions there are.
+u32 Mesh_FindCoincidentVertices(Mesh mesh, f32 tolerance, u32* out_remap);
+// merges duplicate vertices and rewrites the index buffer to match. meshes without an index buffer get one.
+bool Mesh_WeldVertices(Mesh* mesh, MeshWeldDesc desc);
+
+// renumbers the vertices in the order the triangles first use them. the gpu fetches them more linearly, and neighbouring
+// vertices end up close together which helps the stream compression in Mesh_WriteEctorModel a lot.
+bool Mesh_OptimizeVertexFetch(Mesh* mesh);
+// rounds every float attribute to this many mantissa bits (out of 23). lossy, but the dropped bits compress to nothing.
+bool Mesh_RoundVertexPrecision(Mesh* mesh, u8 mantissa_bits);
+
+MeshBuilder Mesh_CreateBuilder(u32 vertex_capacity, u32 index_capacity);
+void Mesh_FreeBuilder(MeshBuilder* builder);
+// makes room for this many more vertices and indices.
+bool Mesh_ReserveBuilder(MeshBuilder* builder, u32 vertex_count, u32 index_count);
+// returns the new vertex's index, or UINT32_MAX if it couldn't be added.
+u32 Mesh_BuilderAddVertex(MeshBuilder* builder, vec3 position, vec3 normal, vec2 texcoord, vec4 tangent);
+void Mesh_BuilderAddTriangle(MeshBuilder* builder, u32 idx_a, u32 idx_b, u32 idx_c);
+void Mesh_BuilderAddQuad(MeshBuilder* builder, u32 faces_x, u32 faces_y, mat4x4 transform, vec4 texture_coords);
+// packs everything into out_mesh with a single vertex allocation and frees the builder. the returned interface can be
+// passed straight on to the Mesh_Gen functions.
+MeshInterface Mesh_FinishBuilder(MeshBuilder* builder, Mesh* out_mesh);
+
 MeshInterface Mesh_ReallocVertices(u32 vertex_count, bool use_normal, bool use_texcoord0, bool use_texcoord1, bool use_tangent, MeshInterface mesh_interface);
 
 MeshInterface Mesh_AddQuad(u32 faces_x, u32 faces_y, mat4x4 transform, MeshInterface mesh_interface);
@@ -176,6 +314,10 @@ MeshInterface Mesh_GenNormals(MeshInterface mesh_interface);
 MeshInterface Mesh_AverageNormalsOverSeams(MeshInterface mesh_interface);
 MeshInterface Mesh_GenTexcoords(MeshInterface mesh_interface, vec3 triplanar_scale);
 MeshInterface Mesh_GenTangents(MeshInterface mesh_interface);
+// same results as the two above, with the triangles and then the vertices split across the pool's workers.
+// every vertex sums its own faces, so nothing is shared between threads. a NULL pool runs it all on the calling thread.
+MeshInterface Mesh_GenNormalsParallel(MeshInterface mesh_interface, JobPool* jobs);
+MeshInterface Mesh_GenTangentsParallel(MeshInterface mesh_interface, JobPool* jobs);
 
 Mesh Mesh_CreatePlane(u32 faces_x, u32 faces_y, vec2 size);
 Mesh Mesh_CreateBox(u32 faces_x, u32 faces_y, u32 faces_z, vec3 size);
@@ -184,6 +326,28 @@ Mesh Mesh_CreateSphere(u32 faces, f32 size);
 
 Mesh Mesh_LoadEctorMesh(memblob memory);
 Model Mesh_LoadEctorModel(memblob memory);
+// the meshes point straight into the mapping instead of getting their own copies. the model takes the mapping over,
+// Model_Free unmaps it, so make any mesh that has to outlive the model owned first.
+Model Mesh_LoadEctorModelMapped(MmapBlob mapping);
+// same as the two above, but the meshes are decoded and post-processed across the pool's workers once the headers
+// have been scanned. a NULL pool runs it all on the calling thread.
+Model Mesh_LoadEctorModelParallel(memblob memory, MeshLoadDesc desc, JobPool* jobs);
+Model Mesh_LoadEctorModelMappedParallel(MmapBlob mapping, MeshLoadDesc desc, JobPool* jobs);
+// decodes just the one mesh. v2 files seek straight to it through the directory, v1 files have to be walked up to it.
+// the mesh always gets its own buffers.
+Mesh Mesh_LoadEctorModelMesh(memblob memory, u32 mesh_index);
+// writes the model out as EBMF v2, bounds are recalculated on the way and the meshlets go along if the model has any.
+// compressed streams get decoded on load instead of being mapped in place, run Mesh_OptimizeVertexFetch first to get
+// the most out of them. fails if any mesh has no vertices. free the returned data when done.
+memblob Mesh_WriteEctorModel(Model model, bool compress_streams);
+// parses a whole .mat file in one pass, replacing any materials the model already had. the strings all end up in
+// one block owned by the model, nothing points back into memory afterwards.
 void Mesh_ParseEctorMaterials(memblob memory, Model* inout_model);
+// loads the materials from a .matb written by Mesh_WriteEctorMaterialCache, the strings are used straight out of the
+// mapping. if source is set the cache is only used when it was compiled from that exact .mat text. the model takes
+// the mapping over, it gets unmapped right away if this returns false.
+bool Mesh_LoadEctorMaterialCache(MmapBlob mapping, memblob source, Model* inout_model);
+// compiles the model's materials into a .matb, source is the .mat text they came from. free the returned data when done.
+memblob Mesh_WriteEctorMaterialCache(Model model, memblob source);
 
 #endif
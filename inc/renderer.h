@@ -4,6 +4,7 @@
 #include "util/types.h"
 #include "util/extra_types.h"
 #include "util/math.h"
+#include "util/jobs.h"
 #include "mesh.h"
 #include "graphics.h"
 
@@ -11,6 +12,7 @@
 
 #define EMPTY_DRAWABLE_TYPE "EmptyDrawable"
 #define GEOMETRY_DRAWABLE_TYPE "GeometryDrawable"
+#define MESHLET_DRAWABLE_TYPE "MeshletDrawable"
 
 #define SURF_MAX_PASSES 4
 #define SURF_MAX_BLOCKS_PER_PASS 4
@@ -18,6 +20,24 @@
 
 #define LIGHTMANAGER_MAX_DEFINES 32
 
+#define SHADER_VARIANT_COMPUTE (1u << 0)
+#define SHADER_VARIANT_LIGHTING (1u << 1) // adds the current light manager's defines
+#define SHADER_VARIANT_ASYNC (1u << 2)
+
+// every material gets one fixed size slot in the material table, bound as a storage buffer.
+// shaders index it with u_material_info.x from the model UBO.
+#define RNDR_MATERIAL_PARAMS_SIZE 256
+#define RNDR_MATERIAL_SSBO_BINDING 3
+
+// meshlet drawables run a culling compute shader right before they draw. it takes storage buffers 4 to 7, uniform block 4
+// and texture unit SURF_MAX_TEXTURES, so don't expect anything bound there to survive a meshlet draw.
+#define RNDR_MESHLET_SSBO_BINDING 4
+#define RNDR_MESHLET_UBO_BINDING 4
+#define RNDR_MESHLET_PYRAMID_SLOT SURF_MAX_TEXTURES
+
+#define RNDR_MAX_PROFILE_SCOPES GFX_MAX_GPU_TIMERS
+#define RNDR_MAX_FRAME_TIMINGS 32
+
 enum {
    RNDR_SURF_TEXTURE_WHITE = 0,
    RNDR_SURF_TEXTURE_GRAY,
@@ -29,6 +49,7 @@ enum {
 };
 
 typedef handle Surface;
+typedef handle MaterialParams;
 
 typedef union Drawable_t
 {
@@ -66,6 +87,8 @@ typedef struct ModelData_t
    mat4x4 mat_mvp;
    vec4 mat_normal_model[3];
    vec4 u_color;
+   u32 u_material_id;
+   u32 mem_unused_[3];
 
 } ModelData;
 
@@ -109,6 +132,7 @@ typedef struct SurfaceTexture_t
 typedef struct SurfaceMaterial_t
 {
    Surface surface;
+   MaterialParams params; // zero is the default (all zero) material
    SurfaceTexture textures[SURF_MAX_TEXTURES];
    u32 texture_count;
 
@@ -116,6 +140,31 @@ typedef struct SurfaceMaterial_t
 
 } SurfaceMaterial;
 
+// scopes with the same name and index are merged, count is how many times they ran.
+// gpu_ms is from GFX_GPU_TIMER_LATENCY - 1 frames before the cpu numbers, and negative if it isn't known.
+typedef struct FrameTiming_t
+{
+   const char* name;
+   u32 index;
+   u32 count;
+   f64 cpu_ms;
+   f64 gpu_ms;
+
+} FrameTiming;
+
+typedef struct FrameStats_t
+{
+   u64 frame_index;
+   f64 cpu_frame_ms;
+   u32 visible_draws;
+   uS texture_memory; // everything the graphics module has allocated for textures, not just the budgeted ones
+   GraphicsStats counters;
+
+   u32 timing_count;
+   FrameTiming timings[RNDR_MAX_FRAME_TIMINGS];
+
+} FrameStats;
+
 typedef struct Renderer_t Renderer;
 
 typedef void (*DrawableFunc)(Renderer* renderer, Drawable self);
@@ -129,9 +178,21 @@ typedef struct DrawableTypeDesc_t
    DrawableFunc on_create_func;
    DrawableFunc on_remove_func;
    uS data_size;
+   bool skip_raycasts; // for things whose bounds aren't something you can hit, like a light's radius
 
 } DrawableTypeDesc;
 
+// return false to stop the query
+typedef bool (*DrawableQueryFunc)(Renderer* renderer, Drawable drawable, void* user_data);
+
+typedef struct RaycastHit_t
+{
+   Drawable drawable;
+   vec3 point;
+   f32 distance; // in units of the ray direction's length
+
+} RaycastHit;
+
 typedef struct ShaderDefines_t
 {
    u32 define_count;
@@ -170,6 +231,21 @@ typedef struct GeometryDrawable_t
 
 } GeometryDrawable;
 
+// set the mesh with Renderer_SetMeshletDrawableMesh, the buffers belong to the drawable and are freed with it.
+// every pass culls the meshlets on the gpu and rewrites the geometry's index buffer with the visible ones.
+typedef struct MeshletDrawable_t
+{
+   SurfaceMaterial material;
+   Geometry geometry;
+   Buffer meshlet_buffer;
+   Buffer index_buffer; // every meshlet's triangles as 32 bit vertex indices, what the culling copies from
+   Buffer draw_buffer; // indirect draw command the culling fills in
+   u32 meshlet_count;
+   color8 color;
+   Transform3D transform;
+
+} MeshletDrawable;
+
 static inline const char* Renderer_TextureSlotString(u32 slot_index)
 {
    const char* const texture_strings[MATERIAL_MAX_TEXTURES] = {
@@ -190,8 +266,22 @@ Renderer* Renderer_Init(Graphics* graphics, const char* app_path);
 void Renderer_Free(Renderer* renderer);
 
 Graphics* Renderer_GetGraphics(Renderer* renderer);
+// worker pool used to build draw lists. free to use for other work between passes.
+JobPool* Renderer_GetJobPool(Renderer* renderer);
 void Renderer_PreRender(Renderer* renderer);
 void Renderer_RenderPass(Renderer* renderer, res2D size, f64 engine_frame_delta, u32 pass_id);
+// call once after the last pass of a frame, this is where frame stats are collected.
+// Engine_Present already does this for the engine's renderer.
+void Renderer_EndFrame(Renderer* renderer);
+
+// profile scopes are off by default. names aren't copied, so use string literals.
+void Renderer_EnableProfiling(Renderer* renderer, bool enable_profiling);
+u32 Renderer_BeginProfileScope(Renderer* renderer, const char* name, u32 index);
+void Renderer_EndProfileScope(Renderer* renderer, u32 scope_id);
+// stats for the last frame finished with Renderer_EndFrame.
+FrameStats Renderer_GetFrameStats(Renderer* renderer);
+// writes one JSON object per line for every frame. a NULL path stops dumping.
+bool Renderer_SetFrameStatsDump(Renderer* renderer, const char* file_path);
 
 void Renderer_SetTexture(Renderer* renderer, Texture texture, u32 bind_slot);
 void Renderer_SetTextureToDefault(Renderer* renderer, u8 texture_default, u32 bind_slot);
@@ -208,6 +298,11 @@ void Renderer_SetFieldOfView(Renderer* renderer, f32 vertical_fov);
 void Renderer_SetClippingPlanes(Renderer* renderer, f32 near_clip, f32 far_clip);
 void Renderer_UpdateCamera(Renderer* renderer, vec3 origin, vec3 euler, f32 distance);
 
+// opt-in reverse-z with an infinite far plane, see Graphics_EnableReverseZ. the far clip is still used to size light clusters.
+// custom projection matrices must map to a [0, 1] clip range while this is enabled.
+bool Renderer_EnableReverseZ(Renderer* renderer, bool enable_reverse_z);
+bool Renderer_IsReverseZ(Renderer* renderer);
+
 f32 Renderer_GetFieldOfView(Renderer* renderer);
 f32 Renderer_GetNearClippingPlane(Renderer* renderer);
 f32 Renderer_GetFarClippingPlane(Renderer* renderer);
@@ -233,6 +328,30 @@ void Renderer_RemoveDrawable(Renderer* renderer, Drawable res_drawable);
 void Renderer_EnableDrawable(Renderer* renderer, Drawable res_drawable);
 void Renderer_DisableDrawable(Renderer* renderer, Drawable res_drawable);
 
+// bounds are in world space. drawables with zero sized bounds are never frustum culled and queries never find them.
+void Renderer_SetDrawableBounds(Renderer* renderer, Drawable res_drawable, BBox bounds);
+BBox Renderer_GetDrawableBounds(Renderer* renderer, Drawable res_drawable);
+bool Renderer_IsDrawableCulled(Renderer* renderer, Drawable res_drawable);
+
+// spatial queries over the enabled drawables' bounds. don't add, remove or move drawables from inside the callback.
+void Renderer_QueryBox(Renderer* renderer, BBox box, DrawableQueryFunc func, void* user_data);
+void Renderer_QuerySphere(Renderer* renderer, vec3 center, f32 radius, DrawableQueryFunc func, void* user_data);
+void Renderer_QueryFrustum(Renderer* renderer, Frustum frustum, DrawableQueryFunc func, void* user_data);
+// closest drawable whose bounds the ray hits within max_distance, returns false if there isn't one.
+// types registered with skip_raycasts are never hit.
+bool Renderer_Raycast(Renderer* renderer, vec3 origin, vec3 direction, f32 max_distance, RaycastHit* out_hit);
+// drawables that render but have no bounds. queries can't see them, so anything deciding a region is empty has to check this too.
+u32 Renderer_GetUnboundedDrawableCount(Renderer* renderer);
+
+// draws mesh.first_meshlet and mesh.meshlet_count of meshlets, or all of them if the mesh has none set (like a mesh that
+// went through Mesh_BuildMeshlets on its own). the meshlets have to be built from this mesh's vertices.
+// returns false and keeps the old mesh if it fails.
+bool Renderer_SetMeshletDrawableMesh(Renderer* renderer, Drawable res_drawable, Mesh mesh, MeshletData meshlets);
+// hi-z occlusion for meshlet drawables in pass_id. the pyramid is a GFX_TEXTUREFORMAT_R_F32 texture with the depth of an earlier frame or
+// pass in mip 0, reduced with GFX_MIPFILTER_DEPTH_MAX (DEPTH_MIN with reverse-z), and view_projection is what rendered it.
+// an invalid texture turns occlusion culling off again.
+void Renderer_SetOcclusionPyramid(Renderer* renderer, Texture pyramid, mat4x4 view_projection, u32 pass_id);
+
 // pointer to drawable data can be invalid when the drawable array gets reallocated!
 // best practice is to call one of these functions whenever you need to set or get drawable data.
 void* Renderer_GetDrawableData(Renderer* renderer, Drawable res_drawable);
@@ -260,9 +379,40 @@ void Renderer_SetLightManager(Renderer* renderer, LightManagerInfo lightmanager_
 bool Renderer_IsLightManagerValid(Renderer* renderer, const u64 desired_id);
 
 Texture Renderer_CreateColorTexture(Renderer* renderer, color8 color, u8 texture_type);
+// returns right away with a 1x1 placeholder in one of the RNDR_SURF_TEXTURE_* colors. the file is read and decoded on a
+// background thread, then Renderer_PreRender uploads its mips smallest first within the per-frame budget, so it sharpens as it streams in.
+Texture Renderer_StreamTexture(Renderer* renderer, const char* texture_file_path, bool is_srgb, u8 placeholder);
+void Renderer_SetTextureStreamingBudget(Renderer* renderer, uS bytes_per_frame);
+u32 Renderer_PendingTextureStreams(Renderer* renderer);
+// caps how much memory textures from Renderer_LoadTexture and Renderer_StreamTexture can take up, 0 (the default) means no cap.
+// when it's exceeded the least recently bound ones lose their top mips first, then get evicted down to a single texel.
+// either way they're streamed back in the next time they're bound.
+void Renderer_SetTextureBudget(Renderer* renderer, uS budget_bytes);
+uS Renderer_GetTextureMemory(Renderer* renderer);
 Texture Renderer_LoadTexture(Renderer* renderer, const char* texture_file_path, res2D slice_size, bool generate_mipmaps, bool is_srgb);
 Shader Renderer_LoadShader(Renderer* renderer, const char* shader_file_path, const char* defines[], const u32 defines_count, bool is_compute);
+// drawables using a surface whose shader is still compiling are skipped until it's ready
+Shader Renderer_LoadShaderAsync(Renderer* renderer, const char* shader_file_path, const char* defines[], const u32 defines_count, bool is_compute);
+// the model's .mat is compiled once and cached in the material cache directory, see Renderer_SetMaterialCacheDirectory.
 Model Renderer_LoadModel(Renderer* renderer, const char* model_file_path);
+// compiled materials are saved here, keyed by the model's path. starts out as "material_cache" next to the app, NULL turns it off.
+void Renderer_SetMaterialCacheDirectory(Renderer* renderer, const char* directory_path);
+
+// each (file, keyword set, flags) combination is only compiled once, asking again hands back the same shader (so don't free it).
+// keywords are define names (with an optional value after a space) and their order doesn't matter.
+// shader files can use #include "file.glsl", paths are relative to the including file and each file is only pasted in once.
+Shader Renderer_GetShaderVariant(Renderer* renderer, const char* shader_file_path, const char* keywords[], u32 keyword_count, u32 variant_flags);
+// anything that includes this file gets re-read the next time a variant of it is asked for.
+void Renderer_InvalidateShaderFile(Renderer* renderer, const char* shader_file_path);
+// every line of the manifest is a shader path followed by its keywords. "@compute" and "@lighting" set those flags and '#' starts a comment.
+// all of them are started asynchronously, returns how many variants were requested.
+u32 Renderer_PrewarmShaderVariants(Renderer* renderer, const char* manifest_file_path);
+
+// material params are copied into the material table and only uploaded again when they change.
+MaterialParams Renderer_AddMaterialParams(Renderer* renderer, void* params, uS size);
+void Renderer_UpdateMaterialParams(Renderer* renderer, MaterialParams res_params, void* params, uS size);
+void Renderer_RemoveMaterialParams(Renderer* renderer, MaterialParams res_params);
+Buffer Renderer_GetMaterialBuffer(Renderer* renderer);
 
 void Renderer_SetSurfaceMaterialTexture(SurfaceMaterial* material, i32 index, i32 bind_slot, Texture texture);
 void Renderer_SetSurfaceMaterialTextureAdvanced(SurfaceMaterial* material, i32 index, i32 bind_slot, Texture texture, TextureInterpolation interpolation_settings);
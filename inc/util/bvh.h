@@ -0,0 +1,46 @@
+#ifndef ECT_BVH_H
+#define ECT_BVH_H
+
+#include "util/types.h"
+#include "util/extra_types.h"
+
+#define BVH_NULL_PROXY INVALID_INDEX_U32
+
+// dynamic AABB tree. every proxy is a leaf with a box a little bigger than the bounds it was given (the margin),
+// so things that move a little don't touch the tree at all. inserts pick a sibling by surface area and refit the
+// ancestors with tree rotations, so it stays close to a good tree without ever needing a full rebuild.
+typedef struct BVH_t BVH;
+
+// return false to stop the query.
+typedef bool (*BVHQueryFunc)(void* user_data, u32 proxy_id, u64 proxy_data);
+// return the distance the ray should be clipped to: max_distance keeps going as is, a smaller one only looks for
+// closer hits from there on and 0 stops right away. negative ignores the proxy.
+typedef f32 (*BVHRayFunc)(void* user_data, u32 proxy_id, u64 proxy_data, vec3 origin, vec3 direction, f32 max_distance);
+
+BVH* Util_CreateBVH(f32 margin);
+void Util_FreeBVH(BVH* bvh);
+
+u32 Util_BVHCreateProxy(BVH* bvh, BBox bounds, u64 proxy_data);
+void Util_BVHDestroyProxy(BVH* bvh, u32 proxy_id);
+// returns true if the proxy had to be reinserted, bounds that still fit in its fat box leave the tree alone.
+bool Util_BVHMoveProxy(BVH* bvh, u32 proxy_id, BBox bounds);
+u64 Util_BVHProxyData(BVH* bvh, u32 proxy_id);
+BBox Util_BVHFatBounds(BVH* bvh, u32 proxy_id);
+
+u32 Util_BVHProxyCount(BVH* bvh);
+u32 Util_BVHHeight(BVH* bvh);
+// summed surface area of the internal nodes over the root's, lower is a better tree.
+f32 Util_BVHAreaRatio(BVH* bvh);
+
+// queries test the fat boxes, so callers that care about exact bounds have to check them again.
+// they only read the tree and can run on several threads at once, as long as nothing changes it in the meantime.
+void Util_BVHQueryBox(BVH* bvh, BBox box, BVHQueryFunc func, void* user_data);
+void Util_BVHQuerySphere(BVH* bvh, vec3 center, f32 radius, BVHQueryFunc func, void* user_data);
+void Util_BVHQueryFrustum(BVH* bvh, Frustum frustum, BVHQueryFunc func, void* user_data);
+// direction doesn't have to be normalized, distances are in units of its length.
+void Util_BVHRaycast(BVH* bvh, vec3 origin, vec3 direction, f32 max_distance, BVHRayFunc func, void* user_data);
+
+// slab test, returns the distance to where the ray enters the box (0 if it starts inside) or a negative number on a miss.
+f32 Util_RayBBoxDistance(vec3 origin, vec3 direction, f32 max_distance, BBox bbox);
+
+#endif
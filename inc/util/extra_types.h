@@ -28,6 +28,12 @@ typedef struct Transform3D_t
    vec3 scale;
 } Transform3D;
 
+// planes are stored as (normal, distance), normals point inward.
+typedef struct Frustum_t
+{
+   vec4 planes[6];
+} Frustum;
+
 static inline color8 Util_MakeRGBE(vec3 hdr_color)
 {
    i32 e = 0;
@@ -165,6 +171,82 @@ static inline bool Util_ContainsBBoxPoint(BBox bbox, vec3 point)
    return (diff.x <= 0) && (diff.y <= 0) && (diff.z <= 0);
 }
 
+static inline BBox Util_TransformBBox(BBox bbox, mat4x4 matrix)
+{
+   mat3x3 basis = { 0 };
+   basis.v[0] = matrix.v[0].xyz;
+   basis.v[1] = matrix.v[1].xyz;
+   basis.v[2] = matrix.v[2].xyz;
+
+   bbox = Util_ResizeBBox(bbox, basis);
+   bbox.center = Util_MulMat4Vec4(matrix, (vec4){ .xyz = bbox.center, .w = 1.0f }).xyz;
+
+   return bbox;
+}
+
+// works for any matrix that goes to clip space, normally a view-projection matrix.
+static inline Frustum Util_FrustumFromMatrix(mat4x4 matrix)
+{
+   vec4 row[4] = { 0 };
+   for (u32 row_i = 0; row_i < 4; row_i++)
+      row[row_i] = VEC4(matrix.m[0][row_i], matrix.m[1][row_i], matrix.m[2][row_i], matrix.m[3][row_i]);
+
+   Frustum frustum = { 0 };
+   frustum.planes[0] = Util_AddVec4(row[3], row[0]);
+   frustum.planes[1] = Util_SubVec4(row[3], row[0]);
+   frustum.planes[2] = Util_AddVec4(row[3], row[1]);
+   frustum.planes[3] = Util_SubVec4(row[3], row[1]);
+   frustum.planes[4] = Util_AddVec4(row[3], row[2]);
+   frustum.planes[5] = Util_SubVec4(row[3], row[2]);
+
+   for (u32 plane_i = 0; plane_i < 6; plane_i++)
+   {
+      f32 length = Util_MagVec3(frustum.planes[plane_i].xyz);
+      frustum.planes[plane_i] = Util_ScaleVec4(frustum.planes[plane_i], M_RCP(length, M_FLOAT_FUZZ));
+
+   }
+
+   return frustum;
+}
+
+// same as above for a [0, 1] clip range. an infinite far plane comes out as an empty plane that never culls.
+static inline Frustum Util_FrustumFromMatrixZeroToOne(mat4x4 matrix)
+{
+   Frustum frustum = Util_FrustumFromMatrix(matrix);
+
+   vec4 row[2] = { 0 };
+   for (u32 row_i = 0; row_i < 2; row_i++)
+      row[row_i] = VEC4(matrix.m[0][row_i + 2], matrix.m[1][row_i + 2], matrix.m[2][row_i + 2], matrix.m[3][row_i + 2]);
+
+   frustum.planes[4] = row[0];
+   frustum.planes[5] = Util_SubVec4(row[1], row[0]);
+
+   for (u32 plane_i = 4; plane_i < 6; plane_i++)
+   {
+      f32 length = Util_MagVec3(frustum.planes[plane_i].xyz);
+      frustum.planes[plane_i] = Util_ScaleVec4(frustum.planes[plane_i], M_RCP(length, M_FLOAT_FUZZ));
+
+   }
+
+   return frustum;
+}
+
+static inline bool Util_FrustumOverlapBBox(Frustum frustum, BBox bbox)
+{
+   for (u32 plane_i = 0; plane_i < 6; plane_i++)
+   {
+      vec4 plane = frustum.planes[plane_i];
+      f32 distance = Util_DotVec3(plane.xyz, bbox.center) + plane.w;
+      f32 radius = Util_DotVec3(Util_AbsVec3(plane.xyz), bbox.extents);
+
+      if (distance + radius < 0.0f)
+         return false;
+
+   }
+
+   return true;
+}
+
 static inline Transform3D Util_IdentityTransform(void)
 {
    return (Transform3D){
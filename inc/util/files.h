@@ -8,13 +8,37 @@
 
 #define PATH_CHARACTER_LIMIT 4096
 
+// a file mapped straight into memory, pages are only read in once they're touched. the mapping is copy-on-write,
+// so writes are fine but they never reach the file. has to go back through Util_UnmapFile, not free.
+typedef struct MmapBlob_t
+{
+   void* data;
+   uS size;
+
+} MmapBlob;
+
 char* Util_ReplaceFileExtension(const char* file_path, const char* extension);
 // will remove the top part of the base path, as it is assumed to be a file.
 // just add a slash at the end if it's a directory and this won't be an issue.
+// a base path with no directory in it gives a path relative to the working directory.
 // NOTE: this allocates memory. remember to free!!!!
 char* Util_MakeFilePath(const char* base_path, const char* file_name);
+// copies the directory with a slash on the end, so it can be handed to Util_MakeFilePath as a base path.
+// NOTE: this allocates memory. remember to free!!!!
+char* Util_MakeDirectoryPath(const char* directory_path);
 memblob Util_LoadFileIntoMemory(const char* file_path, bool read_as_binary);
+MmapBlob Util_MapFile(const char* file_path);
+void Util_UnmapFile(MmapBlob* mapping);
 memblob Util_LoadFileFromBasePath(const char* base_path, const char* file_name, bool read_as_binary);
+// writes the whole blob, replacing the file if it exists. returns false if any of it couldn't be written.
+bool Util_SaveMemoryToFile(const char* file_path, memblob memory);
+// creates a single directory, returns true if it exists afterwards.
+bool Util_MakeDirectory(const char* directory_path);
+
+#define UTIL_HASH_SEED 0xcbf29ce484222325ull
+
+// FNV-1a. pass the previous result as the seed to hash several pieces of data together.
+u64 Util_HashBytes(const void* data, uS size, u64 seed);
 
 // NOTE: allocates new memory for result
 memblob Util_PrependShaderDefines(memblob shader_data, const char* defines[], const u32 define_count, const char* extra);
@@ -0,0 +1,50 @@
+#ifndef ECT_JOBS_H
+#define ECT_JOBS_H
+
+#include "util/types.h"
+
+#define JOBS_MODULE "Jobs"
+
+#define JOBS_MAX_WORKERS 64
+#define JOBS_DEFAULT_GRAIN_SIZE 64u
+
+enum {
+   ERR_JOBS_OUT_OF_MEMORY = 1,
+   ERR_JOBS_THREAD_CREATE_FAILED
+
+};
+
+typedef struct JobPool_t JobPool;
+typedef struct JobQueue_t JobQueue;
+
+// called for every chunk of a parallel-for with the half-open range [start, end).
+// worker_id is always less than Util_JobPoolWorkerCount(), so it can index per-worker scratch memory.
+// the thread that called Util_ParallelFor is always worker 0.
+typedef void (*ParallelForFunc)(void* user_data, u32 start, u32 end, u32 worker_id);
+typedef void (*JobFunc)(void* user_data);
+
+u32 Util_LogicalCoreCount(void);
+// monotonic clock in seconds, only useful for measuring intervals.
+f64 Util_MonotonicTime(void);
+
+// worker_count of 0 uses one worker per logical core. the calling thread counts as a worker.
+JobPool* Util_CreateJobPool(u32 worker_count);
+void Util_FreeJobPool(JobPool* pool);
+u32 Util_JobPoolWorkerCount(JobPool* pool);
+
+// blocks until every index in [0, count) has been processed.
+// ranges are split in half until they're no bigger than grain_size, idle workers steal the halves.
+// a NULL pool, or a call made from inside another parallel-for on the same pool, just runs the whole range on the calling thread.
+// calls from other threads wait until the pool is free, one parallel-for owns the worker slots at a time.
+void Util_ParallelFor(JobPool* pool, u32 count, u32 grain_size, ParallelForFunc func, void* user_data);
+
+// background threads pulling jobs off a fifo, for work the caller doesn't want to wait on (like loading files).
+// nothing here touches the caller's thread, so jobs have to hand their results back themselves.
+JobQueue* Util_CreateJobQueue(u32 thread_count);
+// waits for the jobs that are already running, anything still queued is dropped without being called.
+void Util_FreeJobQueue(JobQueue* queue);
+// blocks until every job pushed so far has finished.
+void Util_WaitJobQueue(JobQueue* queue);
+bool Util_PushJob(JobQueue* queue, JobFunc func, void* user_data);
+
+#endif
@@ -272,6 +272,37 @@ static inline mat4x4 Util_PerspectiveMatrix(f32 fov, f32 aspect_ratio, f32 near,
    );
 }
 
+// for a [0, 1] clip range (glClipControl), near maps to depth 1 and far to depth 0.
+static inline mat4x4 Util_ReverseZPerspectiveMatrix(f32 fov, f32 aspect_ratio, f32 near, f32 far)
+{
+   f32 R = 1.0f / (far - near);
+   f32 Y = 1.0f / M_TAN(fov * 0.5f);
+   f32 X = Y * aspect_ratio;
+   f32 a = near * R;
+   f32 b = (near * far) * R;
+
+   return MAT4(
+      X, 0, 0, 0,
+      0, Y, 0, 0,
+      0, 0, a,-1,
+      0, 0, b, 0
+   );
+}
+
+// same as above with the far plane pushed out to infinity.
+static inline mat4x4 Util_InfiniteReverseZPerspectiveMatrix(f32 fov, f32 aspect_ratio, f32 near)
+{
+   f32 Y = 1.0f / M_TAN(fov * 0.5f);
+   f32 X = Y * aspect_ratio;
+
+   return MAT4(
+      X, 0, 0, 0,
+      0, Y, 0, 0,
+      0, 0, 0,-1,
+      0, 0, near, 0
+   );
+}
+
 static inline mat4x4 Util_InversePerspectiveMatrix(mat4x4 perspective_matrix)
 {
    mat4x4 res = { 0 };
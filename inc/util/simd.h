@@ -0,0 +1,97 @@
+#ifndef ECT_SIMD_H
+#define ECT_SIMD_H
+
+#include "util/types.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+// 4 f32 lanes. sse2 and neon are part of the base instruction set on x86-64 and arm64, so they don't need their own
+// build flags. anything else gets a plain loop over 4 lanes that the compiler can still vectorize on its own
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+   #include <emmintrin.h>
+
+   typedef __m128 f32x4;
+
+   #define Util_Load4(ptr) _mm_loadu_ps(ptr)
+   #define Util_Store4(ptr, a) _mm_storeu_ps(ptr, a)
+   #define Util_Set4(x, y, z, w) _mm_setr_ps(x, y, z, w)
+   #define Util_Splat4(x) _mm_set1_ps(x)
+   #define Util_Add4(a, b) _mm_add_ps(a, b)
+   #define Util_Sub4(a, b) _mm_sub_ps(a, b)
+   #define Util_Mul4(a, b) _mm_mul_ps(a, b)
+   #define Util_Div4(a, b) _mm_div_ps(a, b)
+   #define Util_Min4(a, b) _mm_min_ps(a, b)
+   #define Util_Max4(a, b) _mm_max_ps(a, b)
+   #define Util_AnyLess4(a, b) (_mm_movemask_ps(_mm_cmplt_ps(a, b)) != 0)
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+   #include <arm_neon.h>
+
+   typedef float32x4_t f32x4;
+
+   #define Util_Load4(ptr) vld1q_f32(ptr)
+   #define Util_Store4(ptr, a) vst1q_f32(ptr, a)
+   #define Util_Set4(x, y, z, w) vld1q_f32((const f32[4]){ x, y, z, w })
+   #define Util_Splat4(x) vdupq_n_f32(x)
+   #define Util_Add4(a, b) vaddq_f32(a, b)
+   #define Util_Sub4(a, b) vsubq_f32(a, b)
+   #define Util_Mul4(a, b) vmulq_f32(a, b)
+   #define Util_Div4(a, b) vdivq_f32(a, b)
+   #define Util_Min4(a, b) vminq_f32(a, b)
+   #define Util_Max4(a, b) vmaxq_f32(a, b)
+   #define Util_AnyLess4(a, b) (vmaxvq_u32(vcltq_f32(a, b)) != 0)
+
+#else
+   typedef struct f32x4_t { f32 lane[4]; } f32x4;
+
+   // functions rather than macros, nested calls would otherwise split on the commas inside the compound literals
+   #define UTIL_LANEWISE4(name, expr) \
+      static inline f32x4 name(f32x4 a, f32x4 b) \
+      { \
+         f32x4 res; \
+         for (u32 lane_i = 0; lane_i < 4; lane_i++) \
+         { \
+            f32 x = a.lane[lane_i], y = b.lane[lane_i]; \
+            res.lane[lane_i] = (expr); \
+         } \
+         return res; \
+      }
+
+   UTIL_LANEWISE4(Util_Add4, x + y)
+   UTIL_LANEWISE4(Util_Sub4, x - y)
+   UTIL_LANEWISE4(Util_Mul4, x * y)
+   UTIL_LANEWISE4(Util_Div4, x / y)
+   UTIL_LANEWISE4(Util_Min4, (x < y) ? x : y)
+   UTIL_LANEWISE4(Util_Max4, (x > y) ? x : y)
+
+   #undef UTIL_LANEWISE4
+
+   static inline f32x4 Util_Load4(const f32* ptr)
+   {
+      return (f32x4){ { ptr[0], ptr[1], ptr[2], ptr[3] } };
+   }
+
+   static inline void Util_Store4(f32* ptr, f32x4 a)
+   {
+      memcpy(ptr, a.lane, sizeof(f32) * 4);
+   }
+
+   static inline f32x4 Util_Set4(f32 x, f32 y, f32 z, f32 w)
+   {
+      return (f32x4){ { x, y, z, w } };
+   }
+
+   static inline f32x4 Util_Splat4(f32 x)
+   {
+      return (f32x4){ { x, x, x, x } };
+   }
+
+   static inline bool Util_AnyLess4(f32x4 a, f32x4 b)
+   {
+      return (a.lane[0] < b.lane[0]) || (a.lane[1] < b.lane[1]) || (a.lane[2] < b.lane[2]) || (a.lane[3] < b.lane[3]);
+   }
+
+#endif
+
+#endif
@@ -0,0 +1,178 @@
+#include "util/types.h"
+#include "util/array.h"
+#include "util/files.h"
+#include "util/jobs.h"
+#include "image.h"
+#include "graphics.h"
+
+#include "engine.h"
+#include "engine/internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct eng_FrameWrite_t
+{
+   char* file_path;
+   Image image;
+
+} eng_FrameWrite;
+
+static void ENG_WriteFrameJob(void* user_data)
+{
+   eng_FrameWrite* frame_write = (eng_FrameWrite*)user_data;
+
+   memblob file_data = Image_SaveTGA(&frame_write->image, true);
+   if (file_data.data == NULL || !Util_SaveMemoryToFile(frame_write->file_path, file_data))
+   {
+      error err = { 0 };
+      err.general = ERR_LEVEL_WARN;
+
+      Util_Log(NULL, ENGINE_LOG_NAME, err, "Couldn't write frame to '%s'", frame_write->file_path);
+
+   }
+
+   free(file_data.data);
+   free(frame_write->image.data);
+   free(frame_write->file_path);
+   free(frame_write);
+
+}
+
+// copies a finished readback out of the mapped buffer and hands it to the writer threads
+static void ENG_WriteDumpedFrame(Engine* engine, Graphics* graphics, eng_DumpedFrame frame)
+{
+   eng_FrameDump* frame_dump = &engine->internal.frame_dump;
+
+   Image mapped = Graphics_MapReadback(graphics, frame.readback);
+   eng_FrameWrite* frame_write = calloc(1, sizeof(eng_FrameWrite));
+
+   if (mapped.data != NULL && frame_write != NULL)
+   {
+      uS image_size = Image_MipSize(&mapped, 0);
+      char file_name[64] = { 0 };
+      snprintf(file_name, sizeof(file_name), "frame_%06llu.tga", (unsigned long long)frame.frame_index);
+
+      frame_write->file_path = Util_MakeFilePath(frame_dump->directory, file_name);
+      frame_write->image = mapped;
+      frame_write->image.data = malloc(image_size);
+
+      if (frame_write->image.data != NULL)
+         memcpy(frame_write->image.data, mapped.data, image_size);
+
+   }
+
+   Graphics_ReleaseReadback(graphics, frame.readback);
+
+   if (frame_write == NULL)
+      return;
+
+   if (frame_write->file_path == NULL || frame_write->image.data == NULL || !Util_PushJob(frame_dump->queue, ENG_WriteFrameJob, frame_write))
+   {
+      free(frame_write->image.data);
+      free(frame_write->file_path);
+      free(frame_write);
+
+      frame_dump->dropped_count++;
+
+   }
+
+}
+
+void ENG_InitFrameDump(Engine* engine, const char* directory)
+{
+   eng_FrameDump* frame_dump = &engine->internal.frame_dump;
+   (*frame_dump) = (eng_FrameDump){ 0 };
+
+   if (directory == NULL || !Util_MakeDirectory(directory))
+      return;
+
+   frame_dump->directory = Util_MakeDirectoryPath(directory);
+   if (frame_dump->directory == NULL)
+      return;
+
+   frame_dump->queue = Util_CreateJobQueue(ENG_FRAME_DUMP_THREADS);
+   frame_dump->pending = NEW_ARRAY_N(eng_DumpedFrame, GFX_MAX_READBACKS);
+
+}
+
+void ENG_DumpFrame(Engine* engine)
+{
+   eng_FrameDump* frame_dump = &engine->internal.frame_dump;
+   if (frame_dump->directory == NULL || frame_dump->queue == NULL)
+      return;
+
+   Graphics* graphics = Engine_FetchModule(engine, GRAPHICS_MODULE);
+   if (graphics == NULL)
+      return;
+
+   // frames finish in order, so stop at the first one the gpu hasn't gotten to yet
+   while (Util_ArrayLength(frame_dump->pending) > 0)
+   {
+      eng_DumpedFrame frame = frame_dump->pending[0];
+      if (Graphics_GetReadbackStatus(graphics, frame.readback) == GFX_READBACKSTATUS_PENDING)
+         break;
+
+      ENG_WriteDumpedFrame(engine, graphics, frame);
+      POP_FRONT_ARRAY(frame_dump->pending);
+
+   }
+
+   eng_DumpedFrame frame = { 0 };
+   frame.frame_index = frame_dump->frame_index++;
+   frame.readback = Graphics_RequestFramebufferReadback(graphics, NULLHANDLE, 0, engine->internal.frame_size);
+
+   if (frame.readback.id == INVALID_HANDLE_ID)
+   {
+      frame_dump->dropped_count++;
+
+      return;
+   }
+
+   ADD_BACK_ARRAY(frame_dump->pending, frame);
+
+}
+
+void ENG_FreeFrameDump(Engine* engine)
+{
+   eng_FrameDump* frame_dump = &engine->internal.frame_dump;
+   if (frame_dump->directory == NULL)
+      return;
+
+   // has to run while graphics is still around. it's shutdown, so waiting on the last few frames is fine
+   Graphics* graphics = Engine_FetchModule(engine, GRAPHICS_MODULE);
+   for (u32 frame_i = 0; graphics != NULL && frame_i < Util_ArrayLength(frame_dump->pending); frame_i++)
+   {
+      eng_DumpedFrame frame = frame_dump->pending[frame_i];
+
+      // sleeps on the fence instead of polling it, a frame the gpu still hasn't finished by then is counted as dropped
+      if (Graphics_WaitReadback(graphics, frame.readback, ENG_FRAME_DUMP_WAIT_NS) == GFX_READBACKSTATUS_PENDING)
+      {
+         Graphics_ReleaseReadback(graphics, frame.readback);
+         frame_dump->dropped_count++;
+
+         continue;
+      }
+
+      ENG_WriteDumpedFrame(engine, graphics, frame);
+
+   }
+
+   Util_WaitJobQueue(frame_dump->queue);
+   Util_FreeJobQueue(frame_dump->queue);
+
+   if (frame_dump->dropped_count > 0)
+   {
+      error err = { 0 };
+      err.general = ERR_LEVEL_WARN;
+
+      Util_Log(NULL, ENGINE_LOG_NAME, err, "Frame dump dropped %u of %llu frames", frame_dump->dropped_count, (unsigned long long)frame_dump->frame_index);
+
+   }
+
+   FREE_ARRAY(frame_dump->pending);
+   free(frame_dump->directory);
+   (*frame_dump) = (eng_FrameDump){ 0 };
+
+}
@@ -0,0 +1,198 @@
+#include "util/types.h"
+#include "util/jobs.h"
+
+#include "engine.h"
+#include "engine/internal.h"
+
+#if defined(ECTOR_HAS_EGL)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#if defined(ECTOR_HAS_OSMESA)
+#include <GL/osmesa.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+// GL function pointers are global anyway, so the loader just needs to know which library made the context
+static u8 eng_headless_backend = ENG_HEADLESS_AUTO;
+
+#if defined(ECTOR_HAS_EGL)
+static bool ENG_CreateEGLContext(eng_Headless* headless, res2D size)
+{
+   EGLDisplay display = EGL_NO_DISPLAY;
+
+   // the surfaceless platform doesn't need a display server, and mesa runs llvmpipe on it when there's no gpu
+   const char* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+   PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+   if (get_platform_display != NULL && client_extensions != NULL && strstr(client_extensions, "EGL_MESA_platform_surfaceless") != NULL)
+      display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+
+   if (display == EGL_NO_DISPLAY)
+      display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+   if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL))
+      return false;
+
+   const EGLint config_attribs[] = {
+      EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+      EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+      EGL_RED_SIZE, 8,
+      EGL_GREEN_SIZE, 8,
+      EGL_BLUE_SIZE, 8,
+      EGL_ALPHA_SIZE, 8,
+      EGL_DEPTH_SIZE, 24,
+      EGL_STENCIL_SIZE, 8,
+      EGL_NONE
+   };
+
+   EGLConfig config = NULL;
+   EGLint config_count = 0;
+   if (!eglBindAPI(EGL_OPENGL_API) || !eglChooseConfig(display, config_attribs, &config, 1, &config_count) || config_count == 0)
+   {
+      eglTerminate(display);
+
+      return false;
+   }
+
+   // same context the window gets from glfw
+   const EGLint context_attribs[] = {
+      EGL_CONTEXT_MAJOR_VERSION, 4,
+      EGL_CONTEXT_MINOR_VERSION, 3,
+      EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+      EGL_CONTEXT_OPENGL_FORWARD_COMPATIBLE, EGL_TRUE,
+      EGL_NONE
+   };
+
+   const EGLint surface_attribs[] = {
+      EGL_WIDTH, size.width,
+      EGL_HEIGHT, size.height,
+      EGL_NONE
+   };
+
+   EGLSurface surface = eglCreatePbufferSurface(display, config, surface_attribs);
+   EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs);
+
+   if (surface == EGL_NO_SURFACE || context == EGL_NO_CONTEXT || !eglMakeCurrent(display, surface, surface, context))
+   {
+      if (context != EGL_NO_CONTEXT)
+         eglDestroyContext(display, context);
+
+      if (surface != EGL_NO_SURFACE)
+         eglDestroySurface(display, surface);
+
+      eglTerminate(display);
+
+      return false;
+   }
+
+   headless->display = display;
+   headless->surface = surface;
+   headless->context = context;
+
+   return true;
+}
+#endif
+
+#if defined(ECTOR_HAS_OSMESA)
+static bool ENG_CreateOSMesaContext(eng_Headless* headless, res2D size)
+{
+   const int context_attribs[] = {
+      OSMESA_FORMAT, OSMESA_RGBA,
+      OSMESA_DEPTH_BITS, 24,
+      OSMESA_STENCIL_BITS, 8,
+      OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+      OSMESA_CONTEXT_MAJOR_VERSION, 4,
+      OSMESA_CONTEXT_MINOR_VERSION, 3,
+      0
+   };
+
+   OSMesaContext context = OSMesaCreateContextAttribs(context_attribs, NULL);
+   if (context == NULL)
+      return false;
+
+   u8* color_buffer = malloc((uS)size.width * (uS)size.height * 4);
+   if (color_buffer == NULL || !OSMesaMakeCurrent(context, color_buffer, GL_UNSIGNED_BYTE, size.width, size.height))
+   {
+      free(color_buffer);
+      OSMesaDestroyContext(context);
+
+      return false;
+   }
+
+   headless->context = context;
+   headless->color_buffer = color_buffer;
+
+   return true;
+}
+#endif
+
+bool ENG_CreateHeadlessContext(eng_Headless* headless, res2D size, u8 backend)
+{
+   (*headless) = (eng_Headless){ 0 };
+   headless->start_time = Util_MonotonicTime();
+
+#if defined(ECTOR_HAS_EGL)
+   if ((backend == ENG_HEADLESS_AUTO || backend == ENG_HEADLESS_EGL) && ENG_CreateEGLContext(headless, size))
+      headless->backend = ENG_HEADLESS_EGL;
+#endif
+
+#if defined(ECTOR_HAS_OSMESA)
+   if (headless->backend == ENG_HEADLESS_AUTO && (backend == ENG_HEADLESS_AUTO || backend == ENG_HEADLESS_OSMESA) && ENG_CreateOSMesaContext(headless, size))
+      headless->backend = ENG_HEADLESS_OSMESA;
+#endif
+
+   headless->is_created = (headless->backend != ENG_HEADLESS_AUTO);
+   eng_headless_backend = headless->backend;
+
+   return headless->is_created;
+}
+
+void ENG_FreeHeadlessContext(eng_Headless* headless)
+{
+   if (!headless->is_created)
+      return;
+
+#if defined(ECTOR_HAS_EGL)
+   if (headless->backend == ENG_HEADLESS_EGL)
+   {
+      eglMakeCurrent((EGLDisplay)headless->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+      eglDestroyContext((EGLDisplay)headless->display, (EGLContext)headless->context);
+      eglDestroySurface((EGLDisplay)headless->display, (EGLSurface)headless->surface);
+      eglTerminate((EGLDisplay)headless->display);
+
+   }
+#endif
+
+#if defined(ECTOR_HAS_OSMESA)
+   if (headless->backend == ENG_HEADLESS_OSMESA)
+   {
+      OSMesaDestroyContext((OSMesaContext)headless->context);
+      free(headless->color_buffer);
+
+   }
+#endif
+
+   (*headless) = (eng_Headless){ 0 };
+   eng_headless_backend = ENG_HEADLESS_AUTO;
+
+}
+
+void* ENG_HeadlessLoad(const char* proc_name)
+{
+#if defined(ECTOR_HAS_EGL)
+   if (eng_headless_backend == ENG_HEADLESS_EGL)
+      return (void*)eglGetProcAddress(proc_name);
+#endif
+
+#if defined(ECTOR_HAS_OSMESA)
+   if (eng_headless_backend == ENG_HEADLESS_OSMESA)
+      return (void*)OSMesaGetProcAddress(proc_name);
+#endif
+
+   (void)proc_name;
+
+   return NULL;
+}
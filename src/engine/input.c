@@ -99,7 +99,9 @@ void Engine_SetRawMouseInput(Engine* engine, bool raw_mouse_input)
       return;
 
    eng_EngineGlobal eng_glb = engine->internal;
-   
+   if (eng_glb.window == NULL)
+      return;
+
    if (glfwRawMouseMotionSupported())
    {
       glfwSetInputMode(
@@ -118,6 +120,8 @@ void Engine_SetMouseMode(Engine* engine, MouseMode mouse_mode)
       return;
 
    eng_EngineGlobal* eng_glb = &engine->internal;
+   if (eng_glb->window == NULL)
+      return;
 
    glfwSetInputMode(eng_glb->window, GLFW_CURSOR, GLFW_CURSOR_NORMAL + mouse_mode);
 
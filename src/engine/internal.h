@@ -5,6 +5,8 @@
 #include "util/keymap.h"
 
 #include "engine.h"
+#include "graphics.h"
+#include "util/jobs.h"
 
 #define GLFW_INCLUDE_NONE
 
@@ -16,6 +18,38 @@
 
 #define ENGINE_LOG_NAME "Engine"
 
+#define ENG_FRAME_DUMP_THREADS 2u
+#define ENG_FRAME_DUMP_WAIT_NS 1000000000ull
+
+typedef struct eng_Headless_t
+{
+   void* display;
+   void* surface;
+   void* context;
+   u8* color_buffer; // osmesa draws straight into this
+   f64 start_time;
+   u8 backend;
+   bool is_created;
+
+} eng_Headless;
+
+typedef struct eng_DumpedFrame_t
+{
+   Readback readback;
+   u64 frame_index;
+
+} eng_DumpedFrame;
+
+typedef struct eng_FrameDump_t
+{
+   char* directory;
+   JobQueue* queue;
+   eng_DumpedFrame* pending; // oldest first
+   u64 frame_index;
+   u32 dropped_count;
+
+} eng_FrameDump;
+
 typedef struct eng_EngineGlobal_t
 {
    struct {
@@ -40,7 +74,9 @@ typedef struct eng_EngineGlobal_t
 
    } input;
 
-   GLFWwindow* window;
+   GLFWwindow* window; // NULL when headless
+   eng_Headless headless;
+   eng_FrameDump frame_dump;
    f64 up_time;
    f64 frame_delta;
    res2D frame_size;
@@ -70,6 +106,14 @@ struct Engine_t
 
 };
 
+bool ENG_CreateHeadlessContext(eng_Headless* headless, res2D size, u8 backend);
+void ENG_FreeHeadlessContext(eng_Headless* headless);
+void* ENG_HeadlessLoad(const char* proc_name);
+
+void ENG_InitFrameDump(Engine* engine, const char* directory);
+void ENG_DumpFrame(Engine* engine);
+void ENG_FreeFrameDump(Engine* engine);
+
 void ENG_FramebufferSizeCallback(GLFWwindow* window, i32 width, i32 height);
 static void ENG_CursorCallback(GLFWwindow* window, f64 x, f64 y);
 void ENG_ScrollCallback(GLFWwindow* window, f64 x, f64 y);
@@ -3,6 +3,7 @@
 #include "util/array.h"
 #include "util/keymap.h"
 #include "util/files.h"
+#include "util/jobs.h"
 
 #include "engine.h"
 #include "engine/internal.h"
@@ -15,22 +16,13 @@
 
 // static eng_EngineGlobal* ENGINE_G;
 
-Engine* Engine_Init(i32 argc, char* argv[], const EngineDesc* desc)
+static void* ENG_GLFWLoad(const char* proc_name)
 {
-   const char* app_name = "Ector App";
-   const char* window_title = app_name;
-   i32 width = 1920;
-   i32 height = 1080;
-
-   if (desc != NULL)
-   {
-      app_name = (desc->app_name != NULL) ? desc->app_name : app_name;
-      window_title = (desc->window.title != NULL) ? desc->window.title : app_name;
-      width = (desc->window.size.width > 0) ? desc->window.size.width : width;
-      height = (desc->window.size.height > 0) ? desc->window.size.height : height;
-
-   }
+   return (void*)glfwGetProcAddress(proc_name);
+}
 
+static GLFWwindow* ENG_CreateWindow(i32 width, i32 height, const char* window_title, bool is_hidden)
+{
    if (!glfwInit())
    {
       error err = { 0 };
@@ -46,7 +38,7 @@ Engine* Engine_Init(i32 argc, char* argv[], const EngineDesc* desc)
    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-   if (desc->window.hidden)
+   if (is_hidden)
       glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
    GLFWwindow* window = glfwCreateWindow(width, height, window_title, NULL, NULL);
@@ -65,6 +57,45 @@ Engine* Engine_Init(i32 argc, char* argv[], const EngineDesc* desc)
 
    glfwMakeContextCurrent(window);
 
+   return window;
+}
+
+Engine* Engine_Init(i32 argc, char* argv[], const EngineDesc* desc)
+{
+   const char* app_name = "Ector App";
+   const char* window_title = app_name;
+   i32 width = 1920;
+   i32 height = 1080;
+
+   if (desc != NULL)
+   {
+      app_name = (desc->app_name != NULL) ? desc->app_name : app_name;
+      window_title = (desc->window.title != NULL) ? desc->window.title : app_name;
+      width = (desc->window.size.width > 0) ? desc->window.size.width : width;
+      height = (desc->window.size.height > 0) ? desc->window.size.height : height;
+
+   }
+
+   bool is_headless = (desc != NULL && desc->headless.enabled);
+   GLFWwindow* window = NULL;
+   eng_Headless headless = { 0 };
+
+   if (is_headless)
+   {
+      if (!ENG_CreateHeadlessContext(&headless, (res2D){ width, height }, desc->headless.backend))
+      {
+         error err = { 0 };
+         err.general = ERR_LEVEL_FATAL;
+         err.extra = ERR_ENG_INIT_FAILED;
+         err.flags |= ERR_FLAG_HEADLESS_CONTEXT_FAILED;
+
+         Util_Log(NULL, ENGINE_LOG_NAME, err, "Headless context creation failed!");
+
+      }
+
+   } else
+      window = ENG_CreateWindow(width, height, window_title, (desc != NULL && desc->window.hidden));
+
    Engine* engine = malloc(sizeof(Engine));
    if (engine == NULL)
    {
@@ -87,6 +118,19 @@ Engine* Engine_Init(i32 argc, char* argv[], const EngineDesc* desc)
    engine->internal = (eng_EngineGlobal){ 0 };
    engine->internal.up_time = 0.0;
    engine->internal.window = window;
+   engine->internal.headless = headless;
+
+   if (desc != NULL)
+      ENG_InitFrameDump(engine, desc->frame_dump.directory);
+
+   // offscreen surfaces never change size, and there's nothing to take input from
+   if (window == NULL)
+   {
+      engine->internal.frame_size = (res2D){ width, height };
+
+      return engine;
+   }
+
    glfwSetWindowUserPointer(window, &engine->internal);
 
    glfwGetFramebufferSize(window,
@@ -116,6 +160,8 @@ void Engine_Free(Engine* engine)
    if (engine == NULL)
       return;
 
+   ENG_FreeFrameDump(engine);
+
    u32 module_count = Util_ArrayLength(engine->modules);
    for (u32 i = 0; i < module_count; i++)
    {
@@ -133,6 +179,7 @@ void Engine_Free(Engine* engine)
    FREE_ARRAY(engine->modules);
    FREE_ARRAY(engine->internal.input.keyboard.text_buffer);
 
+   ENG_FreeHeadlessContext(&engine->internal.headless);
    glfwTerminate();
    free(engine);
 
@@ -167,10 +214,13 @@ bool Engine_CheckExitConditions(Engine* engine)
       eng_glb->input.mouse.button_state[button].was_down = eng_glb->input.mouse.button_state[button].is_down;
    }
 
-   f64 new_time = glfwGetTime();
+   f64 new_time = (eng_glb->window != NULL) ? glfwGetTime() : Util_MonotonicTime() - eng_glb->headless.start_time;
    eng_glb->frame_delta = new_time - eng_glb->up_time;
    eng_glb->up_time = new_time;
 
+   if (eng_glb->window == NULL)
+      return engine->exit_requested;
+
    glfwPollEvents();
 
    return (glfwWindowShouldClose(eng_glb->window) || engine->exit_requested);
@@ -249,8 +299,25 @@ void Engine_SetWindowTitle(Engine* engine, const char* window_title)
    eng_EngineGlobal eng_glb = engine->internal;
 
    engine->window_title = window_title;
-   glfwSetWindowTitle(eng_glb.window, engine->window_title);
+   if (eng_glb.window != NULL)
+      glfwSetWindowTitle(eng_glb.window, engine->window_title);
+
+}
+
+bool Engine_IsHeadless(Engine* engine)
+{
+   if (engine == NULL)
+      return false;
+
+   return (engine->internal.window == NULL);
+}
+
+EngineLoadFunc Engine_GetLoadFunc(Engine* engine)
+{
+   if (engine == NULL)
+      return NULL;
 
+   return (engine->internal.window != NULL) ? ENG_GLFWLoad : ENG_HeadlessLoad;
 }
 
 void ENG_FramebufferSizeCallback(GLFWwindow* window, i32 width, i32 height)
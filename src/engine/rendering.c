@@ -1,6 +1,7 @@
 #include "util/types.h"
 
 #include "engine.h"
+#include "renderer.h"
 #include "engine/internal.h"
 
 #include <glad/gl.h>
@@ -31,6 +32,21 @@ void Engine_Present(Engine* engine)
       return;
 
    eng_EngineGlobal* eng_glb = &engine->internal;
+
+   // every frame ends here, so apps don't have to remember to close the renderer's frame stats themselves
+   Renderer_EndFrame(Engine_FetchModule(engine, RENDERER_MODULE));
+
+   // has to happen before the swap, the back buffer's contents are undefined afterwards
+   ENG_DumpFrame(engine);
+
+   // offscreen contexts have nothing to swap, flushing keeps the gpu from sitting idle until the next readback
+   if (eng_glb->window == NULL)
+   {
+      glFlush();
+
+      return;
+   }
+
    glfwSwapBuffers(eng_glb->window);
-   
+
 }
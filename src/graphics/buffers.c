@@ -83,6 +83,9 @@ void Graphics_UpdateBufferExplicit(Graphics* graphics, Buffer res_buffer, void*
    glBindBuffer(gl_target, buffer.id.buf);
    glBufferSubData(gl_target, offset_bytes, total_size, data);
 
+   graphics->stats.buffer_uploads++;
+   graphics->stats.buffer_upload_bytes += (u64)total_size;
+
 }
 
 void Graphics_BindBuffer(Graphics* graphics, Buffer res_buffer, u32 slot)
@@ -1,4 +1,5 @@
 #include "util/types.h"
+#include "util/math.h"
 #include "util/handle.h"
 #include "mesh.h"
 
@@ -7,17 +8,26 @@
 
 #include <glad/gl.h>
 
+#include <string.h>
+
 Geometry Graphics_CreateGeometry(Graphics* graphics, Mesh mesh, u8 draw_mode)
+{
+   return Graphics_CreateDynamicGeometry(graphics, mesh, (GeometryDesc){ .draw_mode = draw_mode });
+}
+
+Geometry Graphics_CreateDynamicGeometry(Graphics* graphics, Mesh mesh, GeometryDesc desc)
 {
    if (graphics == NULL)
       return (handle){ .id = INVALID_HANDLE_ID };
 
    gfx_Geometry geometry = { 0 };
-   geometry.draw_mode = draw_mode;
+   geometry.draw_mode = desc.draw_mode;
    geometry.face_cull_mode = GFX_FACECULL_BACK;
    geometry.primitive = GFX_MeshPrimitive(mesh.primitive);
    geometry.index_type = mesh.index_type;
-   geometry.element_count = ((mesh.index_count > 0) && (geometry.primitive == GFX_PRIMITIVE_TRIANGLE)) ? mesh.index_count : mesh.vertex_count;
+   geometry.vertex_capacity = M_MAX(desc.vertex_capacity, mesh.vertex_count);
+   geometry.index_capacity = M_MAX(desc.index_capacity, GFX_MeshIndexCount(mesh));
+   geometry.ring_count = (u8)M_CLAMP(desc.ring_count, 1, GFX_MAX_GEOMETRY_RING);
 
    GFX_CreateGeometry(&geometry, mesh);
 
@@ -32,26 +42,87 @@ void Graphics_ReuseGeometry(Graphics* graphics, Mesh mesh, u8 draw_mode, Geometr
    if (graphics == NULL || !Util_IsHandleValid(graphics->geometries, res_geometry))
       return;
 
-   gfx_Geometry geometry = graphics->geometries[res_geometry.handle];
-   if (!GFX_IsGeometryValid(geometry, res_geometry))
+   gfx_Geometry* geometry = &graphics->geometries[res_geometry.handle];
+   if (!GFX_IsGeometryValid(*geometry, res_geometry))
       return;
 
-   glDeleteVertexArrays(1, &geometry.id.vao);
+   u32 index_count = GFX_MeshIndexCount(mesh);
+   bool needs_realloc = (geometry->id.v_buf == 0)
+      || !GFX_GeometryLayoutMatches(geometry, mesh, index_count)
+      || (mesh.vertex_count > geometry->vertex_capacity)
+      || (index_count > geometry->index_capacity);
 
-   if (geometry.id.v_buf != 0)
-      glDeleteBuffers(1, &geometry.id.v_buf);
-   if (geometry.id.i_buf != 0)
-      glDeleteBuffers(1, &geometry.id.i_buf);
+   geometry->draw_mode = draw_mode;
+   geometry->primitive = GFX_MeshPrimitive(mesh.primitive);
 
-   geometry.draw_mode = draw_mode;
-   geometry.face_cull_mode = GFX_FACECULL_BACK;
-   geometry.primitive = GFX_MeshPrimitive(mesh.primitive);
-   geometry.element_count = ((mesh.index_count > 0) && (geometry.primitive == GFX_PRIMITIVE_TRIANGLE)) ? mesh.index_count : mesh.vertex_count;
+   if (needs_realloc)
+   {
+      // half again on top, so a mesh that creeps up a little every frame doesn't reallocate every frame
+      if (mesh.vertex_count > geometry->vertex_capacity)
+         geometry->vertex_capacity = M_MAX(mesh.vertex_count, geometry->vertex_capacity + geometry->vertex_capacity / 2);
+      if (index_count > geometry->index_capacity)
+         geometry->index_capacity = M_MAX(index_count, geometry->index_capacity + geometry->index_capacity / 2);
 
-   GFX_CreateGeometry(&geometry, mesh);
+      if (index_count > 0)
+         geometry->index_type = mesh.index_type;
+
+      geometry->attribute_count = M_MIN(mesh.attribute_count, MESH_MAX_ATTRIBUTES);
+      memcpy(geometry->attributes, mesh.attributes, geometry->attribute_count);
+
+      GFX_AllocateGeometryBuffers(geometry);
+
+   } else if (geometry->ring_count > 1) {
+      GFX_AdvanceGeometryRing(geometry);
+
+   } else {
+      GFX_OrphanGeometryBuffers(geometry);
+
+   }
+
+   GFX_WriteGeometry(graphics, geometry, mesh, 0, 0, (geometry->ring_count > 1));
+
+   geometry->is_indexed = (index_count > 0);
+   geometry->element_count = geometry->is_indexed ? index_count : mesh.vertex_count;
 
 }
 
+bool Graphics_UpdateGeometryRange(Graphics* graphics, Geometry res_geometry, Mesh mesh, u32 first_vertex, u32 first_index, bool is_tail)
+{
+   if (graphics == NULL || !Util_IsHandleValid(graphics->geometries, res_geometry))
+      return false;
+
+   gfx_Geometry* geometry = &graphics->geometries[res_geometry.handle];
+   if (!GFX_IsGeometryValid(*geometry, res_geometry))
+      return false;
+
+   u32 index_count = GFX_MeshIndexCount(mesh);
+   bool is_in_range = ((u64)first_vertex + (u64)mesh.vertex_count <= (u64)geometry->vertex_capacity)
+      && ((u64)first_index + (u64)index_count <= (u64)geometry->index_capacity);
+
+   if (!GFX_GeometryLayoutMatches(geometry, mesh, index_count) || !is_in_range)
+   {
+      error err = { 0 };
+      err.general = ERR_LEVEL_WARN;
+
+      Util_Log(NULL, GRAPHICS_MODULE, err, "Geometry update doesn't fit! Use Graphics_ReuseGeometry to change its layout or grow it");
+
+      return false;
+   }
+
+   GFX_WriteGeometry(graphics, geometry, mesh, first_vertex, first_index, false);
+
+   // a tail update decides where the geometry ends, anything else can only stretch it to cover the new range
+   u32 range_end = (index_count > 0) ? (first_index + index_count) : (first_vertex + mesh.vertex_count);
+   if (index_count > 0)
+      geometry->is_indexed = true;
+
+   // vertex only updates of an indexed geometry don't change how much of it is drawn
+   if (index_count > 0 || !geometry->is_indexed)
+      geometry->element_count = is_tail ? range_end : M_MAX(geometry->element_count, range_end);
+
+   return true;
+}
+
 void Graphics_FreeGeometry(Graphics* graphics, Geometry res_geometry)
 {
    if (graphics == NULL || !Util_IsHandleValid(graphics->geometries, res_geometry))
@@ -64,7 +135,8 @@ void Graphics_FreeGeometry(Graphics* graphics, Geometry res_geometry)
    geometry->next_freed = graphics->freed_geometry_root;
    graphics->freed_geometry_root = (u32)res_geometry.handle;
 
-   glDeleteVertexArrays(1, &geometry->id.vao);
+   GFX_ClearGeometryFences(geometry);
+   glDeleteVertexArrays(geometry->ring_count, geometry->id.vaos);
 
    if (geometry->id.v_buf != 0)
       glDeleteBuffers(1, &geometry->id.v_buf);
@@ -86,6 +158,20 @@ void Graphics_SetGeometryFaceCullMode(Graphics* graphics, Geometry res_geometry,
 
 }
 
+bool Graphics_BindGeometryIndexBuffer(Graphics* graphics, Geometry res_geometry, u32 slot)
+{
+   if (graphics == NULL || !Util_IsHandleValid(graphics->geometries, res_geometry))
+      return false;
+
+   gfx_Geometry geometry = graphics->geometries[res_geometry.handle];
+   if (!GFX_IsGeometryValid(geometry, res_geometry) || geometry.id.i_buf == 0 || geometry.ring_count > 1)
+      return false;
+
+   glBindBufferBase(GL_SHADER_STORAGE_BUFFER, slot, geometry.id.i_buf);
+
+   return true;
+}
+
 u8 GFX_MeshPrimitive(u8 mesh_primitive)
 {
    if (mesh_primitive == MESH_PRIMITIVE_TRIANGLE)
@@ -208,28 +294,48 @@ uS GFX_VertexBufferSize(u32 vertex_count, u8* attributes, u16 attribute_count)
    return buffer_size;
 }
 
-void GFX_CreateGeometry(gfx_Geometry* geometry, Mesh mesh)
+u32 GFX_MeshIndexCount(Mesh mesh)
 {
-   if (geometry == NULL || mesh.vertex_buffer == NULL)
-      return;
+   if ((mesh.index_count > 0) && (mesh.index_buffer != NULL) && (GFX_MeshPrimitive(mesh.primitive) == GFX_PRIMITIVE_TRIANGLE))
+      return mesh.index_count;
 
-   glGenVertexArrays(1, &geometry->id.vao);
-   glBindVertexArray(geometry->id.vao);
+   return 0;
+}
 
-   glGenBuffers(1, &geometry->id.v_buf);
+bool GFX_GeometryLayoutMatches(gfx_Geometry* geometry, Mesh mesh, u32 index_count)
+{
+   if (mesh.attribute_count != geometry->attribute_count || memcmp(mesh.attributes, geometry->attributes, geometry->attribute_count) != 0)
+      return false;
+
+   if (index_count > 0 && (geometry->id.i_buf == 0 || mesh.index_type != geometry->index_type))
+      return false;
+
+   return true;
+}
+
+static uS GFX_GeometryIndexSize(gfx_Geometry* geometry)
+{
+   return (geometry->index_type == MESH_INDEXTYPE_16BIT) ? sizeof(u16) : sizeof(u32);
+}
+
+// size of one copy in the ring
+static uS GFX_GeometryVertexRegionSize(gfx_Geometry* geometry)
+{
+   return GFX_VertexBufferSize(geometry->vertex_capacity, geometry->attributes, geometry->attribute_count);
+}
+
+// attributes are laid out one after another, each one sized for the whole capacity
+static void GFX_SetGeometryAttributes(gfx_Geometry* geometry, u8 ring_i)
+{
+   glBindVertexArray(geometry->id.vaos[ring_i]);
    glBindBuffer(GL_ARRAY_BUFFER, geometry->id.v_buf);
-   glBufferData(
-      GL_ARRAY_BUFFER,
-      GFX_VertexBufferSize(mesh.vertex_count, mesh.attributes, mesh.attribute_count),
-      mesh.vertex_buffer,
-      GFX_DrawMode(geometry->draw_mode)
-   );
 
-   uS atr_ofs = 0;
+   uS atr_ofs = (uS)ring_i * GFX_GeometryVertexRegionSize(geometry);
+   u8 atr_i = 0;
 
-   for (u8 atr_i = 0; atr_i < mesh.attribute_count; atr_i++)
+   for (; atr_i < geometry->attribute_count; atr_i++)
    {
-      u8 a = GFX_MeshAttribute(mesh.attributes[atr_i]);
+      u8 a = GFX_MeshAttribute(geometry->attributes[atr_i]);
 
       if (a == GFX_ATTRIBUTE_NULL)
          break;
@@ -249,26 +355,218 @@ void GFX_CreateGeometry(gfx_Geometry* geometry, Mesh mesh)
          (void*)atr_ofs
       );
 
-      atr_ofs += a_size * (uS)a_count * (uS)mesh.vertex_count;
+      atr_ofs += a_size * (uS)a_count * (uS)geometry->vertex_capacity;
 
    }
 
-   if ((mesh.index_count > 0) && (geometry->primitive == GFX_PRIMITIVE_TRIANGLE) && (mesh.index_buffer != NULL))
+   // left over from an older layout
+   for (; atr_i < MESH_MAX_ATTRIBUTES; atr_i++)
+      glDisableVertexAttribArray(atr_i);
+
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry->id.i_buf);
+   glBindVertexArray(0);
+
+}
+
+void GFX_ClearGeometryFences(gfx_Geometry* geometry)
+{
+   for (u8 ring_i = 0; ring_i < GFX_MAX_GEOMETRY_RING; ring_i++)
    {
-      uS index_size = (mesh.index_type == MESH_INDEXTYPE_16BIT) ? sizeof(u16) : sizeof(u32);
+      if (geometry->fences[ring_i] != NULL)
+         glDeleteSync((GLsync)geometry->fences[ring_i]);
 
-      glGenBuffers(1,  &geometry->id.i_buf);
-      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry->id.i_buf);
-      glBufferData(
-         GL_ELEMENT_ARRAY_BUFFER,
-         index_size * (uS)mesh.index_count,
-         mesh.index_buffer,
-         GFX_DrawMode(geometry->draw_mode)
+      geometry->fences[ring_i] = NULL;
 
-      );
+   }
+
+}
+
+// (re)creates the storage for every copy in the ring. glBufferData on a live buffer orphans the old storage,
+// so draws still in flight keep reading what they had
+void GFX_AllocateGeometryBuffers(gfx_Geometry* geometry)
+{
+   if (geometry->id.vaos[0] == 0)
+      glGenVertexArrays(geometry->ring_count, geometry->id.vaos);
+
+   if (geometry->id.v_buf == 0)
+      glGenBuffers(1, &geometry->id.v_buf);
+
+   glBindBuffer(GL_COPY_WRITE_BUFFER, geometry->id.v_buf);
+   glBufferData(GL_COPY_WRITE_BUFFER, GFX_GeometryVertexRegionSize(geometry) * (uS)geometry->ring_count, NULL, GFX_DrawMode(geometry->draw_mode));
+
+   if ((geometry->index_capacity > 0) && (geometry->primitive == GFX_PRIMITIVE_TRIANGLE))
+   {
+      if (geometry->id.i_buf == 0)
+         glGenBuffers(1, &geometry->id.i_buf);
+
+      glBindBuffer(GL_COPY_WRITE_BUFFER, geometry->id.i_buf);
+      glBufferData(GL_COPY_WRITE_BUFFER, GFX_GeometryIndexSize(geometry) * (uS)geometry->index_capacity * (uS)geometry->ring_count, NULL, GFX_DrawMode(geometry->draw_mode));
+
+   } else if (geometry->id.i_buf != 0) {
+      glDeleteBuffers(1, &geometry->id.i_buf);
+      geometry->id.i_buf = 0;
+
+   }
+
+   glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+   for (u8 ring_i = 0; ring_i < geometry->ring_count; ring_i++)
+      GFX_SetGeometryAttributes(geometry, ring_i);
+
+   // nothing can be reading the new storage yet
+   GFX_ClearGeometryFences(geometry);
+   geometry->ring_index = 0;
+   geometry->index_offset = 0;
+   geometry->id.vao = geometry->id.vaos[0];
+
+}
+
+void GFX_OrphanGeometryBuffers(gfx_Geometry* geometry)
+{
+   glBindBuffer(GL_COPY_WRITE_BUFFER, geometry->id.v_buf);
+   glBufferData(GL_COPY_WRITE_BUFFER, GFX_GeometryVertexRegionSize(geometry), NULL, GFX_DrawMode(geometry->draw_mode));
+
+   if (geometry->id.i_buf != 0)
+   {
+      glBindBuffer(GL_COPY_WRITE_BUFFER, geometry->id.i_buf);
+      glBufferData(GL_COPY_WRITE_BUFFER, GFX_GeometryIndexSize(geometry) * (uS)geometry->index_capacity, NULL, GFX_DrawMode(geometry->draw_mode));
+
+   }
+
+   glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+}
+
+// fences off the copy that was just drawn from and moves on to the oldest one
+void GFX_AdvanceGeometryRing(gfx_Geometry* geometry)
+{
+   if (geometry->fences[geometry->ring_index] != NULL)
+      glDeleteSync((GLsync)geometry->fences[geometry->ring_index]);
+
+   geometry->fences[geometry->ring_index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+   geometry->ring_index = (geometry->ring_index + 1) % geometry->ring_count;
+
+   // only blocks if the cpu got a whole ring of frames ahead of the gpu
+   GLsync fence = (GLsync)geometry->fences[geometry->ring_index];
+   if (fence != NULL)
+   {
+      GLenum wait_result = GL_TIMEOUT_EXPIRED;
+      while (wait_result == GL_TIMEOUT_EXPIRED)
+         wait_result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+
+      glDeleteSync(fence);
+      geometry->fences[geometry->ring_index] = NULL;
 
    }
 
+   geometry->id.vao = geometry->id.vaos[geometry->ring_index];
+   geometry->index_offset = (u32)(GFX_GeometryIndexSize(geometry) * (uS)geometry->index_capacity * (uS)geometry->ring_index);
+
+}
+
+// writes into the current copy. a vertex range turns into one copy per attribute since they aren't interleaved.
+// is_unsynchronized maps the copy without waiting on the gpu, only safe right after the ring moved on
+void GFX_WriteGeometry(Graphics* graphics, gfx_Geometry* geometry, Mesh mesh, u32 first_vertex, u32 first_index, bool is_unsynchronized)
+{
+   uS upload_bytes = 0;
+
+   if (mesh.vertex_buffer != NULL && mesh.vertex_count > 0)
+   {
+      uS region_size = GFX_GeometryVertexRegionSize(geometry);
+      uS region_ofs = region_size * (uS)geometry->ring_index;
+
+      glBindBuffer(GL_COPY_WRITE_BUFFER, geometry->id.v_buf);
+
+      u8* mapped = NULL;
+      if (is_unsynchronized)
+         mapped = glMapBufferRange(GL_COPY_WRITE_BUFFER, region_ofs, region_size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+
+      uS dst_ofs = 0;
+      uS src_ofs = 0;
+
+      for (u8 atr_i = 0; atr_i < geometry->attribute_count; atr_i++)
+      {
+         u8 a = GFX_MeshAttribute(geometry->attributes[atr_i]);
+
+         if (a == GFX_ATTRIBUTE_NULL)
+            break;
+
+         uS a_stride = GFX_AttributeTypeSize(a) * (uS)GFX_AttributeTypeCount(a);
+         uS copy_size = a_stride * (uS)mesh.vertex_count;
+         uS copy_ofs = dst_ofs + a_stride * (uS)first_vertex;
+
+         if (mapped != NULL)
+            memcpy(mapped + copy_ofs, mesh.vertex_buffer + src_ofs, copy_size);
+         else
+            glBufferSubData(GL_COPY_WRITE_BUFFER, region_ofs + copy_ofs, copy_size, mesh.vertex_buffer + src_ofs);
+
+         dst_ofs += a_stride * (uS)geometry->vertex_capacity;
+         src_ofs += copy_size;
+
+      }
+
+      if (mapped != NULL)
+         glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+
+      upload_bytes += src_ofs;
+
+   }
+
+   u32 index_count = GFX_MeshIndexCount(mesh);
+   if (index_count > 0 && geometry->id.i_buf != 0)
+   {
+      uS index_size = GFX_GeometryIndexSize(geometry);
+      uS copy_size = index_size * (uS)index_count;
+      uS copy_ofs = (uS)geometry->index_offset + index_size * (uS)first_index;
+
+      glBindBuffer(GL_COPY_WRITE_BUFFER, geometry->id.i_buf);
+
+      void* mapped = NULL;
+      if (is_unsynchronized)
+         mapped = glMapBufferRange(GL_COPY_WRITE_BUFFER, copy_ofs, copy_size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+
+      if (mapped != NULL)
+      {
+         memcpy(mapped, mesh.index_buffer, copy_size);
+         glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+
+      } else {
+         glBufferSubData(GL_COPY_WRITE_BUFFER, copy_ofs, copy_size, mesh.index_buffer);
+
+      }
+
+      upload_bytes += copy_size;
+
+   }
+
+   glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+   // creation doesn't count as an upload, same as buffers
+   if (graphics != NULL && upload_bytes > 0)
+   {
+      graphics->stats.buffer_uploads++;
+      graphics->stats.buffer_upload_bytes += (u64)upload_bytes;
+
+   }
+
+}
+
+void GFX_CreateGeometry(gfx_Geometry* geometry, Mesh mesh)
+{
+   if (geometry == NULL || geometry->vertex_capacity == 0)
+      return;
+
+   geometry->ring_count = M_MAX(geometry->ring_count, 1);
+   geometry->attribute_count = M_MIN(mesh.attribute_count, MESH_MAX_ATTRIBUTES);
+   memcpy(geometry->attributes, mesh.attributes, geometry->attribute_count);
+
+   u32 index_count = GFX_MeshIndexCount(mesh);
+   geometry->is_indexed = (index_count > 0);
+   geometry->element_count = geometry->is_indexed ? index_count : mesh.vertex_count;
+
+   GFX_AllocateGeometryBuffers(geometry);
+   GFX_WriteGeometry(NULL, geometry, mesh, 0, 0, false);
+
 }
 
 void GFX_SetFaceCullMode(Graphics* graphics, u8 face_cull_mode)
@@ -281,6 +579,7 @@ void GFX_SetFaceCullMode(Graphics* graphics, u8 face_cull_mode)
    if ((bool)graphics->state.face_cull_enable != face_cull_enable)
    {
       graphics->state.face_cull_enable = (u16)face_cull_enable;
+      graphics->stats.state_changes++;
 
       if(face_cull_enable)
          glEnable(GL_CULL_FACE);
@@ -292,6 +591,7 @@ void GFX_SetFaceCullMode(Graphics* graphics, u8 face_cull_mode)
    if ((graphics->state.face_cull_mode != face_cull_mode) && face_cull_enable)
    {
       graphics->state.face_cull_mode = (u16)face_cull_mode;
+      graphics->stats.state_changes++;
 
       const u32 gl_cullmode[2] = { GL_BACK, GL_FRONT };
       glCullFace(gl_cullmode[face_cull_mode]);
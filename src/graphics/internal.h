@@ -6,14 +6,37 @@
 
 #include "graphics.h"
 
+#define GFX_MAX_TEXTURE_UNITS 32
+
+#define GFX_UPLOAD_RING_SIZE (16u << 20u)
+#define GFX_UPLOAD_RING_SEGMENTS 4u
+
+// from GL_KHR_parallel_shader_compile (same values as the ARB version), glad is generated without extensions
+#define GFX_GL_MAX_SHADER_COMPILER_THREADS 0x91B0
+#define GFX_GL_COMPLETION_STATUS 0x91B1
+
+// from EXT_texture_compression_s3tc and EXT_texture_sRGB, every desktop driver has them but they never made it into core
+#define GFX_GL_COMPRESSED_RGB_S3TC_DXT1 0x83F0
+#define GFX_GL_COMPRESSED_RGBA_S3TC_DXT1 0x83F1
+#define GFX_GL_COMPRESSED_RGBA_S3TC_DXT3 0x83F2
+#define GFX_GL_COMPRESSED_RGBA_S3TC_DXT5 0x83F3
+#define GFX_GL_COMPRESSED_SRGB_S3TC_DXT1 0x8C4C
+#define GFX_GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1 0x8C4D
+#define GFX_GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3 0x8C4E
+#define GFX_GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5 0x8C4F
+
 typedef struct gfx_Shader_t
 {
    struct {
       u32 program;
+      u32 stages[2]; // only kept while the link is pending
    } id;
 
+   u64 cache_key;
+
    struct {
       u16 is_compute: 1;
+      u16 status: 2;
    };
 
    u16 next_freed;
@@ -40,17 +63,29 @@ typedef struct gfx_Buffer_t
 typedef struct gfx_Geometry_t
 {
    struct {
-      u32 vao;
+      u32 vao; // whichever of vaos is current
+      u32 vaos[GFX_MAX_GEOMETRY_RING];
       u32 v_buf, i_buf;
 
    } id;
 
+   void* fences[GFX_MAX_GEOMETRY_RING];
+
    u32 element_count;
+   u32 vertex_capacity;
+   u32 index_capacity;
+   u32 index_offset; // bytes, where the current copy's indices start
+
+   u8 attributes[MESH_MAX_ATTRIBUTES];
+   u8 attribute_count;
+   u8 ring_count;
+   u8 ring_index;
 
    u8 draw_mode: 4;
    u8 face_cull_mode: 4;
-   u8 primitive: 7;
+   u8 primitive: 6;
    u8 index_type: 1;
+   u8 is_indexed: 1;
 
 
    u16 next_freed;
@@ -71,6 +106,9 @@ typedef struct gfx_Texture_t
    u8 type;
    u8 format;
 
+   // bytes the whole mip chain takes up, from format and size
+   uS memory_size;
+
    handle compare;
    u16 next_freed;
 
@@ -88,6 +126,35 @@ typedef struct gfx_Framebuffer_t
 
 } gfx_Framebuffer;
 
+enum {
+   GFX_READBACK_FREE = 0,
+   GFX_READBACK_PENDING,
+   GFX_READBACK_READY,
+   GFX_READBACK_MAPPED
+
+};
+
+// one pixel pack buffer per slot, kept around between requests and only regrown when a bigger one comes along
+typedef struct gfx_Readback_t
+{
+   u32 pbo;
+   uS capacity;
+   void* fence;
+
+   Image layout; // everything but data, which only points somewhere while it's mapped
+   u64 sequence;
+   u16 generation;
+   u8 state;
+
+} gfx_Readback;
+
+typedef struct gfx_Sampler_t
+{
+   u64 key;
+   u32 sampler;
+
+} gfx_Sampler;
+
 typedef union gfx_State_t
 {
    u16 state_id;
@@ -123,6 +190,7 @@ struct Graphics_t
    gfx_Geometry* geometries;
    gfx_Texture* textures;
    gfx_Framebuffer* framebuffers;
+   gfx_Sampler* samplers;
 
    u16 freed_shader_root;
    u16 freed_buffer_root;
@@ -131,8 +199,63 @@ struct Graphics_t
    u16 freed_framebuffer_root;
 
    gfx_State state;
+
+   // what's bound to each texture unit, so redundant binds can be skipped
+   u32 active_texture_unit;
+   u32 bound_textures[GFX_MAX_TEXTURE_UNITS];
+   u32 bound_samplers[GFX_MAX_TEXTURE_UNITS];
+   f32 max_anisotropy;
+
+   GraphicsStats stats;
+
+   struct {
+      char* directory;
+      u64 driver_hash;
+
+   } shader_cache;
+
+   // set when the driver can be asked if a link is done without blocking
+   bool has_parallel_compile;
+
+   struct {
+      u32 queries[GFX_GPU_TIMER_LATENCY][GFX_MAX_GPU_TIMERS * 2];
+      u32 counts[GFX_GPU_TIMER_LATENCY];
+      bool is_ended[GFX_GPU_TIMER_LATENCY][GFX_MAX_GPU_TIMERS];
+      u64 results[GFX_MAX_GPU_TIMERS];
+      u32 result_count;
+      u32 frame_slot;
+      bool is_created;
+
+   } gpu_timers;
+
+   // staging memory for texture uploads. every segment gets a fence when the ring moves off it,
+   // and isn't written again until that fence has passed.
+   struct {
+      u32 pbo;
+      u8* mapped;
+      uS head;
+      u32 segment;
+      void* fences[GFX_UPLOAD_RING_SEGMENTS];
+      bool is_persistent;
+      bool is_created;
+
+   } upload_ring;
+
+   struct {
+      gfx_Readback slots[GFX_MAX_READBACKS];
+      u64 next_sequence;
+
+   } readbacks;
+
+   // compute downsamplers, built the first time they're needed. second index is for srgb targets.
+   Shader mip_shaders[GFX_MIPFILTER_COUNT][2];
+
+   // sum of memory_size over every live texture
+   uS texture_memory;
+
    color8 clear_color;
    f32 clear_depth;
+   bool reverse_z;
    i32 clear_stencil_id;
 
 };
@@ -172,6 +295,67 @@ static inline bool GFX_IsStencilFormat(u8 texture_format)
    return false;
 }
 
+static inline bool GFX_IsCompressedFormat(u8 texture_format)
+{
+   return (texture_format >= GFX_TEXTUREFORMAT_RGB_BC1 && texture_format <= GFX_TEXTUREFORMAT_RG_BC5);
+}
+
+// bytes per 4x4 block
+static inline uS GFX_CompressedBlockSize(u8 texture_format)
+{
+   switch (texture_format)
+   {
+      case GFX_TEXTUREFORMAT_RGB_BC1:
+      case GFX_TEXTUREFORMAT_RGBA_BC1:
+      case GFX_TEXTUREFORMAT_SRGB_BC1:
+      case GFX_TEXTUREFORMAT_SRGB_ALPHA_BC1:
+      case GFX_TEXTUREFORMAT_R_BC4:
+         return 8;
+
+      default:
+         return 16;
+   }
+}
+
+static inline u32 GFX_PrimitiveCount(u8 primitive_type, u32 element_count)
+{
+   switch (primitive_type)
+   {
+      case GFX_PRIMITIVE_POINT:
+         return element_count;
+
+      case GFX_PRIMITIVE_LINE:
+         return element_count / 2;
+
+      default:
+         return element_count / 3;
+   }
+}
+
+static inline u8 GFX_DepthModeForConvention(u8 depth_mode, bool reverse_z)
+{
+   if (!reverse_z)
+      return depth_mode;
+
+   switch (depth_mode)
+   {
+      default:
+         break;
+
+      case GFX_DEPTHMODE_LESS_THAN:
+         return GFX_DEPTHMODE_GREATER_THAN;
+      case GFX_DEPTHMODE_LESS_THAN_OR_EQUAL:
+         return GFX_DEPTHMODE_GREATER_THAN_OR_EQUAL;
+      case GFX_DEPTHMODE_GREATER_THAN:
+         return GFX_DEPTHMODE_LESS_THAN;
+      case GFX_DEPTHMODE_GREATER_THAN_OR_EQUAL:
+         return GFX_DEPTHMODE_LESS_THAN_OR_EQUAL;
+
+   }
+
+   return depth_mode;
+}
+
 static inline bool GFX_CheckHandleIsValid(handle compare_handle, handle res_handle, const char* resource_type_name, const u32 invalid_handle_error_code)
 {
    if (compare_handle.id == res_handle.id)
@@ -214,6 +398,7 @@ static inline bool GFX_IsFramebufferValid(gfx_Framebuffer framebuffer, handle re
 void GFX_CheckOpenGLError(void);
 
 void GFX_BindUniformBlocks(Graphics* graphics, UniformBlockList uniform_blocks);
+u8 GFX_ResolveShader(Graphics* graphics, gfx_Shader* shader, bool wait_for_link);
 
 u8 GFX_MeshPrimitive(u8 mesh_primitive);
 u8 GFX_MeshAttribute(u8 mesh_attribute);
@@ -224,9 +409,17 @@ bool GFX_AttributeTypeNormalized(u8 attribute);
 uS GFX_AttributeTypeSize(u8 attribute);
 uS GFX_VertexBufferSize(u32 vertex_count, u8* attributes, u16 attribute_count);
 
+u32 GFX_MeshIndexCount(Mesh mesh);
+bool GFX_GeometryLayoutMatches(gfx_Geometry* geometry, Mesh mesh, u32 index_count);
+void GFX_ClearGeometryFences(gfx_Geometry* geometry);
+void GFX_AllocateGeometryBuffers(gfx_Geometry* geometry);
+void GFX_OrphanGeometryBuffers(gfx_Geometry* geometry);
+void GFX_AdvanceGeometryRing(gfx_Geometry* geometry);
+void GFX_WriteGeometry(Graphics* graphics, gfx_Geometry* geometry, Mesh mesh, u32 first_vertex, u32 first_index, bool is_unsynchronized);
 void GFX_CreateGeometry(gfx_Geometry* geometry, Mesh mesh);
 
 uS GFX_PixelSize(u8 format);
+uS GFX_TextureLevelSize(u8 format, i32 width, i32 height, i32 depth);
 i32 GFX_TextureInternalFormat(u8 format);
 u32 GFX_TexturePixelFormat(u8 format);
 u32 GFX_TextureFormatType(u8 format);
@@ -235,10 +428,21 @@ u32 GFX_TextureWrap(u8 wrap);
 gfx_Filtering GFX_TextureFilter(u8 filter);
 
 void GFX_CreateTexture(gfx_Texture* texture, u8* data, bool is_update);
+void GFX_SetActiveTextureUnit(Graphics* graphics, u32 texture_unit);
+u32 GFX_GetSampler(Graphics* graphics, TextureInterpolation interpolation_settings, bool is_tex_shadow);
+void GFX_TrackBoundTexture(Graphics* graphics, u32 gl_texture);
 
 void GFX_SetFaceCullMode(Graphics* graphics, u8 face_cull_mode);
 void GFX_DrawVertices(u8 primitive, u32 element_count, bool use_index_buffer, u8 index_type, u32 gl_vertex_array, i32 offset, u32 instance_count);
 
+void GFX_FreeUploadRing(Graphics* graphics);
+void GFX_FreeReadbacks(Graphics* graphics);
+Image GFX_TextureReadbackLayout(gfx_Texture texture, u32 mip_level, u32* out_gl_format, u32* out_gl_type);
+
+u64 GFX_ShaderCacheKey(Graphics* graphics, const char* sources[], u32 source_count);
+u32 GFX_LoadCachedProgram(Graphics* graphics, u64 cache_key);
+void GFX_StoreCachedProgram(Graphics* graphics, u64 cache_key, u32 gl_program);
+
 u32 GFX_Primitive(u8 primitive_type);
 u32 GFX_DrawMode(u8 draw_mode);
 u32 GFX_BufferType(u8 buffer_type);
@@ -0,0 +1,227 @@
+#include "util/types.h"
+#include "util/math.h"
+#include "util/handle.h"
+#include "util/files.h"
+
+#include "graphics.h"
+#include "graphics/internal.h"
+
+#include <glad/gl.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#define GFX_MIP_GROUP_SIZE 8u
+
+// each invocation writes one texel of the destination mip from a 2x2 footprint of the one above it.
+// the source is bound with its base level moved up, so texelFetch at lod 0 is always the previous mip.
+static const char* gfx_mip_shader_source =
+   "layout(local_size_x = 8, local_size_y = 8) in;\n"
+   "layout(binding = 0) uniform sampler2D u_source;\n"
+   "layout(binding = 0) writeonly uniform image2D u_dest;\n"
+   "\n"
+   "vec4 MIP_Fetch(ivec2 coord, ivec2 source_size)\n"
+   "{\n"
+   "   return texelFetch(u_source, min(coord, source_size - 1), 0);\n"
+   "}\n"
+   "\n"
+   "void main()\n"
+   "{\n"
+   "   ivec2 dest_coord = ivec2(gl_GlobalInvocationID.xy);\n"
+   "   if (any(greaterThanEqual(dest_coord, imageSize(u_dest))))\n"
+   "      return;\n"
+   "\n"
+   "   ivec2 source_size = textureSize(u_source, 0);\n"
+   "   ivec2 source_coord = dest_coord * 2;\n"
+   "   vec4 t00 = MIP_Fetch(source_coord, source_size);\n"
+   "   vec4 t10 = MIP_Fetch(source_coord + ivec2(1, 0), source_size);\n"
+   "   vec4 t01 = MIP_Fetch(source_coord + ivec2(0, 1), source_size);\n"
+   "   vec4 t11 = MIP_Fetch(source_coord + ivec2(1, 1), source_size);\n"
+   "\n"
+   "   vec4 result = (t00 + t10 + t01 + t11) * 0.25;\n"
+   "#if defined(MIP_ALPHA_WEIGHTED)\n"
+   "   float alpha_sum = t00.a + t10.a + t01.a + t11.a;\n"
+   "   if (alpha_sum > 1e-5)\n"
+   "      result.rgb = (t00.rgb * t00.a + t10.rgb * t10.a + t01.rgb * t01.a + t11.rgb * t11.a) / alpha_sum;\n"
+   "#elif defined(MIP_NORMAL_MAP)\n"
+   "   vec3 normal = (t00.xyz + t10.xyz + t01.xyz + t11.xyz) * 2.0 - 4.0;\n"
+   "   result.xyz = (dot(normal, normal) > 1e-10) ? normalize(normal) * 0.5 + 0.5 : vec3(0.5, 0.5, 1.0);\n"
+   "#elif defined(MIP_DEPTH_REDUCE)\n"
+   "   result = MIP_DEPTH_REDUCE(MIP_DEPTH_REDUCE(t00, t10), MIP_DEPTH_REDUCE(t01, t11));\n"
+   "   ivec2 dest_size = imageSize(u_dest);\n"
+   "   bool extra_x = (dest_coord.x == dest_size.x - 1) && (source_size.x > dest_size.x * 2);\n"
+   "   bool extra_y = (dest_coord.y == dest_size.y - 1) && (source_size.y > dest_size.y * 2);\n"
+   "   if (extra_x)\n"
+   "      result = MIP_DEPTH_REDUCE(result, MIP_DEPTH_REDUCE(MIP_Fetch(source_coord + ivec2(2, 0), source_size), MIP_Fetch(source_coord + ivec2(2, 1), source_size)));\n"
+   "   if (extra_y)\n"
+   "      result = MIP_DEPTH_REDUCE(result, MIP_DEPTH_REDUCE(MIP_Fetch(source_coord + ivec2(0, 2), source_size), MIP_Fetch(source_coord + ivec2(1, 2), source_size)));\n"
+   "   if (extra_x && extra_y)\n"
+   "      result = MIP_DEPTH_REDUCE(result, MIP_Fetch(source_coord + ivec2(2, 2), source_size));\n"
+   "#endif\n"
+   "\n"
+   "#if defined(MIP_SRGB)\n"
+   "   vec3 srgb_low = result.rgb * 12.92;\n"
+   "   vec3 srgb_high = 1.055 * pow(max(result.rgb, vec3(0.0)), vec3(1.0 / 2.4)) - 0.055;\n"
+   "   result.rgb = mix(srgb_high, srgb_low, vec3(lessThanEqual(result.rgb, vec3(0.0031308))));\n"
+   "#endif\n"
+   "\n"
+   "   imageStore(u_dest, dest_coord, result);\n"
+   "}\n";
+
+// format the destination mip is bound as for imageStore, 0 if it can't be. three channel formats aren't image formats in GL,
+// and srgb isn't either, those go through their plain rgba8 equivalent and the shader does the encoding.
+static u32 GFX_MipImageFormat(u8 texture_format)
+{
+   switch (texture_format)
+   {
+      default:
+         return 0;
+
+      case GFX_TEXTUREFORMAT_SRGB_ALPHA:
+         return GL_RGBA8;
+
+      case GFX_TEXTUREFORMAT_R_U8_NORM:
+      case GFX_TEXTUREFORMAT_RG_U8_NORM:
+      case GFX_TEXTUREFORMAT_RGBA_U8_NORM:
+      case GFX_TEXTUREFORMAT_R_U16_NORM:
+      case GFX_TEXTUREFORMAT_RG_U16_NORM:
+      case GFX_TEXTUREFORMAT_RGBA_U16_NORM:
+      case GFX_TEXTUREFORMAT_R_F16:
+      case GFX_TEXTUREFORMAT_RG_F16:
+      case GFX_TEXTUREFORMAT_RGBA_F16:
+      case GFX_TEXTUREFORMAT_R_F32:
+      case GFX_TEXTUREFORMAT_RG_F32:
+      case GFX_TEXTUREFORMAT_RGBA_F32:
+      case GFX_TEXTUREFORMAT_R11F_G11F_B10F:
+         return (u32)GFX_TextureInternalFormat(texture_format);
+
+   }
+
+}
+
+static Shader GFX_GetMipShader(Graphics* graphics, u8 mip_filter, bool is_srgb)
+{
+   Shader* shader = &graphics->mip_shaders[mip_filter][is_srgb ? 1 : 0];
+   if (shader->id != INVALID_HANDLE_ID)
+      return (*shader);
+
+   const char* defines[2] = { 0 };
+   u32 define_count = 0;
+
+   if (mip_filter == GFX_MIPFILTER_ALPHA_WEIGHTED)
+      defines[define_count++] = "MIP_ALPHA_WEIGHTED";
+   else if (mip_filter == GFX_MIPFILTER_NORMAL_MAP)
+      defines[define_count++] = "MIP_NORMAL_MAP";
+   else if (mip_filter == GFX_MIPFILTER_DEPTH_MAX)
+      defines[define_count++] = "MIP_DEPTH_REDUCE max";
+   else if (mip_filter == GFX_MIPFILTER_DEPTH_MIN)
+      defines[define_count++] = "MIP_DEPTH_REDUCE min";
+
+   if (is_srgb)
+      defines[define_count++] = "MIP_SRGB";
+
+   memblob source = { .data = (void*)gfx_mip_shader_source, .size = strlen(gfx_mip_shader_source) + 1 };
+   memblob shader_code = Util_PrependShaderDefines(source, defines, define_count, NULL);
+   if (shader_code.data == NULL)
+      return (*shader);
+
+   (*shader) = Graphics_CreateComputeShader(graphics, shader_code.data);
+   free(shader_code.data);
+
+   return (*shader);
+}
+
+Texture Graphics_CreateTextureWithMips(Graphics* graphics, u8* data, TextureDesc desc, u8 mip_filter)
+{
+   if (graphics == NULL)
+      return (handle){ .id = INVALID_HANDLE_ID };
+
+   if (desc.mipmap_count == 0)
+   {
+      i32 largest_side = M_MAX(desc.size.width, desc.size.height);
+      if (desc.texture_type == GFX_TEXTURETYPE_3D)
+         largest_side = M_MAX(largest_side, desc.depth);
+
+      desc.mipmap_count = 1;
+      while ((largest_side >> desc.mipmap_count) > 0)
+         desc.mipmap_count++;
+
+   }
+
+   // empty storage for the whole chain, then just the base level goes up from the cpu
+   Texture res_texture = Graphics_CreateTexture(graphics, NULL, desc);
+   if (res_texture.id == INVALID_HANDLE_ID || data == NULL)
+      return res_texture;
+
+   gfx_Texture base_level = graphics->textures[res_texture.handle];
+   base_level.mipmap_count = 1;
+   GFX_CreateTexture(&base_level, data, true);
+   GFX_TrackBoundTexture(graphics, base_level.id.tex);
+
+   Graphics_GenerateMipmaps(graphics, res_texture, mip_filter);
+
+   return res_texture;
+}
+
+void Graphics_GenerateMipmaps(Graphics* graphics, Texture res_texture, u8 mip_filter)
+{
+   if (graphics == NULL || !Util_IsHandleValid(graphics->textures, res_texture))
+      return;
+
+   gfx_Texture texture = graphics->textures[res_texture.handle];
+   if (!GFX_IsTextureValid(texture, res_texture) || texture.mipmap_count <= 1)
+      return;
+
+   // compressed mips have to come pre-built, GL can't encode them
+   if (GFX_IsCompressedFormat(texture.format))
+   {
+      error err = { 0 };
+      err.general = ERR_LEVEL_WARN;
+
+      Util_Log(NULL, GRAPHICS_MODULE, err, "Can't generate mipmaps for compressed texture %u", res_texture.id);
+
+      return;
+   }
+
+   u32 gl_target = GFX_TextureType(texture.type);
+   u32 image_format = GFX_MipImageFormat(texture.format);
+
+   Shader mip_shader = { .id = INVALID_HANDLE_ID };
+   if (mip_filter != GFX_MIPFILTER_DEFAULT && mip_filter < GFX_MIPFILTER_COUNT && texture.type == GFX_TEXTURETYPE_2D && image_format != 0)
+      mip_shader = GFX_GetMipShader(graphics, mip_filter, (texture.format == GFX_TEXTUREFORMAT_SRGB_ALPHA));
+
+   if (mip_shader.id == INVALID_HANDLE_ID)
+   {
+      glBindTexture(gl_target, texture.id.tex);
+      GFX_TrackBoundTexture(graphics, texture.id.tex);
+      glGenerateMipmap(gl_target);
+
+      return;
+   }
+
+   Graphics_BindTexture(graphics, res_texture, 0);
+
+   for (u32 mip_i = 1; mip_i < texture.mipmap_count; mip_i++)
+   {
+      u32 mip_width = (u32)M_MAX(texture.width >> mip_i, 1);
+      u32 mip_height = (u32)M_MAX(texture.height >> mip_i, 1);
+
+      // the previous mip is the only one the shader can see, the one being written isn't sampled from
+      glTexParameteri(gl_target, GL_TEXTURE_BASE_LEVEL, (i32)mip_i - 1);
+      glTexParameteri(gl_target, GL_TEXTURE_MAX_LEVEL, (i32)mip_i - 1);
+      glBindImageTexture(0, texture.id.tex, (i32)mip_i, GL_FALSE, 0, GL_WRITE_ONLY, image_format);
+
+      u32 group_count_x = (mip_width + GFX_MIP_GROUP_SIZE - 1) / GFX_MIP_GROUP_SIZE;
+      u32 group_count_y = (mip_height + GFX_MIP_GROUP_SIZE - 1) / GFX_MIP_GROUP_SIZE;
+      Graphics_Dispatch(graphics, mip_shader, group_count_x, group_count_y, 1, (UniformBlockList){ 0 });
+
+      glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+   }
+
+   glTexParameteri(gl_target, GL_TEXTURE_BASE_LEVEL, 0);
+   glTexParameteri(gl_target, GL_TEXTURE_MAX_LEVEL, (i32)texture.mipmap_count - 1);
+
+   glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, image_format);
+
+}
@@ -1,4 +1,5 @@
 #include "util/types.h"
+#include "util/math.h"
 #include "util/array.h"
 #include "util/files.h"
 #include "util/handle.h"
@@ -12,9 +13,53 @@
 #include <stdlib.h>
 #include <string.h>
 
+typedef void (GLAD_API_PTR *GFX_MaxShaderCompilerThreadsFunc)(GLuint count);
+
+static void* GFX_GLFWLoad(const char* proc_name)
+{
+   return (void*)glfwGetProcAddress(proc_name);
+}
+
+static bool GFX_EnableParallelShaderCompile(GraphicsLoadFunc load_func)
+{
+   i32 extension_count = 0;
+   glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+
+   const char* func_name = NULL;
+   for (i32 extension_i = 0; extension_i < extension_count && func_name == NULL; extension_i++)
+   {
+      const char* extension_name = (const char*)glGetStringi(GL_EXTENSIONS, (u32)extension_i);
+      if (extension_name == NULL)
+         continue;
+
+      if (strcmp(extension_name, "GL_KHR_parallel_shader_compile") == 0)
+         func_name = "glMaxShaderCompilerThreadsKHR";
+      else if (strcmp(extension_name, "GL_ARB_parallel_shader_compile") == 0)
+         func_name = "glMaxShaderCompilerThreadsARB";
+
+   }
+
+   if (func_name == NULL)
+      return false;
+
+   GFX_MaxShaderCompilerThreadsFunc max_compiler_threads = (GFX_MaxShaderCompilerThreadsFunc)load_func(func_name);
+   if (max_compiler_threads == NULL)
+      return false;
+
+   // 0xFFFFFFFF lets the driver pick how many threads to use
+   max_compiler_threads(0xFFFFFFFFu);
+
+   return true;
+}
+
 Graphics* Graphics_Init(void)
 {
-   if (!gladLoadGL((GLADloadfunc)glfwGetProcAddress))
+   return Graphics_InitWithLoader(GFX_GLFWLoad);
+}
+
+Graphics* Graphics_InitWithLoader(GraphicsLoadFunc load_func)
+{
+   if (load_func == NULL || !gladLoadGL((GLADloadfunc)load_func))
    {
       return NULL;
    }
@@ -25,6 +70,7 @@ Graphics* Graphics_Init(void)
    graphics->geometries = NEW_ARRAY(gfx_Geometry);
    graphics->textures = NEW_ARRAY(gfx_Texture);
    graphics->framebuffers = NEW_ARRAY(gfx_Framebuffer);
+   graphics->samplers = NEW_ARRAY(gfx_Sampler);
    graphics->freed_shader_root = INVALID_HANDLE;
    graphics->freed_buffer_root = INVALID_HANDLE;
    graphics->freed_geometry_root = INVALID_HANDLE;
@@ -37,6 +83,23 @@ Graphics* Graphics_Init(void)
    graphics->state.blend_mode = 7;
    graphics->state.depth_mode = 7;
    graphics->clear_color.hex = 0;
+   graphics->reverse_z = false;
+   graphics->stats = (GraphicsStats){ 0 };
+   graphics->shader_cache.directory = NULL;
+   graphics->shader_cache.driver_hash = 0;
+   graphics->has_parallel_compile = GFX_EnableParallelShaderCompile(load_func);
+   memset(&graphics->gpu_timers, 0, sizeof(graphics->gpu_timers));
+   memset(&graphics->upload_ring, 0, sizeof(graphics->upload_ring));
+   memset(&graphics->readbacks, 0, sizeof(graphics->readbacks));
+   for (u32 filter_i = 0; filter_i < GFX_MIPFILTER_COUNT; filter_i++)
+      graphics->mip_shaders[filter_i][0] = graphics->mip_shaders[filter_i][1] = (handle){ .id = INVALID_HANDLE_ID };
+   graphics->texture_memory = 0;
+   graphics->active_texture_unit = GFX_INVALID_INDEX;
+   memset(graphics->bound_textures, 0, sizeof(graphics->bound_textures));
+   memset(graphics->bound_samplers, 0, sizeof(graphics->bound_samplers));
+
+   graphics->max_anisotropy = 1.0f;
+   glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &graphics->max_anisotropy);
 
    Graphics_SetClearColor(graphics, (color8){ 127, 127, 127, 255 });
    Graphics_SetClearDepth(graphics, 1.0f);
@@ -70,11 +133,23 @@ void Graphics_Free(Graphics* graphics)
    for (u32 i=0; i<Util_ArrayLength(graphics->framebuffers); i++)
       Graphics_FreeFramebuffer(graphics, graphics->framebuffers[i].compare);
 
+   for (u32 i=0; i<Util_ArrayLength(graphics->samplers); i++)
+      glDeleteSamplers(1, &graphics->samplers[i].sampler);
+
+   if (graphics->gpu_timers.is_created)
+      glDeleteQueries(GFX_GPU_TIMER_LATENCY * GFX_MAX_GPU_TIMERS * 2, &graphics->gpu_timers.queries[0][0]);
+
+   GFX_FreeUploadRing(graphics);
+   GFX_FreeReadbacks(graphics);
+
    FREE_ARRAY(graphics->shaders);
    FREE_ARRAY(graphics->buffers);
    FREE_ARRAY(graphics->geometries);
    FREE_ARRAY(graphics->textures);
    FREE_ARRAY(graphics->framebuffers);
+   FREE_ARRAY(graphics->samplers);
+
+   free(graphics->shader_cache.directory);
 
    free(graphics);
 
@@ -168,7 +243,7 @@ void Graphics_SetClearDepth(Graphics* graphics, f32 clear_depth)
 
    graphics->clear_depth = clear_depth;
 
-   glClearDepthf(clear_depth);
+   glClearDepthf((graphics->reverse_z) ? 1.0f - clear_depth : clear_depth);
 
 }
 
@@ -193,6 +268,7 @@ void Graphics_SetBlending(Graphics* graphics, u8 blend_mode)
    if ((bool)graphics->state.blend_enable != blend_enable)
    {
       graphics->state.blend_enable = (u16)blend_enable;
+      graphics->stats.state_changes++;
 
       if(blend_enable)
          glEnable(GL_BLEND);
@@ -202,6 +278,8 @@ void Graphics_SetBlending(Graphics* graphics, u8 blend_mode)
 
    if ((graphics->state.blend_mode != blend_mode) && blend_enable)
    {
+      graphics->stats.state_changes++;
+
       switch (blend_mode)
       {
          case GFX_BLENDMODE_MIX:
@@ -243,6 +321,7 @@ void Graphics_SetDepthTest(Graphics* graphics, u8 depth_mode)
    if ((bool)graphics->state.depthtest_enable != depthtest_enable)
    {
       graphics->state.depthtest_enable = (u16)depthtest_enable;
+      graphics->stats.state_changes++;
 
       if(depthtest_enable)
          glEnable(GL_DEPTH_TEST);
@@ -252,7 +331,9 @@ void Graphics_SetDepthTest(Graphics* graphics, u8 depth_mode)
 
    if ((graphics->state.depth_mode != depth_mode) && depthtest_enable)
    {
-      switch (depth_mode)
+      graphics->stats.state_changes++;
+
+      switch (GFX_DepthModeForConvention(depth_mode, graphics->reverse_z))
       {
          case GFX_DEPTHMODE_LESS_THAN:
             glDepthFunc(GL_LESS);
@@ -291,13 +372,63 @@ void Graphics_SetDepthTest(Graphics* graphics, u8 depth_mode)
 
 }
 
+bool Graphics_EnableReverseZ(Graphics* graphics, bool enable_reverse_z)
+{
+   if (graphics == NULL)
+      return false;
+
+   if ((bool)graphics->reverse_z == enable_reverse_z)
+      return enable_reverse_z;
+
+   if (glClipControl == NULL)
+   {
+      error err = { 0 };
+      err.general = ERR_LEVEL_WARN;
+      err.extra = ERR_GFX_FEATURE_UNSUPPORTED;
+
+      Util_Log(NULL, GRAPHICS_MODULE, err, "Reverse-Z needs glClipControl (GL 4.5), staying with regular depth");
+
+      return false;
+   }
+
+   graphics->reverse_z = enable_reverse_z;
+
+   if (enable_reverse_z)
+      glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+   else
+      glClipControl(GL_LOWER_LEFT, GL_NEGATIVE_ONE_TO_ONE);
+
+   Graphics_SetClearDepth(graphics, graphics->clear_depth);
+
+   // force the depth func to be re-applied with the new convention
+   u8 depth_mode = graphics->state.depth_mode;
+   graphics->state.depth_mode = GFX_DEPTHMODE_NONE;
+   Graphics_SetDepthTest(graphics, depth_mode);
+
+   GFX_CheckOpenGLError();
+
+   return enable_reverse_z;
+}
+
+bool Graphics_IsReverseZ(Graphics* graphics)
+{
+   if (graphics == NULL)
+      return false;
+
+   return graphics->reverse_z;
+}
+
 void Graphics_SetDepthMask(Graphics* graphics, bool depth_mask)
 {
    if (graphics == NULL)
       return;
 
    if ((bool)graphics->state.depthmask_enable != depth_mask)
+   {
       glDepthMask((GLboolean)depth_mask);
+      graphics->stats.state_changes++;
+
+   }
 
    graphics->state.depthmask_enable = depth_mask;
 
@@ -318,6 +449,12 @@ void Graphics_DrawInstanced(Graphics* graphics, Shader res_shader, Geometry res_
    if (!GFX_IsShaderValid(shader, res_shader))
       return;
 
+   // still compiling (or failed), just skip the draw
+   if (GFX_ResolveShader(graphics, &graphics->shaders[res_shader.handle], false) != GFX_SHADERSTATUS_READY)
+      return;
+
+   shader = graphics->shaders[res_shader.handle];
+
    if (shader.is_compute)
    {
       error err = { 0 };
@@ -339,7 +476,67 @@ void Graphics_DrawInstanced(Graphics* graphics, Shader res_shader, Geometry res_
    glUseProgram(shader.id.program);
 
    GFX_BindUniformBlocks(graphics, uniforms);
-   GFX_DrawVertices(geometry.primitive, geometry.element_count, (geometry.id.i_buf != 0), geometry.index_type, geometry.id.vao, 0, instance_count);
+   GFX_DrawVertices(geometry.primitive, geometry.element_count, geometry.is_indexed, geometry.index_type, geometry.id.vao, geometry.is_indexed ? (i32)geometry.index_offset : 0, instance_count);
+
+   u32 drawn_instances = M_MAX(instance_count, 1u);
+   graphics->stats.draw_calls++;
+   graphics->stats.shader_binds++;
+   graphics->stats.instances += drawn_instances;
+   graphics->stats.primitives += (u64)GFX_PrimitiveCount(geometry.primitive, geometry.element_count) * drawn_instances;
+
+   glUseProgram(0);
+
+}
+
+void Graphics_DrawIndirect(Graphics* graphics, Shader res_shader, Geometry res_geometry, Buffer command_buffer, uS command_offset, UniformBlockList uniforms)
+{
+   if (graphics == NULL || !Util_IsHandleValid(graphics->shaders, res_shader) || !Util_IsHandleValid(graphics->geometries, res_geometry) || !Util_IsHandleValid(graphics->buffers, command_buffer))
+      return;
+
+   gfx_Shader shader = graphics->shaders[res_shader.handle];
+   if (!GFX_IsShaderValid(shader, res_shader))
+      return;
+
+   if (GFX_ResolveShader(graphics, &graphics->shaders[res_shader.handle], false) != GFX_SHADERSTATUS_READY)
+      return;
+
+   shader = graphics->shaders[res_shader.handle];
+
+   if (shader.is_compute)
+   {
+      error err = { 0 };
+      err.general = ERR_LEVEL_ERROR;
+      err.extra = ERR_GFX_SHADER_WRONG_TYPE;
+      err.flags |= ERR_FLAG_SHADER_WAS_COMPUTE;
+
+      Util_Log(NULL, GRAPHICS_MODULE, err, "Cannot use compute shader in draw call!");
+
+      return;
+   }
+
+   gfx_Geometry geometry = graphics->geometries[res_geometry.handle];
+   gfx_Buffer buffer = graphics->buffers[command_buffer.handle];
+   if (!GFX_IsGeometryValid(geometry, res_geometry) || !GFX_IsBufferValid(buffer, command_buffer) || !geometry.is_indexed)
+      return;
+
+   GFX_SetFaceCullMode(graphics, geometry.face_cull_mode);
+
+   glUseProgram(shader.id.program);
+
+   GFX_BindUniformBlocks(graphics, uniforms);
+
+   // the command's first index is counted from the start of the buffer, rings aren't offset for
+   i32 gl_index_type = (geometry.index_type == GFX_INDEXTYPE_16BIT) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+   glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer.id.buf);
+   glBindVertexArray(geometry.id.vao);
+   glDrawElementsIndirect(GFX_Primitive(geometry.primitive), gl_index_type, (void*)command_offset);
+   glBindVertexArray(0);
+   glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+   graphics->stats.draw_calls++;
+   graphics->stats.shader_binds++;
+   graphics->stats.instances++;
 
    glUseProgram(0);
 
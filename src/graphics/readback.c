@@ -0,0 +1,325 @@
+#include "util/types.h"
+#include "util/math.h"
+#include "util/handle.h"
+
+#include "graphics.h"
+#include "graphics/internal.h"
+
+#include <glad/gl.h>
+
+#include <string.h>
+
+static gfx_Readback* GFX_GetReadback(Graphics* graphics, Readback res_readback)
+{
+   if (res_readback.id == INVALID_HANDLE_ID || res_readback.handle >= GFX_MAX_READBACKS)
+      return NULL;
+
+   gfx_Readback* readback = &graphics->readbacks.slots[res_readback.handle];
+   if (readback->state == GFX_READBACK_FREE || readback->generation != res_readback.ref)
+      return NULL;
+
+   return readback;
+}
+
+// grabs a free slot and makes sure its buffer is bound to the pack target and big enough
+static Readback GFX_BeginReadback(Graphics* graphics, Image layout)
+{
+   u32 slot_i = 0;
+   while (slot_i < GFX_MAX_READBACKS && graphics->readbacks.slots[slot_i].state != GFX_READBACK_FREE)
+      slot_i++;
+
+   if (slot_i >= GFX_MAX_READBACKS)
+      return NULLHANDLE;
+
+   gfx_Readback* readback = &graphics->readbacks.slots[slot_i];
+   uS size = Image_MipSize(&layout, 0);
+
+   if (readback->pbo == 0)
+      glGenBuffers(1, &readback->pbo);
+
+   glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->pbo);
+
+   if (readback->capacity < size)
+   {
+      glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)size, NULL, GL_STREAM_READ);
+      readback->capacity = size;
+
+   }
+
+   readback->layout = layout;
+   readback->layout.data = NULL;
+   readback->sequence = graphics->readbacks.next_sequence++;
+   readback->generation++;
+   readback->state = GFX_READBACK_PENDING;
+
+   return (handle){ .handle = (u16)slot_i, .ref = readback->generation };
+}
+
+static void GFX_EndReadback(Graphics* graphics, Readback res_readback)
+{
+   gfx_Readback* readback = &graphics->readbacks.slots[res_readback.handle];
+   readback->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+   // no fence means nothing to poll, so wait for the copy here instead of leaving the slot pending forever
+   if (readback->fence == NULL)
+   {
+      glFinish();
+      readback->state = GFX_READBACK_READY;
+
+   }
+
+   glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+   glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+   GFX_CheckOpenGLError();
+
+}
+
+static void GFX_PollReadback(gfx_Readback* readback, u64 timeout_ns)
+{
+   if (readback->state != GFX_READBACK_PENDING)
+      return;
+
+   // the flush makes sure the fence actually gets to the gpu, otherwise polling it could never come back signaled
+   GLenum wait_result = glClientWaitSync((GLsync)readback->fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout_ns);
+   if (wait_result != GL_ALREADY_SIGNALED && wait_result != GL_CONDITION_SATISFIED)
+      return;
+
+   glDeleteSync((GLsync)readback->fence);
+   readback->fence = NULL;
+   readback->state = GFX_READBACK_READY;
+
+}
+
+void GFX_FreeReadbacks(Graphics* graphics)
+{
+   for (u32 slot_i = 0; slot_i < GFX_MAX_READBACKS; slot_i++)
+   {
+      gfx_Readback* readback = &graphics->readbacks.slots[slot_i];
+
+      if (readback->fence != NULL)
+         glDeleteSync((GLsync)readback->fence);
+
+      if (readback->state == GFX_READBACK_MAPPED)
+      {
+         glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->pbo);
+         glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+      }
+
+      if (readback->pbo != 0)
+         glDeleteBuffers(1, &readback->pbo);
+
+   }
+
+   glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+   memset(&graphics->readbacks, 0, sizeof(graphics->readbacks));
+
+}
+
+Readback Graphics_RequestTextureReadback(Graphics* graphics, Texture res_texture, u32 mip_level, u8 cubemap_face)
+{
+   if (graphics == NULL || !Util_IsHandleValid(graphics->textures, res_texture))
+      return NULLHANDLE;
+
+   gfx_Texture texture = graphics->textures[res_texture.handle];
+   if (!GFX_IsTextureValid(texture, res_texture) || mip_level >= texture.mipmap_count)
+      return NULLHANDLE;
+
+   u32 gl_format = 0;
+   u32 gl_type = 0;
+   Image layout = GFX_TextureReadbackLayout(texture, mip_level, &gl_format, &gl_type);
+
+   Readback res_readback = GFX_BeginReadback(graphics, layout);
+   if (res_readback.id == INVALID_HANDLE_ID)
+      return NULLHANDLE;
+
+   u32 gl_target = GFX_TextureType(texture.type);
+   glBindTexture(gl_target, texture.id.tex);
+   GFX_TrackBoundTexture(graphics, texture.id.tex);
+
+   if (texture.type == GFX_TEXTURETYPE_CUBEMAP)
+      gl_target = GL_TEXTURE_CUBE_MAP_POSITIVE_X + cubemap_face;
+
+   // with a pack buffer bound the pointer is an offset into it
+   glPixelStorei(GL_PACK_ALIGNMENT, 1);
+   glGetTexImage(gl_target, (i32)mip_level, gl_format, gl_type, NULL);
+
+   GFX_EndReadback(graphics, res_readback);
+
+   return res_readback;
+}
+
+Readback Graphics_RequestFramebufferReadback(Graphics* graphics, Framebuffer res_framebuffer, u8 attachment_slot, res2D size)
+{
+   if (graphics == NULL || size.width <= 0 || size.height <= 0)
+      return NULLHANDLE;
+
+   u32 fbo = 0;
+   if (res_framebuffer.id != INVALID_HANDLE_ID)
+   {
+      if (!Util_IsHandleValid(graphics->framebuffers, res_framebuffer))
+         return NULLHANDLE;
+
+      gfx_Framebuffer framebuffer = graphics->framebuffers[res_framebuffer.handle];
+      if (!GFX_IsFramebufferValid(framebuffer, res_framebuffer))
+         return NULLHANDLE;
+
+      fbo = framebuffer.id.fbo;
+
+   }
+
+   Image layout = { 0 };
+   layout.size.width = size.width;
+   layout.size.height = size.height;
+   layout.size.depth = 1;
+   layout.mipmap_count = 1;
+   layout.channel_count = 4;
+   layout.image_type = IMG_TYPE_2D;
+   layout.image_format = IMG_FORMAT_U8;
+
+   Readback res_readback = GFX_BeginReadback(graphics, layout);
+   if (res_readback.id == INVALID_HANDLE_ID)
+      return NULLHANDLE;
+
+   i32 previous_read_fbo = 0;
+   glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous_read_fbo);
+
+   glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+
+   // the default framebuffer already reads from the right buffer, pbuffers and offscreen contexts might not have a back one.
+   // the read buffer is framebuffer state, so it's put back before letting go of the fbo
+   i32 previous_read_buffer = GL_NONE;
+   if (fbo != 0)
+   {
+      glGetIntegerv(GL_READ_BUFFER, &previous_read_buffer);
+      glReadBuffer(GL_COLOR_ATTACHMENT0 + attachment_slot);
+
+   }
+
+   glPixelStorei(GL_PACK_ALIGNMENT, 1);
+   glReadPixels(0, 0, size.width, size.height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+   if (fbo != 0)
+      glReadBuffer((u32)previous_read_buffer);
+
+   glBindFramebuffer(GL_READ_FRAMEBUFFER, (u32)previous_read_fbo);
+
+   GFX_EndReadback(graphics, res_readback);
+
+   return res_readback;
+}
+
+u8 Graphics_GetReadbackStatus(Graphics* graphics, Readback res_readback)
+{
+   if (graphics == NULL)
+      return GFX_READBACKSTATUS_INVALID;
+
+   gfx_Readback* readback = GFX_GetReadback(graphics, res_readback);
+   if (readback == NULL)
+      return GFX_READBACKSTATUS_INVALID;
+
+   GFX_PollReadback(readback, 0);
+
+   return (readback->state == GFX_READBACK_PENDING) ? GFX_READBACKSTATUS_PENDING : GFX_READBACKSTATUS_READY;
+}
+
+u8 Graphics_WaitReadback(Graphics* graphics, Readback res_readback, u64 timeout_ns)
+{
+   if (graphics == NULL)
+      return GFX_READBACKSTATUS_INVALID;
+
+   gfx_Readback* readback = GFX_GetReadback(graphics, res_readback);
+   if (readback == NULL)
+      return GFX_READBACKSTATUS_INVALID;
+
+   GFX_PollReadback(readback, timeout_ns);
+
+   return (readback->state == GFX_READBACK_PENDING) ? GFX_READBACKSTATUS_PENDING : GFX_READBACKSTATUS_READY;
+}
+
+Readback Graphics_NextReadyReadback(Graphics* graphics)
+{
+   if (graphics == NULL)
+      return NULLHANDLE;
+
+   u32 oldest_i = GFX_MAX_READBACKS;
+   for (u32 slot_i = 0; slot_i < GFX_MAX_READBACKS; slot_i++)
+   {
+      gfx_Readback* readback = &graphics->readbacks.slots[slot_i];
+      GFX_PollReadback(readback, 0);
+
+      if (readback->state != GFX_READBACK_READY)
+         continue;
+
+      if (oldest_i == GFX_MAX_READBACKS || readback->sequence < graphics->readbacks.slots[oldest_i].sequence)
+         oldest_i = slot_i;
+
+   }
+
+   if (oldest_i == GFX_MAX_READBACKS)
+      return NULLHANDLE;
+
+   return (handle){ .handle = (u16)oldest_i, .ref = graphics->readbacks.slots[oldest_i].generation };
+}
+
+Image Graphics_MapReadback(Graphics* graphics, Readback res_readback)
+{
+   if (graphics == NULL)
+      return (Image){ NULL };
+
+   gfx_Readback* readback = GFX_GetReadback(graphics, res_readback);
+   if (readback == NULL)
+      return (Image){ NULL };
+
+   GFX_PollReadback(readback, 0);
+
+   if (readback->state == GFX_READBACK_PENDING)
+      return (Image){ NULL };
+
+   if (readback->state == GFX_READBACK_READY)
+   {
+      uS size = Image_MipSize(&readback->layout, 0);
+
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->pbo);
+      readback->layout.data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)size, GL_MAP_READ_BIT);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+      if (readback->layout.data == NULL)
+         return (Image){ NULL };
+
+      readback->state = GFX_READBACK_MAPPED;
+
+   }
+
+   return readback->layout;
+}
+
+void Graphics_ReleaseReadback(Graphics* graphics, Readback res_readback)
+{
+   if (graphics == NULL)
+      return;
+
+   gfx_Readback* readback = GFX_GetReadback(graphics, res_readback);
+   if (readback == NULL)
+      return;
+
+   if (readback->fence != NULL)
+   {
+      glDeleteSync((GLsync)readback->fence);
+      readback->fence = NULL;
+
+   }
+
+   if (readback->state == GFX_READBACK_MAPPED)
+   {
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->pbo);
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+   }
+
+   readback->layout.data = NULL;
+   readback->state = GFX_READBACK_FREE;
+
+}
@@ -0,0 +1,200 @@
+#include "util/types.h"
+#include "util/files.h"
+
+#include "graphics.h"
+#include "graphics/internal.h"
+
+#include <glad/gl.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GFX_SHADER_CACHE_MAGIC 0x42534345u // "ECSB"
+#define GFX_SHADER_CACHE_VERSION 1u
+
+typedef struct gfx_ShaderCacheHeader_t
+{
+   u32 magic;
+   u32 version;
+   u64 cache_key;
+   u32 binary_format;
+   u32 binary_size;
+
+} gfx_ShaderCacheHeader;
+
+static char* GFX_ShaderCachePath(Graphics* graphics, u64 cache_key)
+{
+   const char* template = "%s/%016llx.glbin";
+
+   i32 path_length = snprintf(NULL, 0, template, graphics->shader_cache.directory, (unsigned long long)cache_key) + 1;
+   char* cache_path = malloc(path_length);
+   if (cache_path == NULL)
+      return NULL;
+
+   snprintf(cache_path, path_length, template, graphics->shader_cache.directory, (unsigned long long)cache_key);
+
+   return cache_path;
+}
+
+void Graphics_SetShaderCacheDirectory(Graphics* graphics, const char* directory_path)
+{
+   if (graphics == NULL)
+      return;
+
+   free(graphics->shader_cache.directory);
+   graphics->shader_cache.directory = NULL;
+
+   if (directory_path == NULL)
+      return;
+
+   GLint binary_format_count = 0;
+   glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binary_format_count);
+
+   if (binary_format_count <= 0 || !Util_MakeDirectory(directory_path))
+   {
+      error err = { 0 };
+      err.general = ERR_LEVEL_WARN;
+      err.extra = ERR_GFX_FEATURE_UNSUPPORTED;
+
+      Util_Log(NULL, GRAPHICS_MODULE, err, "Shader cache disabled (directory: %s, binary formats: %d)", directory_path, binary_format_count);
+
+      return;
+   }
+
+   uS directory_length = strnlen(directory_path, PATH_CHARACTER_LIMIT);
+   graphics->shader_cache.directory = malloc(directory_length + 1);
+   if (graphics->shader_cache.directory == NULL)
+      return;
+
+   memcpy(graphics->shader_cache.directory, directory_path, directory_length);
+   graphics->shader_cache.directory[directory_length] = '\0';
+
+   // a driver update invalidates every binary, so the driver strings are part of every key
+   const char* driver_strings[3] = {
+      (const char*)glGetString(GL_VENDOR),
+      (const char*)glGetString(GL_RENDERER),
+      (const char*)glGetString(GL_VERSION)
+   };
+
+   u64 driver_hash = UTIL_HASH_SEED;
+   for (u32 string_i = 0; string_i < 3; string_i++)
+   {
+      if (driver_strings[string_i] != NULL)
+         driver_hash = Util_HashBytes(driver_strings[string_i], strlen(driver_strings[string_i]) + 1, driver_hash);
+
+   }
+
+   graphics->shader_cache.driver_hash = driver_hash;
+
+}
+
+u64 GFX_ShaderCacheKey(Graphics* graphics, const char* sources[], u32 source_count)
+{
+   if (graphics->shader_cache.directory == NULL)
+      return 0;
+
+   u64 cache_key = Util_HashBytes(&source_count, sizeof(source_count), graphics->shader_cache.driver_hash);
+   for (u32 source_i = 0; source_i < source_count; source_i++)
+   {
+      if (sources[source_i] != NULL)
+         cache_key = Util_HashBytes(sources[source_i], strlen(sources[source_i]) + 1, cache_key);
+
+   }
+
+   return cache_key;
+}
+
+// returns 0 if there's nothing usable cached, the caller just compiles like normal then.
+u32 GFX_LoadCachedProgram(Graphics* graphics, u64 cache_key)
+{
+   if (graphics->shader_cache.directory == NULL)
+      return 0;
+
+   char* cache_path = GFX_ShaderCachePath(graphics, cache_key);
+   memblob cache_data = Util_LoadFileIntoMemory(cache_path, true);
+   free(cache_path);
+
+   if (cache_data.data == NULL)
+      return 0;
+
+   gfx_ShaderCacheHeader header = { 0 };
+   if (cache_data.size >= sizeof(header))
+      memcpy(&header, cache_data.data, sizeof(header));
+
+   bool is_header_valid =
+      (header.magic == GFX_SHADER_CACHE_MAGIC) &&
+      (header.version == GFX_SHADER_CACHE_VERSION) &&
+      (header.cache_key == cache_key) &&
+      (header.binary_size > 0) &&
+      ((uS)header.binary_size == cache_data.size - sizeof(header));
+
+   u32 gl_program = 0;
+
+   if (is_header_valid)
+   {
+      gl_program = glCreateProgram();
+      glProgramBinary(gl_program, header.binary_format, (u8*)cache_data.data + sizeof(header), (GLsizei)header.binary_size);
+
+      // the driver is allowed to reject a binary for any reason, that just means a fresh compile
+      GLint link_status = GL_FALSE;
+      glGetProgramiv(gl_program, GL_LINK_STATUS, &link_status);
+      if (!link_status)
+      {
+         glDeleteProgram(gl_program);
+         gl_program = 0;
+
+      }
+
+   }
+
+   free(cache_data.data);
+
+   return gl_program;
+}
+
+void GFX_StoreCachedProgram(Graphics* graphics, u64 cache_key, u32 gl_program)
+{
+   if (graphics->shader_cache.directory == NULL || gl_program == 0)
+      return;
+
+   GLint binary_size = 0;
+   glGetProgramiv(gl_program, GL_PROGRAM_BINARY_LENGTH, &binary_size);
+   if (binary_size <= 0)
+      return;
+
+   memblob cache_data = { 0 };
+   cache_data.size = sizeof(gfx_ShaderCacheHeader) + (uS)binary_size;
+   cache_data.data = malloc(cache_data.size);
+   if (cache_data.data == NULL)
+      return;
+
+   gfx_ShaderCacheHeader header = { 0 };
+   header.magic = GFX_SHADER_CACHE_MAGIC;
+   header.version = GFX_SHADER_CACHE_VERSION;
+   header.cache_key = cache_key;
+
+   GLsizei written_size = 0;
+   GLenum binary_format = 0;
+   glGetProgramBinary(gl_program, binary_size, &written_size, &binary_format, (u8*)cache_data.data + sizeof(header));
+
+   header.binary_format = binary_format;
+   header.binary_size = (u32)written_size;
+   memcpy(cache_data.data, &header, sizeof(header));
+
+   cache_data.size = sizeof(header) + (uS)written_size;
+
+   char* cache_path = GFX_ShaderCachePath(graphics, cache_key);
+   if (written_size > 0 && !Util_SaveMemoryToFile(cache_path, cache_data))
+   {
+      error err = { 0 };
+      err.general = ERR_LEVEL_WARN;
+
+      Util_Log(NULL, GRAPHICS_MODULE, err, "Couldn't write shader cache entry: %s", cache_path);
+
+   }
+
+   free(cache_path);
+   free(cache_data.data);
+
+}
@@ -10,99 +10,95 @@
 
 #include <stdlib.h>
 
-Shader Graphics_CreateShader(Graphics* graphics, const char* vertex_shader, const char* fragment_shader)
+static Shader GFX_AddShader(Graphics* graphics, gfx_Shader shader)
 {
-   if (graphics == NULL)
-      return (handle){ .id = INVALID_HANDLE_ID };
+   if (graphics->freed_shader_root == INVALID_HANDLE)
+      return ADD_HANDLE(graphics->shaders, shader);
 
-   gfx_Shader shader = { 0 };
-   shader.is_compute = false;
+   return REUSE_HANDLE(graphics->shaders, shader, graphics->freed_shader_root);
+}
 
-   u32 shd_vrt = glCreateShader(GL_VERTEX_SHADER);
-   glShaderSource(shd_vrt, 1, &vertex_shader, NULL);
-   glCompileShader(shd_vrt);
+// kicks off the compile and link, nothing here waits on the driver.
+static Shader GFX_BeginShader(Graphics* graphics, const char* sources[], const u32 stage_types[], u32 stage_count, bool is_compute)
+{
+   gfx_Shader shader = { 0 };
+   shader.is_compute = is_compute;
+   shader.status = GFX_SHADERSTATUS_READY;
+   shader.cache_key = GFX_ShaderCacheKey(graphics, sources, stage_count);
 
-   u32 shd_frg = glCreateShader(GL_FRAGMENT_SHADER);
-   glShaderSource(shd_frg, 1, &fragment_shader, NULL);
-   glCompileShader(shd_frg);
+   shader.id.program = GFX_LoadCachedProgram(graphics, shader.cache_key);
+   if (shader.id.program != 0)
+      return GFX_AddShader(graphics, shader);
 
-   u32 shd_id = glCreateProgram();
-   glAttachShader(shd_id, shd_vrt);
-   glAttachShader(shd_id, shd_frg);
-   glLinkProgram(shd_id);
+   shader.id.program = glCreateProgram();
 
-   i32 shd_sucess = 1;
-   glGetProgramiv(shd_id, GL_LINK_STATUS, &shd_sucess);
-   if (!shd_sucess)
+   for (u32 stage_i = 0; stage_i < stage_count; stage_i++)
    {
-      char shd_log[1024] = { 0 };
-      glGetProgramInfoLog(shd_id, sizeof(shd_log), NULL, shd_log);
+      shader.id.stages[stage_i] = glCreateShader(stage_types[stage_i]);
+      glShaderSource(shader.id.stages[stage_i], 1, &sources[stage_i], NULL);
+      glCompileShader(shader.id.stages[stage_i]);
+      glAttachShader(shader.id.program, shader.id.stages[stage_i]);
 
-      error err = { 0 };
-      err.general = ERR_LEVEL_ERROR;
-      err.extra = ERR_GFX_SHADER_COMPILATION_FAILED;
-      err.flags |= ERR_FLAG_SHADER_WAS_NOT_COMPUTE | ERR_FLAG_BAD_SHADER_CODE;
-
-      Util_Log(NULL, GRAPHICS_MODULE, err, "Shader Failed To Compile!\n%s", shd_log);
-
-      return (handle){ .id = INVALID_HANDLE_ID };
    }
 
-   glDeleteShader(shd_vrt);
-   glDeleteShader(shd_frg);
+   if (graphics->shader_cache.directory != NULL)
+      glProgramParameteri(shader.id.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 
-   shader.id.program = shd_id;
-
-   if (graphics->freed_shader_root == INVALID_HANDLE)
-      return ADD_HANDLE(graphics->shaders, shader);
+   glLinkProgram(shader.id.program);
+   shader.status = GFX_SHADERSTATUS_PENDING;
 
-   return REUSE_HANDLE(graphics->shaders, shader, graphics->freed_shader_root);
+   return GFX_AddShader(graphics, shader);
 }
 
-Shader Graphics_CreateComputeShader(Graphics* graphics, const char* compute_shader)
+// a pending shader can't be finished without waiting
+static Shader GFX_FinishShader(Graphics* graphics, Shader res_shader)
 {
-   if (graphics == NULL)
-      return (handle){ .id = INVALID_HANDLE_ID };
+   if (res_shader.id == INVALID_HANDLE_ID)
+      return res_shader;
 
-   gfx_Shader shader = { 0 };
-   shader.is_compute = true;
+   if (GFX_ResolveShader(graphics, &graphics->shaders[res_shader.handle], true) != GFX_SHADERSTATUS_READY)
+   {
+      Graphics_FreeShader(graphics, res_shader);
 
-   u32 shd_cmp = glCreateShader(GL_COMPUTE_SHADER);
-   glShaderSource(shd_cmp, 1, &compute_shader, NULL);
-   glCompileShader(shd_cmp);
+      return (handle){ .id = INVALID_HANDLE_ID };
+   }
 
-   u32 shd_id = glCreateProgram();
-   glAttachShader(shd_id, shd_cmp);
-   glLinkProgram(shd_id);
+   return res_shader;
+}
 
-   i32 shd_sucess = 1;
-   glGetProgramiv(shd_id, GL_LINK_STATUS, &shd_sucess);
-   if (!shd_sucess)
-   {
-      char shd_log[1024] = { 0 };
-      glGetProgramInfoLog(shd_id, sizeof(shd_log), NULL, shd_log);
+Shader Graphics_CreateShaderAsync(Graphics* graphics, const char* vertex_shader, const char* fragment_shader)
+{
+   if (graphics == NULL)
+      return (handle){ .id = INVALID_HANDLE_ID };
 
-      error err = { 0 };
-      err.general = ERR_LEVEL_ERROR;
-      err.extra = ERR_GFX_SHADER_COMPILATION_FAILED;
-      err.flags |= ERR_FLAG_SHADER_WAS_COMPUTE | ERR_FLAG_BAD_SHADER_CODE;
+   const char* sources[2] = { vertex_shader, fragment_shader };
+   const u32 stage_types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
 
-      Util_Log(NULL, GRAPHICS_MODULE, err, "Compute Shader Failed To Compile!\n%s", shd_log);
+   return GFX_BeginShader(graphics, sources, stage_types, 2, false);
+}
 
+Shader Graphics_CreateComputeShaderAsync(Graphics* graphics, const char* compute_shader)
+{
+   if (graphics == NULL)
       return (handle){ .id = INVALID_HANDLE_ID };
-   }
 
-   glDeleteShader(shd_cmp);
+   const char* sources[1] = { compute_shader };
+   const u32 stage_types[1] = { GL_COMPUTE_SHADER };
 
-   shader.id.program = shd_id;
+   return GFX_BeginShader(graphics, sources, stage_types, 1, true);
+}
 
-   if (graphics->freed_shader_root == INVALID_HANDLE)
-      return ADD_HANDLE(graphics->shaders, shader);
+Shader Graphics_CreateShader(Graphics* graphics, const char* vertex_shader, const char* fragment_shader)
+{
+   return GFX_FinishShader(graphics, Graphics_CreateShaderAsync(graphics, vertex_shader, fragment_shader));
+}
 
-   return REUSE_HANDLE(graphics->shaders, shader, graphics->freed_shader_root);
+Shader Graphics_CreateComputeShader(Graphics* graphics, const char* compute_shader)
+{
+   return GFX_FinishShader(graphics, Graphics_CreateComputeShaderAsync(graphics, compute_shader));
 }
 
-Shader Graphics_LoadShaderFromFile(Graphics* graphics, const char* file_path, const char* defines[], const u32 define_count, bool is_compute)
+static Shader GFX_LoadShaderFromFile(Graphics* graphics, const char* file_path, const char* defines[], const u32 define_count, bool is_compute, bool is_async)
 {
    if (graphics == NULL || file_path == NULL)
       return (handle){ .id = INVALID_HANDLE_ID };
@@ -119,7 +115,9 @@ Shader Graphics_LoadShaderFromFile(Graphics* graphics, const char* file_path, co
    {
       memblob compute_shader_code = Util_PrependShaderDefines(shader_data, defines, define_count, NULL);
 
-      res_shader = Graphics_CreateComputeShader(graphics, compute_shader_code.data);
+      res_shader = Graphics_CreateComputeShaderAsync(graphics, compute_shader_code.data);
+      if (!is_async)
+         res_shader = GFX_FinishShader(graphics, res_shader);
 
       if (res_shader.id == INVALID_HANDLE_ID)
       {
@@ -136,7 +134,9 @@ Shader Graphics_LoadShaderFromFile(Graphics* graphics, const char* file_path, co
       memblob vert_shader_code = Util_PrependShaderDefines(shader_data, defines, define_count, "#define VERT");
       memblob frag_shader_code = Util_PrependShaderDefines(shader_data, defines, define_count, "#define FRAG");
 
-      res_shader = Graphics_CreateShader(graphics, vert_shader_code.data, frag_shader_code.data);
+      res_shader = Graphics_CreateShaderAsync(graphics, vert_shader_code.data, frag_shader_code.data);
+      if (!is_async)
+         res_shader = GFX_FinishShader(graphics, res_shader);
 
       if (res_shader.id == INVALID_HANDLE_ID)
       {
@@ -159,6 +159,40 @@ Shader Graphics_LoadShaderFromFile(Graphics* graphics, const char* file_path, co
    return res_shader;
 }
 
+Shader Graphics_LoadShaderFromFile(Graphics* graphics, const char* file_path, const char* defines[], const u32 define_count, bool is_compute)
+{
+   return GFX_LoadShaderFromFile(graphics, file_path, defines, define_count, is_compute, false);
+}
+
+Shader Graphics_LoadShaderFromFileAsync(Graphics* graphics, const char* file_path, const char* defines[], const u32 define_count, bool is_compute)
+{
+   return GFX_LoadShaderFromFile(graphics, file_path, defines, define_count, is_compute, true);
+}
+
+u8 Graphics_GetShaderStatus(Graphics* graphics, Shader res_shader)
+{
+   if (graphics == NULL || !Util_IsHandleValid(graphics->shaders, res_shader))
+      return GFX_SHADERSTATUS_FAILED;
+
+   gfx_Shader* shader = &graphics->shaders[res_shader.handle];
+   if (shader->compare.id != res_shader.id)
+      return GFX_SHADERSTATUS_FAILED;
+
+   return GFX_ResolveShader(graphics, shader, false);
+}
+
+u8 Graphics_WaitForShader(Graphics* graphics, Shader res_shader)
+{
+   if (graphics == NULL || !Util_IsHandleValid(graphics->shaders, res_shader))
+      return GFX_SHADERSTATUS_FAILED;
+
+   gfx_Shader* shader = &graphics->shaders[res_shader.handle];
+   if (shader->compare.id != res_shader.id)
+      return GFX_SHADERSTATUS_FAILED;
+
+   return GFX_ResolveShader(graphics, shader, true);
+}
+
 void Graphics_FreeShader(Graphics* graphics, Shader res_shader)
 {
    if (graphics == NULL || !Util_IsHandleValid(graphics->shaders, res_shader))
@@ -171,6 +205,13 @@ void Graphics_FreeShader(Graphics* graphics, Shader res_shader)
    shader->next_freed = graphics->freed_shader_root;
    graphics->freed_shader_root = (u32)res_shader.handle;
 
+   for (u32 stage_i = 0; stage_i < 2; stage_i++)
+   {
+      glDeleteShader(shader->id.stages[stage_i]);
+      shader->id.stages[stage_i] = 0;
+
+   }
+
    glDeleteProgram(shader->id.program);
 }
 
@@ -183,6 +224,11 @@ void Graphics_Dispatch(Graphics* graphics, Shader res_shader, u32 size_x, u32 si
    if (!GFX_IsShaderValid(shader, res_shader))
       return;
 
+   if (GFX_ResolveShader(graphics, &graphics->shaders[res_shader.handle], false) != GFX_SHADERSTATUS_READY)
+      return;
+
+   shader = graphics->shaders[res_shader.handle];
+
    if (!shader.is_compute)
    {
       error err = { 0 };
@@ -201,6 +247,9 @@ void Graphics_Dispatch(Graphics* graphics, Shader res_shader, u32 size_x, u32 si
 
    glDispatchCompute(size_x, size_y, size_z);
 
+   graphics->stats.dispatches++;
+   graphics->stats.shader_binds++;
+
    glUseProgram(0);
 
 }
@@ -210,7 +259,7 @@ void Graphics_DispatchBarrier(Graphics* graphics)
    if (graphics == NULL)
       return;
 
-   glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+   glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_ELEMENT_ARRAY_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
 
 }
 
@@ -223,3 +272,52 @@ void GFX_BindUniformBlocks(Graphics* graphics, UniformBlockList uniform_blocks)
       Graphics_BindBuffer(graphics, uniform_blocks.blocks[i].ubo, uniform_blocks.blocks[i].binding);
 
 }
+
+// without the parallel compile extension there's no way to ask if a link is done without blocking, so the first
+// query just waits for it. the compiles were all started up front though, which lets drivers that thread them overlap the work.
+u8 GFX_ResolveShader(Graphics* graphics, gfx_Shader* shader, bool wait_for_link)
+{
+   if (shader->status != GFX_SHADERSTATUS_PENDING)
+      return shader->status;
+
+   if (!wait_for_link && graphics->has_parallel_compile)
+   {
+      i32 is_complete = GL_FALSE;
+      glGetProgramiv(shader->id.program, GFX_GL_COMPLETION_STATUS, &is_complete);
+      if (!is_complete)
+         return GFX_SHADERSTATUS_PENDING;
+
+   }
+
+   i32 shd_sucess = 1;
+   glGetProgramiv(shader->id.program, GL_LINK_STATUS, &shd_sucess);
+   if (!shd_sucess)
+   {
+      char shd_log[1024] = { 0 };
+      glGetProgramInfoLog(shader->id.program, sizeof(shd_log), NULL, shd_log);
+
+      error err = { 0 };
+      err.general = ERR_LEVEL_ERROR;
+      err.extra = ERR_GFX_SHADER_COMPILATION_FAILED;
+      err.flags |= ERR_FLAG_BAD_SHADER_CODE;
+      err.flags |= (shader->is_compute) ? ERR_FLAG_SHADER_WAS_COMPUTE : ERR_FLAG_SHADER_WAS_NOT_COMPUTE;
+
+      Util_Log(NULL, GRAPHICS_MODULE, err, "%s Failed To Compile!\n%s", (shader->is_compute) ? "Compute Shader" : "Shader", shd_log);
+
+      shader->status = GFX_SHADERSTATUS_FAILED;
+
+   } else {
+      shader->status = GFX_SHADERSTATUS_READY;
+      GFX_StoreCachedProgram(graphics, shader->cache_key, shader->id.program);
+
+   }
+
+   for (u32 stage_i = 0; stage_i < 2; stage_i++)
+   {
+      glDeleteShader(shader->id.stages[stage_i]);
+      shader->id.stages[stage_i] = 0;
+
+   }
+
+   return shader->status;
+}
@@ -0,0 +1,253 @@
+#include "util/types.h"
+#include "util/math.h"
+#include "util/handle.h"
+
+#include "graphics.h"
+#include "graphics/internal.h"
+
+#include <glad/gl.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#define GFX_UPLOAD_SEGMENT_SIZE (GFX_UPLOAD_RING_SIZE / GFX_UPLOAD_RING_SEGMENTS)
+#define GFX_UPLOAD_ALIGNMENT 16u
+
+static void GFX_CreateUploadRing(Graphics* graphics)
+{
+   glGenBuffers(1, &graphics->upload_ring.pbo);
+   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, graphics->upload_ring.pbo);
+
+   // persistent mapping needs 4.4, the context only asks for 4.3 so it might not be there
+   if (glBufferStorage != NULL)
+   {
+      u32 map_flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+      glBufferStorage(GL_PIXEL_UNPACK_BUFFER, GFX_UPLOAD_RING_SIZE, NULL, map_flags);
+      graphics->upload_ring.mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, GFX_UPLOAD_RING_SIZE, map_flags);
+      graphics->upload_ring.is_persistent = (graphics->upload_ring.mapped != NULL);
+
+      // storage is immutable, so a failed map needs a whole new buffer
+      if (!graphics->upload_ring.is_persistent)
+      {
+         glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+         glDeleteBuffers(1, &graphics->upload_ring.pbo);
+         glGenBuffers(1, &graphics->upload_ring.pbo);
+         glBindBuffer(GL_PIXEL_UNPACK_BUFFER, graphics->upload_ring.pbo);
+
+      }
+
+   }
+
+   if (!graphics->upload_ring.is_persistent)
+      glBufferData(GL_PIXEL_UNPACK_BUFFER, GFX_UPLOAD_RING_SIZE, NULL, GL_STREAM_DRAW);
+
+   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+   graphics->upload_ring.head = 0;
+   graphics->upload_ring.segment = 0;
+   graphics->upload_ring.is_created = true;
+
+}
+
+static bool GFX_ReserveUploadRange(Graphics* graphics, uS size, uS* out_offset)
+{
+   uS head = (graphics->upload_ring.head + (GFX_UPLOAD_ALIGNMENT - 1)) & ~(uS)(GFX_UPLOAD_ALIGNMENT - 1);
+   u32 segment = graphics->upload_ring.segment;
+
+   if (head + size > (uS)(segment + 1) * GFX_UPLOAD_SEGMENT_SIZE)
+   {
+      u32 next_segment = (segment + 1) % GFX_UPLOAD_RING_SEGMENTS;
+
+      GLsync next_fence = (GLsync)graphics->upload_ring.fences[next_segment];
+      if (next_fence != NULL)
+      {
+         GLenum wait_result = glClientWaitSync(next_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+         if (wait_result != GL_ALREADY_SIGNALED && wait_result != GL_CONDITION_SATISFIED)
+            return false;
+
+         glDeleteSync(next_fence);
+         graphics->upload_ring.fences[next_segment] = NULL;
+
+      }
+
+      graphics->upload_ring.fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+      graphics->upload_ring.segment = next_segment;
+
+      head = (uS)next_segment * GFX_UPLOAD_SEGMENT_SIZE;
+
+   }
+
+   (*out_offset) = head;
+   graphics->upload_ring.head = head + size;
+
+   return true;
+}
+
+void GFX_FreeUploadRing(Graphics* graphics)
+{
+   if (!graphics->upload_ring.is_created)
+      return;
+
+   for (u32 segment_i = 0; segment_i < GFX_UPLOAD_RING_SEGMENTS; segment_i++)
+   {
+      if (graphics->upload_ring.fences[segment_i] != NULL)
+         glDeleteSync((GLsync)graphics->upload_ring.fences[segment_i]);
+
+   }
+
+   if (graphics->upload_ring.is_persistent)
+   {
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, graphics->upload_ring.pbo);
+      glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+   }
+
+   glDeleteBuffers(1, &graphics->upload_ring.pbo);
+   memset(&graphics->upload_ring, 0, sizeof(graphics->upload_ring));
+
+}
+
+// checks a mip against the storage it's going into, so bad uploads can be told apart from a busy ring
+static u8 GFX_CheckStagedMip(const gfx_Texture* texture, u32 mip_level, uS size, Texture res_texture, uS* out_mip_size)
+{
+   i32 mip_width = M_MAX(texture->width >> mip_level, 1);
+   i32 mip_height = M_MAX(texture->height >> mip_level, 1);
+   (*out_mip_size) = GFX_TextureLevelSize(texture->format, mip_width, mip_height, 1);
+
+   if (texture->type != GFX_TEXTURETYPE_2D || mip_level >= texture->mipmap_count || size < (*out_mip_size))
+   {
+      error err = { 0 };
+      err.general = ERR_LEVEL_ERROR;
+      err.extra = ERR_GFX_TEXTURE_INVALID_HANDLE;
+
+      Util_Log(NULL, GRAPHICS_MODULE, err, "Can't stage mip %u of texture %u, only whole mips of 2D textures can be staged", mip_level, res_texture.id);
+
+      return GFX_STAGE_INVALID;
+   }
+
+   return GFX_STAGE_OK;
+}
+
+// mips too big for a segment skip the ring and go straight from client memory
+static bool GFX_BeginStagedMip(Graphics* graphics, uS mip_size, bool* out_use_ring, uS* out_ring_offset)
+{
+   if (!graphics->upload_ring.is_created)
+      GFX_CreateUploadRing(graphics);
+
+   (*out_ring_offset) = 0;
+   (*out_use_ring) = (mip_size <= GFX_UPLOAD_SEGMENT_SIZE);
+
+   return !(*out_use_ring) || GFX_ReserveUploadRange(graphics, mip_size, out_ring_offset);
+}
+
+static void GFX_UploadStagedMip(Graphics* graphics, const gfx_Texture* texture, u32 mip_level, const u8* data, uS mip_size, bool use_ring, uS ring_offset)
+{
+   i32 mip_width = M_MAX(texture->width >> mip_level, 1);
+   i32 mip_height = M_MAX(texture->height >> mip_level, 1);
+
+   const void* pixels = data;
+
+   if (use_ring)
+   {
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, graphics->upload_ring.pbo);
+
+      if (graphics->upload_ring.is_persistent)
+      {
+         memcpy(graphics->upload_ring.mapped + ring_offset, data, mip_size);
+
+      } else {
+         u32 map_flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+         void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, (GLintptr)ring_offset, (GLsizeiptr)mip_size, map_flags);
+         if (mapped != NULL)
+            memcpy(mapped, data, mip_size);
+
+         glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+      }
+
+      pixels = (const void*)(uintptr_t)ring_offset;
+
+   }
+
+   glBindTexture(GL_TEXTURE_2D, texture->id.tex);
+   GFX_TrackBoundTexture(graphics, texture->id.tex);
+
+   if (GFX_IsCompressedFormat(texture->format))
+   {
+      glCompressedTexSubImage2D(
+         GL_TEXTURE_2D, (i32)mip_level, 0, 0, mip_width, mip_height,
+         (u32)GFX_TextureInternalFormat(texture->format), (i32)mip_size, pixels);
+
+   } else {
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      glTexSubImage2D(
+         GL_TEXTURE_2D, (i32)mip_level, 0, 0, mip_width, mip_height,
+         GFX_TexturePixelFormat(texture->format), GFX_TextureFormatType(texture->format), pixels);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+   }
+
+   if (use_ring)
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+   graphics->stats.buffer_uploads++;
+   graphics->stats.buffer_upload_bytes += mip_size;
+
+}
+
+u8 Graphics_StageTextureMip(Graphics* graphics, Texture res_texture, u32 mip_level, const u8* data, uS size)
+{
+   if (graphics == NULL || data == NULL || !Util_IsHandleValid(graphics->textures, res_texture))
+      return GFX_STAGE_INVALID;
+
+   gfx_Texture texture = graphics->textures[res_texture.handle];
+   if (!GFX_IsTextureValid(texture, res_texture))
+      return GFX_STAGE_INVALID;
+
+   uS mip_size = 0;
+   if (GFX_CheckStagedMip(&texture, mip_level, size, res_texture, &mip_size) != GFX_STAGE_OK)
+      return GFX_STAGE_INVALID;
+
+   bool use_ring = false;
+   uS ring_offset = 0;
+   if (!GFX_BeginStagedMip(graphics, mip_size, &use_ring, &ring_offset))
+      return GFX_STAGE_BUSY;
+
+   GFX_UploadStagedMip(graphics, &texture, mip_level, data, mip_size, use_ring, ring_offset);
+
+   return GFX_STAGE_OK;
+}
+
+u8 Graphics_ReallocateTextureStaged(Graphics* graphics, Texture res_texture, TextureDesc desc, u32 mip_level, const u8* data, uS size)
+{
+   if (graphics == NULL || data == NULL || !Util_IsHandleValid(graphics->textures, res_texture))
+      return GFX_STAGE_INVALID;
+
+   if (!GFX_IsTextureValid(graphics->textures[res_texture.handle], res_texture))
+      return GFX_STAGE_INVALID;
+
+   // what the texture will look like once it's reallocated, checked before anything about it changes
+   gfx_Texture new_texture = { 0 };
+   new_texture.width = desc.size.width;
+   new_texture.height = desc.size.height;
+   new_texture.mipmap_count = M_MAX(desc.mipmap_count, 1);
+   new_texture.type = desc.texture_type;
+   new_texture.format = desc.texture_format;
+
+   uS mip_size = 0;
+   if (desc.size.width < 1 || desc.size.height < 1 || GFX_CheckStagedMip(&new_texture, mip_level, size, res_texture, &mip_size) != GFX_STAGE_OK)
+      return GFX_STAGE_INVALID;
+
+   bool use_ring = false;
+   uS ring_offset = 0;
+   if (!GFX_BeginStagedMip(graphics, mip_size, &use_ring, &ring_offset))
+      return GFX_STAGE_BUSY;
+
+   Graphics_ReallocateTexture(graphics, res_texture, desc);
+
+   gfx_Texture texture = graphics->textures[res_texture.handle];
+   GFX_UploadStagedMip(graphics, &texture, mip_level, data, mip_size, use_ring, ring_offset);
+
+   return GFX_STAGE_OK;
+}
@@ -13,30 +13,70 @@
 #include <assert.h>
 #include <stdlib.h>
 
-Texture Graphics_CreateTexture(Graphics* graphics, u8* data, TextureDesc desc)
+static uS GFX_TextureMemorySize(const gfx_Texture* texture)
 {
-   if (graphics == NULL)
-      return (handle){ .id = INVALID_HANDLE_ID };
+   bool is_cubemap = ((texture->type == GFX_TEXTURETYPE_CUBEMAP) || (texture->type == GFX_TEXTURETYPE_CUBEMAP_ARRAY));
+   uS face_count = is_cubemap ? 6 : 1;
 
-   gfx_Texture texture = { 0 };
-   texture.width = M_MAX(1, desc.size.width);
-   texture.height = M_MAX(1, desc.size.height);
-   texture.depth = M_MAX(1, desc.depth);
-   texture.mipmap_count = M_MAX(1, desc.mipmap_count);
-   texture.type = desc.texture_type;
-   texture.format = desc.texture_format;
+   uS memory_size = 0;
+   for (u32 mip_i = 0; mip_i < texture->mipmap_count; mip_i++)
+   {
+      // only 3D textures get shallower with each mip, array layers stay put
+      i32 mip_depth = (texture->type == GFX_TEXTURETYPE_3D) ? (texture->depth >> mip_i) : texture->depth;
+      memory_size += GFX_TextureLevelSize(texture->format, texture->width >> mip_i, texture->height >> mip_i, mip_depth) * face_count;
 
-   glGenTextures(1, &texture.id.tex);
+   }
 
-   u32 gl_target = GFX_TextureType(texture.type);
+   return memory_size;
+}
+
+static void GFX_InitTexture(Graphics* graphics, gfx_Texture* texture, u8* data, TextureDesc desc)
+{
+   texture->width = M_MAX(1, desc.size.width);
+   texture->height = M_MAX(1, desc.size.height);
+   texture->depth = M_MAX(1, desc.depth);
+   texture->mipmap_count = M_MAX(1, desc.mipmap_count);
+   texture->type = desc.texture_type;
+   texture->format = desc.texture_format;
+
+   glGenTextures(1, &texture->id.tex);
+
+   u32 gl_target = GFX_TextureType(texture->type);
+   glBindTexture(gl_target, texture->id.tex);
    glTexParameteri(gl_target, GL_TEXTURE_WRAP_R, GL_REPEAT);
    glTexParameteri(gl_target, GL_TEXTURE_WRAP_S, GL_REPEAT);
    glTexParameteri(gl_target, GL_TEXTURE_WRAP_T, GL_REPEAT);
    glTexParameteri(gl_target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
    glTexParameteri(gl_target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-   glTexParameteri(gl_target, GL_TEXTURE_MAX_LEVEL, (i32)(texture.mipmap_count));
+   glTexParameteri(gl_target, GL_TEXTURE_MAX_LEVEL, (i32)(texture->mipmap_count));
+
+   GFX_CreateTexture(texture, data, false);
+   GFX_TrackBoundTexture(graphics, texture->id.tex);
+
+   texture->memory_size = GFX_TextureMemorySize(texture);
+   graphics->texture_memory += texture->memory_size;
+
+}
+
+static void GFX_ForgetBoundTexture(Graphics* graphics, u32 gl_texture)
+{
+   // deleting a texture unbinds it everywhere, and GL is free to hand out the same name again
+   for (u32 unit_i = 0; unit_i < GFX_MAX_TEXTURE_UNITS; unit_i++)
+   {
+      if (graphics->bound_textures[unit_i] == gl_texture)
+         graphics->bound_textures[unit_i] = 0;
+
+   }
+
+}
 
-   GFX_CreateTexture(&texture, data, false);
+Texture Graphics_CreateTexture(Graphics* graphics, u8* data, TextureDesc desc)
+{
+   if (graphics == NULL)
+      return (handle){ .id = INVALID_HANDLE_ID };
+
+   gfx_Texture texture = { 0 };
+   GFX_InitTexture(graphics, &texture, data, desc);
 
    texture.compare.handle = Util_ArrayLength(graphics->textures);
 
@@ -46,6 +86,68 @@ Texture Graphics_CreateTexture(Graphics* graphics, u8* data, TextureDesc desc)
    return REUSE_HANDLE(graphics->textures, texture, graphics->freed_texture_root);
 }
 
+void Graphics_ReallocateTexture(Graphics* graphics, Texture res_texture, TextureDesc desc)
+{
+   if (graphics == NULL || !Util_IsHandleValid(graphics->textures, res_texture))
+      return;
+
+   gfx_Texture* texture = &graphics->textures[res_texture.handle];
+   if (!GFX_IsTextureValid(*texture, res_texture))
+      return;
+
+   GFX_ForgetBoundTexture(graphics, texture->id.tex);
+   glDeleteTextures(1, &texture->id.tex);
+   graphics->texture_memory -= texture->memory_size;
+
+   GFX_InitTexture(graphics, texture, NULL, desc);
+
+}
+
+bool Graphics_DropTextureMips(Graphics* graphics, Texture res_texture, u32 drop_count)
+{
+   if (graphics == NULL || !Util_IsHandleValid(graphics->textures, res_texture))
+      return false;
+
+   gfx_Texture* texture = &graphics->textures[res_texture.handle];
+   if (!GFX_IsTextureValid(*texture, res_texture))
+      return false;
+
+   if (texture->type != GFX_TEXTURETYPE_2D || drop_count == 0 || drop_count >= texture->mipmap_count)
+      return false;
+
+   gfx_Texture old_texture = (*texture);
+
+   TextureDesc desc = { 0 };
+   desc.size.width = M_MAX(old_texture.width >> drop_count, 1);
+   desc.size.height = M_MAX(old_texture.height >> drop_count, 1);
+   desc.depth = 1;
+   desc.mipmap_count = (u16)(old_texture.mipmap_count - drop_count);
+   desc.texture_type = old_texture.type;
+   desc.texture_format = old_texture.format;
+
+   graphics->texture_memory -= old_texture.memory_size;
+   GFX_InitTexture(graphics, texture, NULL, desc);
+
+   // the lower mips are already the right data, they just move up the chain
+   for (u32 mip_i = 0; mip_i < texture->mipmap_count; mip_i++)
+   {
+      i32 mip_width = M_MAX(texture->width >> mip_i, 1);
+      i32 mip_height = M_MAX(texture->height >> mip_i, 1);
+
+      glCopyImageSubData(
+         old_texture.id.tex, GL_TEXTURE_2D, (i32)(mip_i + drop_count), 0, 0, 0,
+         texture->id.tex, GL_TEXTURE_2D, (i32)mip_i, 0, 0, 0,
+         mip_width, mip_height, 1
+      );
+
+   }
+
+   GFX_ForgetBoundTexture(graphics, old_texture.id.tex);
+   glDeleteTextures(1, &old_texture.id.tex);
+
+   return true;
+}
+
 void Graphics_FreeTexture(Graphics* graphics, Texture res_texture)
 {
    if (graphics == NULL || !Util_IsHandleValid(graphics->textures, res_texture))
@@ -58,8 +160,12 @@ void Graphics_FreeTexture(Graphics* graphics, Texture res_texture)
    texture->next_freed = graphics->freed_texture_root;
    graphics->freed_texture_root = (u32)res_texture.handle;
 
+   GFX_ForgetBoundTexture(graphics, texture->id.tex);
    glDeleteTextures(1, &texture->id.tex);
 
+   graphics->texture_memory -= texture->memory_size;
+   texture->memory_size = 0;
+
 }
 
 void Graphics_UpdateTexture(Graphics* graphics, u8* data, Texture res_texture)
@@ -72,9 +178,69 @@ void Graphics_UpdateTexture(Graphics* graphics, u8* data, Texture res_texture)
       return;
 
    GFX_CreateTexture(&texture, data, true);
+   GFX_TrackBoundTexture(graphics, texture.id.tex);
 
 }
 
+void Graphics_SetTextureMipRange(Graphics* graphics, Texture res_texture, u32 base_mip, u32 max_mip)
+{
+   if (graphics == NULL || !Util_IsHandleValid(graphics->textures, res_texture))
+      return;
+
+   gfx_Texture texture = graphics->textures[res_texture.handle];
+   if (!GFX_IsTextureValid(texture, res_texture))
+      return;
+
+   u32 gl_target = GFX_TextureType(texture.type);
+
+   glBindTexture(gl_target, texture.id.tex);
+   GFX_TrackBoundTexture(graphics, texture.id.tex);
+
+   glTexParameteri(gl_target, GL_TEXTURE_BASE_LEVEL, (i32)M_MIN(base_mip, max_mip));
+   glTexParameteri(gl_target, GL_TEXTURE_MAX_LEVEL, (i32)max_mip);
+
+}
+
+TextureDesc Graphics_GetTextureDesc(Graphics* graphics, Texture res_texture)
+{
+   if (graphics == NULL || !Util_IsHandleValid(graphics->textures, res_texture))
+      return (TextureDesc){ 0 };
+
+   gfx_Texture texture = graphics->textures[res_texture.handle];
+   if (!GFX_IsTextureValid(texture, res_texture))
+      return (TextureDesc){ 0 };
+
+   TextureDesc desc = { 0 };
+   desc.size.width = texture.width;
+   desc.size.height = texture.height;
+   desc.depth = texture.depth;
+   desc.mipmap_count = texture.mipmap_count;
+   desc.texture_type = texture.type;
+   desc.texture_format = texture.format;
+
+   return desc;
+}
+
+uS Graphics_GetTextureSize(Graphics* graphics, Texture res_texture)
+{
+   if (graphics == NULL || !Util_IsHandleValid(graphics->textures, res_texture))
+      return 0;
+
+   gfx_Texture texture = graphics->textures[res_texture.handle];
+   if (!GFX_IsTextureValid(texture, res_texture))
+      return 0;
+
+   return texture.memory_size;
+}
+
+uS Graphics_GetTextureMemory(Graphics* graphics)
+{
+   if (graphics == NULL)
+      return 0;
+
+   return graphics->texture_memory;
+}
+
 void Graphics_BindTexture(Graphics *graphics, Texture res_texture, u32 bind_slot)
 {
    if (graphics == NULL || !Util_IsHandleValid(graphics->textures, res_texture))
@@ -84,11 +250,19 @@ void Graphics_BindTexture(Graphics *graphics, Texture res_texture, u32 bind_slot
    if (!GFX_IsTextureValid(texture, res_texture))
       return;
 
+   if (bind_slot < GFX_MAX_TEXTURE_UNITS && graphics->bound_textures[bind_slot] == texture.id.tex)
+      return;
+
    u32 gl_target = GFX_TextureType(texture.type);
 
-   glActiveTexture(GL_TEXTURE0 + bind_slot);
+   GFX_SetActiveTextureUnit(graphics, bind_slot);
    glBindTexture(gl_target, texture.id.tex);
 
+   if (bind_slot < GFX_MAX_TEXTURE_UNITS)
+      graphics->bound_textures[bind_slot] = texture.id.tex;
+
+   graphics->stats.texture_binds++;
+
 }
 
 void Graphics_BindTextureView(Graphics* graphics, Texture res_texture, u32 bind_slot, const AdvancedBindOptions* bind_options)
@@ -129,6 +303,7 @@ void Graphics_UnbindTextures(Graphics* graphics, u8 texture_type)
    u32 gl_target = GFX_TextureType(texture_type);
 
    glBindTexture(gl_target, 0);
+   GFX_TrackBoundTexture(graphics, 0);
 
 }
 
@@ -144,6 +319,7 @@ void Graphics_SetTextureInterpolation(Graphics* graphics, Texture res_texture, T
    u32 gl_target = GFX_TextureType(texture.type);
 
    glBindTexture(gl_target, texture.id.tex);
+   GFX_TrackBoundTexture(graphics, texture.id.tex);
 
    f32 aniso = M_CLAMP((f32)interpolation_settings.texture_anisotropy, 1.0f, GL_MAX_TEXTURE_MAX_ANISOTROPY);
    u32 wrap = GFX_TextureWrap(interpolation_settings.texture_wrap);
@@ -170,21 +346,41 @@ void Graphics_SetTextureShadowSampler(Graphics* graphics, Texture res_texture, b
    u32 gl_target = GFX_TextureType(texture.type);
 
    glBindTexture(gl_target, texture.id.tex);
+   GFX_TrackBoundTexture(graphics, texture.id.tex);
 
    GLint compare_mode = (is_tex_shadow) ? GL_COMPARE_REF_TO_TEXTURE : GL_NONE;
    glTexParameteri(gl_target, GL_TEXTURE_COMPARE_MODE, compare_mode);
 
 }
 
-Image Graphics_GetTextureImageData(Graphics* graphics, Texture res_texture, u32 mip_level, u8 cubemap_face)
+void Graphics_BindSampler(Graphics* graphics, TextureInterpolation interpolation_settings, bool is_tex_shadow, u32 bind_slot)
 {
-   if (graphics == NULL || !Util_IsHandleValid(graphics->textures, res_texture))
-      return (Image){ NULL };
+   if (graphics == NULL || bind_slot >= GFX_MAX_TEXTURE_UNITS)
+      return;
 
-   gfx_Texture texture = graphics->textures[res_texture.handle];
-   if (!GFX_IsTextureValid(texture, res_texture))
-      return (Image){ NULL };
+   u32 sampler = GFX_GetSampler(graphics, interpolation_settings, is_tex_shadow);
+   if (graphics->bound_samplers[bind_slot] == sampler)
+      return;
 
+   glBindSampler(bind_slot, sampler);
+   graphics->bound_samplers[bind_slot] = sampler;
+   graphics->stats.sampler_binds++;
+
+}
+
+void Graphics_UnbindSampler(Graphics* graphics, u32 bind_slot)
+{
+   if (graphics == NULL || bind_slot >= GFX_MAX_TEXTURE_UNITS || graphics->bound_samplers[bind_slot] == 0)
+      return;
+
+   glBindSampler(bind_slot, 0);
+   graphics->bound_samplers[bind_slot] = 0;
+   graphics->stats.sampler_binds++;
+
+}
+
+Image GFX_TextureReadbackLayout(gfx_Texture texture, u32 mip_level, u32* out_gl_format, u32* out_gl_type)
+{
    i32 mip_divisor = 1 << mip_level;
 
    Image image = { 0 };
@@ -224,18 +420,39 @@ Image Graphics_GetTextureImageData(Graphics* graphics, Texture res_texture, u32
 
    image.image_format = (gl_type == GL_FLOAT) ? IMG_FORMAT_F32 : IMG_FORMAT_U8;
 
+   (*out_gl_format) = gl_format;
+   (*out_gl_type) = gl_type;
+
+   return image;
+}
+
+Image Graphics_GetTextureImageData(Graphics* graphics, Texture res_texture, u32 mip_level, u8 cubemap_face)
+{
+   if (graphics == NULL || !Util_IsHandleValid(graphics->textures, res_texture))
+      return (Image){ NULL };
+
+   gfx_Texture texture = graphics->textures[res_texture.handle];
+   if (!GFX_IsTextureValid(texture, res_texture))
+      return (Image){ NULL };
+
+   u32 gl_format = 0;
+   u32 gl_type = 0;
+   Image image = GFX_TextureReadbackLayout(texture, mip_level, &gl_format, &gl_type);
+
    u32 gl_target = GFX_TextureType(texture.type);
-   if (texture.format == GFX_TEXTURETYPE_CUBEMAP)
+   if (texture.type == GFX_TEXTURETYPE_CUBEMAP)
       gl_target = GL_TEXTURE_CUBE_MAP_POSITIVE_X + cubemap_face;
 
-   uS pixel_size = ((gl_type == GL_FLOAT) ? 4 : 1) * image.channel_count;
-   uS num_bytes = image.size.width * image.size.height * pixel_size;
+   uS num_bytes = Image_MipSize(&image, 0);
 
    f32* image_data = malloc(num_bytes);
    assert(image_data != NULL);
 
-   glBindTexture(gl_target, texture.id.tex);
+   glBindTexture(GFX_TextureType(texture.type), texture.id.tex);
+   GFX_TrackBoundTexture(graphics, texture.id.tex);
+   glPixelStorei(GL_PACK_ALIGNMENT, 1);
    glGetTexImage(gl_target, mip_level, gl_format, gl_type, image_data);
+   glPixelStorei(GL_PACK_ALIGNMENT, 4);
 
    GFX_CheckOpenGLError();
 
@@ -259,7 +476,7 @@ Framebuffer Graphics_CreateFramebuffer(Graphics* graphics, res2D size, bool dept
    if (depthstencil_renderbuffer)
    {
       glBindRenderbuffer(GL_RENDERBUFFER, framebuffer.id.rbo);
-      glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, size.width, size.height);
+      glRenderbufferStorage(GL_RENDERBUFFER, (graphics->reverse_z) ? GL_DEPTH32F_STENCIL8 : GL_DEPTH24_STENCIL8, size.width, size.height);
 
       glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, framebuffer.id.rbo);
 
@@ -317,7 +534,7 @@ void Graphics_ReuseFramebuffer(Graphics* graphics, res2D size, bool depthstencil
    if (depthstencil_renderbuffer)
    {
       glBindRenderbuffer(GL_RENDERBUFFER, framebuffer.id.rbo);
-      glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, size.width, size.height);
+      glRenderbufferStorage(GL_RENDERBUFFER, (graphics->reverse_z) ? GL_DEPTH32F_STENCIL8 : GL_DEPTH24_STENCIL8, size.width, size.height);
 
       glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, framebuffer.id.rbo);
 
@@ -490,6 +707,67 @@ void Graphics_AttachTextureToFramebuffer(Graphics* graphics, Framebuffer res_fra
 
 }
 
+void GFX_SetActiveTextureUnit(Graphics* graphics, u32 texture_unit)
+{
+   if (graphics->active_texture_unit == texture_unit)
+      return;
+
+   graphics->active_texture_unit = texture_unit;
+   glActiveTexture(GL_TEXTURE0 + texture_unit);
+
+}
+
+// call after anything binds a texture with glBindTexture directly, it always lands on the active unit.
+void GFX_TrackBoundTexture(Graphics* graphics, u32 gl_texture)
+{
+   if (graphics->active_texture_unit < GFX_MAX_TEXTURE_UNITS)
+      graphics->bound_textures[graphics->active_texture_unit] = gl_texture;
+
+}
+
+u32 GFX_GetSampler(Graphics* graphics, TextureInterpolation interpolation_settings, bool is_tex_shadow)
+{
+   u64 key =
+      (u64)interpolation_settings.texture_anisotropy |
+      ((u64)interpolation_settings.texture_filter << 16) |
+      ((u64)interpolation_settings.texture_wrap << 24) |
+      ((u64)is_tex_shadow << 32) |
+      ((u64)graphics->reverse_z << 33);
+
+   u32 sampler_count = Util_ArrayLength(graphics->samplers);
+   for (u32 sampler_i = 0; sampler_i < sampler_count; sampler_i++)
+   {
+      if (graphics->samplers[sampler_i].key == key)
+         return graphics->samplers[sampler_i].sampler;
+
+   }
+
+   gfx_Sampler sampler = { .key = key };
+   glGenSamplers(1, &sampler.sampler);
+
+   f32 aniso = M_CLAMP((f32)interpolation_settings.texture_anisotropy, 1.0f, graphics->max_anisotropy);
+   u32 wrap = GFX_TextureWrap(interpolation_settings.texture_wrap);
+   gfx_Filtering filter = GFX_TextureFilter(interpolation_settings.texture_filter);
+
+   glSamplerParameteri(sampler.sampler, GL_TEXTURE_WRAP_R, wrap);
+   glSamplerParameteri(sampler.sampler, GL_TEXTURE_WRAP_S, wrap);
+   glSamplerParameteri(sampler.sampler, GL_TEXTURE_WRAP_T, wrap);
+   glSamplerParameteri(sampler.sampler, GL_TEXTURE_MIN_FILTER, filter.min_filter);
+   glSamplerParameteri(sampler.sampler, GL_TEXTURE_MAG_FILTER, filter.mag_filter);
+   glSamplerParameterf(sampler.sampler, GL_TEXTURE_MAX_ANISOTROPY, aniso);
+
+   if (is_tex_shadow)
+   {
+      glSamplerParameteri(sampler.sampler, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+      glSamplerParameteri(sampler.sampler, GL_TEXTURE_COMPARE_FUNC, (graphics->reverse_z) ? GL_GEQUAL : GL_LEQUAL);
+
+   }
+
+   ADD_BACK_ARRAY(graphics->samplers, sampler);
+
+   return sampler.sampler;
+}
+
 uS GFX_PixelSize(u8 format)
 {
    switch (format)
@@ -550,13 +828,28 @@ uS GFX_PixelSize(u8 format)
       case GFX_TEXTUREFORMAT_DEPTH_F32_STENCIL_8:
          return 5;
 
-      // TODO: compressed formats
+      // compressed formats don't have a size per pixel, GFX_TextureLevelSize handles them
 
       default:
          return 4;
    }
 }
 
+uS GFX_TextureLevelSize(u8 format, i32 width, i32 height, i32 depth)
+{
+   uS level_depth = (uS)M_MAX(depth, 1);
+
+   if (GFX_IsCompressedFormat(format))
+   {
+      uS blocks_x = ((uS)M_MAX(width, 1) + 3) / 4;
+      uS blocks_y = ((uS)M_MAX(height, 1) + 3) / 4;
+
+      return blocks_x * blocks_y * level_depth * GFX_CompressedBlockSize(format);
+   }
+
+   return GFX_PixelSize(format) * (uS)M_MAX(width, 1) * (uS)M_MAX(height, 1) * level_depth;
+}
+
 i32 GFX_TextureInternalFormat(u8 format)
 {
    switch (format)
@@ -619,7 +912,37 @@ i32 GFX_TextureInternalFormat(u8 format)
       case GFX_TEXTUREFORMAT_SRGB_ALPHA:
          return GL_SRGB8_ALPHA8;
 
-      // TODO: compressed formats
+      case GFX_TEXTUREFORMAT_RGB_BC1:
+         return GFX_GL_COMPRESSED_RGB_S3TC_DXT1;
+      case GFX_TEXTUREFORMAT_RGBA_BC1:
+         return GFX_GL_COMPRESSED_RGBA_S3TC_DXT1;
+      case GFX_TEXTUREFORMAT_RGBA_BC2:
+         return GFX_GL_COMPRESSED_RGBA_S3TC_DXT3;
+      case GFX_TEXTUREFORMAT_RGBA_BC3:
+         return GFX_GL_COMPRESSED_RGBA_S3TC_DXT5;
+      case GFX_TEXTUREFORMAT_RGBA_BC7:
+         return GL_COMPRESSED_RGBA_BPTC_UNORM;
+
+      case GFX_TEXTUREFORMAT_SRGB_BC1:
+         return GFX_GL_COMPRESSED_SRGB_S3TC_DXT1;
+      case GFX_TEXTUREFORMAT_SRGB_ALPHA_BC1:
+         return GFX_GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1;
+      case GFX_TEXTUREFORMAT_SRGB_ALPHA_BC2:
+         return GFX_GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3;
+      case GFX_TEXTUREFORMAT_SRGB_ALPHA_BC3:
+         return GFX_GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5;
+      case GFX_TEXTUREFORMAT_SRGB_ALPHA_BC7:
+         return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+
+      case GFX_TEXTUREFORMAT_RGB_SIGNED_BC6:
+         return GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT;
+      case GFX_TEXTUREFORMAT_RGB_UNSIGNED_BC6:
+         return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+
+      case GFX_TEXTUREFORMAT_R_BC4:
+         return GL_COMPRESSED_RED_RGTC1;
+      case GFX_TEXTUREFORMAT_RG_BC5:
+         return GL_COMPRESSED_RG_RGTC2;
 
       default:
          return GL_RGBA8;
@@ -666,7 +989,18 @@ u32 GFX_TexturePixelFormat(u8 format)
       case GFX_TEXTUREFORMAT_DEPTH_F32_STENCIL_8:
          return GL_DEPTH_STENCIL;
 
-      // TODO: compressed formats
+      // only used when reading compressed textures back, GL decompresses into these
+      case GFX_TEXTUREFORMAT_R_BC4:
+         return GL_RED;
+
+      case GFX_TEXTUREFORMAT_RG_BC5:
+         return GL_RG;
+
+      case GFX_TEXTUREFORMAT_RGB_BC1:
+      case GFX_TEXTUREFORMAT_SRGB_BC1:
+      case GFX_TEXTUREFORMAT_RGB_SIGNED_BC6:
+      case GFX_TEXTUREFORMAT_RGB_UNSIGNED_BC6:
+         return GL_RGB;
 
       default:
          return GL_RGBA;
@@ -721,7 +1055,9 @@ u32 GFX_TextureFormatType(u8 format)
       case GFX_TEXTUREFORMAT_DEPTH_F32_STENCIL_8:
          return GL_FLOAT;
 
-      // TODO: compressed formats
+      case GFX_TEXTUREFORMAT_RGB_SIGNED_BC6:
+      case GFX_TEXTUREFORMAT_RGB_UNSIGNED_BC6:
+         return GL_FLOAT;
 
       default:
          return GL_UNSIGNED_BYTE;
@@ -800,6 +1136,31 @@ gfx_Filtering GFX_TextureFilter(u8 filter)
    }
 }
 
+static void GFX_CreateCompressedLevel(gfx_Texture* texture, u32 gl_face, u32 mip_level, i32 width, i32 height, i32 depth, const u8* data, uS size, bool is_update)
+{
+   i32 internal_format = GFX_TextureInternalFormat(texture->format);
+
+   switch (texture->type) {
+      case GFX_TEXTURETYPE_3D:
+      case GFX_TEXTURETYPE_2D_ARRAY:
+      case GFX_TEXTURETYPE_CUBEMAP_ARRAY:
+         if (!is_update)
+            glCompressedTexImage3D(gl_face, (i32)mip_level, (u32)internal_format, width, height, depth, 0, (i32)size, data);
+         else
+            glCompressedTexSubImage3D(gl_face, (i32)mip_level, 0, 0, 0, width, height, depth, (u32)internal_format, (i32)size, data);
+         break;
+
+      default:
+      case GFX_TEXTURETYPE_2D:
+         if (!is_update)
+            glCompressedTexImage2D(gl_face, (i32)mip_level, (u32)internal_format, width, height, 0, (i32)size, data);
+         else
+            glCompressedTexSubImage2D(gl_face, (i32)mip_level, 0, 0, width, height, (u32)internal_format, (i32)size, data);
+
+   }
+
+}
+
 void GFX_CreateTexture(gfx_Texture* texture, u8* data, bool is_update)
 {
    if (texture == NULL)
@@ -840,7 +1201,7 @@ void GFX_CreateTexture(gfx_Texture* texture, u8* data, bool is_update)
       u32 face_count = is_cubemap ? 6 : 1;
       u32 gl_face = is_cubemap ? GL_TEXTURE_CUBE_MAP_POSITIVE_X : gl_target;
 
-      uS pixel_size = GFX_PixelSize(texture->format);
+      bool is_compressed = GFX_IsCompressedFormat(texture->format);
 
       uS offset = 0;
       i32 mip_width = M_MAX(width, 1);
@@ -849,8 +1210,18 @@ void GFX_CreateTexture(gfx_Texture* texture, u8* data, bool is_update)
 
       for (u32 mip_i = 0; mip_i < texture->mipmap_count; mip_i++)
       {
+         uS level_size = GFX_TextureLevelSize(texture->format, mip_width, mip_height, mip_depth);
+
          for (u32 face_i = 0; face_i < face_count; face_i++)
          {
+            if (is_compressed)
+            {
+               GFX_CreateCompressedLevel(texture, gl_face + face_i, mip_i, mip_width, mip_height, mip_depth, data + offset, level_size, is_update);
+               offset += level_size;
+
+               continue;
+            }
+
             switch (texture->type) {
                case GFX_TEXTURETYPE_3D:
                case GFX_TEXTURETYPE_2D_ARRAY:
@@ -870,7 +1241,7 @@ void GFX_CreateTexture(gfx_Texture* texture, u8* data, bool is_update)
 
             }
 
-            offset += pixel_size * (uS)(mip_width * mip_height * mip_depth);
+            offset += level_size;
 
          }
 
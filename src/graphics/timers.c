@@ -0,0 +1,115 @@
+#include "util/types.h"
+#include "util/math.h"
+
+#include "graphics.h"
+#include "graphics/internal.h"
+
+#include <glad/gl.h>
+
+#include <string.h>
+
+GraphicsStats Graphics_GetStats(Graphics* graphics)
+{
+   if (graphics == NULL)
+      return (GraphicsStats){ 0 };
+
+   return graphics->stats;
+}
+
+void Graphics_ResetStats(Graphics* graphics)
+{
+   if (graphics == NULL)
+      return;
+
+   graphics->stats = (GraphicsStats){ 0 };
+
+}
+
+u32 Graphics_BeginGpuTimer(Graphics* graphics)
+{
+   if (graphics == NULL || !graphics->gpu_timers.is_created)
+      return GFX_INVALID_INDEX;
+
+   u32 slot = graphics->gpu_timers.frame_slot;
+   u32 timer_id = graphics->gpu_timers.counts[slot];
+   if (timer_id >= GFX_MAX_GPU_TIMERS)
+      return GFX_INVALID_INDEX;
+
+   glQueryCounter(graphics->gpu_timers.queries[slot][timer_id * 2], GL_TIMESTAMP);
+   graphics->gpu_timers.is_ended[slot][timer_id] = false;
+   graphics->gpu_timers.counts[slot]++;
+
+   return timer_id;
+}
+
+void Graphics_EndGpuTimer(Graphics* graphics, u32 timer_id)
+{
+   if (graphics == NULL || timer_id >= GFX_MAX_GPU_TIMERS)
+      return;
+
+   u32 slot = graphics->gpu_timers.frame_slot;
+   if (timer_id >= graphics->gpu_timers.counts[slot] || graphics->gpu_timers.is_ended[slot][timer_id])
+      return;
+
+   glQueryCounter(graphics->gpu_timers.queries[slot][timer_id * 2 + 1], GL_TIMESTAMP);
+   graphics->gpu_timers.is_ended[slot][timer_id] = true;
+
+}
+
+void Graphics_NextGpuTimerFrame(Graphics* graphics)
+{
+   if (graphics == NULL)
+      return;
+
+   // queries are only made once someone actually wants timings
+   if (!graphics->gpu_timers.is_created)
+   {
+      glGenQueries(GFX_GPU_TIMER_LATENCY * GFX_MAX_GPU_TIMERS * 2, &graphics->gpu_timers.queries[0][0]);
+      graphics->gpu_timers.is_created = true;
+
+   }
+
+   u32 slot = (graphics->gpu_timers.frame_slot + 1) % GFX_GPU_TIMER_LATENCY;
+   u32 timer_count = graphics->gpu_timers.counts[slot];
+
+   // this slot was last used GFX_GPU_TIMER_LATENCY - 1 frames ago. anything still in flight gets dropped instead of waited on.
+   for (u32 timer_i = 0; timer_i < timer_count; timer_i++)
+   {
+      u32 query_begin = graphics->gpu_timers.queries[slot][timer_i * 2];
+      u32 query_end = graphics->gpu_timers.queries[slot][timer_i * 2 + 1];
+
+      GLint is_available = GL_FALSE;
+      if (graphics->gpu_timers.is_ended[slot][timer_i])
+         glGetQueryObjectiv(query_end, GL_QUERY_RESULT_AVAILABLE, &is_available);
+
+      if (!is_available)
+      {
+         graphics->gpu_timers.results[timer_i] = GFX_GPU_TIMER_NOT_READY;
+         continue;
+      }
+
+      GLuint64 time_begin = 0;
+      GLuint64 time_end = 0;
+      glGetQueryObjectui64v(query_begin, GL_QUERY_RESULT, &time_begin);
+      glGetQueryObjectui64v(query_end, GL_QUERY_RESULT, &time_end);
+
+      graphics->gpu_timers.results[timer_i] = (time_end > time_begin) ? (u64)(time_end - time_begin) : 0;
+
+   }
+
+   graphics->gpu_timers.result_count = timer_count;
+   graphics->gpu_timers.counts[slot] = 0;
+   graphics->gpu_timers.frame_slot = slot;
+
+}
+
+u32 Graphics_GetGpuTimerResults(Graphics* graphics, u64* out_results, u32 max_results)
+{
+   if (graphics == NULL || out_results == NULL)
+      return 0;
+
+   u32 result_count = M_MIN(graphics->gpu_timers.result_count, max_results);
+   memcpy(out_results, graphics->gpu_timers.results, sizeof(u64) * result_count);
+
+   return result_count;
+}
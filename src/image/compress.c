@@ -0,0 +1,439 @@
+#include "util/types.h"
+#include "util/math.h"
+#include "util/files.h"
+#include "util/jobs.h"
+
+#include "image.h"
+#include "image/internal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// block rows handed to a worker at a time
+#define IMG_COMPRESS_GRAIN_SIZE 4u
+
+typedef struct IMG_CompressJob_t
+{
+   const u8* source;
+   u8* dest;
+   i32 width;
+   i32 height;
+   u32 blocks_x;
+   uS block_size;
+   u8 format;
+
+} IMG_CompressJob;
+
+// the per-pixel loops below all run over flat arrays of 16 floats so the compiler can turn them into simd
+
+static void IMG_FetchBlock(const u8* source, i32 width, i32 height, u32 block_x, u32 block_y, f32 out_channels[4][16])
+{
+   for (u32 pixel_i = 0; pixel_i < 16; pixel_i++)
+   {
+      // edge blocks repeat the last row and column
+      i32 x = M_MIN((i32)(block_x * 4 + (pixel_i & 3)), width - 1);
+      i32 y = M_MIN((i32)(block_y * 4 + (pixel_i >> 2)), height - 1);
+
+      const u8* pixel = source + ((uS)y * (uS)width + (uS)x) * 4;
+      for (u32 channel_i = 0; channel_i < 4; channel_i++)
+         out_channels[channel_i][pixel_i] = (f32)pixel[channel_i];
+
+   }
+
+}
+
+static void IMG_WriteU16(u8* dest, u16 value)
+{
+   dest[0] = (u8)(value & 0xFF);
+   dest[1] = (u8)(value >> 8);
+
+}
+
+static u16 IMG_PackColor565(const f32 color[3])
+{
+   u32 r = (u32)M_CLAMP(color[0] * (31.0f / 255.0f) + 0.5f, 0.0f, 31.0f);
+   u32 g = (u32)M_CLAMP(color[1] * (63.0f / 255.0f) + 0.5f, 0.0f, 63.0f);
+   u32 b = (u32)M_CLAMP(color[2] * (31.0f / 255.0f) + 0.5f, 0.0f, 31.0f);
+
+   return (u16)((r << 11) | (g << 5) | b);
+}
+
+static void IMG_UnpackColor565(u16 packed, f32 out_color[3])
+{
+   u32 r = (packed >> 11) & 31;
+   u32 g = (packed >> 5) & 63;
+   u32 b = packed & 31;
+
+   out_color[0] = (f32)((r << 3) | (r >> 2));
+   out_color[1] = (f32)((g << 2) | (g >> 4));
+   out_color[2] = (f32)((b << 3) | (b >> 2));
+
+}
+
+// picks the closest of the four palette entries for every pixel, returns the summed squared error
+static f32 IMG_SelectColorIndices(const f32 channels[4][16], u16 color_0, u16 color_1, u32 out_indices[16])
+{
+   f32 palette[4][3] = { 0 };
+   IMG_UnpackColor565(color_0, palette[0]);
+   IMG_UnpackColor565(color_1, palette[1]);
+
+   for (u32 channel_i = 0; channel_i < 3; channel_i++)
+   {
+      palette[2][channel_i] = (2.0f * palette[0][channel_i] + palette[1][channel_i]) / 3.0f;
+      palette[3][channel_i] = (palette[0][channel_i] + 2.0f * palette[1][channel_i]) / 3.0f;
+
+   }
+
+   f32 best_error[16];
+   for (u32 pixel_i = 0; pixel_i < 16; pixel_i++)
+   {
+      best_error[pixel_i] = 1e30f;
+      out_indices[pixel_i] = 0;
+
+   }
+
+   for (u32 entry_i = 0; entry_i < 4; entry_i++)
+   {
+      for (u32 pixel_i = 0; pixel_i < 16; pixel_i++)
+      {
+         f32 dr = channels[0][pixel_i] - palette[entry_i][0];
+         f32 dg = channels[1][pixel_i] - palette[entry_i][1];
+         f32 db = channels[2][pixel_i] - palette[entry_i][2];
+         f32 error = dr * dr + dg * dg + db * db;
+
+         if (error < best_error[pixel_i])
+         {
+            best_error[pixel_i] = error;
+            out_indices[pixel_i] = entry_i;
+
+         }
+
+      }
+
+   }
+
+   f32 total_error = 0.0f;
+   for (u32 pixel_i = 0; pixel_i < 16; pixel_i++)
+      total_error += best_error[pixel_i];
+
+   return total_error;
+}
+
+// endpoints come from the extremes along the block's principal axis, then get one least squares refinement
+static void IMG_EncodeColorBlock(const f32 channels[4][16], u8* dest)
+{
+   f32 mean[3] = { 0 };
+   f32 min_color[3] = { 255.0f, 255.0f, 255.0f };
+   f32 max_color[3] = { 0 };
+
+   for (u32 channel_i = 0; channel_i < 3; channel_i++)
+   {
+      for (u32 pixel_i = 0; pixel_i < 16; pixel_i++)
+      {
+         mean[channel_i] += channels[channel_i][pixel_i];
+         min_color[channel_i] = M_MIN(min_color[channel_i], channels[channel_i][pixel_i]);
+         max_color[channel_i] = M_MAX(max_color[channel_i], channels[channel_i][pixel_i]);
+
+      }
+
+      mean[channel_i] /= 16.0f;
+
+   }
+
+   f32 covariance[6] = { 0 };
+   for (u32 pixel_i = 0; pixel_i < 16; pixel_i++)
+   {
+      f32 r = channels[0][pixel_i] - mean[0];
+      f32 g = channels[1][pixel_i] - mean[1];
+      f32 b = channels[2][pixel_i] - mean[2];
+
+      covariance[0] += r * r;
+      covariance[1] += r * g;
+      covariance[2] += r * b;
+      covariance[3] += g * g;
+      covariance[4] += g * b;
+      covariance[5] += b * b;
+
+   }
+
+   f32 axis[3] = { max_color[0] - min_color[0], max_color[1] - min_color[1], max_color[2] - min_color[2] };
+   for (u32 iteration_i = 0; iteration_i < 4; iteration_i++)
+   {
+      f32 next_axis[3] = {
+         axis[0] * covariance[0] + axis[1] * covariance[1] + axis[2] * covariance[2],
+         axis[0] * covariance[1] + axis[1] * covariance[3] + axis[2] * covariance[4],
+         axis[0] * covariance[2] + axis[1] * covariance[4] + axis[2] * covariance[5]
+      };
+
+      f32 largest = M_MAX(M_MAX(fabsf(next_axis[0]), fabsf(next_axis[1])), fabsf(next_axis[2]));
+      if (largest < 1e-6f)
+         break;
+
+      axis[0] = next_axis[0] / largest;
+      axis[1] = next_axis[1] / largest;
+      axis[2] = next_axis[2] / largest;
+
+   }
+
+   f32 min_projection = 1e30f;
+   f32 max_projection = -1e30f;
+   u32 min_pixel = 0;
+   u32 max_pixel = 0;
+
+   for (u32 pixel_i = 0; pixel_i < 16; pixel_i++)
+   {
+      f32 projection = channels[0][pixel_i] * axis[0] + channels[1][pixel_i] * axis[1] + channels[2][pixel_i] * axis[2];
+      if (projection < min_projection)
+      {
+         min_projection = projection;
+         min_pixel = pixel_i;
+
+      }
+
+      if (projection > max_projection)
+      {
+         max_projection = projection;
+         max_pixel = pixel_i;
+
+      }
+
+   }
+
+   f32 endpoint_0[3] = { channels[0][max_pixel], channels[1][max_pixel], channels[2][max_pixel] };
+   f32 endpoint_1[3] = { channels[0][min_pixel], channels[1][min_pixel], channels[2][min_pixel] };
+
+   u16 color_0 = IMG_PackColor565(endpoint_0);
+   u16 color_1 = IMG_PackColor565(endpoint_1);
+
+   u32 indices[16] = { 0 };
+   f32 best_error = IMG_SelectColorIndices(channels, color_0, color_1, indices);
+
+   // solve for the endpoints that best fit the chosen indices
+   static const f32 weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+   f32 alpha_alpha = 0.0f, beta_beta = 0.0f, alpha_beta = 0.0f;
+   f32 alpha_x[3] = { 0 }, beta_x[3] = { 0 };
+
+   for (u32 pixel_i = 0; pixel_i < 16; pixel_i++)
+   {
+      f32 alpha = weights[indices[pixel_i]];
+      f32 beta = 1.0f - alpha;
+
+      alpha_alpha += alpha * alpha;
+      beta_beta += beta * beta;
+      alpha_beta += alpha * beta;
+
+      for (u32 channel_i = 0; channel_i < 3; channel_i++)
+      {
+         alpha_x[channel_i] += alpha * channels[channel_i][pixel_i];
+         beta_x[channel_i] += beta * channels[channel_i][pixel_i];
+
+      }
+
+   }
+
+   f32 determinant = alpha_alpha * beta_beta - alpha_beta * alpha_beta;
+   if (fabsf(determinant) > 1e-6f)
+   {
+      f32 refined_0[3], refined_1[3];
+      for (u32 channel_i = 0; channel_i < 3; channel_i++)
+      {
+         refined_0[channel_i] = (alpha_x[channel_i] * beta_beta - beta_x[channel_i] * alpha_beta) / determinant;
+         refined_1[channel_i] = (beta_x[channel_i] * alpha_alpha - alpha_x[channel_i] * alpha_beta) / determinant;
+
+      }
+
+      u16 refined_color_0 = IMG_PackColor565(refined_0);
+      u16 refined_color_1 = IMG_PackColor565(refined_1);
+
+      u32 refined_indices[16] = { 0 };
+      f32 refined_error = IMG_SelectColorIndices(channels, refined_color_0, refined_color_1, refined_indices);
+      if (refined_error < best_error)
+      {
+         color_0 = refined_color_0;
+         color_1 = refined_color_1;
+         memcpy(indices, refined_indices, sizeof(indices));
+
+      }
+
+   }
+
+   // color_0 has to be the larger one or the block switches to 3 color mode
+   if (color_0 < color_1)
+   {
+      u16 swap_color = color_0;
+      color_0 = color_1;
+      color_1 = swap_color;
+
+      for (u32 pixel_i = 0; pixel_i < 16; pixel_i++)
+         indices[pixel_i] ^= 1;
+
+   } else if (color_0 == color_1)
+      memset(indices, 0, sizeof(indices));
+
+   u32 packed_indices = 0;
+   for (u32 pixel_i = 0; pixel_i < 16; pixel_i++)
+      packed_indices |= indices[pixel_i] << (pixel_i * 2);
+
+   IMG_WriteU16(dest + 0, color_0);
+   IMG_WriteU16(dest + 2, color_1);
+   IMG_WriteU16(dest + 4, (u16)(packed_indices & 0xFFFF));
+   IMG_WriteU16(dest + 6, (u16)(packed_indices >> 16));
+
+}
+
+// BC4, also used for the alpha half of BC3 and both halves of BC5. always the 8 value mode.
+static void IMG_EncodeChannelBlock(const f32 values[16], u8* dest)
+{
+   f32 min_value = 255.0f;
+   f32 max_value = 0.0f;
+   for (u32 pixel_i = 0; pixel_i < 16; pixel_i++)
+   {
+      min_value = M_MIN(min_value, values[pixel_i]);
+      max_value = M_MAX(max_value, values[pixel_i]);
+
+   }
+
+   u8 endpoint_0 = (u8)(max_value + 0.5f);
+   u8 endpoint_1 = (u8)(min_value + 0.5f);
+
+   dest[0] = endpoint_0;
+   dest[1] = endpoint_1;
+
+   u64 packed_indices = 0;
+   if (endpoint_0 > endpoint_1)
+   {
+      f32 scale = 7.0f / (f32)(endpoint_0 - endpoint_1);
+
+      u32 steps[16];
+      for (u32 pixel_i = 0; pixel_i < 16; pixel_i++)
+         steps[pixel_i] = (u32)M_CLAMP(((f32)endpoint_0 - values[pixel_i]) * scale + 0.5f, 0.0f, 7.0f);
+
+      // palette order is endpoint_0, endpoint_1, then the 6 in-between values going from 0 towards 1
+      for (u32 pixel_i = 0; pixel_i < 16; pixel_i++)
+      {
+         u64 index = (steps[pixel_i] == 0) ? 0 : ((steps[pixel_i] == 7) ? 1 : steps[pixel_i] + 1);
+         packed_indices |= index << (pixel_i * 3);
+
+      }
+
+   }
+
+   for (u32 byte_i = 0; byte_i < 6; byte_i++)
+      dest[2 + byte_i] = (u8)((packed_indices >> (byte_i * 8)) & 0xFF);
+
+}
+
+static void IMG_CompressRows(void* user_data, u32 start, u32 end, u32 worker_id)
+{
+   IMG_CompressJob* job = (IMG_CompressJob*)user_data;
+
+   f32 channels[4][16];
+
+   for (u32 block_y = start; block_y < end; block_y++)
+   {
+      for (u32 block_x = 0; block_x < job->blocks_x; block_x++)
+      {
+         u8* dest = job->dest + ((uS)block_y * (uS)job->blocks_x + (uS)block_x) * job->block_size;
+
+         IMG_FetchBlock(job->source, job->width, job->height, block_x, block_y, channels);
+
+         switch (job->format)
+         {
+            case IMG_FORMAT_BC1:
+            case IMG_FORMAT_BC1_SRGB: {
+               IMG_EncodeColorBlock(channels, dest);
+            } break;
+
+            case IMG_FORMAT_BC3:
+            case IMG_FORMAT_BC3_SRGB: {
+               IMG_EncodeChannelBlock(channels[3], dest);
+               IMG_EncodeColorBlock(channels, dest + 8);
+            } break;
+
+            case IMG_FORMAT_BC4: {
+               IMG_EncodeChannelBlock(channels[0], dest);
+            } break;
+
+            case IMG_FORMAT_BC5: {
+               IMG_EncodeChannelBlock(channels[0], dest);
+               IMG_EncodeChannelBlock(channels[1], dest + 8);
+            } break;
+
+            default:
+               break;
+
+         }
+
+      }
+
+   }
+
+}
+
+Image Image_CompressImage(const Image* image, u8 compressed_format, JobPool* jobs)
+{
+   if (image == NULL || image->data == NULL)
+      return (Image){ .data = NULL };
+
+   bool is_source_valid = (image->image_format == IMG_FORMAT_U8 || image->image_format == IMG_FORMAT_U8_SRGB);
+   is_source_valid &= (image->channel_count == 4 && image->image_type == IMG_TYPE_2D && image->size.depth <= 1);
+
+   bool is_format_valid = (compressed_format >= IMG_FORMAT_BC1 && compressed_format <= IMG_FORMAT_BC5);
+
+   if (!is_source_valid || !is_format_valid)
+   {
+      error err = { 0 };
+      err.general = ERR_LEVEL_ERROR;
+      err.extra = ERR_IMG_UNSUPPORTED_FORMAT;
+
+      Util_Log(NULL, IMAGE_MODULE, err, "Only 8 bit rgba 2D images can be compressed, and only to BC1, BC3, BC4 or BC5");
+
+      return (Image){ .data = NULL };
+   }
+
+   // srgb sources stay srgb, the blocks are encoded in the same space the pixels are stored in
+   if (image->image_format == IMG_FORMAT_U8_SRGB && compressed_format == IMG_FORMAT_BC1)
+      compressed_format = IMG_FORMAT_BC1_SRGB;
+   else if (image->image_format == IMG_FORMAT_U8_SRGB && compressed_format == IMG_FORMAT_BC3)
+      compressed_format = IMG_FORMAT_BC3_SRGB;
+
+   Image compressed = { 0 };
+   compressed.size = image->size;
+   compressed.mipmap_count = M_MAX(image->mipmap_count, 1);
+   compressed.image_type = IMG_TYPE_2D;
+   compressed.image_format = compressed_format;
+   compressed.channel_count = (compressed_format == IMG_FORMAT_BC4) ? 1 : ((compressed_format == IMG_FORMAT_BC5) ? 2 : 4);
+
+   uS compressed_size = 0;
+   for (u32 mip_i = 0; mip_i < compressed.mipmap_count; mip_i++)
+      compressed_size += Image_MipSize(&compressed, mip_i);
+
+   compressed.data = malloc(compressed_size);
+   if (compressed.data == NULL)
+      return (Image){ .data = NULL };
+
+   uS source_offset = 0;
+   uS dest_offset = 0;
+
+   for (u32 mip_i = 0; mip_i < compressed.mipmap_count; mip_i++)
+   {
+      IMG_CompressJob job = { 0 };
+      job.source = image->data + source_offset;
+      job.dest = compressed.data + dest_offset;
+      job.width = M_MAX(image->size.width >> mip_i, 1);
+      job.height = M_MAX(image->size.height >> mip_i, 1);
+      job.blocks_x = ((u32)job.width + 3) / 4;
+      job.block_size = IMG_BlockSize(compressed_format);
+      job.format = compressed_format;
+
+      u32 blocks_y = ((u32)job.height + 3) / 4;
+      Util_ParallelFor(jobs, blocks_y, IMG_COMPRESS_GRAIN_SIZE, IMG_CompressRows, &job);
+
+      source_offset += Image_MipSize(image, mip_i);
+      dest_offset += Image_MipSize(&compressed, mip_i);
+
+   }
+
+   return compressed;
+}
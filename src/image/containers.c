@@ -0,0 +1,520 @@
+#include "util/types.h"
+#include "util/math.h"
+#include "util/files.h"
+
+#include "image.h"
+#include "image/internal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// khronos data format descriptor values, only the handful the writer needs
+#define KDF_VERSION 2u
+#define KDF_MODEL_RGBSDA 1u
+#define KDF_MODEL_BC1A 128u
+#define KDF_MODEL_BC3 130u
+#define KDF_MODEL_BC4 131u
+#define KDF_MODEL_BC5 132u
+#define KDF_MODEL_BC6H 133u
+#define KDF_MODEL_BC7 134u
+#define KDF_PRIMARIES_BT709 1u
+#define KDF_TRANSFER_LINEAR 1u
+#define KDF_TRANSFER_SRGB 2u
+#define KDF_CHANNEL_ALPHA 15u
+#define KDF_QUALIFIER_FLOAT 0x80u
+
+static Image IMG_ContainerError(u32 error_code, const char* message)
+{
+   error err = { 0 };
+   err.general = ERR_LEVEL_ERROR;
+   err.extra = error_code;
+
+   Util_Log(NULL, IMAGE_MODULE, err, "%s", message);
+
+   return (Image){ .data = NULL };
+}
+
+static u8 IMG_FormatFromVulkan(u32 vk_format, u8* out_channel_count)
+{
+   switch (vk_format)
+   {
+      case IMG_VK_FORMAT_R8G8B8A8_UNORM: (*out_channel_count) = 4; return IMG_FORMAT_U8;
+      case IMG_VK_FORMAT_R8G8B8A8_SRGB: (*out_channel_count) = 4; return IMG_FORMAT_U8_SRGB;
+      case IMG_VK_FORMAT_BC1_RGB_UNORM:
+      case IMG_VK_FORMAT_BC1_RGBA_UNORM: (*out_channel_count) = 4; return IMG_FORMAT_BC1;
+      case IMG_VK_FORMAT_BC1_RGB_SRGB:
+      case IMG_VK_FORMAT_BC1_RGBA_SRGB: (*out_channel_count) = 4; return IMG_FORMAT_BC1_SRGB;
+      case IMG_VK_FORMAT_BC3_UNORM: (*out_channel_count) = 4; return IMG_FORMAT_BC3;
+      case IMG_VK_FORMAT_BC3_SRGB: (*out_channel_count) = 4; return IMG_FORMAT_BC3_SRGB;
+      case IMG_VK_FORMAT_BC4_UNORM: (*out_channel_count) = 1; return IMG_FORMAT_BC4;
+      case IMG_VK_FORMAT_BC5_UNORM: (*out_channel_count) = 2; return IMG_FORMAT_BC5;
+      case IMG_VK_FORMAT_BC6H_UFLOAT: (*out_channel_count) = 3; return IMG_FORMAT_BC6H;
+      case IMG_VK_FORMAT_BC7_UNORM: (*out_channel_count) = 4; return IMG_FORMAT_BC7;
+      case IMG_VK_FORMAT_BC7_SRGB: (*out_channel_count) = 4; return IMG_FORMAT_BC7_SRGB;
+
+      default:
+         return UINT8_MAX;
+   }
+}
+
+static u32 IMG_FormatToVulkan(u8 image_format)
+{
+   switch (image_format)
+   {
+      case IMG_FORMAT_U8: return IMG_VK_FORMAT_R8G8B8A8_UNORM;
+      case IMG_FORMAT_U8_SRGB: return IMG_VK_FORMAT_R8G8B8A8_SRGB;
+      case IMG_FORMAT_BC1: return IMG_VK_FORMAT_BC1_RGBA_UNORM;
+      case IMG_FORMAT_BC1_SRGB: return IMG_VK_FORMAT_BC1_RGBA_SRGB;
+      case IMG_FORMAT_BC3: return IMG_VK_FORMAT_BC3_UNORM;
+      case IMG_FORMAT_BC3_SRGB: return IMG_VK_FORMAT_BC3_SRGB;
+      case IMG_FORMAT_BC4: return IMG_VK_FORMAT_BC4_UNORM;
+      case IMG_FORMAT_BC5: return IMG_VK_FORMAT_BC5_UNORM;
+      case IMG_FORMAT_BC6H: return IMG_VK_FORMAT_BC6H_UFLOAT;
+      case IMG_FORMAT_BC7: return IMG_VK_FORMAT_BC7_UNORM;
+      case IMG_FORMAT_BC7_SRGB: return IMG_VK_FORMAT_BC7_SRGB;
+
+      default:
+         return 0;
+   }
+}
+
+static u8 IMG_FormatFromDXGI(u32 dxgi_format, u8* out_channel_count)
+{
+   switch (dxgi_format)
+   {
+      case IMG_DXGI_FORMAT_R8G8B8A8_UNORM: (*out_channel_count) = 4; return IMG_FORMAT_U8;
+      case IMG_DXGI_FORMAT_R8G8B8A8_UNORM_SRGB: (*out_channel_count) = 4; return IMG_FORMAT_U8_SRGB;
+      case IMG_DXGI_FORMAT_BC1_UNORM: (*out_channel_count) = 4; return IMG_FORMAT_BC1;
+      case IMG_DXGI_FORMAT_BC1_UNORM_SRGB: (*out_channel_count) = 4; return IMG_FORMAT_BC1_SRGB;
+      case IMG_DXGI_FORMAT_BC3_UNORM: (*out_channel_count) = 4; return IMG_FORMAT_BC3;
+      case IMG_DXGI_FORMAT_BC3_UNORM_SRGB: (*out_channel_count) = 4; return IMG_FORMAT_BC3_SRGB;
+      case IMG_DXGI_FORMAT_BC4_UNORM: (*out_channel_count) = 1; return IMG_FORMAT_BC4;
+      case IMG_DXGI_FORMAT_BC5_UNORM: (*out_channel_count) = 2; return IMG_FORMAT_BC5;
+      case IMG_DXGI_FORMAT_BC6H_UF16: (*out_channel_count) = 3; return IMG_FORMAT_BC6H;
+      case IMG_DXGI_FORMAT_BC7_UNORM: (*out_channel_count) = 4; return IMG_FORMAT_BC7;
+      case IMG_DXGI_FORMAT_BC7_UNORM_SRGB: (*out_channel_count) = 4; return IMG_FORMAT_BC7_SRGB;
+
+      default:
+         return UINT8_MAX;
+   }
+}
+
+// old style dds files only have a fourcc, and never say if they're srgb
+static u8 IMG_FormatFromFourCC(u32 fourcc, bool is_srgb, u8* out_channel_count)
+{
+   char code[5] = { 0 };
+   memcpy(code, &fourcc, sizeof(u32));
+
+   if (strcmp(code, "DXT1") == 0)
+   {
+      (*out_channel_count) = 4;
+      return is_srgb ? IMG_FORMAT_BC1_SRGB : IMG_FORMAT_BC1;
+   }
+
+   if (strcmp(code, "DXT5") == 0)
+   {
+      (*out_channel_count) = 4;
+      return is_srgb ? IMG_FORMAT_BC3_SRGB : IMG_FORMAT_BC3;
+   }
+
+   if (strcmp(code, "ATI1") == 0 || strcmp(code, "BC4U") == 0)
+   {
+      (*out_channel_count) = 1;
+      return IMG_FORMAT_BC4;
+   }
+
+   if (strcmp(code, "ATI2") == 0 || strcmp(code, "BC5U") == 0)
+   {
+      (*out_channel_count) = 2;
+      return IMG_FORMAT_BC5;
+   }
+
+   return UINT8_MAX;
+}
+
+static uS IMG_ChainSize(const Image* image)
+{
+   uS total_size = 0;
+   for (u32 mip_i = 0; mip_i < image->mipmap_count; mip_i++)
+      total_size += Image_MipSize(image, mip_i);
+
+   return total_size;
+}
+
+// levels in a full chain down to 1x1, anything past that can't be uploaded
+static u32 IMG_MaxMipCount(i32 width, i32 height)
+{
+   u32 largest = (u32)M_MAX(width, height);
+   u32 mip_count = 1;
+   while (largest > 1)
+   {
+      largest >>= 1;
+      mip_count++;
+
+   }
+
+   return mip_count;
+}
+
+static Image IMG_LoadKTX2(memblob memory)
+{
+   if (memory.size < sizeof(IMG_KTX2Header))
+      return IMG_ContainerError(ERR_IMG_TRUNCATED_FILE, "KTX2 file is too small to hold its header");
+
+   IMG_KTX2Header header = { 0 };
+   memcpy(&header, memory.data, sizeof(IMG_KTX2Header));
+
+   if (header.supercompression_scheme != 0)
+      return IMG_ContainerError(ERR_IMG_UNSUPPORTED_CONTAINER, "Supercompressed KTX2 files aren't supported");
+
+   if (header.pixel_depth > 1 || header.layer_count > 1 || header.face_count > 1)
+      return IMG_ContainerError(ERR_IMG_UNSUPPORTED_CONTAINER, "Only 2D KTX2 textures are supported, no arrays, cubemaps or volumes");
+
+   if (header.pixel_width < 1 || header.pixel_width > INT32_MAX || header.pixel_height < 1 || header.pixel_height > INT32_MAX)
+      return IMG_ContainerError(ERR_IMG_UNSUPPORTED_CONTAINER, "KTX2 texture size is out of range");
+
+   Image image = { 0 };
+   image.image_format = IMG_FormatFromVulkan(header.vk_format, &image.channel_count);
+   if (image.image_format == UINT8_MAX)
+      return IMG_ContainerError(ERR_IMG_UNSUPPORTED_FORMAT, "KTX2 file uses a format the engine can't load");
+
+   // a level count of 0 asks for mips to be generated at load time
+   u32 level_count = M_MAX(header.level_count, 1);
+
+   image.size.width = (i32)header.pixel_width;
+   image.size.height = (i32)header.pixel_height;
+   image.size.depth = 1;
+   image.image_type = IMG_TYPE_2D;
+   image.mipmap_count = (u8)M_MIN(level_count, UINT8_MAX);
+
+   if (level_count > IMG_MaxMipCount(image.size.width, image.size.height))
+      return IMG_ContainerError(ERR_IMG_UNSUPPORTED_CONTAINER, "KTX2 file has more levels than its size allows");
+
+   uS level_index_end = sizeof(IMG_KTX2Header) + sizeof(IMG_KTX2Level) * (uS)level_count;
+   if (memory.size < level_index_end)
+      return IMG_ContainerError(ERR_IMG_TRUNCATED_FILE, "KTX2 file is too small to hold its level index");
+
+   image.data = malloc(IMG_ChainSize(&image));
+   if (image.data == NULL)
+      return (Image){ .data = NULL };
+
+   const u8* level_index = (const u8*)memory.data + sizeof(IMG_KTX2Header);
+
+   // the level index always starts at the base level, whatever order the data is in
+   uS write_offset = 0;
+   for (u32 mip_i = 0; mip_i < image.mipmap_count; mip_i++)
+   {
+      IMG_KTX2Level level = { 0 };
+      memcpy(&level, level_index + sizeof(IMG_KTX2Level) * mip_i, sizeof(IMG_KTX2Level));
+
+      uS mip_size = Image_MipSize(&image, mip_i);
+      if (level.byte_length < mip_size || level.byte_offset > memory.size || memory.size - level.byte_offset < mip_size)
+      {
+         Image_Free(&image);
+
+         return IMG_ContainerError(ERR_IMG_TRUNCATED_FILE, "KTX2 level data runs past the end of the file");
+      }
+
+      memcpy(image.data + write_offset, (const u8*)memory.data + level.byte_offset, mip_size);
+      write_offset += mip_size;
+
+   }
+
+   return image;
+}
+
+static Image IMG_LoadDDS(memblob memory, bool is_srgb)
+{
+   if (memory.size < sizeof(IMG_DDSHeader))
+      return IMG_ContainerError(ERR_IMG_TRUNCATED_FILE, "DDS file is too small to hold its header");
+
+   IMG_DDSHeader header = { 0 };
+   memcpy(&header, memory.data, sizeof(IMG_DDSHeader));
+
+   uS data_offset = sizeof(IMG_DDSHeader);
+
+   Image image = { 0 };
+
+   if (header.pixel_format.fourcc == DDS_DX10_FOURCC)
+   {
+      if (memory.size < data_offset + sizeof(IMG_DDSHeaderDX10))
+         return IMG_ContainerError(ERR_IMG_TRUNCATED_FILE, "DDS file is too small to hold its DX10 header");
+
+      IMG_DDSHeaderDX10 header_dx10 = { 0 };
+      memcpy(&header_dx10, (const u8*)memory.data + data_offset, sizeof(IMG_DDSHeaderDX10));
+      data_offset += sizeof(IMG_DDSHeaderDX10);
+
+      if (header_dx10.array_size > 1)
+         return IMG_ContainerError(ERR_IMG_UNSUPPORTED_CONTAINER, "DDS texture arrays aren't supported");
+
+      image.image_format = IMG_FormatFromDXGI(header_dx10.dxgi_format, &image.channel_count);
+
+   } else
+      image.image_format = IMG_FormatFromFourCC(header.pixel_format.fourcc, is_srgb, &image.channel_count);
+
+   if ((header.caps[1] & (DDS_CAPS2_CUBEMAP | DDS_CAPS2_VOLUME)) != 0)
+      return IMG_ContainerError(ERR_IMG_UNSUPPORTED_CONTAINER, "Only 2D DDS textures are supported, no cubemaps or volumes");
+
+   if (image.image_format == UINT8_MAX)
+      return IMG_ContainerError(ERR_IMG_UNSUPPORTED_FORMAT, "DDS file uses a format the engine can't load");
+
+   if (header.width < 1 || header.width > INT32_MAX || header.height < 1 || header.height > INT32_MAX)
+      return IMG_ContainerError(ERR_IMG_UNSUPPORTED_CONTAINER, "DDS texture size is out of range");
+
+   image.size.width = (i32)header.width;
+   image.size.height = (i32)header.height;
+   image.size.depth = 1;
+   image.image_type = IMG_TYPE_2D;
+   image.mipmap_count = (u8)M_CLAMP(header.mipmap_count, 1, UINT8_MAX);
+
+   if (M_MAX(header.mipmap_count, 1) > IMG_MaxMipCount(image.size.width, image.size.height))
+      return IMG_ContainerError(ERR_IMG_UNSUPPORTED_CONTAINER, "DDS file has more mips than its size allows");
+
+   // dds already stores mips largest first, same as Image
+   uS chain_size = IMG_ChainSize(&image);
+   if (memory.size - data_offset < chain_size)
+      return IMG_ContainerError(ERR_IMG_TRUNCATED_FILE, "DDS mip data runs past the end of the file");
+
+   image.data = malloc(chain_size);
+   if (image.data == NULL)
+      return (Image){ .data = NULL };
+
+   memcpy(image.data, (const u8*)memory.data + data_offset, chain_size);
+
+   return image;
+}
+
+Image Image_LoadContainer(memblob memory, bool is_srgb)
+{
+   if (!IMG_IsContainer(memory))
+      return (Image){ .data = NULL };
+
+   if (memcmp(memory.data, img_ktx2_identifier, sizeof(img_ktx2_identifier)) == 0)
+      return IMG_LoadKTX2(memory);
+
+   return IMG_LoadDDS(memory, is_srgb);
+}
+
+// a single-plane basic descriptor, which is all a 2D texture with one of these formats needs
+static uS IMG_WriteKTX2DataFormat(const Image* image, u32* out_words)
+{
+   u32 color_model = KDF_MODEL_RGBSDA;
+   u32 block_size = (u32)IMG_BlockSize(image->image_format);
+   u32 sample_channels[4] = { 0 };
+   u32 sample_bits[4] = { 0 };
+   u32 sample_count = 1;
+
+   switch (image->image_format)
+   {
+      default:
+      case IMG_FORMAT_U8:
+      case IMG_FORMAT_U8_SRGB:
+         block_size = 4;
+         sample_count = 4;
+         sample_channels[1] = 1;
+         sample_channels[2] = 2;
+         sample_channels[3] = KDF_CHANNEL_ALPHA;
+         sample_bits[0] = sample_bits[1] = sample_bits[2] = sample_bits[3] = 8;
+         break;
+
+      case IMG_FORMAT_BC1:
+      case IMG_FORMAT_BC1_SRGB:
+         color_model = KDF_MODEL_BC1A;
+         sample_bits[0] = 64;
+         break;
+
+      case IMG_FORMAT_BC3:
+      case IMG_FORMAT_BC3_SRGB:
+         color_model = KDF_MODEL_BC3;
+         sample_count = 2;
+         sample_channels[0] = KDF_CHANNEL_ALPHA;
+         sample_bits[0] = sample_bits[1] = 64;
+         break;
+
+      case IMG_FORMAT_BC4:
+         color_model = KDF_MODEL_BC4;
+         sample_bits[0] = 64;
+         break;
+
+      case IMG_FORMAT_BC5:
+         color_model = KDF_MODEL_BC5;
+         sample_count = 2;
+         sample_channels[1] = 1;
+         sample_bits[0] = sample_bits[1] = 64;
+         break;
+
+      case IMG_FORMAT_BC6H:
+         color_model = KDF_MODEL_BC6H;
+         sample_channels[0] = KDF_QUALIFIER_FLOAT;
+         sample_bits[0] = 128;
+         break;
+
+      case IMG_FORMAT_BC7:
+      case IMG_FORMAT_BC7_SRGB:
+         color_model = KDF_MODEL_BC7;
+         sample_bits[0] = 128;
+         break;
+
+   }
+
+   bool is_srgb = (image->image_format == IMG_FORMAT_U8_SRGB || image->image_format == IMG_FORMAT_BC1_SRGB || image->image_format == IMG_FORMAT_BC3_SRGB || image->image_format == IMG_FORMAT_BC7_SRGB);
+   u32 block_dimension = Image_IsCompressed(image->image_format) ? 3u : 0u;
+
+   u32 descriptor_size = 24 + 16 * sample_count;
+   u32 word_count = 1 + descriptor_size / 4;
+
+   if (out_words == NULL)
+      return (uS)word_count * sizeof(u32);
+
+   memset(out_words, 0, (uS)word_count * sizeof(u32));
+
+   out_words[0] = word_count * 4; // total size, including this word
+   out_words[1] = 0; // khronos vendor, basic descriptor type
+   out_words[2] = KDF_VERSION | (descriptor_size << 16u);
+   out_words[3] = color_model | (KDF_PRIMARIES_BT709 << 8u) | ((is_srgb ? KDF_TRANSFER_SRGB : KDF_TRANSFER_LINEAR) << 16u);
+   out_words[4] = block_dimension | (block_dimension << 8u);
+   out_words[5] = block_size;
+
+   u32 bit_offset = 0;
+   for (u32 sample_i = 0; sample_i < sample_count; sample_i++)
+   {
+      u32* sample = out_words + 7 + sample_i * 4;
+      sample[0] = bit_offset | ((sample_bits[sample_i] - 1) << 16u) | (sample_channels[sample_i] << 24u);
+      sample[1] = 0;
+      sample[2] = 0;
+      sample[3] = (sample_bits[sample_i] >= 32) ? UINT32_MAX : ((1u << sample_bits[sample_i]) - 1);
+
+      bit_offset += sample_bits[sample_i];
+
+   }
+
+   return (uS)word_count * sizeof(u32);
+}
+
+memblob Image_SaveKTX2(const Image* image)
+{
+   if (image == NULL || image->data == NULL || image->image_type != IMG_TYPE_2D || image->size.depth > 1)
+      return (memblob){ 0 };
+
+   u32 vk_format = IMG_FormatToVulkan(image->image_format);
+   if (vk_format == 0 || (!Image_IsCompressed(image->image_format) && image->channel_count != 4))
+   {
+      IMG_ContainerError(ERR_IMG_UNSUPPORTED_FORMAT, "Image format can't be written to a KTX2 file");
+
+      return (memblob){ 0 };
+   }
+
+   u32 level_count = M_MAX(image->mipmap_count, 1);
+
+   uS level_index_size = sizeof(IMG_KTX2Level) * (uS)level_count;
+   uS dfd_offset = sizeof(IMG_KTX2Header) + level_index_size;
+   uS dfd_size = IMG_WriteKTX2DataFormat(image, NULL);
+
+   // levels are aligned to the block size (8 or 16 here, which is already a multiple of 4)
+   uS level_alignment = Image_IsCompressed(image->image_format) ? IMG_BlockSize(image->image_format) : 4;
+
+   uS file_size = dfd_offset + dfd_size;
+   for (u32 mip_i = 0; mip_i < level_count; mip_i++)
+   {
+      file_size = (file_size + level_alignment - 1) & ~(level_alignment - 1);
+      file_size += Image_MipSize(image, mip_i);
+
+   }
+
+   u8* file_data = calloc(1, file_size);
+   if (file_data == NULL)
+      return (memblob){ 0 };
+
+   IMG_KTX2Header header = { 0 };
+   memcpy(header.identifier, img_ktx2_identifier, sizeof(img_ktx2_identifier));
+   header.vk_format = vk_format;
+   header.type_size = 1;
+   header.pixel_width = (u32)image->size.width;
+   header.pixel_height = (u32)image->size.height;
+   header.level_count = level_count;
+   header.face_count = 1;
+   header.dfd_byte_offset = (u32)dfd_offset;
+   header.dfd_byte_length = (u32)dfd_size;
+
+   memcpy(file_data, &header, sizeof(IMG_KTX2Header));
+   IMG_WriteKTX2DataFormat(image, (u32*)(file_data + dfd_offset));
+
+   // the spec wants the smallest mip first in the file, Image keeps the largest first
+   uS source_offsets[UINT8_MAX + 1] = { 0 };
+   for (u32 mip_i = 1; mip_i < level_count; mip_i++)
+      source_offsets[mip_i] = source_offsets[mip_i - 1] + Image_MipSize(image, mip_i - 1);
+
+   uS write_offset = dfd_offset + dfd_size;
+   for (u32 level_i = level_count; level_i > 0; level_i--)
+   {
+      u32 mip_i = level_i - 1;
+
+      write_offset = (write_offset + level_alignment - 1) & ~(level_alignment - 1);
+
+      IMG_KTX2Level level = { 0 };
+      level.byte_offset = write_offset;
+      level.byte_length = Image_MipSize(image, mip_i);
+      level.uncompressed_byte_length = level.byte_length;
+
+      memcpy(file_data + sizeof(IMG_KTX2Header) + sizeof(IMG_KTX2Level) * mip_i, &level, sizeof(IMG_KTX2Level));
+      memcpy(file_data + write_offset, image->data + source_offsets[mip_i], level.byte_length);
+
+      write_offset += level.byte_length;
+
+   }
+
+   return (memblob){ file_data, file_size };
+}
+
+memblob Image_SaveTGA(const Image* image, bool is_bottom_up)
+{
+   if (image == NULL || image->data == NULL || image->image_format != IMG_FORMAT_U8 || image->size.width > UINT16_MAX || image->size.height > UINT16_MAX)
+      return (memblob){ 0 };
+
+   if (image->channel_count != 1 && image->channel_count != 3 && image->channel_count != 4)
+   {
+      IMG_ContainerError(ERR_IMG_UNSUPPORTED_FORMAT, "Image format can't be written to a TGA file");
+
+      return (memblob){ 0 };
+   }
+
+   uS pixel_count = (uS)image->size.width * (uS)image->size.height;
+   uS file_size = 18 + pixel_count * image->channel_count;
+
+   u8* file_data = calloc(1, file_size);
+   if (file_data == NULL)
+      return (memblob){ 0 };
+
+   // uncompressed true color (2) or grayscale (3). bit 5 of the descriptor puts the first row at the top
+   file_data[2] = (image->channel_count == 1) ? 3 : 2;
+   file_data[12] = (u8)(image->size.width & 0xFF);
+   file_data[13] = (u8)(image->size.width >> 8);
+   file_data[14] = (u8)(image->size.height & 0xFF);
+   file_data[15] = (u8)(image->size.height >> 8);
+   file_data[16] = (u8)(image->channel_count * 8);
+   file_data[17] = (u8)(((image->channel_count == 4) ? 8 : 0) | (is_bottom_up ? 0 : 0x20));
+
+   // tga stores colors as bgr(a)
+   u8* pixels = file_data + 18;
+   for (uS pixel_i = 0; pixel_i < pixel_count; pixel_i++)
+   {
+      const u8* source = image->data + pixel_i * image->channel_count;
+      u8* dest = pixels + pixel_i * image->channel_count;
+
+      if (image->channel_count == 1)
+      {
+         dest[0] = source[0];
+         continue;
+      }
+
+      dest[0] = source[2];
+      dest[1] = source[1];
+      dest[2] = source[0];
+
+      if (image->channel_count == 4)
+         dest[3] = source[3];
+
+   }
+
+   return (memblob){ file_data, file_size };
+}
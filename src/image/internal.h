@@ -0,0 +1,137 @@
+#ifndef IMG_INTERNAL
+#define IMG_INTERNAL
+
+#include "util/types.h"
+
+#include "image.h"
+
+#include <string.h>
+
+// "DDS " in hex
+#define DDS_MAGIC_ID 0x20534444
+// "DX10" in hex, the fourcc of files with the extended header
+#define DDS_DX10_FOURCC 0x30315844
+
+#define DDS_CAPS2_CUBEMAP 0x200u
+#define DDS_CAPS2_VOLUME 0x200000u
+
+// vulkan format ids that KTX2 files use
+enum {
+   IMG_VK_FORMAT_R8G8B8A8_UNORM = 37,
+   IMG_VK_FORMAT_R8G8B8A8_SRGB = 43,
+   IMG_VK_FORMAT_BC1_RGB_UNORM = 131,
+   IMG_VK_FORMAT_BC1_RGB_SRGB = 132,
+   IMG_VK_FORMAT_BC1_RGBA_UNORM = 133,
+   IMG_VK_FORMAT_BC1_RGBA_SRGB = 134,
+   IMG_VK_FORMAT_BC3_UNORM = 137,
+   IMG_VK_FORMAT_BC3_SRGB = 138,
+   IMG_VK_FORMAT_BC4_UNORM = 139,
+   IMG_VK_FORMAT_BC5_UNORM = 141,
+   IMG_VK_FORMAT_BC6H_UFLOAT = 143,
+   IMG_VK_FORMAT_BC7_UNORM = 145,
+   IMG_VK_FORMAT_BC7_SRGB = 146
+};
+
+// dxgi format ids from the DX10 dds header
+enum {
+   IMG_DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+   IMG_DXGI_FORMAT_R8G8B8A8_UNORM_SRGB = 29,
+   IMG_DXGI_FORMAT_BC1_UNORM = 71,
+   IMG_DXGI_FORMAT_BC1_UNORM_SRGB = 72,
+   IMG_DXGI_FORMAT_BC3_UNORM = 77,
+   IMG_DXGI_FORMAT_BC3_UNORM_SRGB = 78,
+   IMG_DXGI_FORMAT_BC4_UNORM = 80,
+   IMG_DXGI_FORMAT_BC5_UNORM = 83,
+   IMG_DXGI_FORMAT_BC6H_UF16 = 95,
+   IMG_DXGI_FORMAT_BC7_UNORM = 98,
+   IMG_DXGI_FORMAT_BC7_UNORM_SRGB = 99
+};
+
+typedef struct IMG_KTX2Header_t
+{
+   u8 identifier[12];
+
+   u32 vk_format;
+   u32 type_size;
+   u32 pixel_width;
+   u32 pixel_height;
+   u32 pixel_depth;
+   u32 layer_count;
+   u32 face_count;
+   u32 level_count;
+   u32 supercompression_scheme;
+
+   u32 dfd_byte_offset;
+   u32 dfd_byte_length;
+   u32 kvd_byte_offset;
+   u32 kvd_byte_length;
+   u64 sgd_byte_offset;
+   u64 sgd_byte_length;
+
+} IMG_KTX2Header;
+
+typedef struct IMG_KTX2Level_t
+{
+   u64 byte_offset;
+   u64 byte_length;
+   u64 uncompressed_byte_length;
+
+} IMG_KTX2Level;
+
+typedef struct IMG_DDSPixelFormat_t
+{
+   u32 size;
+   u32 flags;
+   u32 fourcc;
+   u32 rgb_bit_count;
+   u32 bit_masks[4];
+
+} IMG_DDSPixelFormat;
+
+typedef struct IMG_DDSHeader_t
+{
+   u32 magic; // must equal "DDS "
+   u32 size;
+   u32 flags;
+   u32 height;
+   u32 width;
+   u32 pitch_or_linear_size;
+   u32 depth;
+   u32 mipmap_count;
+   u32 reserved_0[11];
+   IMG_DDSPixelFormat pixel_format;
+   u32 caps[4];
+   u32 reserved_1;
+
+} IMG_DDSHeader;
+
+typedef struct IMG_DDSHeaderDX10_t
+{
+   u32 dxgi_format;
+   u32 resource_dimension;
+   u32 misc_flag;
+   u32 array_size;
+   u32 misc_flags_2;
+
+} IMG_DDSHeaderDX10;
+
+static const u8 img_ktx2_identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+// bytes per 4x4 block
+static inline uS IMG_BlockSize(u8 image_format)
+{
+   return (image_format == IMG_FORMAT_BC1 || image_format == IMG_FORMAT_BC1_SRGB || image_format == IMG_FORMAT_BC4) ? 8 : 16;
+}
+
+static inline bool IMG_IsContainer(memblob memory)
+{
+   if (memory.data == NULL || memory.size < sizeof(img_ktx2_identifier))
+      return false;
+
+   u32 magic = 0;
+   memcpy(&magic, memory.data, sizeof(u32));
+
+   return (magic == DDS_MAGIC_ID || memcmp(memory.data, img_ktx2_identifier, sizeof(img_ktx2_identifier)) == 0);
+}
+
+#endif
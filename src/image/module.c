@@ -4,6 +4,7 @@
 #include "util/vec4.h"
 
 #include "image.h"
+#include "image/internal.h"
 
 #include <stb_image.h>
 
@@ -15,6 +16,9 @@ Image Image_CreateImage(memblob memory, u8 image_type, res2D slice_size, bool is
    if (memory.data == NULL || memory.size == 0)
       return (Image){ .data = NULL };
 
+   if (IMG_IsContainer(memory))
+      return Image_LoadContainer(memory, is_srgb);
+
    bool is_hdr = (bool)stbi_is_hdr_from_memory(memory.data, (i32)memory.size);
 
    Image image = { 0 };
@@ -117,7 +121,7 @@ void Image_Free(Image* image)
 
 void Image_GenerateMipmaps(Image* image)
 {
-   if (image == NULL || image->data == NULL)
+   if (image == NULL || image->data == NULL || Image_IsCompressed(image->image_format))
       return;
 
    bool is_hdr = (image->image_format == IMG_FORMAT_F32);
@@ -237,3 +241,22 @@ void Image_GenerateMipmaps(Image* image)
    image->mipmap_count = mipmap_count;
 
 }
+
+uS Image_MipSize(const Image* image, u32 mip_level)
+{
+   if (image == NULL)
+      return 0;
+
+   // sizes are at most INT32_MAX, so every level from 31 on is a single texel (and shifting that far isn't defined)
+   u32 shift = M_MIN(mip_level, 31u);
+   uS mip_width = (uS)M_MAX(image->size.width >> shift, 1);
+   uS mip_height = (uS)M_MAX(image->size.height >> shift, 1);
+   uS mip_depth = (uS)M_MAX((image->image_type == IMG_TYPE_3D) ? image->size.depth >> shift : image->size.depth, 1);
+
+   if (Image_IsCompressed(image->image_format))
+      return ((mip_width + 3) / 4) * ((mip_height + 3) / 4) * mip_depth * IMG_BlockSize(image->image_format);
+
+   uS bytes_per_channel = (image->image_format == IMG_FORMAT_F32) ? sizeof(f32) : sizeof(u8);
+
+   return bytes_per_channel * (uS)image->channel_count * mip_width * mip_height * mip_depth;
+}
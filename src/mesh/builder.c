@@ -0,0 +1,186 @@
+#include "util/math.h"
+#include "util/types.h"
+#include "util/vec2.h"
+#include "util/vec3.h"
+#include "util/vec4.h"
+#include "util/matrix.h"
+
+#include "mesh/internal.h"
+#include "mesh.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static bool MSH_GrowStream(void** stream, uS element_size, u32 capacity)
+{
+   void* grown = realloc(*stream, element_size * (uS)capacity);
+   if (grown == NULL)
+      return false;
+
+   (*stream) = grown;
+
+   return true;
+}
+
+MeshBuilder Mesh_CreateBuilder(u32 vertex_capacity, u32 index_capacity)
+{
+   MeshBuilder builder = { 0 };
+   Mesh_ReserveBuilder(&builder, vertex_capacity, index_capacity);
+
+   return builder;
+}
+
+void Mesh_FreeBuilder(MeshBuilder* builder)
+{
+   if (builder == NULL)
+      return;
+
+   free(builder->position);
+   free(builder->normal);
+   free(builder->texcoord);
+   free(builder->tangent);
+   free(builder->indices);
+
+   (*builder) = (MeshBuilder){ 0 };
+
+}
+
+bool Mesh_ReserveBuilder(MeshBuilder* builder, u32 vertex_count, u32 index_count)
+{
+   if (builder == NULL)
+      return false;
+
+   u32 needed_vertices = builder->vertex_count + vertex_count;
+   u32 needed_indices = builder->index_count + index_count;
+
+   // doubling keeps lots of small appends linear overall
+   if (needed_vertices > builder->vertex_capacity)
+   {
+      u32 capacity = M_MAX(needed_vertices, builder->vertex_capacity * 2u);
+
+      bool is_grown =
+         MSH_GrowStream((void**)&builder->position, sizeof(vec3), capacity) &&
+         MSH_GrowStream((void**)&builder->normal, sizeof(vec3), capacity) &&
+         MSH_GrowStream((void**)&builder->texcoord, sizeof(vec2), capacity) &&
+         MSH_GrowStream((void**)&builder->tangent, sizeof(vec4), capacity);
+
+      if (!is_grown)
+         return false;
+
+      builder->vertex_capacity = capacity;
+
+   }
+
+   if (needed_indices > builder->index_capacity)
+   {
+      u32 capacity = M_MAX(needed_indices, builder->index_capacity * 2u);
+
+      if (!MSH_GrowStream((void**)&builder->indices, sizeof(u32), capacity))
+         return false;
+
+      builder->index_capacity = capacity;
+
+   }
+
+   return true;
+}
+
+u32 Mesh_BuilderAddVertex(MeshBuilder* builder, vec3 position, vec3 normal, vec2 texcoord, vec4 tangent)
+{
+   if (!Mesh_ReserveBuilder(builder, 1, 0))
+      return UINT32_MAX;
+
+   u32 vert_i = builder->vertex_count++;
+   builder->position[vert_i] = position;
+   builder->normal[vert_i] = normal;
+   builder->texcoord[vert_i] = texcoord;
+   builder->tangent[vert_i] = tangent;
+
+   return vert_i;
+}
+
+void Mesh_BuilderAddTriangle(MeshBuilder* builder, u32 idx_a, u32 idx_b, u32 idx_c)
+{
+   if (!Mesh_ReserveBuilder(builder, 0, 3))
+      return;
+
+   builder->indices[builder->index_count++] = idx_a;
+   builder->indices[builder->index_count++] = idx_b;
+   builder->indices[builder->index_count++] = idx_c;
+
+}
+
+void Mesh_BuilderAddQuad(MeshBuilder* builder, u32 faces_x, u32 faces_y, mat4x4 transform, vec4 texture_coords)
+{
+   u32 vertex_count = (u32)((faces_x + 1) * (faces_y + 1));
+   u32 index_count = (u32)(faces_x * faces_y * 6);
+
+   if (!Mesh_ReserveBuilder(builder, vertex_count, index_count))
+      return;
+
+   u32 last_vrt = builder->vertex_count;
+   u32 last_idx = builder->index_count;
+
+   MSH_FillQuad(faces_x, faces_y, transform, texture_coords, last_vrt, builder->position + last_vrt, builder->normal + last_vrt, builder->texcoord + last_vrt, builder->tangent + last_vrt, builder->indices + last_idx);
+
+   builder->vertex_count += vertex_count;
+   builder->index_count += index_count;
+
+}
+
+MeshInterface Mesh_FinishBuilder(MeshBuilder* builder, Mesh* out_mesh)
+{
+   if (builder == NULL || out_mesh == NULL)
+      return Mesh_NewInterface(NULL);
+
+   Mesh mesh = Mesh_EmptyMeshWithIndexType(MESH_PRIMITIVE_TRIANGLE, MESH_INDEXTYPE_32BIT);
+   mesh.attribute_count = 4;
+   mesh.attributes[0] = MESH_ATTRIBUTE_3_CHANNEL;
+   mesh.attributes[1] = MESH_ATTRIBUTE_3_CHANNEL;
+   mesh.attributes[2] = MESH_ATTRIBUTE_2_CHANNEL;
+   mesh.attributes[3] = MESH_ATTRIBUTE_4_CHANNEL;
+
+   (*out_mesh) = mesh;
+   MeshInterface mesh_interface = Mesh_NewInterface(out_mesh);
+
+   u32 vertex_count = builder->vertex_count;
+
+   mesh_interface.atr.position_size = sizeof(vec3) * (uS)vertex_count;
+   mesh_interface.atr.normal_ofs = mesh_interface.atr.position_size;
+   mesh_interface.atr.normal_size = sizeof(vec3) * (uS)vertex_count;
+   mesh_interface.atr.texcoord_ofs[0] = mesh_interface.atr.normal_ofs + mesh_interface.atr.normal_size;
+   mesh_interface.atr.texcoord_size[0] = sizeof(vec2) * (uS)vertex_count;
+   mesh_interface.atr.tangent_ofs = mesh_interface.atr.texcoord_ofs[0] + mesh_interface.atr.texcoord_size[0];
+   mesh_interface.atr.tangent_size = sizeof(vec4) * (uS)vertex_count;
+   mesh_interface.total_bytes = mesh_interface.atr.tangent_ofs + mesh_interface.atr.tangent_size;
+
+   u8* vertex_buffer = (vertex_count > 0) ? malloc(mesh_interface.total_bytes) : NULL;
+   if (vertex_buffer == NULL)
+   {
+      Mesh_FreeBuilder(builder);
+
+      return Mesh_NewInterface(out_mesh);
+   }
+
+   memcpy(vertex_buffer, builder->position, mesh_interface.atr.position_size);
+   memcpy(vertex_buffer + mesh_interface.atr.normal_ofs, builder->normal, mesh_interface.atr.normal_size);
+   memcpy(vertex_buffer + mesh_interface.atr.texcoord_ofs[0], builder->texcoord, mesh_interface.atr.texcoord_size[0]);
+   memcpy(vertex_buffer + mesh_interface.atr.tangent_ofs, builder->tangent, mesh_interface.atr.tangent_size);
+
+   out_mesh->vertex_buffer = vertex_buffer;
+   out_mesh->vertex_count = vertex_count;
+
+   // the index stream is already in the final format, so it's handed over instead of copied
+   if (builder->index_count > 0)
+   {
+      u32* indices = realloc(builder->indices, sizeof(u32) * (uS)builder->index_count);
+      out_mesh->index_buffer = (indices != NULL) ? indices : builder->indices;
+      out_mesh->index_count = builder->index_count;
+      builder->indices = NULL;
+
+   }
+
+   Mesh_FreeBuilder(builder);
+
+   return mesh_interface;
+}
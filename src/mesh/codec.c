@@ -0,0 +1,679 @@
+#include "util/types.h"
+#include "util/math.h"
+
+#include "mesh/internal.h"
+#include "mesh.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+   vertex streams: every attribute is split into its 32 bit channels, each channel is delta coded against the same
+   channel of the previous vertex with the sign folded into the low bit, then split into 4 byte planes. neighbouring
+   vertices share their high bytes (sign, exponent, top of the mantissa) so those planes come out mostly zero, and
+   floats with rounded off mantissas (Mesh_RoundVertexPrecision) zero out the low planes as well. each plane is stored as blocks of
+   16 bytes, with a 2 bit width per block (0, 2, 4 or 8 bits per byte) packed 4 to a byte ahead of the block data.
+
+   index streams: one 4 bit code per index. 0 is the next vertex nobody has used yet, 1 to 14 are hits in a fifo of
+   recently added vertices, 15 is a miss with a zigzagged varint delta from the previous index in a separate byte stream.
+   triangle lists made of strips and fans mostly land in the first two cases.
+*/
+
+#define MSH_VERTEX_CODEC_VERSION 0xA1
+#define MSH_INDEX_CODEC_VERSION 0xB1
+
+#define MSH_CODEC_BLOCK_SIZE 16u
+#define MSH_INDEX_FIFO_SIZE 16u
+#define MSH_INDEX_FIFO_CODES 14u
+#define MSH_INDEX_CODE_NEW 0u
+#define MSH_INDEX_CODE_ESCAPE 15u
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+   #include <emmintrin.h>
+   #define MSH_CODEC_SSE2
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+   #include <arm_neon.h>
+   #define MSH_CODEC_NEON
+
+#endif
+
+static const u8 MSH_BLOCK_BITS[4] = { 0, 2, 4, 8 };
+
+static inline u32 MSH_ZigZag(u32 delta)
+{
+   return (delta << 1) ^ (u32)((i32)delta >> 31);
+}
+
+static inline u32 MSH_UnZigZag(u32 value)
+{
+   return (value >> 1) ^ (0u - (value & 1u));
+}
+
+// like zigzag but sign and magnitude, so a delta that ends in zero bits keeps them whichever way it goes.
+// the one magnitude that doesn't fit (a flipped sign bit, 0x80000000) lands on the otherwise unused negative zero
+static inline u32 MSH_FoldSign(u32 delta)
+{
+   u32 sign = (u32)((i32)delta >> 31);
+   return (((delta ^ sign) - sign) << 1) | (sign & 1u);
+}
+
+static inline u32 MSH_UnfoldSign(u32 value)
+{
+   u32 sign = 0u - (value & 1u);
+   return (((value >> 1) ^ sign) - sign) | ((u32)(value == 1u) << 31);
+}
+
+static uS MSH_PlaneBound(u32 count)
+{
+   uS block_count = ((uS)count + MSH_CODEC_BLOCK_SIZE - 1) / MSH_CODEC_BLOCK_SIZE;
+   return (block_count + 3) / 4 + block_count * MSH_CODEC_BLOCK_SIZE;
+}
+
+static u8* MSH_EncodePlane(u8* write_head, const u8* plane, u32 count)
+{
+   uS block_count = ((uS)count + MSH_CODEC_BLOCK_SIZE - 1) / MSH_CODEC_BLOCK_SIZE;
+   u8* header = write_head;
+   write_head += (block_count + 3) / 4;
+
+   memset(header, 0, (block_count + 3) / 4);
+
+   for (uS block_i = 0; block_i < block_count; block_i++)
+   {
+      u8 block[MSH_CODEC_BLOCK_SIZE] = { 0 };
+      uS block_start = block_i * MSH_CODEC_BLOCK_SIZE;
+      uS block_length = M_MIN((uS)count - block_start, (uS)MSH_CODEC_BLOCK_SIZE);
+
+      u8 block_max = 0;
+      for (uS byte_i = 0; byte_i < block_length; byte_i++)
+      {
+         block[byte_i] = plane[block_start + byte_i];
+         block_max = M_MAX(block_max, block[byte_i]);
+
+      }
+
+      u8 width = (block_max == 0) ? 0 : (block_max < 4) ? 1 : (block_max < 16) ? 2 : 3;
+      header[block_i / 4] |= (u8)(width << ((block_i % 4) * 2));
+
+      u8 bits = MSH_BLOCK_BITS[width];
+      if (bits == 8)
+      {
+         memcpy(write_head, block, MSH_CODEC_BLOCK_SIZE);
+         write_head += MSH_CODEC_BLOCK_SIZE;
+
+         continue;
+      }
+
+      u8 per_byte = (bits == 0) ? 0 : (u8)(8 / bits);
+      for (u8 out_i = 0; bits != 0 && out_i < MSH_CODEC_BLOCK_SIZE / per_byte; out_i++)
+      {
+         u8 packed = 0;
+         for (u8 value_i = 0; value_i < per_byte; value_i++)
+            packed |= (u8)(block[out_i * per_byte + value_i] << (value_i * bits));
+
+         *(write_head++) = packed;
+
+      }
+
+   }
+
+   return write_head;
+}
+
+static inline void MSH_UnpackBlock(u8* out_block, const u8* data, u8 bits)
+{
+#if defined(MSH_CODEC_SSE2)
+   if (bits == 4)
+   {
+      __m128i packed = _mm_loadl_epi64((const __m128i*)data);
+      __m128i nibble_mask = _mm_set1_epi8(0x0F);
+      __m128i low = _mm_and_si128(packed, nibble_mask);
+      __m128i high = _mm_and_si128(_mm_srli_epi16(packed, 4), nibble_mask);
+
+      _mm_storeu_si128((__m128i*)out_block, _mm_unpacklo_epi8(low, high));
+
+      return;
+   }
+
+   if (bits == 2)
+   {
+      u32 word = 0;
+      memcpy(&word, data, sizeof(u32));
+
+      __m128i packed = _mm_cvtsi32_si128((i32)word);
+      __m128i pair_mask = _mm_set1_epi8(0x03);
+      __m128i value_0 = _mm_and_si128(packed, pair_mask);
+      __m128i value_1 = _mm_and_si128(_mm_srli_epi16(packed, 2), pair_mask);
+      __m128i value_2 = _mm_and_si128(_mm_srli_epi16(packed, 4), pair_mask);
+      __m128i value_3 = _mm_and_si128(_mm_srli_epi16(packed, 6), pair_mask);
+
+      __m128i low = _mm_unpacklo_epi8(value_0, value_1);
+      __m128i high = _mm_unpacklo_epi8(value_2, value_3);
+
+      _mm_storeu_si128((__m128i*)out_block, _mm_unpacklo_epi16(low, high));
+
+      return;
+   }
+
+#elif defined(MSH_CODEC_NEON)
+   if (bits == 4)
+   {
+      uint8x8_t packed = vld1_u8(data);
+      uint8x8x2_t zipped = vzip_u8(vand_u8(packed, vdup_n_u8(0x0F)), vshr_n_u8(packed, 4));
+
+      vst1q_u8(out_block, vcombine_u8(zipped.val[0], zipped.val[1]));
+
+      return;
+   }
+
+   if (bits == 2)
+   {
+      u32 word = 0;
+      memcpy(&word, data, sizeof(u32));
+
+      uint8x8_t packed = vcreate_u8((u64)word);
+      uint8x8_t pair_mask = vdup_n_u8(0x03);
+
+      uint8x8_t low = vzip_u8(vand_u8(packed, pair_mask), vand_u8(vshr_n_u8(packed, 2), pair_mask)).val[0];
+      uint8x8_t high = vzip_u8(vand_u8(vshr_n_u8(packed, 4), pair_mask), vshr_n_u8(packed, 6)).val[0];
+      uint16x4x2_t zipped = vzip_u16(vreinterpret_u16_u8(low), vreinterpret_u16_u8(high));
+
+      vst1q_u8(out_block, vreinterpretq_u8_u16(vcombine_u16(zipped.val[0], zipped.val[1])));
+
+      return;
+   }
+
+#endif
+
+   u8 per_byte = (u8)(8 / bits);
+   u8 value_mask = (u8)((1u << bits) - 1);
+
+   for (u8 value_i = 0; value_i < MSH_CODEC_BLOCK_SIZE; value_i++)
+      out_block[value_i] = (data[value_i / per_byte] >> ((value_i % per_byte) * bits)) & value_mask;
+
+}
+
+// out_plane has to be padded out to a whole number of blocks
+static const u8* MSH_DecodePlane(u8* out_plane, u32 count, const u8* read_head, const u8* data_end)
+{
+   uS block_count = ((uS)count + MSH_CODEC_BLOCK_SIZE - 1) / MSH_CODEC_BLOCK_SIZE;
+   uS header_size = (block_count + 3) / 4;
+
+   if ((uS)(data_end - read_head) < header_size)
+      return NULL;
+
+   const u8* header = read_head;
+   read_head += header_size;
+
+   for (uS block_i = 0; block_i < block_count; block_i++)
+   {
+      u8 bits = MSH_BLOCK_BITS[(header[block_i / 4] >> ((block_i % 4) * 2)) & 3];
+      u8* out_block = out_plane + block_i * MSH_CODEC_BLOCK_SIZE;
+      uS data_size = (uS)bits * MSH_CODEC_BLOCK_SIZE / 8;
+
+      if ((uS)(data_end - read_head) < data_size)
+         return NULL;
+
+      if (bits == 0)
+         memset(out_block, 0, MSH_CODEC_BLOCK_SIZE);
+      else if (bits == 8)
+         memcpy(out_block, read_head, MSH_CODEC_BLOCK_SIZE);
+      else
+         MSH_UnpackBlock(out_block, read_head, bits);
+
+      read_head += data_size;
+
+   }
+
+   return read_head;
+}
+
+// stitches the 4 planes of a channel back into words, undoes the sign folding and the delta, and writes every stride'th word
+static void MSH_RebuildChannel(u32* out_words, u32 stride, u32 count, u8* planes[4])
+{
+   u32 previous = 0;
+   u32 vert_i = 0;
+
+#if defined(MSH_CODEC_SSE2)
+   __m128i zero = _mm_setzero_si128();
+   __m128i one = _mm_set1_epi32(1);
+
+   for (; vert_i + 4 <= count; vert_i += 4)
+   {
+      u32 plane_words[4];
+      for (u32 plane_i = 0; plane_i < 4; plane_i++)
+         memcpy(&plane_words[plane_i], planes[plane_i] + vert_i, sizeof(u32));
+
+      __m128i low = _mm_unpacklo_epi8(_mm_cvtsi32_si128((i32)plane_words[0]), _mm_cvtsi32_si128((i32)plane_words[1]));
+      __m128i high = _mm_unpacklo_epi8(_mm_cvtsi32_si128((i32)plane_words[2]), _mm_cvtsi32_si128((i32)plane_words[3]));
+      __m128i folded = _mm_unpacklo_epi16(low, high);
+
+      __m128i sign = _mm_sub_epi32(zero, _mm_and_si128(folded, one));
+      __m128i delta = _mm_sub_epi32(_mm_xor_si128(_mm_srli_epi32(folded, 1), sign), sign);
+      delta = _mm_or_si128(delta, _mm_and_si128(_mm_cmpeq_epi32(folded, one), _mm_set1_epi32(INT32_MIN)));
+
+      // running sum across the 4 lanes, then carry in whatever the last group ended on
+      delta = _mm_add_epi32(delta, _mm_slli_si128(delta, 4));
+      delta = _mm_add_epi32(delta, _mm_slli_si128(delta, 8));
+      delta = _mm_add_epi32(delta, _mm_set1_epi32((i32)previous));
+
+      u32 words[4];
+      _mm_storeu_si128((__m128i*)words, delta);
+
+      for (u32 lane_i = 0; lane_i < 4; lane_i++)
+         out_words[(uS)(vert_i + lane_i) * stride] = words[lane_i];
+
+      previous = words[3];
+
+   }
+
+#elif defined(MSH_CODEC_NEON)
+   uint32x4_t zero = vdupq_n_u32(0);
+
+   for (; vert_i + 4 <= count; vert_i += 4)
+   {
+      uint32x4_t folded = vdupq_n_u32(0);
+      for (u32 plane_i = 0; plane_i < 4; plane_i++)
+      {
+         u32 plane_word = 0;
+         memcpy(&plane_word, planes[plane_i] + vert_i, sizeof(u32));
+
+         uint32x4_t widened = vmovl_u16(vget_low_u16(vmovl_u8(vcreate_u8((u64)plane_word))));
+         folded = vorrq_u32(folded, vshlq_u32(widened, vdupq_n_s32((i32)(plane_i * 8))));
+
+      }
+
+      uint32x4_t sign = vreinterpretq_u32_s32(vnegq_s32(vreinterpretq_s32_u32(vandq_u32(folded, vdupq_n_u32(1)))));
+      uint32x4_t delta = vsubq_u32(veorq_u32(vshrq_n_u32(folded, 1), sign), sign);
+      delta = vorrq_u32(delta, vandq_u32(vceqq_u32(folded, vdupq_n_u32(1)), vdupq_n_u32(0x80000000u)));
+
+      delta = vaddq_u32(delta, vextq_u32(zero, delta, 3));
+      delta = vaddq_u32(delta, vextq_u32(zero, delta, 2));
+      delta = vaddq_u32(delta, vdupq_n_u32(previous));
+
+      u32 words[4];
+      vst1q_u32(words, delta);
+
+      for (u32 lane_i = 0; lane_i < 4; lane_i++)
+         out_words[(uS)(vert_i + lane_i) * stride] = words[lane_i];
+
+      previous = words[3];
+
+   }
+
+#endif
+
+   for (; vert_i < count; vert_i++)
+   {
+      u32 folded = (u32)planes[0][vert_i] | ((u32)planes[1][vert_i] << 8) | ((u32)planes[2][vert_i] << 16) | ((u32)planes[3][vert_i] << 24);
+
+      previous += MSH_UnfoldSign(folded);
+      out_words[(uS)vert_i * stride] = previous;
+
+   }
+
+}
+
+uS MSH_VertexStreamBound(const u8* attributes, u8 attribute_count, u32 vertex_count)
+{
+   uS channel_count = MSH_VertexSize(attributes, attribute_count) / sizeof(u32);
+   return 1 + channel_count * 4 * MSH_PlaneBound(vertex_count);
+}
+
+uS MSH_VertexStreamMinimum(const u8* attributes, u8 attribute_count, u32 vertex_count)
+{
+   // every block is all zeros, so only the width headers are left
+   uS channel_count = MSH_VertexSize(attributes, attribute_count) / sizeof(u32);
+   uS block_count = ((uS)vertex_count + MSH_CODEC_BLOCK_SIZE - 1) / MSH_CODEC_BLOCK_SIZE;
+
+   return 1 + channel_count * 4 * ((block_count + 3) / 4);
+}
+
+uS MSH_EncodeVertexStream(u8* out_data, uS out_capacity, const u8* vertex_buffer, const u8* attributes, u8 attribute_count, u32 vertex_count)
+{
+   if (out_data == NULL || vertex_buffer == NULL || out_capacity < MSH_VertexStreamBound(attributes, attribute_count, vertex_count))
+      return 0;
+
+   u8* planes = malloc((uS)M_MAX(vertex_count, 1u) * 4);
+   if (planes == NULL)
+      return 0;
+
+   u8* write_head = out_data;
+   *(write_head++) = MSH_VERTEX_CODEC_VERSION;
+
+   const u8* attribute_data = vertex_buffer;
+
+   for (u8 atr_i = 0; atr_i < attribute_count; atr_i++)
+   {
+      u32 channel_count = (u32)(MSH_VertexSize(&attributes[atr_i], 1) / sizeof(u32));
+
+      for (u32 channel_i = 0; channel_i < channel_count; channel_i++)
+      {
+         u32 previous = 0;
+
+         for (u32 vert_i = 0; vert_i < vertex_count; vert_i++)
+         {
+            u32 word = 0;
+            memcpy(&word, attribute_data + ((uS)vert_i * channel_count + channel_i) * sizeof(u32), sizeof(u32));
+
+            u32 folded = MSH_FoldSign(word - previous);
+            previous = word;
+
+            for (u32 plane_i = 0; plane_i < 4; plane_i++)
+               planes[(uS)plane_i * vertex_count + vert_i] = (u8)(folded >> (plane_i * 8));
+
+         }
+
+         for (u32 plane_i = 0; plane_i < 4; plane_i++)
+            write_head = MSH_EncodePlane(write_head, planes + (uS)plane_i * vertex_count, vertex_count);
+
+      }
+
+      attribute_data += (uS)channel_count * sizeof(u32) * vertex_count;
+
+   }
+
+   free(planes);
+
+   return (uS)(write_head - out_data);
+}
+
+bool MSH_DecodeVertexStream(u8* out_vertex_buffer, const u8* attributes, u8 attribute_count, u32 vertex_count, const u8* data, uS data_size)
+{
+   if (out_vertex_buffer == NULL || data == NULL || data_size == 0 || data[0] != MSH_VERTEX_CODEC_VERSION)
+      return false;
+
+   uS plane_size = ((uS)vertex_count + MSH_CODEC_BLOCK_SIZE - 1) / MSH_CODEC_BLOCK_SIZE * MSH_CODEC_BLOCK_SIZE;
+   u8* plane_data = malloc(M_MAX(plane_size, (uS)MSH_CODEC_BLOCK_SIZE) * 4);
+
+   if (plane_data == NULL)
+      return false;
+
+   u8* planes[4] = { plane_data, plane_data + plane_size, plane_data + plane_size * 2, plane_data + plane_size * 3 };
+
+   const u8* read_head = data + 1;
+   const u8* data_end = data + data_size;
+   u8* attribute_data = out_vertex_buffer;
+
+   for (u8 atr_i = 0; atr_i < attribute_count && read_head != NULL; atr_i++)
+   {
+      u32 channel_count = (u32)(MSH_VertexSize(&attributes[atr_i], 1) / sizeof(u32));
+
+      for (u32 channel_i = 0; channel_i < channel_count && read_head != NULL; channel_i++)
+      {
+         for (u32 plane_i = 0; plane_i < 4 && read_head != NULL; plane_i++)
+            read_head = MSH_DecodePlane(planes[plane_i], vertex_count, read_head, data_end);
+
+         if (read_head != NULL)
+            MSH_RebuildChannel((u32*)attribute_data + channel_i, channel_count, vertex_count, planes);
+
+      }
+
+      attribute_data += (uS)channel_count * sizeof(u32) * vertex_count;
+
+   }
+
+   free(plane_data);
+
+   return (read_head != NULL);
+}
+
+uS MSH_IndexStreamBound(u32 index_count)
+{
+   // every index could miss the fifo, and a varint of 32 bits takes 5 bytes
+   return 1 + ((uS)index_count + 1) / 2 + (uS)index_count * 5;
+}
+
+uS MSH_IndexStreamMinimum(u32 index_count)
+{
+   return 1 + ((uS)index_count + 1) / 2;
+}
+
+static inline u32 MSH_ReadIndex(const void* index_buffer, u8 index_type, u32 index_i)
+{
+   if (index_type == MESH_INDEXTYPE_32BIT)
+      return ((const u32*)index_buffer)[index_i];
+
+   return ((const u16*)index_buffer)[index_i];
+}
+
+uS MSH_EncodeIndexStream(u8* out_data, uS out_capacity, const void* index_buffer, u8 index_type, u32 index_count)
+{
+   if (out_data == NULL || index_buffer == NULL || out_capacity < MSH_IndexStreamBound(index_count))
+      return 0;
+
+   uS code_size = ((uS)index_count + 1) / 2;
+   u8* codes = out_data + 1;
+   u8* escape_head = codes + code_size;
+
+   out_data[0] = MSH_INDEX_CODEC_VERSION;
+   memset(codes, 0, code_size);
+
+   u32 fifo[MSH_INDEX_FIFO_SIZE];
+   memset(fifo, 0xFF, sizeof(fifo));
+
+   u32 fifo_head = 0;
+   u32 next_vertex = 0;
+   u32 last_index = 0;
+
+   for (u32 index_i = 0; index_i < index_count; index_i++)
+   {
+      u32 index = MSH_ReadIndex(index_buffer, index_type, index_i);
+      u32 code = MSH_INDEX_CODE_ESCAPE;
+
+      if (index == next_vertex)
+      {
+         code = MSH_INDEX_CODE_NEW;
+         next_vertex++;
+
+      } else {
+         for (u32 fifo_i = 0; fifo_i < MSH_INDEX_FIFO_CODES; fifo_i++)
+         {
+            if (fifo[(fifo_head - 1 - fifo_i) % MSH_INDEX_FIFO_SIZE] == index)
+            {
+               code = 1 + fifo_i;
+               break;
+            }
+
+         }
+
+      }
+
+      if (code == MSH_INDEX_CODE_ESCAPE)
+      {
+         u32 value = MSH_ZigZag(index - last_index);
+
+         while (value >= 0x80)
+         {
+            *(escape_head++) = (u8)(value | 0x80);
+            value >>= 7;
+
+         }
+
+         *(escape_head++) = (u8)value;
+
+      }
+
+      // hits stay where they are, so the fifo keeps tracking the most recently introduced vertices
+      if (code == MSH_INDEX_CODE_NEW || code == MSH_INDEX_CODE_ESCAPE)
+         fifo[(fifo_head++) % MSH_INDEX_FIFO_SIZE] = index;
+
+      codes[index_i / 2] |= (u8)(code << ((index_i % 2) * 4));
+      last_index = index;
+
+   }
+
+   return (uS)(escape_head - out_data);
+}
+
+bool MSH_DecodeIndexStream(void* out_index_buffer, u8 index_type, u32 index_count, const u8* data, uS data_size)
+{
+   uS code_size = ((uS)index_count + 1) / 2;
+   if (out_index_buffer == NULL || data == NULL || data_size < MSH_IndexStreamMinimum(index_count) || data[0] != MSH_INDEX_CODEC_VERSION)
+      return false;
+
+   const u8* codes = data + 1;
+   const u8* escape_head = codes + code_size;
+   const u8* data_end = data + data_size;
+
+   u32 fifo[MSH_INDEX_FIFO_SIZE];
+   memset(fifo, 0xFF, sizeof(fifo));
+
+   u32 fifo_head = 0;
+   u32 next_vertex = 0;
+   u32 last_index = 0;
+
+   for (u32 index_i = 0; index_i < index_count; index_i++)
+   {
+      u32 code = (codes[index_i / 2] >> ((index_i % 2) * 4)) & 0x0F;
+      u32 index = 0;
+
+      if (code == MSH_INDEX_CODE_NEW)
+      {
+         index = next_vertex++;
+         fifo[(fifo_head++) % MSH_INDEX_FIFO_SIZE] = index;
+
+      } else if (code == MSH_INDEX_CODE_ESCAPE) {
+         u32 value = 0;
+         u32 shift = 0;
+
+         while (true)
+         {
+            if (escape_head == data_end || shift > 28)
+               return false;
+
+            u8 byte = *(escape_head++);
+            value |= (u32)(byte & 0x7F) << shift;
+            shift += 7;
+
+            if ((byte & 0x80) == 0)
+               break;
+
+         }
+
+         index = last_index + MSH_UnZigZag(value);
+         fifo[(fifo_head++) % MSH_INDEX_FIFO_SIZE] = index;
+
+      } else {
+         index = fifo[(fifo_head - code) % MSH_INDEX_FIFO_SIZE];
+
+      }
+
+      if (index_type == MESH_INDEXTYPE_32BIT)
+         ((u32*)out_index_buffer)[index_i] = index;
+      else
+         ((u16*)out_index_buffer)[index_i] = (u16)index;
+
+      last_index = index;
+
+   }
+
+   return true;
+}
+
+bool Mesh_OptimizeVertexFetch(Mesh* mesh)
+{
+   if (mesh == NULL || mesh->vertex_buffer == NULL || mesh->index_buffer == NULL || !Mesh_MakeOwned(mesh))
+      return false;
+
+   u32 vertex_count = mesh->vertex_count;
+   u32* remap = malloc(sizeof(u32) * (uS)M_MAX(vertex_count, 1u));
+   u8* vertex_buffer = malloc(MSH_VertexSize(mesh->attributes, mesh->attribute_count) * (uS)M_MAX(vertex_count, 1u));
+
+   if (remap == NULL || vertex_buffer == NULL)
+   {
+      free(remap);
+      free(vertex_buffer);
+
+      return false;
+   }
+
+   memset(remap, 0xFF, sizeof(u32) * (uS)vertex_count);
+
+   // vertices go in the order the triangles first use them, anything unused ends up at the back
+   u32 next_vertex = 0;
+   for (u32 index_i = 0; index_i < mesh->index_count; index_i++)
+   {
+      u32 index = Mesh_GetIndexFromBuffer(*mesh, index_i);
+      if (index < vertex_count && remap[index] == UINT32_MAX)
+         remap[index] = next_vertex++;
+
+   }
+
+   for (u32 vert_i = 0; vert_i < vertex_count; vert_i++)
+   {
+      if (remap[vert_i] == UINT32_MAX)
+         remap[vert_i] = next_vertex++;
+
+   }
+
+   uS attribute_ofs = 0;
+   for (u8 atr_i = 0; atr_i < mesh->attribute_count; atr_i++)
+   {
+      uS attribute_size = MSH_VertexSize(&mesh->attributes[atr_i], 1);
+
+      for (u32 vert_i = 0; vert_i < vertex_count; vert_i++)
+         memcpy(vertex_buffer + attribute_ofs + attribute_size * (uS)remap[vert_i], mesh->vertex_buffer + attribute_ofs + attribute_size * (uS)vert_i, attribute_size);
+
+      attribute_ofs += attribute_size * (uS)vertex_count;
+
+   }
+
+   for (u32 index_i = 0; index_i < mesh->index_count; index_i++)
+   {
+      u32 index = Mesh_GetIndexFromBuffer(*mesh, index_i);
+      if (index < vertex_count)
+         Mesh_SetIndexInBuffer(mesh, index_i, remap[index]);
+
+   }
+
+   free(mesh->vertex_buffer);
+   mesh->vertex_buffer = vertex_buffer;
+
+   free(remap);
+
+   return true;
+}
+
+bool Mesh_RoundVertexPrecision(Mesh* mesh, u8 mantissa_bits)
+{
+   if (mesh == NULL || mesh->vertex_buffer == NULL || !Mesh_MakeOwned(mesh))
+      return false;
+
+   if (mantissa_bits >= 23)
+      return true;
+
+   u32 dropped_mask = (1u << (23 - mantissa_bits)) - 1;
+   u8* attribute_data = mesh->vertex_buffer;
+
+   for (u8 atr_i = 0; atr_i < mesh->attribute_count; atr_i++)
+   {
+      uS word_count = MSH_VertexSize(&mesh->attributes[atr_i], 1) / sizeof(u32) * (uS)mesh->vertex_count;
+
+      // colors are already bytes
+      if (mesh->attributes[atr_i] == MESH_ATTRIBUTE_COLOR)
+      {
+         attribute_data += word_count * sizeof(u32);
+         continue;
+      }
+
+      u32* words = (u32*)attribute_data;
+      for (uS word_i = 0; word_i < word_count; word_i++)
+      {
+         u32 word = words[word_i];
+         if ((word & 0x7F800000u) == 0x7F800000u)
+            continue;
+
+         // round to nearest, unless that would carry all the way into infinity
+         u32 rounded = (word + (dropped_mask >> 1) + 1) & ~dropped_mask;
+         words[word_i] = ((rounded & 0x7F800000u) == 0x7F800000u) ? (word & ~dropped_mask) : rounded;
+
+      }
+
+      attribute_data += word_count * sizeof(u32);
+
+   }
+
+   return true;
+}
@@ -0,0 +1,1103 @@
+#include "util/types.h"
+#include "util/extra_types.h"
+#include "util/files.h"
+#include "util/jobs.h"
+#include "util/math.h"
+
+#include "mesh/internal.h"
+#include "mesh.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static u64 MSH_AlignOffset(u64 offset)
+{
+   return (offset + (EBMF_ALIGNMENT - 1)) & ~(u64)(EBMF_ALIGNMENT - 1);
+}
+
+static bool MSH_RangeInside(u64 offset, u64 size, uS total_size)
+{
+   return (offset <= (u64)total_size) && (size <= (u64)total_size - offset);
+}
+
+static bool MSH_PeekModelVersion(memblob memory, u16* out_version)
+{
+   if ((memory.data == NULL) || (memory.size < sizeof(MSH_ModelHeader)))
+      return false;
+
+   MSH_ModelHeader model_header = { 0 };
+   memcpy(&model_header, memory.data, sizeof(MSH_ModelHeader));
+
+   if (model_header.identifier.magic != MODEL_MAGIC_ID)
+      return false;
+
+   (*out_version) = model_header.version;
+
+   return true;
+}
+
+static bool MSH_ReadModelHeaderV2(memblob memory, MSH_ModelHeaderV2* out_header)
+{
+   u16 version = 0;
+   if (!MSH_PeekModelVersion(memory, &version) || version != EBMF_VERSION_2 || memory.size < sizeof(MSH_ModelHeaderV2))
+      return false;
+
+   memcpy(out_header, memory.data, sizeof(MSH_ModelHeaderV2));
+
+   return MSH_RangeInside(out_header->directory_offset, (u64)out_header->chunk_count * sizeof(MSH_ChunkEntry), memory.size);
+}
+
+static MSH_ChunkEntry MSH_GetChunkEntry(memblob memory, MSH_ModelHeaderV2 header, u32 chunk_i)
+{
+   MSH_ChunkEntry chunk = { 0 };
+   memcpy(&chunk, (u8*)memory.data + header.directory_offset + (u64)chunk_i * sizeof(MSH_ChunkEntry), sizeof(MSH_ChunkEntry));
+
+   if (!MSH_RangeInside(chunk.offset, chunk.size, memory.size))
+      chunk.type = 0;
+
+   return chunk;
+}
+
+// checks everything the header points at actually lies inside the file before anything gets read through it
+static bool MSH_ReadMeshHeaderV2(memblob memory, MSH_ChunkEntry chunk, MSH_MeshHeaderV2* out_header)
+{
+   if (chunk.size < sizeof(MSH_MeshHeaderV2))
+      return false;
+
+   MSH_MeshHeaderV2 mesh_header = { 0 };
+   memcpy(&mesh_header, (u8*)memory.data + chunk.offset, sizeof(MSH_MeshHeaderV2));
+
+   if (mesh_header.vertex_count == 0 || mesh_header.attribute_count == 0 || mesh_header.attribute_count > MESH_MAX_ATTRIBUTES)
+      return false;
+
+   if (mesh_header.index_type != MESH_INDEXTYPE_16BIT && mesh_header.index_type != MESH_INDEXTYPE_32BIT)
+      return false;
+
+   uS index_stride = (mesh_header.index_type == MESH_INDEXTYPE_32BIT) ? sizeof(u32) : sizeof(u16);
+   u64 index_size = (u64)mesh_header.index_count * index_stride;
+   u64 vertex_size = (u64)MSH_VertexSize(mesh_header.attributes, mesh_header.attribute_count) * mesh_header.vertex_count;
+
+   // compressed payloads are checked when they get decoded
+   bool is_compressed = (mesh_header.flags & MSH_EBMF_MESH_COMPRESSED);
+   if (!is_compressed && (mesh_header.index_size != index_size || mesh_header.vertex_size != vertex_size))
+      return false;
+
+   u64 lod_size = (u64)mesh_header.lod_count * sizeof(MSH_MeshLodV2);
+   if (chunk.size - sizeof(MSH_MeshHeaderV2) < lod_size)
+      return false;
+
+   if (!MSH_RangeInside(mesh_header.index_offset, mesh_header.index_size, memory.size) || !MSH_RangeInside(mesh_header.vertex_offset, mesh_header.vertex_size, memory.size))
+      return false;
+
+   (*out_header) = mesh_header;
+
+   return true;
+}
+
+static Mesh MSH_DecodeMeshV2(memblob memory, MSH_MeshHeaderV2 mesh_header, bool is_borrowed)
+{
+   Mesh mesh = {
+      .vertex_count = mesh_header.vertex_count,
+      .index_count = mesh_header.index_count,
+      .node_id = mesh_header.node_id,
+      .material_id = (i16)mesh_header.material_id,
+      .primitive = mesh_header.primitive,
+      .index_type = mesh_header.index_type,
+      .attribute_count = mesh_header.attribute_count,
+      .bounds = mesh_header.bounds,
+      .bounding_sphere = VEC4(mesh_header.sphere_center.x, mesh_header.sphere_center.y, mesh_header.sphere_center.z, mesh_header.sphere_radius)
+   };
+
+   memcpy(mesh.attributes, mesh_header.attributes, MESH_MAX_ATTRIBUTES);
+
+   u8* index_data = (u8*)memory.data + mesh_header.index_offset;
+   u8* vertex_data = (u8*)memory.data + mesh_header.vertex_offset;
+
+   if (mesh_header.flags & MSH_EBMF_MESH_COMPRESSED)
+   {
+      // the counts decide how much gets allocated, so they can't be trusted past what the payloads could possibly hold.
+      // the codecs can't do better than 4 bits per index and a byte per 16 vertices of a channel
+      bool is_sized =
+         ((u64)mesh.index_count <= (u64)memory.size * 2) && ((u64)mesh.vertex_count <= (u64)memory.size * 16) &&
+         (mesh.index_count == 0 || mesh_header.index_size >= MSH_IndexStreamMinimum(mesh.index_count)) &&
+         (mesh_header.vertex_size >= MSH_VertexStreamMinimum(mesh.attributes, mesh.attribute_count, mesh.vertex_count));
+
+      if (!is_sized)
+      {
+         Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_ERROR }, "Compressed EBMF mesh claims more than its payloads can hold");
+
+         return (Mesh){ 0 };
+      }
+
+      uS index_size = ((mesh.index_type == MESH_INDEXTYPE_32BIT) ? sizeof(u32) : sizeof(u16)) * (uS)mesh.index_count;
+      uS vertex_size = MSH_VertexSize(mesh.attributes, mesh.attribute_count) * (uS)mesh.vertex_count;
+
+      mesh.index_buffer = (mesh.index_count > 0) ? malloc(index_size) : NULL;
+      mesh.vertex_buffer = malloc(vertex_size);
+
+      bool is_decoded =
+         (mesh.vertex_buffer != NULL) && (mesh.index_count == 0 || mesh.index_buffer != NULL) &&
+         (mesh.index_count == 0 || MSH_DecodeIndexStream(mesh.index_buffer, mesh.index_type, mesh.index_count, index_data, (uS)mesh_header.index_size)) &&
+         MSH_DecodeVertexStream(mesh.vertex_buffer, mesh.attributes, mesh.attribute_count, mesh.vertex_count, vertex_data, (uS)mesh_header.vertex_size);
+
+      if (!is_decoded)
+      {
+         Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_ERROR }, "Failed to decode compressed EBMF mesh");
+         Mesh_Free(&mesh);
+
+         return (Mesh){ 0 };
+      }
+
+      return mesh;
+   }
+
+   // the payloads are aligned in the file, this only fails if the memory itself isn't
+   bool is_aligned = (((uintptr_t)index_data % sizeof(u32)) == 0) && (((uintptr_t)vertex_data % sizeof(f32)) == 0);
+
+   if (is_borrowed && is_aligned)
+   {
+      mesh.index_buffer = (mesh_header.index_count > 0) ? index_data : NULL;
+      mesh.vertex_buffer = vertex_data;
+      mesh.is_borrowed = true;
+
+      return mesh;
+   }
+
+   mesh.index_buffer = (mesh_header.index_count > 0) ? malloc((uS)mesh_header.index_size) : NULL;
+   mesh.vertex_buffer = malloc((uS)mesh_header.vertex_size);
+
+   if (mesh.index_buffer != NULL)
+      memcpy(mesh.index_buffer, index_data, (uS)mesh_header.index_size);
+
+   if (mesh.vertex_buffer != NULL)
+      memcpy(mesh.vertex_buffer, vertex_data, (uS)mesh_header.vertex_size);
+
+   return mesh;
+}
+
+static char* MSH_CopyNodeName(memblob strings, u32 name_offset)
+{
+   uS name_length = 0;
+   if (strings.data != NULL && name_offset < strings.size)
+      name_length = strnlen((char*)strings.data + name_offset, M_MIN(strings.size - name_offset, (uS)EBMF_NODE_NAME_MAX));
+
+   char* name = malloc(name_length + 1);
+   if (name == NULL)
+      return NULL;
+
+   if (name_length > 0)
+      memcpy(name, (char*)strings.data + name_offset, name_length);
+
+   name[name_length] = '\0';
+
+   return name;
+}
+
+// where each mesh sits in the file. the scan fills this in so the meshes can be decoded in any order
+typedef struct MSH_MeshSource_t
+{
+   u64 offset;
+   u64 size;
+   MSH_MeshHeaderV2 header; // v2 only
+   u32 first_lod;
+   u32 lod_count;
+   MSH_ChunkEntry meshlet_chunk; // type is 0 if the mesh has no meshlets
+   MSH_MeshletHeaderV2 meshlet_header;
+   u32 first_meshlet;
+   u32 meshlet_count;
+   bool is_valid;
+
+} MSH_MeshSource;
+
+typedef struct MSH_ModelDecodeJob_t
+{
+   memblob memory;
+   Model* model;
+   const MSH_MeshSource* sources;
+   MeshLoadDesc desc;
+   bool is_borrowed;
+
+} MSH_ModelDecodeJob;
+
+// how many bytes a v1 mesh takes up, without reading any of its data
+static uS MSH_EctorMeshSizeV1(memblob memory)
+{
+   if ((memory.data == NULL) || (memory.size < sizeof(MSH_MeshHeader)))
+      return 0;
+
+   MSH_MeshHeader mesh_header = { 0 };
+   memcpy(&mesh_header, memory.data, sizeof(MSH_MeshHeader));
+
+   uS header_size = sizeof(MSH_MeshHeader) + (uS)mesh_header.attribute_count;
+   if (mesh_header.attribute_count > MESH_MAX_ATTRIBUTES || header_size > memory.size)
+      return 0;
+
+   u8 attributes[MESH_MAX_ATTRIBUTES] = { 0 };
+   memcpy(attributes, (u8*)memory.data + sizeof(MSH_MeshHeader), mesh_header.attribute_count);
+
+   uS index_stride = (mesh_header.vertex_count > UINT16_MAX) ? sizeof(u32) : sizeof(u16);
+   uS mesh_size = header_size + (uS)mesh_header.index_count * index_stride + MSH_VertexSize(attributes, mesh_header.attribute_count) * (uS)mesh_header.vertex_count;
+
+   return (mesh_size <= memory.size) ? mesh_size : 0;
+}
+
+// v1 has no directory, so the nodes and every mesh before the one you want have to be walked over.
+// the nodes only get read if model->nodes is set, and everything after a broken entry is left invalid
+static void MSH_ScanEctorModelV1(memblob memory, Model* model, MSH_MeshSource* sources)
+{
+   u8* read_head = (u8*)memory.data + sizeof(MSH_ModelHeader);
+   u8* file_end = (u8*)memory.data + memory.size;
+
+   for (u32 node_i = 0; node_i < model->node_count; node_i++)
+   {
+      uS name_length = strnlen((char*)read_head, M_MIN((uS)(file_end - read_head), (uS)EBMF_NODE_NAME_MAX));
+      uS node_size = name_length + 1 + sizeof(Transform3D) + 12;
+
+      if (node_size > (uS)(file_end - read_head))
+         return;
+
+      if (model->nodes != NULL)
+      {
+         Node* node = &model->nodes[node_i];
+         void* field_head = read_head + name_length + 1;
+
+         node->name = malloc(name_length + 1);
+         if (node->name != NULL)
+         {
+            memcpy(node->name, read_head, name_length);
+            node->name[name_length] = '\0';
+
+         }
+
+         READ_HEAD(field_head, node->transform, Transform3D);
+         READ_HEAD(field_head, node->child_count, u32);
+         READ_HEAD(field_head, node->parent_id, i16);
+         READ_HEAD(field_head, node->prev_sibling_id, i16);
+         READ_HEAD(field_head, node->next_sibling_id, i16);
+         READ_HEAD(field_head, node->root_child_id, i16);
+
+      }
+
+      read_head += node_size;
+
+   }
+
+   for (u32 mesh_i = 0; mesh_i < model->mesh_count; mesh_i++)
+   {
+      uS mesh_size = MSH_EctorMeshSizeV1((memblob){ read_head, (uS)(file_end - read_head) });
+      if (mesh_size == 0)
+         return;
+
+      sources[mesh_i] = (MSH_MeshSource){
+         .offset = (u64)(read_head - (u8*)memory.data),
+         .size = mesh_size,
+         .is_valid = true
+      };
+
+      read_head += mesh_size;
+
+   }
+
+}
+
+static bool MSH_ReadMeshletHeaderV2(memblob memory, MSH_ChunkEntry chunk, MSH_MeshletHeaderV2* out_header)
+{
+   if (chunk.size < sizeof(MSH_MeshletHeaderV2))
+      return false;
+
+   MSH_MeshletHeaderV2 meshlet_header = { 0 };
+   memcpy(&meshlet_header, (u8*)memory.data + chunk.offset, sizeof(MSH_MeshletHeaderV2));
+
+   u64 data_size = (u64)meshlet_header.meshlet_count * sizeof(MSH_MeshletV2)
+      + (u64)meshlet_header.vertex_count * sizeof(u32)
+      + (u64)meshlet_header.triangle_count * 3;
+
+   if (meshlet_header.meshlet_count == 0 || chunk.size - sizeof(MSH_MeshletHeaderV2) < data_size)
+      return false;
+
+   (*out_header) = meshlet_header;
+
+   return true;
+}
+
+// copies a mesh's meshlets onto the end of the model's table. nothing is kept unless every meshlet stays inside its
+// own arrays and every vertex inside the mesh, so a bad one can't be drawn from later
+static bool MSH_ReadMeshletsV2(memblob memory, const MSH_MeshSource* source, MeshletData* inout_meshlets)
+{
+   MSH_MeshletHeaderV2 meshlet_header = source->meshlet_header;
+   const u8* chunk_data = (const u8*)memory.data + source->meshlet_chunk.offset + sizeof(MSH_MeshletHeaderV2);
+   const u8* vertex_data = chunk_data + (uS)meshlet_header.meshlet_count * sizeof(MSH_MeshletV2);
+   const u8* triangle_data = vertex_data + (uS)meshlet_header.vertex_count * sizeof(u32);
+
+   u32* vertices = inout_meshlets->vertices + inout_meshlets->vertex_count;
+   u8* triangles = inout_meshlets->triangles + (uS)inout_meshlets->triangle_count * 3;
+
+   memcpy(vertices, vertex_data, sizeof(u32) * (uS)meshlet_header.vertex_count);
+   memcpy(triangles, triangle_data, (uS)meshlet_header.triangle_count * 3);
+
+   for (u32 vert_i = 0; vert_i < meshlet_header.vertex_count; vert_i++)
+   {
+      if (vertices[vert_i] >= source->header.vertex_count)
+         return false;
+
+   }
+
+   for (u32 meshlet_i = 0; meshlet_i < meshlet_header.meshlet_count; meshlet_i++)
+   {
+      MSH_MeshletV2 meshlet = { 0 };
+      memcpy(&meshlet, chunk_data + (uS)meshlet_i * sizeof(MSH_MeshletV2), sizeof(MSH_MeshletV2));
+
+      if (meshlet.vertex_count > MESHLET_MAX_VERTICES || meshlet.vertex_offset > meshlet_header.vertex_count || meshlet.vertex_count > meshlet_header.vertex_count - meshlet.vertex_offset)
+         return false;
+
+      if (meshlet.triangle_offset > meshlet_header.triangle_count || meshlet.triangle_count > meshlet_header.triangle_count - meshlet.triangle_offset)
+         return false;
+
+      for (u32 corner_i = 0; corner_i < meshlet.triangle_count * 3; corner_i++)
+      {
+         if (triangles[(uS)meshlet.triangle_offset * 3 + corner_i] >= meshlet.vertex_count)
+            return false;
+
+      }
+
+      inout_meshlets->meshlets[inout_meshlets->meshlet_count + meshlet_i] = (Meshlet){
+         .vertex_offset = inout_meshlets->vertex_count + meshlet.vertex_offset,
+         .triangle_offset = inout_meshlets->triangle_count + meshlet.triangle_offset,
+         .vertex_count = meshlet.vertex_count,
+         .triangle_count = meshlet.triangle_count,
+         .bounding_sphere = meshlet.bounding_sphere,
+         .cone_apex = meshlet.cone_apex,
+         .cone_axis = meshlet.cone_axis,
+         .cone_cutoff = meshlet.cone_cutoff
+      };
+
+   }
+
+   inout_meshlets->meshlet_count += meshlet_header.meshlet_count;
+   inout_meshlets->vertex_count += meshlet_header.vertex_count;
+   inout_meshlets->triangle_count += meshlet_header.triangle_count;
+
+   return true;
+}
+
+static void MSH_ScanEctorModelV2(memblob memory, MSH_ModelHeaderV2 header, Model* model, MSH_MeshSource* sources)
+{
+   // names have to be known before the nodes, and the lods all go in one table, so count them up front
+   memblob strings = { 0 };
+   u32 lod_count = 0;
+
+   for (u32 chunk_i = 0; chunk_i < header.chunk_count; chunk_i++)
+   {
+      MSH_ChunkEntry chunk = MSH_GetChunkEntry(memory, header, chunk_i);
+      MSH_MeshHeaderV2 mesh_header = { 0 };
+
+      if (chunk.type == MSH_EBMF_CHUNK_STRINGS)
+         strings = (memblob){ (u8*)memory.data + chunk.offset, (uS)chunk.size };
+
+      // a mesh listed twice keeps the first one
+      if (chunk.type != MSH_EBMF_CHUNK_MESH || chunk.index >= model->mesh_count || sources[chunk.index].is_valid || !MSH_ReadMeshHeaderV2(memory, chunk, &mesh_header))
+         continue;
+
+      sources[chunk.index] = (MSH_MeshSource){
+         .offset = chunk.offset,
+         .size = chunk.size,
+         .header = mesh_header,
+         .is_valid = true
+      };
+
+      lod_count += mesh_header.lod_count;
+
+   }
+
+   // meshlets are matched up to their meshes once every mesh has been found, whatever order the directory is in
+   MeshletData meshlet_totals = { 0 };
+
+   for (u32 chunk_i = 0; chunk_i < header.chunk_count; chunk_i++)
+   {
+      MSH_ChunkEntry chunk = MSH_GetChunkEntry(memory, header, chunk_i);
+      MSH_MeshletHeaderV2 meshlet_header = { 0 };
+
+      if (chunk.type != MSH_EBMF_CHUNK_MESHLETS || chunk.index >= model->mesh_count)
+         continue;
+
+      MSH_MeshSource* source = &sources[chunk.index];
+      if (!source->is_valid || source->meshlet_chunk.type != 0 || !MSH_ReadMeshletHeaderV2(memory, chunk, &meshlet_header))
+         continue;
+
+      source->meshlet_chunk = chunk;
+      source->meshlet_header = meshlet_header;
+
+      meshlet_totals.meshlet_count += meshlet_header.meshlet_count;
+      meshlet_totals.vertex_count += meshlet_header.vertex_count;
+      meshlet_totals.triangle_count += meshlet_header.triangle_count;
+
+   }
+
+   for (u32 chunk_i = 0; chunk_i < header.chunk_count && model->nodes != NULL; chunk_i++)
+   {
+      MSH_ChunkEntry chunk = MSH_GetChunkEntry(memory, header, chunk_i);
+      if (chunk.type != MSH_EBMF_CHUNK_NODES)
+         continue;
+
+      u32 node_count = M_MIN(model->node_count, (u32)(chunk.size / sizeof(MSH_NodeV2)));
+
+      for (u32 node_i = 0; node_i < node_count; node_i++)
+      {
+         MSH_NodeV2 node = { 0 };
+         memcpy(&node, (u8*)memory.data + chunk.offset + (u64)node_i * sizeof(MSH_NodeV2), sizeof(MSH_NodeV2));
+
+         model->nodes[node_i] = (Node){
+            .name = MSH_CopyNodeName(strings, node.name_offset),
+            .transform = node.transform,
+            .child_count = node.child_count,
+            .parent_id = node.parent_id,
+            .prev_sibling_id = node.prev_sibling_id,
+            .next_sibling_id = node.next_sibling_id,
+            .root_child_id = node.root_child_id
+         };
+
+      }
+
+      break;
+   }
+
+   if (meshlet_totals.meshlet_count > 0)
+   {
+      model->meshlets.meshlets = malloc(sizeof(Meshlet) * (uS)meshlet_totals.meshlet_count);
+      model->meshlets.vertices = malloc(sizeof(u32) * (uS)M_MAX(meshlet_totals.vertex_count, 1u));
+      model->meshlets.triangles = malloc((uS)M_MAX(meshlet_totals.triangle_count, 1u) * 3);
+
+      if (model->meshlets.meshlets == NULL || model->meshlets.vertices == NULL || model->meshlets.triangles == NULL)
+         Mesh_FreeMeshlets(&model->meshlets);
+
+   }
+
+   for (u32 mesh_i = 0; mesh_i < model->mesh_count && model->meshlets.meshlets != NULL; mesh_i++)
+   {
+      MSH_MeshSource* source = &sources[mesh_i];
+      if (source->meshlet_chunk.type == 0)
+         continue;
+
+      // a bad chunk leaves the counts where they were, the next mesh just writes over what it copied
+      MeshletData before = model->meshlets;
+      if (!MSH_ReadMeshletsV2(memory, source, &model->meshlets))
+      {
+         model->meshlets = before;
+         continue;
+      }
+
+      source->first_meshlet = before.meshlet_count;
+      source->meshlet_count = model->meshlets.meshlet_count - before.meshlet_count;
+
+   }
+
+   model->lods = (lod_count > 0) ? malloc(sizeof(MeshLod) * (uS)lod_count) : NULL;
+   if (model->lods == NULL)
+      return;
+
+   for (u32 mesh_i = 0; mesh_i < model->mesh_count; mesh_i++)
+   {
+      MSH_MeshSource* source = &sources[mesh_i];
+      if (!source->is_valid)
+         continue;
+
+      source->first_lod = model->lod_count;
+
+      for (u32 lod_i = 0; lod_i < source->header.lod_count; lod_i++)
+      {
+         MSH_MeshLodV2 lod = { 0 };
+         memcpy(&lod, (u8*)memory.data + source->offset + sizeof(MSH_MeshHeaderV2) + (u64)lod_i * sizeof(MSH_MeshLodV2), sizeof(MSH_MeshLodV2));
+
+         // lods outside the mesh's own indices are dropped
+         u32 index_count = source->header.index_count;
+         if (lod.first_index > index_count || lod.index_count > index_count - lod.first_index)
+            continue;
+
+         model->lods[model->lod_count++] = (MeshLod){ lod.first_index, lod.index_count, lod.error };
+         source->lod_count++;
+
+      }
+
+   }
+
+}
+
+static bool MSH_ConvertIndexType(Mesh* mesh, u8 index_type)
+{
+   if (mesh->index_type == index_type || mesh->index_buffer == NULL)
+      return true;
+
+   // the old buffer gets freed below, so it can't be pointing into a mapping
+   if (!Mesh_MakeOwned(mesh))
+      return false;
+
+   uS index_stride = (index_type == MESH_INDEXTYPE_32BIT) ? sizeof(u32) : sizeof(u16);
+   void* index_buffer = malloc(index_stride * (uS)mesh->index_count);
+   if (index_buffer == NULL)
+      return false;
+
+   Mesh old_mesh = (*mesh);
+   mesh->index_buffer = index_buffer;
+   mesh->index_type = index_type;
+
+   for (u32 index_i = 0; index_i < mesh->index_count; index_i++)
+      Mesh_SetIndexInBuffer(mesh, index_i, Mesh_GetIndexFromBuffer(old_mesh, index_i));
+
+   free(old_mesh.index_buffer);
+
+   return true;
+}
+
+// tangents can only be made for meshes laid out the way the procedural functions lay them out: position, normal,
+// texcoord, an optional second texcoord and an optional tangent that gets overwritten
+static void MSH_GenLoadedTangents(Mesh* mesh)
+{
+   const u8* attributes = mesh->attributes;
+   if (mesh->attribute_count < 3 || attributes[0] != MESH_ATTRIBUTE_3_CHANNEL || attributes[1] != MESH_ATTRIBUTE_3_CHANNEL || attributes[2] != MESH_ATTRIBUTE_2_CHANNEL)
+      return;
+
+   u8 attribute_i = 3;
+   bool has_texcoord1 = (attribute_i < mesh->attribute_count && attributes[attribute_i] == MESH_ATTRIBUTE_2_CHANNEL);
+   attribute_i += (u8)has_texcoord1;
+
+   bool has_tangent = (attribute_i < mesh->attribute_count && attributes[attribute_i] == MESH_ATTRIBUTE_4_CHANNEL);
+   attribute_i += (u8)has_tangent;
+
+   if (attribute_i != mesh->attribute_count)
+      return;
+
+   uS vertex_count = (uS)mesh->vertex_count;
+
+   MeshInterface mesh_interface = Mesh_NewInterface(mesh);
+   mesh_interface.atr.position_size = sizeof(vec3) * vertex_count;
+   mesh_interface.atr.normal_ofs = mesh_interface.atr.position_size;
+   mesh_interface.atr.normal_size = sizeof(vec3) * vertex_count;
+   mesh_interface.atr.texcoord_ofs[0] = mesh_interface.atr.normal_ofs + mesh_interface.atr.normal_size;
+   mesh_interface.atr.texcoord_size[0] = sizeof(vec2) * vertex_count;
+   mesh_interface.atr.texcoord_ofs[1] = mesh_interface.atr.texcoord_ofs[0] + mesh_interface.atr.texcoord_size[0];
+   mesh_interface.atr.texcoord_size[1] = (has_texcoord1) ? sizeof(vec2) * vertex_count : 0;
+   mesh_interface.atr.tangent_ofs = mesh_interface.atr.texcoord_ofs[1] + mesh_interface.atr.texcoord_size[1];
+   mesh_interface.atr.tangent_size = (has_tangent) ? sizeof(vec4) * vertex_count : 0;
+   mesh_interface.total_bytes = mesh_interface.atr.tangent_ofs + mesh_interface.atr.tangent_size;
+
+   // already on a worker, so the tangents themselves run serially
+   mesh_interface = Mesh_GenTangentsParallel(mesh_interface, NULL);
+
+   if (mesh_interface.atr.tangent_size != 0 && !has_tangent)
+      mesh->attributes[mesh->attribute_count++] = MESH_ATTRIBUTE_4_CHANNEL;
+
+}
+
+static void MSH_PostProcessMesh(Mesh* mesh, MeshLoadDesc desc, bool needs_bounds)
+{
+   if (mesh->vertex_buffer == NULL)
+      return;
+
+   if (desc.narrow_indices && mesh->vertex_count <= (u32)UINT16_MAX + 1)
+      MSH_ConvertIndexType(mesh, MESH_INDEXTYPE_16BIT);
+   else if (desc.widen_indices)
+      MSH_ConvertIndexType(mesh, MESH_INDEXTYPE_32BIT);
+
+   if (desc.generate_tangents)
+      MSH_GenLoadedTangents(mesh);
+
+   if (needs_bounds || desc.calculate_bounds)
+      Mesh_CalculateBounds(mesh);
+
+}
+
+static void MSH_DecodeModelMeshes(void* user_data, u32 start, u32 end, u32 worker_id)
+{
+   MSH_ModelDecodeJob* job = user_data;
+   Model* model = job->model;
+
+   for (u32 mesh_i = start; mesh_i < end; mesh_i++)
+   {
+      MSH_MeshSource source = job->sources[mesh_i];
+      if (!source.is_valid)
+         continue;
+
+      Mesh mesh = { 0 };
+      memblob mesh_memory = { (u8*)job->memory.data + source.offset, (uS)source.size };
+
+      if (model->version == EBMF_VERSION_1)
+      {
+         mesh = MSH_ParseEctorMesh(mesh_memory, NULL, job->is_borrowed);
+
+      } else {
+         mesh = MSH_DecodeMeshV2(job->memory, source.header, job->is_borrowed);
+         mesh.first_lod = source.first_lod;
+         mesh.lod_count = source.lod_count;
+         mesh.first_meshlet = source.first_meshlet;
+         mesh.meshlet_count = source.meshlet_count;
+
+      }
+
+      // v1 doesn't store any bounds
+      MSH_PostProcessMesh(&mesh, job->desc, (model->version == EBMF_VERSION_1));
+
+      // every mesh has its own slot, nothing else gets written from here
+      model->meshes[mesh_i] = mesh;
+
+   }
+
+}
+
+Model MSH_ParseEctorModel(memblob memory, MeshLoadDesc desc, bool is_borrowed, JobPool* jobs)
+{
+   u16 version = 0;
+   if (!MSH_PeekModelVersion(memory, &version))
+      return (Model){ 0 };
+
+   MSH_ModelHeaderV2 header = { 0 };
+
+   switch (version)
+   {
+      case EBMF_VERSION_1:
+         memcpy(&header.base, memory.data, sizeof(MSH_ModelHeader));
+         break;
+
+      case EBMF_VERSION_2:
+         if (!MSH_ReadModelHeaderV2(memory, &header))
+            return (Model){ 0 };
+
+         break;
+
+      default:
+         Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_ERROR }, "Unsupported EBMF version %u", (u32)version);
+
+         return (Model){ 0 };
+   }
+
+   if (header.base.mesh_count == 0)
+      return (Model){ 0 };
+
+   Model model = {
+      .version = header.base.version,
+      .root_bone_id = header.base.root_bone_id,
+      .node_count = header.base.node_count,
+      .mesh_count = header.base.mesh_count,
+      .material_count = header.base.material_count
+   };
+
+   model.meshes = calloc((uS)model.mesh_count, sizeof(Mesh));
+   model.nodes = (model.node_count > 0) ? calloc((uS)model.node_count, sizeof(Node)) : NULL;
+   model.materials = (model.material_count > 0) ? calloc((uS)model.material_count, sizeof(Material)) : NULL;
+
+   MSH_MeshSource* sources = calloc((uS)model.mesh_count, sizeof(MSH_MeshSource));
+
+   if (model.meshes == NULL || sources == NULL)
+   {
+      free(sources);
+      Model_Free(&model);
+
+      return (Model){ 0 };
+   }
+
+   // first pass is serial and only touches headers, the second one does all the copying and decoding
+   if (version == EBMF_VERSION_1)
+      MSH_ScanEctorModelV1(memory, &model, sources);
+   else
+      MSH_ScanEctorModelV2(memory, header, &model, sources);
+
+   MSH_ModelDecodeJob job = {
+      .memory = memory,
+      .model = &model,
+      .sources = sources,
+      .desc = desc,
+      .is_borrowed = is_borrowed
+   };
+
+   Util_ParallelFor(jobs, model.mesh_count, 1, MSH_DecodeModelMeshes, &job);
+   free(sources);
+
+   return model;
+}
+
+Mesh Mesh_LoadEctorModelMesh(memblob memory, u32 mesh_index)
+{
+   u16 version = 0;
+   if (!MSH_PeekModelVersion(memory, &version))
+      return (Mesh){ 0 };
+
+   if (version == EBMF_VERSION_1)
+   {
+      MSH_ModelHeader model_header = { 0 };
+      memcpy(&model_header, memory.data, sizeof(MSH_ModelHeader));
+
+      if (mesh_index >= model_header.mesh_count)
+         return (Mesh){ 0 };
+
+      // only walks the nodes, nothing gets read out of them
+      Model model = { .node_count = model_header.node_count, .mesh_count = mesh_index + 1 };
+      MSH_MeshSource* sources = calloc((uS)model.mesh_count, sizeof(MSH_MeshSource));
+      if (sources == NULL)
+         return (Mesh){ 0 };
+
+      MSH_ScanEctorModelV1(memory, &model, sources);
+      MSH_MeshSource source = sources[mesh_index];
+      free(sources);
+
+      if (!source.is_valid)
+         return (Mesh){ 0 };
+
+      Mesh mesh = MSH_ParseEctorMesh((memblob){ (u8*)memory.data + source.offset, (uS)source.size }, NULL, false);
+      Mesh_CalculateBounds(&mesh);
+
+      return mesh;
+   }
+
+   MSH_ModelHeaderV2 header = { 0 };
+   if (!MSH_ReadModelHeaderV2(memory, &header) || mesh_index >= header.base.mesh_count)
+      return (Mesh){ 0 };
+
+   for (u32 chunk_i = 0; chunk_i < header.chunk_count; chunk_i++)
+   {
+      MSH_ChunkEntry chunk = MSH_GetChunkEntry(memory, header, chunk_i);
+      if (chunk.type != MSH_EBMF_CHUNK_MESH || chunk.index != mesh_index)
+         continue;
+
+      // the lods live in the model's table, there's nowhere to put them here
+      MSH_MeshHeaderV2 mesh_header = { 0 };
+      if (MSH_ReadMeshHeaderV2(memory, chunk, &mesh_header))
+         return MSH_DecodeMeshV2(memory, mesh_header, false);
+
+      break;
+   }
+
+   return (Mesh){ 0 };
+}
+
+// whether the mesh's range of the model's meshlet table is there to be written
+static bool MSH_HasMeshlets(Model model, Mesh mesh)
+{
+   return (model.meshlets.meshlets != NULL && mesh.meshlet_count > 0 && mesh.first_meshlet <= model.meshlets.meshlet_count && mesh.meshlet_count <= model.meshlets.meshlet_count - mesh.first_meshlet);
+}
+
+// the span of the shared vertex and triangle arrays a mesh's meshlets use, they get stored relative to its start
+static MSH_MeshletHeaderV2 MSH_MeshletSpan(Model model, Mesh mesh, u32* out_vertex_base, u32* out_triangle_base)
+{
+   const Meshlet* meshlets = &model.meshlets.meshlets[mesh.first_meshlet];
+   u32 vertex_base = UINT32_MAX, vertex_end = 0;
+   u32 triangle_base = UINT32_MAX, triangle_end = 0;
+
+   for (u32 meshlet_i = 0; meshlet_i < mesh.meshlet_count; meshlet_i++)
+   {
+      vertex_base = M_MIN(vertex_base, meshlets[meshlet_i].vertex_offset);
+      vertex_end = M_MAX(vertex_end, meshlets[meshlet_i].vertex_offset + meshlets[meshlet_i].vertex_count);
+      triangle_base = M_MIN(triangle_base, meshlets[meshlet_i].triangle_offset);
+      triangle_end = M_MAX(triangle_end, meshlets[meshlet_i].triangle_offset + meshlets[meshlet_i].triangle_count);
+
+   }
+
+   (*out_vertex_base) = vertex_base;
+   (*out_triangle_base) = triangle_base;
+
+   return (MSH_MeshletHeaderV2){ mesh.meshlet_count, vertex_end - vertex_base, triangle_end - triangle_base, 0 };
+}
+
+static u64 MSH_MeshletChunkSize(MSH_MeshletHeaderV2 meshlet_header)
+{
+   return sizeof(MSH_MeshletHeaderV2)
+      + (u64)meshlet_header.meshlet_count * sizeof(MSH_MeshletV2)
+      + (u64)meshlet_header.vertex_count * sizeof(u32)
+      + (u64)meshlet_header.triangle_count * 3;
+}
+
+static void MSH_WriteMeshletChunk(u8* chunk_data, Model model, Mesh mesh)
+{
+   u32 vertex_base = 0;
+   u32 triangle_base = 0;
+   MSH_MeshletHeaderV2 meshlet_header = MSH_MeshletSpan(model, mesh, &vertex_base, &triangle_base);
+
+   memcpy(chunk_data, &meshlet_header, sizeof(MSH_MeshletHeaderV2));
+   chunk_data += sizeof(MSH_MeshletHeaderV2);
+
+   for (u32 meshlet_i = 0; meshlet_i < mesh.meshlet_count; meshlet_i++)
+   {
+      Meshlet meshlet = model.meshlets.meshlets[mesh.first_meshlet + meshlet_i];
+      MSH_MeshletV2 meshlet_v2 = {
+         .vertex_offset = meshlet.vertex_offset - vertex_base,
+         .triangle_offset = meshlet.triangle_offset - triangle_base,
+         .vertex_count = meshlet.vertex_count,
+         .triangle_count = meshlet.triangle_count,
+         .bounding_sphere = meshlet.bounding_sphere,
+         .cone_apex = meshlet.cone_apex,
+         .cone_axis = meshlet.cone_axis,
+         .cone_cutoff = meshlet.cone_cutoff
+      };
+
+      memcpy(chunk_data, &meshlet_v2, sizeof(MSH_MeshletV2));
+      chunk_data += sizeof(MSH_MeshletV2);
+
+   }
+
+   memcpy(chunk_data, model.meshlets.vertices + vertex_base, sizeof(u32) * (uS)meshlet_header.vertex_count);
+   chunk_data += sizeof(u32) * (uS)meshlet_header.vertex_count;
+
+   memcpy(chunk_data, model.meshlets.triangles + (uS)triangle_base * 3, (uS)meshlet_header.triangle_count * 3);
+
+}
+
+static void MSH_FreeEncodedPayloads(u8** payloads, u32 mesh_count, bool is_compressed)
+{
+   if (payloads != NULL && is_compressed)
+   {
+      for (u32 payload_i = 0; payload_i < mesh_count * 2; payload_i++)
+         free(payloads[payload_i]);
+
+   }
+
+   free(payloads);
+
+}
+
+memblob Mesh_WriteEctorModel(Model model, bool compress_streams)
+{
+   if (model.meshes == NULL || model.mesh_count == 0)
+      return (memblob){ 0 };
+
+   // the reader won't take these, and dropping them would shift the index of every mesh after them
+   for (u32 mesh_i = 0; mesh_i < model.mesh_count; mesh_i++)
+   {
+      Mesh mesh = model.meshes[mesh_i];
+      if (mesh.vertex_buffer == NULL || mesh.vertex_count == 0 || mesh.attribute_count == 0 || mesh.attribute_count > MESH_MAX_ATTRIBUTES)
+      {
+         Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_ERROR }, "Can't write EBMF, mesh %u has no vertices", mesh_i);
+
+         return (memblob){ 0 };
+      }
+
+   }
+
+   bool has_nodes = (model.nodes != NULL && model.node_count > 0);
+   u32 chunk_count = model.mesh_count + ((has_nodes) ? 2 : 0);
+
+   for (u32 mesh_i = 0; mesh_i < model.mesh_count; mesh_i++)
+      chunk_count += (MSH_HasMeshlets(model, model.meshes[mesh_i])) ? 1 : 0;
+
+   MSH_ChunkEntry* chunks = calloc((uS)chunk_count, sizeof(MSH_ChunkEntry));
+   MSH_MeshHeaderV2* mesh_headers = calloc((uS)model.mesh_count, sizeof(MSH_MeshHeaderV2));
+
+   // index then vertex data for every mesh, either the mesh's own buffers or what the codecs turned them into
+   u8** payloads = calloc((uS)model.mesh_count * 2, sizeof(u8*));
+
+   if (chunks == NULL || mesh_headers == NULL || payloads == NULL)
+   {
+      free(chunks);
+      free(mesh_headers);
+      free(payloads);
+
+      return (memblob){ 0 };
+   }
+
+   // first pass only works out where everything goes
+   u64 write_ofs = MSH_AlignOffset(sizeof(MSH_ModelHeaderV2));
+   u32 chunk_i = 0;
+   u64 strings_size = 0;
+
+   if (has_nodes)
+   {
+      for (u32 node_i = 0; node_i < model.node_count; node_i++)
+      {
+         const char* name = model.nodes[node_i].name;
+         strings_size += ((name != NULL) ? strnlen(name, EBMF_NODE_NAME_MAX - 1) : 0) + 1;
+
+      }
+
+      chunks[chunk_i++] = (MSH_ChunkEntry){ MSH_EBMF_CHUNK_NODES, 0, write_ofs, (u64)model.node_count * sizeof(MSH_NodeV2) };
+      write_ofs = MSH_AlignOffset(write_ofs + chunks[chunk_i - 1].size);
+
+      chunks[chunk_i++] = (MSH_ChunkEntry){ MSH_EBMF_CHUNK_STRINGS, 0, write_ofs, strings_size };
+      write_ofs = MSH_AlignOffset(write_ofs + strings_size);
+
+   }
+
+   for (u32 mesh_i = 0; mesh_i < model.mesh_count; mesh_i++)
+   {
+      Mesh mesh = model.meshes[mesh_i];
+      Mesh_CalculateBounds(&mesh);
+
+      bool has_lods = (model.lods != NULL && mesh.first_lod <= model.lod_count && mesh.lod_count <= model.lod_count - mesh.first_lod);
+      u32 index_count = (mesh.index_buffer != NULL) ? mesh.index_count : 0;
+      uS index_stride = (mesh.index_type == MESH_INDEXTYPE_32BIT) ? sizeof(u32) : sizeof(u16);
+
+      MSH_MeshHeaderV2 mesh_header = {
+         .index_count = index_count,
+         .vertex_count = (mesh.vertex_buffer != NULL) ? mesh.vertex_count : 0,
+         .node_id = mesh.node_id,
+         .material_id = (u16)mesh.material_id,
+         .primitive = mesh.primitive,
+         .attribute_count = mesh.attribute_count,
+         .index_type = mesh.index_type,
+         .lod_count = (has_lods) ? (u8)M_MIN(mesh.lod_count, (u32)UINT8_MAX) : 0,
+         .bounds = mesh.bounds,
+         .sphere_center = mesh.bounding_sphere.xyz,
+         .sphere_radius = mesh.bounding_sphere.w
+      };
+
+      memcpy(mesh_header.attributes, mesh.attributes, MESH_MAX_ATTRIBUTES);
+
+      u64 chunk_ofs = write_ofs;
+      write_ofs = MSH_AlignOffset(write_ofs + sizeof(MSH_MeshHeaderV2) + (u64)mesh_header.lod_count * sizeof(MSH_MeshLodV2));
+
+      mesh_header.index_size = (u64)index_count * index_stride;
+      mesh_header.vertex_size = (u64)MSH_VertexSize(mesh.attributes, mesh.attribute_count) * mesh_header.vertex_count;
+
+      u8** index_payload = &payloads[mesh_i * 2];
+      u8** vertex_payload = &payloads[mesh_i * 2 + 1];
+
+      if (compress_streams && mesh_header.vertex_count > 0)
+      {
+         uS index_bound = MSH_IndexStreamBound(index_count);
+         uS vertex_bound = MSH_VertexStreamBound(mesh.attributes, mesh.attribute_count, mesh_header.vertex_count);
+
+         (*index_payload) = (index_count > 0) ? malloc(index_bound) : NULL;
+         (*vertex_payload) = malloc(vertex_bound);
+
+         mesh_header.index_size = (index_count > 0) ? MSH_EncodeIndexStream(*index_payload, index_bound, mesh.index_buffer, mesh.index_type, index_count) : 0;
+         mesh_header.vertex_size = MSH_EncodeVertexStream(*vertex_payload, vertex_bound, mesh.vertex_buffer, mesh.attributes, mesh.attribute_count, mesh_header.vertex_count);
+         mesh_header.flags |= MSH_EBMF_MESH_COMPRESSED;
+
+         if ((index_count > 0 && mesh_header.index_size == 0) || mesh_header.vertex_size == 0)
+         {
+            free(chunks);
+            free(mesh_headers);
+            MSH_FreeEncodedPayloads(payloads, model.mesh_count, compress_streams);
+
+            return (memblob){ 0 };
+         }
+
+      } else if (!compress_streams) {
+         (*index_payload) = mesh.index_buffer;
+         (*vertex_payload) = mesh.vertex_buffer;
+
+      }
+
+      mesh_header.index_offset = write_ofs;
+      write_ofs = MSH_AlignOffset(write_ofs + mesh_header.index_size);
+
+      mesh_header.vertex_offset = write_ofs;
+      write_ofs = MSH_AlignOffset(write_ofs + mesh_header.vertex_size);
+
+      mesh_headers[mesh_i] = mesh_header;
+      chunks[chunk_i++] = (MSH_ChunkEntry){ MSH_EBMF_CHUNK_MESH, mesh_i, chunk_ofs, write_ofs - chunk_ofs };
+
+      // meshlets go right after their mesh
+      if (MSH_HasMeshlets(model, mesh))
+      {
+         u32 vertex_base = 0;
+         u32 triangle_base = 0;
+         u64 meshlet_size = MSH_MeshletChunkSize(MSH_MeshletSpan(model, mesh, &vertex_base, &triangle_base));
+
+         chunks[chunk_i++] = (MSH_ChunkEntry){ MSH_EBMF_CHUNK_MESHLETS, mesh_i, write_ofs, meshlet_size };
+         write_ofs = MSH_AlignOffset(write_ofs + meshlet_size);
+
+      }
+
+   }
+
+   u64 directory_offset = write_ofs;
+   uS total_size = (uS)(directory_offset + (u64)chunk_count * sizeof(MSH_ChunkEntry));
+
+   u8* data = calloc(total_size, 1);
+   if (data == NULL)
+   {
+      free(chunks);
+      free(mesh_headers);
+      MSH_FreeEncodedPayloads(payloads, model.mesh_count, compress_streams);
+
+      return (memblob){ 0 };
+   }
+
+   MSH_ModelHeaderV2 header = {
+      .base = {
+         .identifier.magic = MODEL_MAGIC_ID,
+         .version = EBMF_VERSION_2,
+         .root_bone_id = model.root_bone_id,
+         .node_count = (has_nodes) ? model.node_count : 0,
+         .mesh_count = model.mesh_count,
+         .material_count = model.material_count
+      },
+      .chunk_count = chunk_count,
+      .directory_offset = directory_offset
+   };
+
+   memcpy(data, &header, sizeof(MSH_ModelHeaderV2));
+   memcpy(data + directory_offset, chunks, (uS)chunk_count * sizeof(MSH_ChunkEntry));
+
+   if (has_nodes)
+   {
+      u8* node_data = data + chunks[0].offset;
+      char* string_data = (char*)data + chunks[1].offset;
+      u32 name_offset = 0;
+
+      for (u32 node_i = 0; node_i < model.node_count; node_i++)
+      {
+         Node node = model.nodes[node_i];
+         uS name_length = (node.name != NULL) ? strnlen(node.name, EBMF_NODE_NAME_MAX - 1) : 0;
+
+         MSH_NodeV2 node_v2 = {
+            .name_offset = name_offset,
+            .child_count = node.child_count,
+            .transform = node.transform,
+            .parent_id = node.parent_id,
+            .prev_sibling_id = node.prev_sibling_id,
+            .next_sibling_id = node.next_sibling_id,
+            .root_child_id = node.root_child_id
+         };
+
+         memcpy(node_data + (uS)node_i * sizeof(MSH_NodeV2), &node_v2, sizeof(MSH_NodeV2));
+
+         if (name_length > 0)
+            memcpy(string_data + name_offset, node.name, name_length);
+
+         name_offset += (u32)name_length + 1;
+
+      }
+
+   }
+
+   for (u32 entry_i = 0; entry_i < chunk_count; entry_i++)
+   {
+      MSH_ChunkEntry chunk = chunks[entry_i];
+      if (chunk.type != MSH_EBMF_CHUNK_MESH && chunk.type != MSH_EBMF_CHUNK_MESHLETS)
+         continue;
+
+      u32 mesh_i = chunk.index;
+      Mesh mesh = model.meshes[mesh_i];
+      u8* chunk_data = data + chunk.offset;
+
+      if (chunk.type == MSH_EBMF_CHUNK_MESHLETS)
+      {
+         MSH_WriteMeshletChunk(chunk_data, model, mesh);
+         continue;
+      }
+
+      MSH_MeshHeaderV2 mesh_header = mesh_headers[mesh_i];
+      memcpy(chunk_data, &mesh_header, sizeof(MSH_MeshHeaderV2));
+
+      for (u32 lod_i = 0; lod_i < mesh_header.lod_count; lod_i++)
+      {
+         MeshLod lod = model.lods[mesh.first_lod + lod_i];
+         MSH_MeshLodV2 lod_v2 = { lod.first_index, lod.index_count, lod.error, 0 };
+
+         memcpy(chunk_data + sizeof(MSH_MeshHeaderV2) + (uS)lod_i * sizeof(MSH_MeshLodV2), &lod_v2, sizeof(MSH_MeshLodV2));
+
+      }
+
+      if (mesh_header.index_size > 0)
+         memcpy(data + mesh_header.index_offset, payloads[mesh_i * 2], (uS)mesh_header.index_size);
+
+      if (mesh_header.vertex_size > 0)
+         memcpy(data + mesh_header.vertex_offset, payloads[mesh_i * 2 + 1], (uS)mesh_header.vertex_size);
+
+   }
+
+   free(chunks);
+   free(mesh_headers);
+   MSH_FreeEncodedPayloads(payloads, model.mesh_count, compress_streams);
+
+   return (memblob){ data, total_size };
+}
@@ -11,11 +11,16 @@
 // "EBMF" in hex
 #define MODEL_MAGIC_ID 0x464D4245
 
-// EBMF version
-#define EBMF_VERSION 0x0001
+// EBMF versions, the reader takes either one and the writer always writes the newest
+#define EBMF_VERSION_1 0x0001
+#define EBMF_VERSION_2 0x0002
+#define EBMF_VERSION EBMF_VERSION_2
 
 #define EBMF_NODE_NAME_MAX 128
 
+// every v2 chunk and payload starts on this, relative to the start of the file
+#define EBMF_ALIGNMENT 16
+
 typedef enum MSH_MatTokenType_t
 {
    MSH_MATTOK_INVALID = 0,
@@ -23,7 +28,7 @@ typedef enum MSH_MatTokenType_t
    MSH_MATTOK_END_LINE,
    MSH_MATTOK_START,
    MSH_MATTOK_STOP,
-   MSH_MATTOK_COMMENT
+   MSH_MATTOK_END_FILE
 
 } MSH_MatTokenType;
 
@@ -31,10 +36,63 @@ typedef struct MSH_MatToken_t
 {
    MSH_MatTokenType token_type;
    u32 token_size;
-   char* token_start;
+   const char* token_start;
 
 } MSH_MatToken;
 
+// "EMTB" in hex
+#define MATERIAL_CACHE_MAGIC_ID 0x42544D45
+#define MATERIAL_CACHE_VERSION 0x0001
+// string offset for a string that isn't set
+#define MATERIAL_CACHE_NO_STRING UINT32_MAX
+
+// .matb layout: this header, then material_count records, then parameter_count parameters, then string_size bytes of
+// NUL terminated strings that the records point at by offset. material slots without a name are left empty.
+typedef struct MSH_MaterialCacheHeader_t
+{
+   union {
+      u8 string[4];
+      u32 magic;
+   } identifier; // must equal "EMTB"
+
+   u16 version;
+   u16 reserved;
+   u32 material_count;
+   u32 parameter_count;
+   u32 string_size;
+   u32 padding;
+   u64 source_size;
+   u64 source_hash; // of the .mat text the cache was compiled from
+
+} MSH_MaterialCacheHeader;
+
+typedef struct MSH_MaterialRecord_t
+{
+   u32 name_offset;
+   u32 surface_name_offset;
+   u32 texture_offsets[MATERIAL_MAX_TEXTURES];
+   u32 id;
+   u32 first_parameter;
+   u32 parameter_count;
+   u32 reserved;
+
+} MSH_MaterialRecord;
+
+typedef struct MSH_MaterialParamRecord_t
+{
+   u32 key_offset;
+   u32 slot;
+   u32 count;
+   u32 type;
+
+   union {
+      f32 as_f32[4];
+      i32 as_i32[4];
+
+   } value;
+
+} MSH_MaterialParamRecord;
+
 // Header for the Ector Binary Model Format
 typedef struct MSH_ModelHeader_t
 {
@@ -62,18 +120,181 @@ typedef struct MSH_MeshHeader_t
 
 } MSH_MeshHeader;
 
-static inline char* MSH_CopyTokenString(MSH_MatToken token)
+/*
+   EBMF v2 layout:
+
+   MSH_ModelHeaderV2           version 2, and where the directory is
+   ...chunks...                each one 16 byte aligned
+   MSH_ChunkEntry[chunk_count] the directory, at directory_offset
+
+   chunks:
+   - NODES    node_count MSH_NodeV2, fixed size so any node can be looked up directly
+   - STRINGS  null terminated node names, MSH_NodeV2.name_offset is relative to the start of this chunk
+   - MESH     one per mesh, index is the mesh's number. a MSH_MeshHeaderV2 followed by lod_count MSH_MeshLodV2,
+              then the index and vertex payloads. the payload offsets are from the start of the file and 16 byte aligned,
+              so they can be mapped and handed to the gpu as is. meshes flagged MSH_EBMF_MESH_COMPRESSED store
+              encoded payloads instead, which always get decoded into their own buffers.
+   - MESHLETS optional, index is the mesh it belongs to. a MSH_MeshletHeaderV2, then meshlet_count MSH_MeshletV2,
+              vertex_count u32 vertex indices and triangle_count * 3 bytes of triangles. offsets are relative to the mesh's own
+              meshlets, not the model's.
+
+   everything is little endian and laid out the way the structs below are. unknown chunk types are skipped.
+*/
+
+enum {
+   MSH_EBMF_CHUNK_NODES = 1,
+   MSH_EBMF_CHUNK_STRINGS,
+   MSH_EBMF_CHUNK_MESH,
+   MSH_EBMF_CHUNK_MESHLETS
+
+};
+
+enum {
+   // both payloads went through the codecs in codec.c and have to be decoded before use
+   MSH_EBMF_MESH_COMPRESSED = 0x0001
+
+};
+
+typedef struct MSH_ModelHeaderV2_t
+{
+   MSH_ModelHeader base;
+   u32 chunk_count;
+   u64 directory_offset;
+
+} MSH_ModelHeaderV2;
+
+typedef struct MSH_ChunkEntry_t
+{
+   u32 type;
+   u32 index;
+   u64 offset;
+   u64 size;
+
+} MSH_ChunkEntry;
+
+typedef struct MSH_NodeV2_t
 {
-   char* string = calloc(token.token_size + 1, sizeof(char));
-   if (string != NULL)
-      memcpy(string, token.token_start, token.token_size);
+   u32 name_offset;
+   u32 child_count;
+   Transform3D transform;
+   i16 parent_id;
+   i16 prev_sibling_id;
+   i16 next_sibling_id;
+   i16 root_child_id;
 
-   return string;
+} MSH_NodeV2;
+
+typedef struct MSH_MeshHeaderV2_t
+{
+   u32 index_count;
+   u32 vertex_count;
+   i32 node_id;
+   u16 material_id;
+   u8 primitive;
+   u8 attribute_count;
+   u8 index_type; // stored instead of guessed from the vertex count like v1 does
+   u8 lod_count;
+   u16 flags; // MSH_EBMF_MESH_*
+   u8 attributes[MESH_MAX_ATTRIBUTES];
+
+   BBox bounds;
+   vec3 sphere_center;
+   f32 sphere_radius;
+
+   u32 padding;
+   u64 index_offset;
+   u64 index_size; // the sizes are bytes in the file, so encoded sizes for compressed meshes
+   u64 vertex_offset;
+   u64 vertex_size;
+
+} MSH_MeshHeaderV2;
+
+typedef struct MSH_MeshLodV2_t
+{
+   u32 first_index;
+   u32 index_count;
+   f32 error;
+   u32 reserved;
+
+} MSH_MeshLodV2;
+
+typedef struct MSH_MeshletHeaderV2_t
+{
+   u32 meshlet_count;
+   u32 vertex_count;
+   u32 triangle_count;
+   u32 reserved;
+
+} MSH_MeshletHeaderV2;
+
+typedef struct MSH_MeshletV2_t
+{
+   u32 vertex_offset;
+   u32 triangle_offset;
+   u32 vertex_count;
+   u32 triangle_count;
+
+   vec4 bounding_sphere;
+   vec3 cone_apex;
+   vec3 cone_axis;
+   f32 cone_cutoff;
+   u32 reserved;
+
+} MSH_MeshletV2;
+
+// bytes per vertex, summed over every attribute
+static inline uS MSH_VertexSize(const u8* attributes, u8 attribute_count)
+{
+   uS vertex_size = 0;
+   for (u8 atr_i = 0; atr_i < attribute_count; atr_i++)
+   {
+      switch (attributes[atr_i])
+      {
+         case MESH_ATTRIBUTE_1_CHANNEL:
+         case MESH_ATTRIBUTE_COLOR:
+            vertex_size += 4;
+            break;
+
+         case MESH_ATTRIBUTE_2_CHANNEL:
+            vertex_size += 8;
+            break;
+
+         case MESH_ATTRIBUTE_3_CHANNEL:
+            vertex_size += 12;
+            break;
+
+         case MESH_ATTRIBUTE_4_CHANNEL:
+            vertex_size += 16;
+            break;
+
+         default:
+            break;
+
+      }
+
+   }
+
+   return vertex_size;
 }
 
 void MSH_RellocAttribute(u8* new_vertex_buffer, u8* old_vertex_buffer, uS* inout_new_size, uS* inout_new_ofs, uS old_size, uS old_ofs, uS new_bytes, uS* inout_total_bytes, const bool clear_attribute);
-Material MSH_ParseNextMaterial(memblob memory, uS* char_offset);
-MSH_MatToken* MSH_TokenizeMaterial(memblob memory, uS* out_buffer_size);
-Mesh MSH_ParseEctorMesh(memblob memory, uS* mesh_size);
+Mesh MSH_ParseEctorMesh(memblob memory, uS* mesh_size, bool is_borrowed);
+// writes a faces_x by faces_y grid into the given streams, indices start counting at first_vertex. indices can be NULL
+void MSH_FillQuad(u32 faces_x, u32 faces_y, mat4x4 transform, vec4 texture_coords, u32 first_vertex, vec3* position, vec3* normal, vec2* texcoord, vec4* tangent, u32* indices);
+// frees the material table along with its strings, or unmaps the cache they came from
+void MSH_FreeMaterials(Model* model);
+// see codec.c for the formats. the encoders return 0 if out_capacity is under the bound
+uS MSH_VertexStreamBound(const u8* attributes, u8 attribute_count, u32 vertex_count);
+// the smallest a stream of that many vertices or indices can encode to, anything shorter can't be valid
+uS MSH_VertexStreamMinimum(const u8* attributes, u8 attribute_count, u32 vertex_count);
+uS MSH_EncodeVertexStream(u8* out_data, uS out_capacity, const u8* vertex_buffer, const u8* attributes, u8 attribute_count, u32 vertex_count);
+bool MSH_DecodeVertexStream(u8* out_vertex_buffer, const u8* attributes, u8 attribute_count, u32 vertex_count, const u8* data, uS data_size);
+uS MSH_IndexStreamBound(u32 index_count);
+uS MSH_IndexStreamMinimum(u32 index_count);
+uS MSH_EncodeIndexStream(u8* out_data, uS out_capacity, const void* index_buffer, u8 index_type, u32 index_count);
+bool MSH_DecodeIndexStream(void* out_index_buffer, u8 index_type, u32 index_count, const u8* data, uS data_size);
+
+// scans the headers for where every mesh lives, then decodes and post-processes the meshes across the pool
+Model MSH_ParseEctorModel(memblob memory, MeshLoadDesc desc, bool is_borrowed, JobPool* jobs);
 
 #endif
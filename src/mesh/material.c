@@ -0,0 +1,672 @@
+#include "util/types.h"
+#include "util/extra_types.h"
+#include "util/files.h"
+#include "util/math.h"
+
+#include "mesh/internal.h"
+#include "mesh.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// numbers longer than this get cut off before they're parsed
+#define MSH_MAT_NUMBER_MAX 63
+
+enum {
+   MSH_MATKEY_NONE = 0,
+   MSH_MATKEY_ID,
+   MSH_MATKEY_SURF,
+   MSH_MATKEY_TEX,
+   MSH_MATKEY_PARAM,
+   MSH_MATKEY_UNKNOWN
+};
+
+typedef struct MSH_MatKeyword_t
+{
+   const char* string;
+   u32 size;
+   u8 key;
+
+} MSH_MatKeyword;
+
+// every keyword ends in a different character, so the low bits of that pick its slot. a new keyword has to
+// keep it that way
+static const MSH_MatKeyword msh_mat_keywords[8] = {
+   [('d' & 7)] = { "id", 2, MSH_MATKEY_ID },
+   [('f' & 7)] = { "surf", 4, MSH_MATKEY_SURF },
+   [('x' & 7)] = { "tex", 3, MSH_MATKEY_TEX },
+   [('m' & 7)] = { "param", 5, MSH_MATKEY_PARAM }
+};
+
+typedef struct MSH_MatLexer_t
+{
+   const char* read_head;
+   const char* file_end;
+
+} MSH_MatLexer;
+
+// strings are interned, every copy of the same string points at the same bytes
+typedef struct MSH_MatStringArena_t
+{
+   char* data;
+   uS size;
+   uS capacity;
+
+   u32* table; // offset + 1 of each string, 0 for an empty slot
+   u32 table_mask;
+   u32 string_count;
+
+} MSH_MatStringArena;
+
+// plain ascii checks, the locale aware ones cost more than the rest of the lexer put together
+static bool MSH_IsMatSpace(char head)
+{
+   return ((u8)head <= ' ' || (u8)head == 0x7F);
+}
+
+static bool MSH_IsMatStringChar(char head)
+{
+   return ((u8)head > ' ' && (u8)head < 0x7F) && head != '=' && head != ',' && head != ';' && head != '{' && head != '}' && head != '#';
+}
+
+static MSH_MatToken MSH_NextMatToken(MSH_MatLexer* lexer)
+{
+   while (lexer->read_head < lexer->file_end)
+   {
+      const char* token_start = lexer->read_head;
+      char head = *(lexer->read_head++);
+
+      if (head == '#')
+      {
+         const char* line_end = memchr(lexer->read_head, '\n', (uS)(lexer->file_end - lexer->read_head));
+         lexer->read_head = (line_end != NULL) ? line_end + 1 : lexer->file_end;
+
+         continue;
+      }
+
+      if (MSH_IsMatSpace(head) || head == '=' || head == ',')
+         continue;
+
+      switch (head)
+      {
+         case ';':
+            return (MSH_MatToken){ MSH_MATTOK_END_LINE, 1, token_start };
+
+         case '{':
+            return (MSH_MatToken){ MSH_MATTOK_START, 1, token_start };
+
+         case '}':
+            return (MSH_MatToken){ MSH_MATTOK_STOP, 1, token_start };
+
+         default:
+            break;
+      }
+
+      if (!MSH_IsMatStringChar(head))
+         return (MSH_MatToken){ MSH_MATTOK_INVALID, 1, token_start };
+
+      // spaces in the middle of a string are part of it, the ones at the end aren't
+      const char* token_end = lexer->read_head;
+      while (lexer->read_head < lexer->file_end)
+      {
+         char next = (*lexer->read_head);
+
+         if (MSH_IsMatStringChar(next))
+            token_end = ++lexer->read_head;
+         else if (MSH_IsMatSpace(next))
+            lexer->read_head++;
+         else
+            break;
+
+      }
+
+      return (MSH_MatToken){ MSH_MATTOK_VALID_STRING, (u32)(token_end - token_start), token_start };
+   }
+
+   return (MSH_MatToken){ MSH_MATTOK_END_FILE, 0, lexer->file_end };
+}
+
+static u8 MSH_MatKeywordFromToken(MSH_MatToken token)
+{
+   MSH_MatKeyword keyword = msh_mat_keywords[token.token_start[token.token_size - 1] & 7];
+
+   if (keyword.size == token.token_size && memcmp(keyword.string, token.token_start, keyword.size) == 0)
+      return keyword.key;
+
+   return MSH_MATKEY_UNKNOWN;
+}
+
+// the source is never written to, so numbers get terminated in a copy instead
+static i32 MSH_MatTokenToI32(MSH_MatToken token)
+{
+   char number[MSH_MAT_NUMBER_MAX + 1] = { 0 };
+   memcpy(number, token.token_start, M_MIN(token.token_size, (u32)MSH_MAT_NUMBER_MAX));
+
+   return (i32)strtol(number, NULL, 10);
+}
+
+static f32 MSH_MatTokenToF32(MSH_MatToken token)
+{
+   char number[MSH_MAT_NUMBER_MAX + 1] = { 0 };
+   memcpy(number, token.token_start, M_MIN(token.token_size, (u32)MSH_MAT_NUMBER_MAX));
+
+   return strtof(number, NULL);
+}
+
+static bool MSH_InitStringArena(MSH_MatStringArena* arena, uS source_size)
+{
+   // every string is its own piece of the source with at least one character after it that isn't part of any
+   // string, so the arena can never outgrow the source
+   arena->capacity = source_size + 1;
+   arena->data = malloc(arena->capacity);
+
+   u32 table_size = 16;
+   while (table_size < arena->capacity / 4 && table_size < (1u << 30))
+      table_size <<= 1;
+
+   arena->table = calloc(table_size, sizeof(u32));
+   arena->table_mask = table_size - 1;
+
+   return (arena->data != NULL && arena->table != NULL);
+}
+
+static const char* MSH_InternString(MSH_MatStringArena* arena, MSH_MatToken token)
+{
+   // past half full the table stops deduplicating, the strings still go in the arena
+   bool can_dedup = (arena->string_count < (arena->table_mask + 1) / 2);
+   u32 slot = (u32)Util_HashBytes(token.token_start, token.token_size, UTIL_HASH_SEED) & arena->table_mask;
+
+   while (can_dedup && arena->table[slot] != 0)
+   {
+      const char* string = arena->data + arena->table[slot] - 1;
+      if (strncmp(string, token.token_start, token.token_size) == 0 && string[token.token_size] == '\0')
+         return string;
+
+      slot = (slot + 1) & arena->table_mask;
+
+   }
+
+   if (arena->size + token.token_size + 1 > arena->capacity)
+      return NULL;
+
+   char* string = arena->data + arena->size;
+   memcpy(string, token.token_start, token.token_size);
+   string[token.token_size] = '\0';
+
+   if (can_dedup)
+   {
+      arena->table[slot] = (u32)arena->size + 1;
+      arena->string_count++;
+
+   }
+
+   arena->size += (uS)token.token_size + 1;
+
+   return string;
+}
+
+static bool MSH_StoreMaterial(Model* model, u32* inout_capacity, u32* inout_parsed_count, Material material)
+{
+   u32 index = (material.id == INVALID_HANDLE_ID) ? (*inout_parsed_count) : material.id;
+
+   if (index >= (*inout_capacity))
+   {
+      u32 capacity = M_MAX(index + 1, (*inout_capacity) * 2);
+      Material* tmp = realloc(model->materials, (uS)capacity * sizeof(Material));
+      if (tmp == NULL)
+      {
+         Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_ERROR }, "Ran out of memory for material %u", index);
+
+         return false;
+      }
+
+      memset(tmp + (*inout_capacity), 0, (uS)(capacity - (*inout_capacity)) * sizeof(Material));
+      model->materials = tmp;
+      (*inout_capacity) = capacity;
+
+   }
+
+   model->materials[index] = material;
+   (*inout_parsed_count) = index + 1;
+
+   return true;
+}
+
+void MSH_FreeMaterials(Model* model)
+{
+   free(model->materials);
+   model->materials = NULL;
+
+   // strings from a cache live in its mapping
+   if (model->material_source.data == NULL)
+      free(model->material_strings.data);
+
+   model->material_strings = (memblob){ 0 };
+   Util_UnmapFile(&model->material_source);
+
+}
+
+void Mesh_ParseEctorMaterials(memblob memory, Model* inout_model)
+{
+   if (memory.data == NULL || memory.size == 0 || inout_model == NULL)
+      return;
+
+   MSH_FreeMaterials(inout_model);
+
+   u32 capacity = M_MAX(inout_model->material_count, 16u);
+   inout_model->materials = calloc((uS)capacity, sizeof(Material));
+
+   MSH_MatStringArena arena = { 0 };
+   if (!MSH_InitStringArena(&arena, memory.size) || inout_model->materials == NULL)
+   {
+      free(arena.data);
+      free(arena.table);
+      MSH_FreeMaterials(inout_model);
+
+      return;
+   }
+
+   MSH_MatLexer lexer = { (const char*)memory.data, (const char*)memory.data + memory.size };
+
+   Material material = { .id = INVALID_HANDLE_ID };
+   bool in_material = false;
+   u8 keyword = MSH_MATKEY_NONE;
+
+   u32 arg_count = 0;
+   u32 param_count = 0;
+   bool param_is_float = false;
+   i32 tex_slot = -1;
+   u32 parsed_count = 0;
+
+   while (true)
+   {
+      MSH_MatToken token = MSH_NextMatToken(&lexer);
+
+      if (token.token_type == MSH_MATTOK_END_FILE)
+         break;
+
+      if (token.token_type == MSH_MATTOK_INVALID)
+      {
+         Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_ERROR }, "Encountered invalid token! Material parsing failed.");
+
+         break;
+      }
+
+      switch (token.token_type)
+      {
+         case MSH_MATTOK_VALID_STRING: {
+            if (!in_material)
+            {
+               if (material.name == NULL)
+                  material.name = MSH_InternString(&arena, token);
+
+               break;
+            }
+
+            if (keyword == MSH_MATKEY_NONE)
+            {
+               keyword = MSH_MatKeywordFromToken(token);
+               arg_count = 0;
+
+               if (keyword == MSH_MATKEY_UNKNOWN)
+                  Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_WARN }, "Unrecognized keyword \"%.*s\"", (i32)token.token_size, token.token_start);
+
+               break;
+            }
+
+            switch (keyword)
+            {
+               case MSH_MATKEY_ID: {
+                  if (arg_count >= 1)
+                     Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_WARN }, "Material 'id' only takes 1 argument!");
+                  else
+                     material.id = (u32)MSH_MatTokenToI32(token);
+
+               } break;
+
+               case MSH_MATKEY_SURF: {
+                  if (arg_count >= 1)
+                     Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_WARN }, "Material 'surf' only takes 1 argument!");
+                  else
+                     material.surface_name = MSH_InternString(&arena, token);
+
+               } break;
+
+               case MSH_MATKEY_TEX: {
+                  if (arg_count >= 2)
+                     Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_WARN }, "Material 'tex' only takes 2 arguments!");
+                  else if (arg_count == 0)
+                  {
+                     tex_slot = MSH_MatTokenToI32(token);
+                     if (tex_slot < 0 || tex_slot >= MATERIAL_MAX_TEXTURES)
+                     {
+                        Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_WARN }, "Material texture slot %d is out of range!", tex_slot);
+                        tex_slot = -1;
+
+                     }
+
+                  } else if (tex_slot >= 0)
+                     material.texture_strings[tex_slot] = MSH_InternString(&arena, token);
+
+               } break;
+
+               case MSH_MATKEY_PARAM: {
+                  if (param_count >= MATERIAL_MAX_PARAMS)
+                  {
+                     if (arg_count == 0)
+                        Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_WARN }, "Materials only take up to %d params!", MATERIAL_MAX_PARAMS);
+
+                  } else if (arg_count >= 6)
+                     Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_WARN }, "Material 'param' only takes up to 6 arguments!");
+                  else if (arg_count == 0)
+                     material.parameter[param_count].key = MSH_InternString(&arena, token);
+                  else if (arg_count == 1)
+                     param_is_float = (token.token_start[0] == 'f');
+                  else {
+                     u32 param_idx = arg_count - 2;
+
+                     if (param_is_float)
+                     {
+                        material.parameter[param_count].type = MAT_PARAMTYPE_F32;
+                        material.parameter[param_count].value.as_f32[param_idx] = MSH_MatTokenToF32(token);
+
+                     } else {
+                        material.parameter[param_count].type = MAT_PARAMTYPE_I32;
+                        material.parameter[param_count].value.as_i32[param_idx] = MSH_MatTokenToI32(token);
+
+                     }
+
+                     material.parameter[param_count].count++;
+
+                  }
+
+               } break;
+
+               default:
+                  break;
+            }
+
+            arg_count++;
+
+         } break;
+
+         case MSH_MATTOK_END_LINE: {
+            if (keyword == MSH_MATKEY_PARAM && param_count < MATERIAL_MAX_PARAMS)
+               param_count++;
+
+            keyword = MSH_MATKEY_NONE;
+
+         } break;
+
+         case MSH_MATTOK_START: {
+            if (in_material)
+               Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_WARN }, "Misplaced open bracket!");
+            else if (material.name == NULL)
+               Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_WARN }, "Materials require names!");
+
+            // a nameless material still gets read through, it's just thrown away at the end
+            in_material = true;
+
+         } break;
+
+         case MSH_MATTOK_STOP: {
+            if (!in_material)
+            {
+               Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_WARN }, "Misplaced closing bracket!");
+
+               break;
+            }
+
+            if (material.name != NULL && !MSH_StoreMaterial(inout_model, &capacity, &parsed_count, material))
+               lexer.read_head = lexer.file_end;
+
+            material = (Material){ .id = INVALID_HANDLE_ID };
+            in_material = false;
+            keyword = MSH_MATKEY_NONE;
+            param_count = 0;
+            tex_slot = -1;
+
+         } break;
+
+         default:
+            break;
+      }
+
+   }
+
+   if (in_material)
+   {
+      Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_WARN }, "Missing closing bracket!");
+
+      if (material.name != NULL)
+         MSH_StoreMaterial(inout_model, &capacity, &parsed_count, material);
+
+   }
+
+   free(arena.table);
+
+   inout_model->material_strings = (memblob){ arena.data, arena.size };
+   inout_model->material_count = M_MAX(parsed_count, inout_model->material_count);
+
+}
+
+// strings from the model's own block keep their offset in it, anything else is added after the block
+static u32 MSH_CacheStringOffset(memblob strings, const char* string, u8* string_data, u64* inout_extra_offset)
+{
+   if (string == NULL)
+      return MATERIAL_CACHE_NO_STRING;
+
+   const char* block = strings.data;
+   if (block != NULL && string >= block && string < block + strings.size)
+      return (u32)(string - block);
+
+   uS string_size = strlen(string) + 1;
+   u64 offset = (*inout_extra_offset);
+
+   if (string_data != NULL)
+      memcpy(string_data + offset, string, string_size);
+
+   (*inout_extra_offset) += string_size;
+
+   return (u32)offset;
+}
+
+// fills in the records if they're given, returns how big the string block ends up
+static u64 MSH_BuildMaterialRecords(Model model, MSH_MaterialRecord* records, MSH_MaterialParamRecord* params, u8* string_data, u32* out_param_count)
+{
+   u64 string_size = model.material_strings.size;
+   u32 param_total = 0;
+
+   if (string_data != NULL && string_size > 0)
+      memcpy(string_data, model.material_strings.data, (uS)string_size);
+
+   for (u32 material_i = 0; material_i < model.material_count; material_i++)
+   {
+      Material material = model.materials[material_i];
+      MSH_MaterialRecord record = {
+         .name_offset = MSH_CacheStringOffset(model.material_strings, material.name, string_data, &string_size),
+         .surface_name_offset = MSH_CacheStringOffset(model.material_strings, material.surface_name, string_data, &string_size),
+         .id = material.id,
+         .first_parameter = param_total
+      };
+
+      for (u32 tex_i = 0; tex_i < MATERIAL_MAX_TEXTURES; tex_i++)
+         record.texture_offsets[tex_i] = MSH_CacheStringOffset(model.material_strings, material.texture_strings[tex_i], string_data, &string_size);
+
+      // only the params that were actually set get written
+      for (u32 param_i = 0; param_i < MATERIAL_MAX_PARAMS; param_i++)
+      {
+         if (material.parameter[param_i].key == NULL && material.parameter[param_i].count == 0)
+            continue;
+
+         MSH_MaterialParamRecord param = {
+            .key_offset = MSH_CacheStringOffset(model.material_strings, material.parameter[param_i].key, string_data, &string_size),
+            .slot = param_i,
+            .count = material.parameter[param_i].count,
+            .type = material.parameter[param_i].type
+         };
+
+         memcpy(&param.value, &material.parameter[param_i].value, sizeof(param.value));
+
+         if (params != NULL)
+            params[param_total] = param;
+
+         param_total++;
+         record.parameter_count++;
+
+      }
+
+      if (records != NULL)
+         records[material_i] = record;
+
+   }
+
+   (*out_param_count) = param_total;
+
+   return string_size;
+}
+
+memblob Mesh_WriteEctorMaterialCache(Model model, memblob source)
+{
+   if (model.materials == NULL || model.material_count == 0)
+      return (memblob){ 0 };
+
+   u32 param_count = 0;
+   u64 string_size = MSH_BuildMaterialRecords(model, NULL, NULL, NULL, &param_count);
+   if (string_size >= MATERIAL_CACHE_NO_STRING)
+      return (memblob){ 0 };
+
+   uS records_ofs = sizeof(MSH_MaterialCacheHeader);
+   uS params_ofs = records_ofs + (uS)model.material_count * sizeof(MSH_MaterialRecord);
+   uS strings_ofs = params_ofs + (uS)param_count * sizeof(MSH_MaterialParamRecord);
+   uS total_size = strings_ofs + (uS)string_size;
+
+   u8* data = calloc(total_size, 1);
+   if (data == NULL)
+      return (memblob){ 0 };
+
+   MSH_MaterialCacheHeader header = {
+      .identifier.magic = MATERIAL_CACHE_MAGIC_ID,
+      .version = MATERIAL_CACHE_VERSION,
+      .material_count = model.material_count,
+      .parameter_count = param_count,
+      .string_size = (u32)string_size,
+      .source_size = source.size,
+      .source_hash = Util_HashBytes(source.data, source.size, UTIL_HASH_SEED)
+   };
+
+   memcpy(data, &header, sizeof(MSH_MaterialCacheHeader));
+   MSH_BuildMaterialRecords(model, (MSH_MaterialRecord*)(data + records_ofs), (MSH_MaterialParamRecord*)(data + params_ofs), data + strings_ofs, &param_count);
+
+   return (memblob){ data, total_size };
+}
+
+static bool MSH_CacheStringValid(u32 offset, u32 string_size)
+{
+   return (offset == MATERIAL_CACHE_NO_STRING || offset < string_size);
+}
+
+static const char* MSH_CacheString(const char* strings, u32 offset)
+{
+   return (offset == MATERIAL_CACHE_NO_STRING) ? NULL : strings + offset;
+}
+
+bool Mesh_LoadEctorMaterialCache(MmapBlob mapping, memblob source, Model* inout_model)
+{
+   if (mapping.data == NULL || mapping.size < sizeof(MSH_MaterialCacheHeader) || inout_model == NULL)
+   {
+      Util_UnmapFile(&mapping);
+
+      return false;
+   }
+
+   MSH_MaterialCacheHeader header = { 0 };
+   memcpy(&header, mapping.data, sizeof(MSH_MaterialCacheHeader));
+
+   u64 records_ofs = sizeof(MSH_MaterialCacheHeader);
+   u64 params_ofs = records_ofs + (u64)header.material_count * sizeof(MSH_MaterialRecord);
+   u64 strings_ofs = params_ofs + (u64)header.parameter_count * sizeof(MSH_MaterialParamRecord);
+
+   const u8* data = mapping.data;
+   const char* strings = (const char*)data + strings_ofs;
+
+   bool is_valid =
+      header.identifier.magic == MATERIAL_CACHE_MAGIC_ID && header.version == MATERIAL_CACHE_VERSION &&
+      strings_ofs + header.string_size <= (u64)mapping.size &&
+      (header.string_size == 0 || strings[header.string_size - 1] == '\0');
+
+   // a cache that doesn't match the text anymore is just stale, not broken
+   if (is_valid && source.data != NULL && (header.source_size != source.size || header.source_hash != Util_HashBytes(source.data, source.size, UTIL_HASH_SEED)))
+   {
+      Util_UnmapFile(&mapping);
+
+      return false;
+   }
+
+   u32 material_count = M_MAX(header.material_count, inout_model->material_count);
+   Material* materials = (is_valid) ? calloc(M_MAX((uS)material_count, 1), sizeof(Material)) : NULL;
+
+   for (u32 material_i = 0; materials != NULL && material_i < header.material_count; material_i++)
+   {
+      MSH_MaterialRecord record = { 0 };
+      memcpy(&record, data + records_ofs + (u64)material_i * sizeof(MSH_MaterialRecord), sizeof(MSH_MaterialRecord));
+
+      bool is_record_valid =
+         MSH_CacheStringValid(record.name_offset, header.string_size) && MSH_CacheStringValid(record.surface_name_offset, header.string_size) &&
+         record.first_parameter <= header.parameter_count && record.parameter_count <= header.parameter_count - record.first_parameter;
+
+      Material* material = &materials[material_i];
+      material->name = MSH_CacheString(strings, record.name_offset);
+      material->surface_name = MSH_CacheString(strings, record.surface_name_offset);
+      material->id = record.id;
+
+      for (u32 tex_i = 0; tex_i < MATERIAL_MAX_TEXTURES; tex_i++)
+      {
+         is_record_valid &= MSH_CacheStringValid(record.texture_offsets[tex_i], header.string_size);
+         material->texture_strings[tex_i] = MSH_CacheString(strings, record.texture_offsets[tex_i]);
+
+      }
+
+      for (u32 param_i = 0; is_record_valid && param_i < record.parameter_count; param_i++)
+      {
+         MSH_MaterialParamRecord param = { 0 };
+         memcpy(&param, data + params_ofs + (u64)(record.first_parameter + param_i) * sizeof(MSH_MaterialParamRecord), sizeof(MSH_MaterialParamRecord));
+
+         is_record_valid &= (param.slot < MATERIAL_MAX_PARAMS && param.count <= 4 && MSH_CacheStringValid(param.key_offset, header.string_size));
+         if (!is_record_valid)
+            break;
+
+         material->parameter[param.slot].key = MSH_CacheString(strings, param.key_offset);
+         material->parameter[param.slot].count = param.count;
+         material->parameter[param.slot].type = param.type;
+         memcpy(&material->parameter[param.slot].value, &param.value, sizeof(param.value));
+
+      }
+
+      if (!is_record_valid)
+      {
+         free(materials);
+         materials = NULL;
+
+      }
+
+   }
+
+   if (materials == NULL)
+   {
+      Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_WARN }, "Ignoring broken material cache");
+      Util_UnmapFile(&mapping);
+
+      return false;
+   }
+
+   MSH_FreeMaterials(inout_model);
+
+   inout_model->materials = materials;
+   inout_model->material_count = material_count;
+   inout_model->material_strings = (memblob){ (void*)strings, header.string_size };
+   inout_model->material_source = mapping;
+
+   return true;
+}
@@ -0,0 +1,491 @@
+#include "util/types.h"
+#include "util/extra_types.h"
+#include "util/math.h"
+#include "util/vec3.h"
+#include "util/jobs.h"
+
+#include "mesh/internal.h"
+#include "mesh.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MSH_MESHLET_NO_VERTEX UINT8_MAX
+
+// a normal cone wider than this (about 168 degrees) can't cull anything worth the test, and the apex gets unstable
+#define MSH_MESHLET_MIN_CONE_DOT 0.1f
+
+// every triangle is reachable from its vertices through adjacency, live_counts is how many unused triangles each
+// vertex still has and local_index is where a vertex sits in the meshlet being built
+typedef struct MSH_MeshletBuilder_t
+{
+   const vec3* positions;
+   u32* indices;
+   u32* adjacency_offsets;
+   u32* adjacency;
+   u32* live_counts;
+   u8* local_index;
+   bool* is_used;
+
+   u32 vertex_count;
+   u32 triangle_count;
+
+} MSH_MeshletBuilder;
+
+typedef struct MSH_MeshletJob_t
+{
+   const Model* model;
+   MeshletData* results;
+
+} MSH_MeshletJob;
+
+static void MSH_FreeMeshletBuilder(MSH_MeshletBuilder* builder)
+{
+   free(builder->indices);
+   free(builder->adjacency_offsets);
+   free(builder->adjacency);
+   free(builder->live_counts);
+   free(builder->local_index);
+   free(builder->is_used);
+
+}
+
+static bool MSH_InitMeshletBuilder(MSH_MeshletBuilder* builder, Mesh mesh)
+{
+   u32 vertex_count = mesh.vertex_count;
+   u32 triangle_count = mesh.index_count / 3;
+
+   (*builder) = (MSH_MeshletBuilder){
+      .positions = (const vec3*)mesh.vertex_buffer,
+      .indices = malloc(sizeof(u32) * (uS)triangle_count * 3),
+      .adjacency_offsets = calloc((uS)vertex_count + 1, sizeof(u32)),
+      .adjacency = malloc(sizeof(u32) * (uS)triangle_count * 3),
+      .live_counts = calloc((uS)vertex_count, sizeof(u32)),
+      .local_index = malloc((uS)vertex_count),
+      .is_used = calloc((uS)triangle_count, sizeof(bool)),
+      .vertex_count = vertex_count,
+      .triangle_count = triangle_count
+   };
+
+   if (builder->indices == NULL || builder->adjacency_offsets == NULL || builder->adjacency == NULL || builder->live_counts == NULL || builder->local_index == NULL || builder->is_used == NULL)
+   {
+      MSH_FreeMeshletBuilder(builder);
+
+      return false;
+   }
+
+   memset(builder->local_index, MSH_MESHLET_NO_VERTEX, (uS)vertex_count);
+
+   for (u32 index_i = 0; index_i < triangle_count * 3; index_i++)
+      builder->indices[index_i] = Mesh_GetIndexFromBuffer(mesh, index_i);
+
+   // triangles pointing outside the vertices are left out, as if they were already used
+   for (u32 tri_i = 0; tri_i < triangle_count; tri_i++)
+   {
+      const u32* triangle = &builder->indices[tri_i * 3];
+      if (triangle[0] >= vertex_count || triangle[1] >= vertex_count || triangle[2] >= vertex_count)
+      {
+         builder->is_used[tri_i] = true;
+         continue;
+      }
+
+      for (u32 corner_i = 0; corner_i < 3; corner_i++)
+         builder->live_counts[triangle[corner_i]]++;
+
+   }
+
+   for (u32 vert_i = 0; vert_i < vertex_count; vert_i++)
+      builder->adjacency_offsets[vert_i + 1] = builder->adjacency_offsets[vert_i] + builder->live_counts[vert_i];
+
+   // live_counts doubles as the fill cursor here, then gets counted back up
+   memset(builder->live_counts, 0, sizeof(u32) * (uS)vertex_count);
+
+   for (u32 tri_i = 0; tri_i < triangle_count; tri_i++)
+   {
+      if (builder->is_used[tri_i])
+         continue;
+
+      const u32* triangle = &builder->indices[tri_i * 3];
+      for (u32 corner_i = 0; corner_i < 3; corner_i++)
+      {
+         u32 vertex = triangle[corner_i];
+         builder->adjacency[builder->adjacency_offsets[vertex] + builder->live_counts[vertex]++] = tri_i;
+
+      }
+
+   }
+
+   return true;
+}
+
+static u32 MSH_NewMeshletVertices(const MSH_MeshletBuilder* builder, u32 triangle_id)
+{
+   const u32* triangle = &builder->indices[triangle_id * 3];
+
+   return (u32)(builder->local_index[triangle[0]] == MSH_MESHLET_NO_VERTEX)
+      + (u32)(builder->local_index[triangle[1]] == MSH_MESHLET_NO_VERTEX)
+      + (u32)(builder->local_index[triangle[2]] == MSH_MESHLET_NO_VERTEX);
+}
+
+// the unused triangle around these vertices that adds the fewest new ones. ties go to the one whose vertices have the
+// fewest unused triangles left, which finishes vertices off instead of leaving them to be duplicated into another meshlet
+static u32 MSH_PickAdjacentTriangle(const MSH_MeshletBuilder* builder, const u32* vertices, u32 vertex_count)
+{
+   u32 best_triangle = UINT32_MAX;
+   u32 best_score = UINT32_MAX;
+
+   for (u32 vert_i = 0; vert_i < vertex_count; vert_i++)
+   {
+      u32 vertex = vertices[vert_i];
+      if (builder->live_counts[vertex] == 0)
+         continue;
+
+      for (u32 adj_i = builder->adjacency_offsets[vertex]; adj_i < builder->adjacency_offsets[vertex + 1]; adj_i++)
+      {
+         u32 triangle_id = builder->adjacency[adj_i];
+         if (builder->is_used[triangle_id])
+            continue;
+
+         const u32* triangle = &builder->indices[triangle_id * 3];
+         u32 live_sum = builder->live_counts[triangle[0]] + builder->live_counts[triangle[1]] + builder->live_counts[triangle[2]];
+         u32 score = (MSH_NewMeshletVertices(builder, triangle_id) << 24) | M_MIN(live_sum, 0xFFFFFFu);
+
+         if (score < best_score)
+         {
+            best_score = score;
+            best_triangle = triangle_id;
+
+         }
+
+      }
+
+   }
+
+   return best_triangle;
+}
+
+static vec3 MSH_MeshletTriangleNormal(const vec3* positions, const u32* vertices, const u8* triangle, f32* out_length)
+{
+   vec3 a = positions[vertices[triangle[0]]];
+   vec3 b = positions[vertices[triangle[1]]];
+   vec3 c = positions[vertices[triangle[2]]];
+
+   vec3 normal = Util_CrossVec3(Util_SubVec3(b, a), Util_SubVec3(c, a));
+   (*out_length) = Util_MagVec3(normal);
+
+   return ((*out_length) > 0.0f) ? Util_ScaleVec3(normal, 1.0f / (*out_length)) : (vec3){ 0 };
+}
+
+// sphere around the box like Mesh_CalculateBounds, and the cone of directions the triangles can all be backfacing from
+static void MSH_CalculateMeshletBounds(Meshlet* meshlet, const MeshletData* data, const vec3* positions)
+{
+   const u32* vertices = &data->vertices[meshlet->vertex_offset];
+   const u8* triangles = &data->triangles[(uS)meshlet->triangle_offset * 3];
+
+   vec3 min_vertex = positions[vertices[0]];
+   vec3 max_vertex = positions[vertices[0]];
+
+   for (u32 vert_i = 1; vert_i < meshlet->vertex_count; vert_i++)
+   {
+      min_vertex = Util_MinVec3(min_vertex, positions[vertices[vert_i]]);
+      max_vertex = Util_MaxVec3(max_vertex, positions[vertices[vert_i]]);
+
+   }
+
+   vec3 center = Util_ScaleVec3(Util_AddVec3(min_vertex, max_vertex), 0.5f);
+
+   f32 radius_sqr = 0.0f;
+   for (u32 vert_i = 0; vert_i < meshlet->vertex_count; vert_i++)
+      radius_sqr = M_MAX(radius_sqr, Util_MagSqrVec3(Util_SubVec3(positions[vertices[vert_i]], center)));
+
+   meshlet->bounding_sphere = VEC4(center.x, center.y, center.z, sqrtf(radius_sqr));
+   meshlet->cone_apex = center;
+   meshlet->cone_axis = (vec3){ 0 };
+   meshlet->cone_cutoff = 1.0f;
+
+   vec3 normal_sum = { 0 };
+   for (u32 tri_i = 0; tri_i < meshlet->triangle_count; tri_i++)
+   {
+      f32 length = 0.0f;
+      normal_sum = Util_AddVec3(normal_sum, MSH_MeshletTriangleNormal(positions, vertices, &triangles[tri_i * 3], &length));
+
+   }
+
+   f32 sum_length = Util_MagVec3(normal_sum);
+   if (sum_length <= 0.0f)
+      return;
+
+   vec3 axis = Util_ScaleVec3(normal_sum, 1.0f / sum_length);
+
+   // degenerate triangles don't face anywhere, so they don't widen the cone
+   f32 min_dot = 1.0f;
+   for (u32 tri_i = 0; tri_i < meshlet->triangle_count; tri_i++)
+   {
+      f32 length = 0.0f;
+      vec3 normal = MSH_MeshletTriangleNormal(positions, vertices, &triangles[tri_i * 3], &length);
+
+      if (length > 0.0f)
+         min_dot = M_MIN(min_dot, Util_DotVec3(normal, axis));
+
+   }
+
+   if (min_dot <= MSH_MESHLET_MIN_CONE_DOT)
+      return;
+
+   // the apex slides back along the axis from the center until it's behind every triangle's plane
+   f32 max_t = 0.0f;
+   for (u32 tri_i = 0; tri_i < meshlet->triangle_count; tri_i++)
+   {
+      f32 length = 0.0f;
+      const u8* triangle = &triangles[tri_i * 3];
+      vec3 normal = MSH_MeshletTriangleNormal(positions, vertices, triangle, &length);
+
+      if (length <= 0.0f)
+         continue;
+
+      f32 t = Util_DotVec3(Util_SubVec3(center, positions[vertices[triangle[0]]]), normal) / Util_DotVec3(axis, normal);
+      max_t = M_MAX(max_t, t);
+
+   }
+
+   // the normals are within acos(min_dot) of the axis, so the view directions they all face away from are within
+   // 90 degrees minus that of it, and cos(90 - a) = sin(a)
+   meshlet->cone_apex = Util_SubVec3(center, Util_ScaleVec3(axis, max_t));
+   meshlet->cone_axis = axis;
+   meshlet->cone_cutoff = sqrtf(1.0f - min_dot * min_dot);
+
+}
+
+static void MSH_FinishMeshlet(MSH_MeshletBuilder* builder, MeshletData* data, Meshlet* meshlet)
+{
+   MSH_CalculateMeshletBounds(meshlet, data, builder->positions);
+
+   for (u32 vert_i = 0; vert_i < meshlet->vertex_count; vert_i++)
+      builder->local_index[data->vertices[meshlet->vertex_offset + vert_i]] = MSH_MESHLET_NO_VERTEX;
+
+   data->meshlets[data->meshlet_count++] = (*meshlet);
+   data->vertex_count += meshlet->vertex_count;
+   data->triangle_count += meshlet->triangle_count;
+
+   (*meshlet) = (Meshlet){ .vertex_offset = data->vertex_count, .triangle_offset = data->triangle_count };
+
+}
+
+MeshletData Mesh_BuildMeshlets(Mesh mesh)
+{
+   MeshletData data = { 0 };
+
+   if (mesh.vertex_buffer == NULL || mesh.index_buffer == NULL || mesh.index_count < 3 || mesh.primitive != MESH_PRIMITIVE_TRIANGLE)
+      return data;
+
+   if (mesh.attribute_count == 0 || mesh.attributes[0] != MESH_ATTRIBUTE_3_CHANNEL)
+      return data;
+
+   MSH_MeshletBuilder builder = { 0 };
+   if (!MSH_InitMeshletBuilder(&builder, mesh))
+      return data;
+
+   // every meshlet but the last is either full of triangles or has at least MESHLET_MAX_VERTICES - 2 vertices,
+   // and each of those took at least one index
+   u32 index_count = builder.triangle_count * 3;
+   u32 meshlet_bound = builder.triangle_count / MESHLET_MAX_TRIANGLES + index_count / (MESHLET_MAX_VERTICES - 2) + 1;
+
+   data.meshlets = malloc(sizeof(Meshlet) * (uS)meshlet_bound);
+   data.vertices = malloc(sizeof(u32) * (uS)index_count);
+   data.triangles = malloc((uS)index_count);
+
+   if (data.meshlets == NULL || data.vertices == NULL || data.triangles == NULL)
+   {
+      Mesh_FreeMeshlets(&data);
+      MSH_FreeMeshletBuilder(&builder);
+
+      return data;
+   }
+
+   Meshlet meshlet = { 0 };
+   u32 last_triangle = UINT32_MAX;
+   u32 seed_cursor = 0;
+
+   while (true)
+   {
+      // grow through the last triangle's neighbours, then the rest of the meshlet's
+      u32 triangle_id = UINT32_MAX;
+      if (meshlet.triangle_count > 0)
+      {
+         triangle_id = MSH_PickAdjacentTriangle(&builder, &builder.indices[last_triangle * 3], 3);
+         if (triangle_id == UINT32_MAX)
+            triangle_id = MSH_PickAdjacentTriangle(&builder, &data.vertices[meshlet.vertex_offset], meshlet.vertex_count);
+
+      }
+
+      // nothing connected is left, carry on in index order. that's close to spatial order once the vertex fetch is optimized
+      if (triangle_id == UINT32_MAX)
+      {
+         while (seed_cursor < builder.triangle_count && builder.is_used[seed_cursor])
+            seed_cursor++;
+
+         if (seed_cursor == builder.triangle_count)
+            break;
+
+         triangle_id = seed_cursor;
+
+      }
+
+      if (meshlet.vertex_count + MSH_NewMeshletVertices(&builder, triangle_id) > MESHLET_MAX_VERTICES || meshlet.triangle_count == MESHLET_MAX_TRIANGLES)
+         MSH_FinishMeshlet(&builder, &data, &meshlet);
+
+      const u32* triangle = &builder.indices[triangle_id * 3];
+      u8* local_triangle = &data.triangles[(uS)(meshlet.triangle_offset + meshlet.triangle_count) * 3];
+
+      for (u32 corner_i = 0; corner_i < 3; corner_i++)
+      {
+         u32 vertex = triangle[corner_i];
+         if (builder.local_index[vertex] == MSH_MESHLET_NO_VERTEX)
+         {
+            builder.local_index[vertex] = (u8)meshlet.vertex_count;
+            data.vertices[meshlet.vertex_offset + meshlet.vertex_count++] = vertex;
+
+         }
+
+         local_triangle[corner_i] = builder.local_index[vertex];
+         builder.live_counts[vertex]--;
+
+      }
+
+      builder.is_used[triangle_id] = true;
+      meshlet.triangle_count++;
+      last_triangle = triangle_id;
+
+   }
+
+   if (meshlet.triangle_count > 0)
+      MSH_FinishMeshlet(&builder, &data, &meshlet);
+
+   MSH_FreeMeshletBuilder(&builder);
+
+   // the bounds were worst cases, give back what wasn't used
+   if (data.meshlet_count == 0)
+   {
+      Mesh_FreeMeshlets(&data);
+
+      return data;
+   }
+
+   Meshlet* meshlets = realloc(data.meshlets, sizeof(Meshlet) * (uS)data.meshlet_count);
+   u32* vertices = realloc(data.vertices, sizeof(u32) * (uS)data.vertex_count);
+   u8* triangles = realloc(data.triangles, (uS)data.triangle_count * 3);
+
+   data.meshlets = (meshlets != NULL) ? meshlets : data.meshlets;
+   data.vertices = (vertices != NULL) ? vertices : data.vertices;
+   data.triangles = (triangles != NULL) ? triangles : data.triangles;
+
+   return data;
+}
+
+void Mesh_FreeMeshlets(MeshletData* meshlets)
+{
+   if (meshlets == NULL)
+      return;
+
+   free(meshlets->meshlets);
+   free(meshlets->vertices);
+   free(meshlets->triangles);
+
+   (*meshlets) = (MeshletData){ 0 };
+
+}
+
+static void MSH_BuildModelMeshlets(void* user_data, u32 start, u32 end, u32 worker_id)
+{
+   MSH_MeshletJob* job = (MSH_MeshletJob*)user_data;
+
+   for (u32 mesh_i = start; mesh_i < end; mesh_i++)
+      job->results[mesh_i] = Mesh_BuildMeshlets(job->model->meshes[mesh_i]);
+
+}
+
+bool Model_BuildMeshlets(Model* model, JobPool* jobs)
+{
+   if (model == NULL || model->meshes == NULL || model->mesh_count == 0)
+      return false;
+
+   MeshletData* results = calloc((uS)model->mesh_count, sizeof(MeshletData));
+   if (results == NULL)
+      return false;
+
+   MSH_MeshletJob job = { .model = model, .results = results };
+   Util_ParallelFor(jobs, model->mesh_count, 1, MSH_BuildModelMeshlets, &job);
+
+   MeshletData gathered = { 0 };
+   u32 meshlet_count = 0;
+   u32 vertex_count = 0;
+   u32 triangle_count = 0;
+
+   for (u32 mesh_i = 0; mesh_i < model->mesh_count; mesh_i++)
+   {
+      meshlet_count += results[mesh_i].meshlet_count;
+      vertex_count += results[mesh_i].vertex_count;
+      triangle_count += results[mesh_i].triangle_count;
+
+   }
+
+   bool is_ok = true;
+   if (meshlet_count > 0)
+   {
+      gathered.meshlets = malloc(sizeof(Meshlet) * (uS)meshlet_count);
+      gathered.vertices = malloc(sizeof(u32) * (uS)vertex_count);
+      gathered.triangles = malloc((uS)triangle_count * 3);
+
+      is_ok = (gathered.meshlets != NULL && gathered.vertices != NULL && gathered.triangles != NULL);
+
+   }
+
+   for (u32 mesh_i = 0; mesh_i < model->mesh_count && is_ok; mesh_i++)
+   {
+      MeshletData* result = &results[mesh_i];
+
+      model->meshes[mesh_i].first_meshlet = gathered.meshlet_count;
+      model->meshes[mesh_i].meshlet_count = result->meshlet_count;
+
+      for (u32 meshlet_i = 0; meshlet_i < result->meshlet_count; meshlet_i++)
+      {
+         Meshlet meshlet = result->meshlets[meshlet_i];
+         meshlet.vertex_offset += gathered.vertex_count;
+         meshlet.triangle_offset += gathered.triangle_count;
+
+         gathered.meshlets[gathered.meshlet_count + meshlet_i] = meshlet;
+
+      }
+
+      if (result->meshlet_count > 0)
+      {
+         memcpy(gathered.vertices + gathered.vertex_count, result->vertices, sizeof(u32) * (uS)result->vertex_count);
+         memcpy(gathered.triangles + (uS)gathered.triangle_count * 3, result->triangles, (uS)result->triangle_count * 3);
+
+      }
+
+      gathered.meshlet_count += result->meshlet_count;
+      gathered.vertex_count += result->vertex_count;
+      gathered.triangle_count += result->triangle_count;
+
+   }
+
+   for (u32 mesh_i = 0; mesh_i < model->mesh_count; mesh_i++)
+      Mesh_FreeMeshlets(&results[mesh_i]);
+
+   free(results);
+
+   if (!is_ok)
+   {
+      Mesh_FreeMeshlets(&gathered);
+
+      return false;
+   }
+
+   Mesh_FreeMeshlets(&model->meshlets);
+   model->meshlets = gathered;
+
+   return true;
+}
@@ -1,6 +1,5 @@
 #include "util/types.h"
 #include "util/extra_types.h"
-#include "util/array.h"
 #include "util/files.h"
 #include "util/math.h"
 
@@ -10,7 +9,6 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
 
 void Model_Free(Model* model)
 {
@@ -34,45 +32,34 @@ void Model_Free(Model* model)
 
    }
 
-   if (model->materials != NULL)
-   {
-      for (u32 material_i = 0; material_i < model->material_count; material_i++)
-      {
-         Material material = model->materials[material_i];
-         if (material.name != NULL)
-            free((char*)material.name);
-
-         if (material.surface_name != NULL)
-            free((char*)material.surface_name);
-
-         for (u32 tex_i = 0; tex_i < MATERIAL_MAX_TEXTURES; tex_i++)
-         {
-            if (material.texture_strings[tex_i] != NULL)
-               free((char*)material.texture_strings[tex_i]);
-
-         }
-
-         for (u32 param_i = 0; param_i < MATERIAL_MAX_PARAMS; param_i++)
-         {
-            if (material.parameter[param_i].key != NULL)
-               free((char*)material.parameter[param_i].key);
+   MSH_FreeMaterials(model);
 
-         }
-
-      }
-
-      free(model->materials);
-      model->materials = NULL;
+   if (model->lods != NULL)
+   {
+      free(model->lods);
+      model->lods = NULL;
 
    }
 
+   Mesh_FreeMeshlets(&model->meshlets);
+   Util_UnmapFile(&model->source);
+
    model->mesh_count = 0;
    model->material_count = 0;
+   model->lod_count = 0;
 
 }
 
 void Mesh_Free(Mesh* mesh)
 {
+   if (mesh->is_borrowed)
+   {
+      mesh->vertex_buffer = NULL;
+      mesh->index_buffer = NULL;
+      mesh->is_borrowed = false;
+
+   }
+
    if (mesh->vertex_buffer != NULL)
    {
       free(mesh->vertex_buffer);
@@ -121,427 +108,106 @@ u32 Mesh_GetIndexFromBuffer(Mesh mesh, u32 at_index)
    return ((u32*)mesh.index_buffer)[at_index];
 }
 
-Mesh Mesh_LoadEctorMesh(memblob memory)
-{
-   return MSH_ParseEctorMesh(memory, NULL);
-}
-
-Model Mesh_LoadEctorModel(memblob memory)
+bool Mesh_MakeOwned(Mesh* mesh)
 {
-   if ((memory.data == NULL) || (memory.size < sizeof(MSH_ModelHeader)))
-      return (Model){ 0 };
+   if (mesh == NULL || !mesh->is_borrowed)
+      return true;
 
-   void* read_head = memory.data;
-   uS size_left = memory.size - sizeof(MSH_ModelHeader);
+   uS vertex_size = MSH_VertexSize(mesh->attributes, mesh->attribute_count) * (uS)mesh->vertex_count;
+   uS index_size = ((mesh->index_type == MESH_INDEXTYPE_16BIT) ? sizeof(u16) : sizeof(u32)) * (uS)mesh->index_count;
 
-   MSH_ModelHeader model_header = { 0 };
-   READ_HEAD(read_head, model_header, MSH_ModelHeader);
+   u8* vertex_buffer = (mesh->vertex_buffer != NULL) ? malloc(vertex_size) : NULL;
+   void* index_buffer = (mesh->index_buffer != NULL) ? malloc(index_size) : NULL;
 
-   if (model_header.identifier.magic != MODEL_MAGIC_ID || model_header.mesh_count == 0 || model_header.version != EBMF_VERSION)
-      return (Model){ 0 };
-
-   Model model = {
-      .version = model_header.version,
-      .root_bone_id = model_header.root_bone_id,
-      .node_count = model_header.node_count,
-      .mesh_count = model_header.mesh_count,
-      .material_count = model_header.material_count
-   };
-
-   model.meshes = calloc((uS)model.mesh_count, sizeof(Mesh));
-   model.nodes = (model.node_count > 0) ? calloc((uS)model.node_count, sizeof(Node)) : NULL;
-   model.materials = (model.material_count > 0) ? calloc((uS)model.material_count, sizeof(Material)) : NULL;
-
-   for (u32 node_i = 0; node_i < model.node_count; node_i++)
+   if ((mesh->vertex_buffer != NULL && vertex_buffer == NULL) || (mesh->index_buffer != NULL && index_buffer == NULL))
    {
-      uS name_length = strnlen(read_head, EBMF_NODE_NAME_MAX);
-
-      model.nodes[node_i].name = malloc(name_length + 1);
-      memcpy(model.nodes[node_i].name, read_head, name_length + 1);
-
-      size_left -= name_length + 1;
-      read_head = ((u8*)read_head) + name_length + 1;
-
-      READ_HEAD(read_head, model.nodes[node_i].transform, Transform3D);
-      READ_HEAD(read_head, model.nodes[node_i].child_count, u32);
-      READ_HEAD(read_head, model.nodes[node_i].parent_id, i16);
-      READ_HEAD(read_head, model.nodes[node_i].prev_sibling_id, i16);
-      READ_HEAD(read_head, model.nodes[node_i].next_sibling_id, i16);
-      READ_HEAD(read_head, model.nodes[node_i].root_child_id, i16);
-
-      size_left -= sizeof(Transform3D) + 12;
+      free(vertex_buffer);
+      free(index_buffer);
 
+      return false;
    }
 
-   for (u32 mesh_i = 0; mesh_i < model.mesh_count; mesh_i++)
-   {
-      uS mesh_size = 0;
-      model.meshes[mesh_i] = MSH_ParseEctorMesh((memblob){ read_head, size_left }, &mesh_size);
+   if (vertex_buffer != NULL)
+      memcpy(vertex_buffer, mesh->vertex_buffer, vertex_size);
 
-      size_left -= mesh_size;
-      read_head = ((u8*)read_head) + mesh_size;
+   if (index_buffer != NULL)
+      memcpy(index_buffer, mesh->index_buffer, index_size);
 
-   }
+   mesh->vertex_buffer = vertex_buffer;
+   mesh->index_buffer = index_buffer;
+   mesh->is_borrowed = false;
 
-   return model;
+   return true;
 }
 
-void Mesh_ParseEctorMaterials(memblob memory, Model* inout_model)
+void Mesh_CalculateBounds(Mesh* mesh)
 {
-   if (memory.data == NULL || memory.size == 0 || inout_model == NULL)
+   if (mesh == NULL)
       return;
 
-   if (inout_model->materials == NULL)
-      inout_model->materials = calloc(inout_model->material_count, sizeof(Material));
-
-   uS char_offset = 0;
-   u32 material_count = 0;
-   while (true)
-   {
-      Material material = MSH_ParseNextMaterial(memory, &char_offset);
-      if (material.name == NULL)
-         break;
-
-      u32 index = (material.id == INVALID_HANDLE_ID) ? material_count : material.id;
-      material_count = index + 1;
-
-      if (material_count > inout_model->material_count)
-      {
-         Material* tmp = realloc(inout_model->materials, material_count * sizeof(Material));
-         if (tmp == NULL)
-            break;
+   mesh->bounds = (BBox){ 0 };
+   mesh->bounding_sphere = (vec4){ 0 };
 
-         inout_model->materials = tmp;
-
-      }
-
-      inout_model->materials[index] = material;
-
-   }
-
-   inout_model->material_count = M_MAX(material_count, inout_model->material_count);
-
-}
-
-Material MSH_ParseNextMaterial(memblob memory, uS* char_offset)
-{
-   if (memory.data == NULL || memory.size == 0 || char_offset == NULL)
-      return (Material){ .name = NULL };
-
-   char* read_head = (char*)memory.data + (*char_offset);
-   uS read_size = memory.size - (*char_offset);
+   if (mesh->vertex_buffer == NULL || mesh->vertex_count == 0 || mesh->attribute_count == 0 || mesh->attributes[0] != MESH_ATTRIBUTE_3_CHANNEL)
+      return;
 
-   uS buffer_size = 0;
-   MSH_MatToken* tokens = MSH_TokenizeMaterial((memblob){ read_head, read_size }, &buffer_size);
+   vec3* position = (vec3*)mesh->vertex_buffer;
+   vec3 min_vertex = position[0];
+   vec3 max_vertex = position[0];
 
-   if (tokens == NULL || Util_ArrayLength(tokens) == 0)
+   for (u32 vert_i = 1; vert_i < mesh->vertex_count; vert_i++)
    {
-      FREE_ARRAY(tokens);
+      min_vertex = Util_MinVec3(min_vertex, position[vert_i]);
+      max_vertex = Util_MaxVec3(max_vertex, position[vert_i]);
 
-      return (Material){ .name = NULL };
    }
 
-   (*char_offset) += buffer_size;
-
-   bool in_material = false;
-   bool in_id = false;
-   bool in_surf = false;
-   bool in_tex = false;
-   bool in_param = false;
-   bool has_start = false;
-
-   u32 arg_count = 0;
-   u32 param_count = 0;
-   bool param_is_float = false;
-   i32 tex_slot = 0;
-
-   Material material = {
-      .name = NULL,
-      .id = INVALID_HANDLE_ID
-   };
-
-   for (u32 token_i = 0; token_i < Util_ArrayLength(tokens); token_i++)
-   {
-      MSH_MatToken token = tokens[token_i];
-
-      if (token.token_type == MSH_MATTOK_INVALID)
-      {
-         Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_ERROR }, "Encountered invalid token! Material parsing failed.");
-
-         break;
-      }
-
-      bool mat_scope = in_material && !in_id && !in_surf && !in_tex && !in_param;
-
-      switch (token.token_type)
-      {
-         case MSH_MATTOK_VALID_STRING: {
-            if (!in_material && material.name == NULL)
-               material.name = MSH_CopyTokenString(token);
-            else {
-               if (in_id)
-               {
-                  if (arg_count >= 1)
-                     Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_WARN }, "Material 'id' only takes 1 argument!");
-                  else {
-                     token.token_start[token.token_size] = 0;
-                     material.id = strtol(token.token_start, NULL, 10);
-
-                  }
-
-               }
-
-               if (in_surf)
-               {
-                  if (arg_count >= 1)
-                     Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_WARN }, "Material 'surf' only takes 1 argument!");
-                  else
-                     material.surface_name = MSH_CopyTokenString(token);
-
-               }
-
-               if (in_tex)
-               {
-                  if (arg_count >= 2)
-                     Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_WARN }, "Material 'tex' only takes 2 arguments!");
-                  else {
-                     if (arg_count == 0)
-                     {
-                        token.token_start[token.token_size] = 0;
-                        tex_slot = strtol(token.token_start, NULL, 10);
-
-                     } else
-                        material.texture_strings[tex_slot] = MSH_CopyTokenString(token);
-
-                  }
-
-               }
-
-               if (in_param)
-               {
-                  if (arg_count >= 6)
-                     Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_WARN }, "Material 'param' only takes up to 6 arguments!");
-                  else {
-                     if (arg_count == 0)
-                        material.parameter[param_count].key = MSH_CopyTokenString(token);
-                     else if (arg_count == 1)
-                        param_is_float = (token.token_start[0] == 'f');
-                     else {
-                        u32 param_idx = M_CLAMP(arg_count - 2, 0, 3);
-
-                        token.token_start[token.token_size] = 0;
-                        if (param_is_float)
-                        {
-                           material.parameter[param_count].type = MAT_PARAMTYPE_F32;
-                           material.parameter[param_count].value.as_f32[param_idx] = strtof(token.token_start, NULL);
-
-                        } else {
-                           material.parameter[param_count].type = MAT_PARAMTYPE_I32;
-                           material.parameter[param_count].value.as_i32[param_idx] = strtol(token.token_start, NULL, 10);
-
-                        }
-
-                        material.parameter[param_count].count++;
-
-                     }
-
-                  }
-
-               }
-
-               arg_count++;
-
-               if (mat_scope)
-               {
-                  if (strncmp(token.token_start, "id", token.token_size) == 0)
-                     in_id = true;
-                  else if (strncmp(token.token_start, "surf", token.token_size) == 0)
-                     in_surf = true;
-                  else if (strncmp(token.token_start, "tex", token.token_size) == 0)
-                     in_tex = true;
-                  else if (strncmp(token.token_start, "param", token.token_size) == 0)
-                     in_param = true;
-                  else
-                     Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_WARN }, "Unrecognized keyword \"%.*s\"", (i32)token.token_size, token.token_start);
-
-                  arg_count = 0;
-
-               }
+   vec3 center = Util_ScaleVec3(Util_AddVec3(min_vertex, max_vertex), 0.5f);
 
-            }
+   // centered on the box, but the radius comes from the vertices so it's tighter than the box's corners
+   f32 radius_sqr = 0.0f;
+   for (u32 vert_i = 0; vert_i < mesh->vertex_count; vert_i++)
+      radius_sqr = M_MAX(radius_sqr, Util_MagSqrVec3(Util_SubVec3(position[vert_i], center)));
 
-         } break;
-
-         case MSH_MATTOK_END_LINE: {
-            if (in_material)
-            {
-               if (in_param)
-                  param_count++;
+   mesh->bounds = (BBox){ center, Util_ScaleVec3(Util_SubVec3(max_vertex, min_vertex), 0.5f) };
+   mesh->bounding_sphere = VEC4(center.x, center.y, center.z, sqrtf(radius_sqr));
 
-               in_id = false;
-               in_surf = false;
-               in_tex = false;
-               in_param = false;
-
-            }
-
-         } break;
-
-         case MSH_MATTOK_START: {
-            has_start = true;
-
-            if (in_material)
-               Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_WARN }, "Misplaced open bracket!");
-            else if (material.name == NULL)
-               Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_WARN }, "Materials require names!");
-            else
-               in_material = true;
-
-         } break;
-
-         case MSH_MATTOK_STOP: {
-            if (!in_material && !has_start)
-               Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_WARN }, "Misplaced closing bracket!");
-            else
-               in_material = false;
-
-         } break;
-
-         default:
-            break;
-      }
-
-   }
-
-   if (in_material)
-      Util_Log(NULL, "Mesh", (error){ .general = ERR_LEVEL_WARN }, "Missing closing bracket!");
-
-   FREE_ARRAY(tokens);
-
-   return material;
 }
 
-MSH_MatToken* MSH_TokenizeMaterial(memblob memory, uS* out_buffer_size)
+Mesh Mesh_LoadEctorMesh(memblob memory)
 {
-   if (memory.data == NULL || memory.size == 0)
-      return NULL;
-
-   (*out_buffer_size) = 0;
-
-   char* read_head = (char*)memory.data;
-   MSH_MatToken* tokens = NEW_ARRAY(MSH_MatToken);
-   uS space_count = 0;
-
-   MSH_MatToken new_token = { .token_start = NULL };
-   while ((*out_buffer_size) < memory.size)
-   {
-      char* prev_head = read_head;
-      char head = (*prev_head);
-      read_head++;
-      (*out_buffer_size)++;
-
-      MSH_MatTokenType token_type = MSH_MATTOK_INVALID;
-      u32 token_size = new_token.token_size;
-
-      if (head == '#')
-      {
-         new_token.token_type = MSH_MATTOK_COMMENT;
-         new_token.token_size = 0;
-
-      }
-
-      if (new_token.token_type == MSH_MATTOK_COMMENT)
-      {
-         new_token.token_size++;
-
-         if (head == '\n')
-         {
-            ADD_BACK_ARRAY(tokens, new_token);
-
-            new_token.token_type = MSH_MATTOK_INVALID;
-            new_token.token_size = 0;
-
-         }
-
-         continue;
-      }
-
-      if (isspace(head) || iscntrl(head))
-      {
-         space_count++;
-
-         continue;
-      }
-
-      bool is_seperator = (head == '=' || head == ',');
-
-      if (!is_seperator && (isalnum(head) || ispunct(head)) && head != '{' && head != '}')
-      {
-         token_type = MSH_MATTOK_VALID_STRING;
-         token_size++;
-
-         if (new_token.token_type != token_type)
-            space_count = 0;
-
-      }
-
-      switch (head)
-      {
-         case ';': {
-            token_type = MSH_MATTOK_END_LINE;
-            token_size = 1;
-
-         } break;
-
-         case '{': {
-            token_type = MSH_MATTOK_START;
-            token_size = 1;
-
-         } break;
-
-         case '}': {
-            token_type = MSH_MATTOK_STOP;
-            token_size = 1;
-
-         } break;
-
-         default:
-            break;
-      }
-
-      if (new_token.token_type == MSH_MATTOK_VALID_STRING && token_type != new_token.token_type)
-         ADD_BACK_ARRAY(tokens, new_token);
-
-      if (token_type != MSH_MATTOK_VALID_STRING)
-      {
-         new_token.token_type = token_type;
-         new_token.token_size = token_size;
-         new_token.token_start = prev_head;
-
-         if (!is_seperator)
-            ADD_BACK_ARRAY(tokens, new_token);
-
-         new_token.token_size = 0;
+   return MSH_ParseEctorMesh(memory, NULL, false);
+}
 
-         if (token_type == MSH_MATTOK_STOP)
-            break;
+Model Mesh_LoadEctorModel(memblob memory)
+{
+   return MSH_ParseEctorModel(memory, (MeshLoadDesc){ 0 }, false, NULL);
+}
 
-      } else {
-         if (new_token.token_type != token_type)
-            new_token.token_start = prev_head;
+Model Mesh_LoadEctorModelParallel(memblob memory, MeshLoadDesc desc, JobPool* jobs)
+{
+   return MSH_ParseEctorModel(memory, desc, false, jobs);
+}
 
-         new_token.token_type = token_type;
-         new_token.token_size = token_size + space_count;
-         space_count = 0;
+Model Mesh_LoadEctorModelMapped(MmapBlob mapping)
+{
+   return Mesh_LoadEctorModelMappedParallel(mapping, (MeshLoadDesc){ 0 }, NULL);
+}
 
-      }
+Model Mesh_LoadEctorModelMappedParallel(MmapBlob mapping, MeshLoadDesc desc, JobPool* jobs)
+{
+   Model model = MSH_ParseEctorModel((memblob){ mapping.data, mapping.size }, desc, true, jobs);
 
-   }
+   // nothing points into it if parsing failed
+   if (model.meshes == NULL)
+      Util_UnmapFile(&mapping);
+   else
+      model.source = mapping;
 
-   return tokens;
+   return model;
 }
 
-Mesh MSH_ParseEctorMesh(memblob memory, uS* mesh_size)
+Mesh MSH_ParseEctorMesh(memblob memory, uS* mesh_size, bool is_borrowed)
 {
    if ((memory.data == NULL) || (memory.size < sizeof(MSH_MeshHeader)))
       return (Mesh){ 0 };
@@ -563,58 +229,44 @@ Mesh MSH_ParseEctorMesh(memblob memory, uS* mesh_size)
       .index_type = (high_precision_idx) ? MESH_INDEXTYPE_32BIT : MESH_INDEXTYPE_16BIT
    };
 
-   uS index_size = mesh_header.index_count * ((high_precision_idx) ? sizeof(u32) : sizeof(u16));
-   uS vertex_size = 0;
-
-   for (u8 attribute_i = 0; attribute_i < mesh.attribute_count; attribute_i++)
-   {
-      u8 attribute = 0;
-      READ_HEAD(read_head, attribute, u8);
-
-      switch (attribute)
-      {
-         case MESH_ATTRIBUTE_1_CHANNEL:
-         case MESH_ATTRIBUTE_COLOR:
-            vertex_size += 4;
-            break;
-
-         case MESH_ATTRIBUTE_2_CHANNEL:
-            vertex_size += 8;
-            break;
-
-         case MESH_ATTRIBUTE_3_CHANNEL:
-            vertex_size += 12;
-            break;
-
-         case MESH_ATTRIBUTE_4_CHANNEL:
-            vertex_size += 16;
-            break;
-
-         default:
-            break;
-
-      }
-
-      mesh.attributes[attribute_i] = attribute;
+   uS header_size = sizeof(MSH_MeshHeader) + (uS)mesh_header.attribute_count;
+   if (mesh_header.attribute_count > MESH_MAX_ATTRIBUTES || header_size > memory.size)
+      return (Mesh){ 0 };
 
-   }
+   Util_ReadThenMove(&read_head, mesh.attributes, mesh_header.attribute_count);
 
-   vertex_size *= (uS)mesh_header.vertex_count;
+   uS index_size = (uS)mesh_header.index_count * ((high_precision_idx) ? sizeof(u32) : sizeof(u16));
+   uS vertex_size = MSH_VertexSize(mesh.attributes, mesh.attribute_count) * (uS)mesh_header.vertex_count;
 
-   if ((index_size + vertex_size) > memory.size)
+   // borrowed buffers would point past the end of the mapping otherwise
+   if ((index_size + vertex_size) > (memory.size - header_size))
       return (Mesh){ 0 };
 
    mesh.index_count = mesh_header.index_count;
    mesh.vertex_count = mesh_header.vertex_count;
    mesh.primitive = mesh_header.primitive;
 
-   mesh.index_buffer = malloc(index_size);
-   mesh.vertex_buffer = malloc(vertex_size);
+   // v1 files don't pad anything, so a mesh that lands on an odd offset still gets copied
+   uS index_alignment = (high_precision_idx) ? sizeof(u32) : sizeof(u16);
+   bool is_aligned = (((uintptr_t)read_head % index_alignment) == 0) && ((((uintptr_t)read_head + index_size) % sizeof(f32)) == 0);
+
+   if (is_borrowed && is_aligned)
+   {
+      mesh.index_buffer = read_head;
+      mesh.vertex_buffer = (u8*)read_head + index_size;
+      mesh.is_borrowed = true;
+
+   } else {
+      mesh.index_buffer = malloc(index_size);
+      mesh.vertex_buffer = malloc(vertex_size);
+
+      Util_ReadThenMove(&read_head, mesh.index_buffer, index_size);
+      Util_ReadThenMove(&read_head, mesh.vertex_buffer, vertex_size);
 
-   Util_ReadThenMove(&read_head, mesh.index_buffer, index_size);
-   Util_ReadThenMove(&read_head, mesh.vertex_buffer, vertex_size);
+   }
 
-   *mesh_size = sizeof(MSH_MeshHeader) + (uS)mesh_header.attribute_count + index_size + vertex_size;
+   if (mesh_size != NULL)
+      *mesh_size = header_size + index_size + vertex_size;
 
    return mesh;
 }
@@ -0,0 +1,403 @@
+#include "util/math.h"
+#include "util/types.h"
+#include "util/vec3.h"
+#include "util/jobs.h"
+#include "util/simd.h"
+
+#include "mesh/internal.h"
+#include "mesh.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// triangles handed to a worker at a time, and how many of those get their indices unpacked in one go
+#define MSH_TRIANGLE_GRAIN_SIZE 4096u
+#define MSH_VERTEX_GRAIN_SIZE 4096u
+#define MSH_TRIANGLE_BATCH 64u
+
+typedef struct MSH_TangentFrameJob_t
+{
+   Mesh mesh;
+   vec3* position;
+   vec2* texcoord;
+   vec3* normal;
+   vec4* tangent;
+
+   // per corner for normals (every corner gets its own weight), per triangle for tangents
+   vec3* face_normal;
+   vec3* face_tangent;
+   vec3* face_bitangent;
+
+   // corners that touch each vertex, so every vertex can sum its own faces without fighting over writes
+   u32* vertex_start;
+   u32* vertex_corners;
+
+} MSH_TangentFrameJob;
+
+static inline f32x4 MSH_Cross4(f32x4 a_y, f32x4 a_z, f32x4 b_y, f32x4 b_z)
+{
+   return Util_Sub4(Util_Mul4(a_y, b_z), Util_Mul4(a_z, b_y));
+}
+
+// the index type check happens once per batch instead of once per index
+static void MSH_UnpackTriangleIndices(Mesh mesh, u32 first_triangle, u32 triangle_count, u32* out_indices)
+{
+   u32 first_index = first_triangle * 3;
+   u32 index_count = triangle_count * 3;
+
+   if (mesh.index_buffer == NULL)
+   {
+      for (u32 idx_i = 0; idx_i < index_count; idx_i++)
+         out_indices[idx_i] = first_index + idx_i;
+
+   } else if (mesh.index_type == MESH_INDEXTYPE_16BIT) {
+      u16* index_buffer = (u16*)mesh.index_buffer + first_index;
+      for (u32 idx_i = 0; idx_i < index_count; idx_i++)
+         out_indices[idx_i] = index_buffer[idx_i];
+
+   } else {
+      memcpy(out_indices, (u32*)mesh.index_buffer + first_index, sizeof(u32) * (uS)index_count);
+
+   }
+
+}
+
+// positions are gathered into lanes, so the math runs on 4 triangles at once. a short batch repeats its last triangle
+static void MSH_GatherTriangles(MSH_TangentFrameJob* job, const u32* indices, u32 batch_count, f32 out_p[3][3][4], f32 out_uv[3][2][4])
+{
+   for (u32 lane = 0; lane < 4; lane++)
+   {
+      const u32* tri = indices + M_MIN(lane, batch_count - 1) * 3;
+
+      for (u32 corner = 0; corner < 3; corner++)
+      {
+         vec3 p = job->position[tri[corner]];
+         out_p[corner][0][lane] = p.x;
+         out_p[corner][1][lane] = p.y;
+         out_p[corner][2][lane] = p.z;
+
+         if (out_uv != NULL)
+         {
+            vec2 uv = job->texcoord[tri[corner]];
+            out_uv[corner][0][lane] = uv.x;
+            out_uv[corner][1][lane] = uv.y;
+
+         }
+
+      }
+
+   }
+
+}
+
+static void MSH_FaceNormals(void* user_data, u32 start, u32 end, u32 worker_id)
+{
+   MSH_TangentFrameJob* job = (MSH_TangentFrameJob*)user_data;
+   u32 indices[MSH_TRIANGLE_BATCH * 3];
+
+   for (u32 batch_start = start; batch_start < end; batch_start += MSH_TRIANGLE_BATCH)
+   {
+      u32 batch_end = M_MIN(batch_start + MSH_TRIANGLE_BATCH, end);
+      MSH_UnpackTriangleIndices(job->mesh, batch_start, batch_end - batch_start, indices);
+
+      for (u32 tri_i = batch_start; tri_i < batch_end; tri_i += 4)
+      {
+         u32 lane_count = M_MIN(4u, batch_end - tri_i);
+
+         f32 p[3][3][4];
+         MSH_GatherTriangles(job, indices + (tri_i - batch_start) * 3, lane_count, p, NULL);
+
+         f32x4 a_x = Util_Load4(p[0][0]), a_y = Util_Load4(p[0][1]), a_z = Util_Load4(p[0][2]);
+         f32x4 b_x = Util_Load4(p[1][0]), b_y = Util_Load4(p[1][1]), b_z = Util_Load4(p[1][2]);
+         f32x4 c_x = Util_Load4(p[2][0]), c_y = Util_Load4(p[2][1]), c_z = Util_Load4(p[2][2]);
+
+         f32x4 ba_x = Util_Sub4(b_x, a_x), ba_y = Util_Sub4(b_y, a_y), ba_z = Util_Sub4(b_z, a_z);
+         f32x4 ca_x = Util_Sub4(c_x, a_x), ca_y = Util_Sub4(c_y, a_y), ca_z = Util_Sub4(c_z, a_z);
+         f32x4 cb_x = Util_Sub4(c_x, b_x), cb_y = Util_Sub4(c_y, b_y), cb_z = Util_Sub4(c_z, b_z);
+
+         // unnormalized, so bigger faces pull harder
+         f32x4 n_x = MSH_Cross4(ba_y, ba_z, ca_y, ca_z);
+         f32x4 n_y = MSH_Cross4(ba_z, ba_x, ca_z, ca_x);
+         f32x4 n_z = MSH_Cross4(ba_x, ba_y, ca_x, ca_y);
+
+         // same corner weights as before: dot(b - a, c - a), dot(c - b, a - b) and dot(a - c, b - c)
+         f32x4 bias = Util_Splat4(0.0001f);
+         f32x4 weight[3];
+         weight[0] = Util_Add4(Util_Add4(Util_Add4(Util_Mul4(ba_x, ca_x), Util_Mul4(ba_y, ca_y)), Util_Mul4(ba_z, ca_z)), bias);
+         weight[1] = Util_Add4(Util_Sub4(Util_Splat4(0.0f), Util_Add4(Util_Add4(Util_Mul4(cb_x, ba_x), Util_Mul4(cb_y, ba_y)), Util_Mul4(cb_z, ba_z))), bias);
+         weight[2] = Util_Add4(Util_Add4(Util_Add4(Util_Mul4(ca_x, cb_x), Util_Mul4(ca_y, cb_y)), Util_Mul4(ca_z, cb_z)), bias);
+
+         for (u32 corner = 0; corner < 3; corner++)
+         {
+            f32 out[3][4];
+            Util_Store4(out[0], Util_Mul4(n_x, weight[corner]));
+            Util_Store4(out[1], Util_Mul4(n_y, weight[corner]));
+            Util_Store4(out[2], Util_Mul4(n_z, weight[corner]));
+
+            for (u32 lane = 0; lane < lane_count; lane++)
+               job->face_normal[(tri_i + lane) * 3 + corner] = VEC3(out[0][lane], out[1][lane], out[2][lane]);
+
+         }
+
+      }
+
+   }
+
+   (void)worker_id;
+
+}
+
+static void MSH_FaceTangents(void* user_data, u32 start, u32 end, u32 worker_id)
+{
+   MSH_TangentFrameJob* job = (MSH_TangentFrameJob*)user_data;
+   u32 indices[MSH_TRIANGLE_BATCH * 3];
+
+   for (u32 batch_start = start; batch_start < end; batch_start += MSH_TRIANGLE_BATCH)
+   {
+      u32 batch_end = M_MIN(batch_start + MSH_TRIANGLE_BATCH, end);
+      MSH_UnpackTriangleIndices(job->mesh, batch_start, batch_end - batch_start, indices);
+
+      for (u32 tri_i = batch_start; tri_i < batch_end; tri_i += 4)
+      {
+         u32 lane_count = M_MIN(4u, batch_end - tri_i);
+
+         f32 p[3][3][4];
+         f32 uv[3][2][4];
+         MSH_GatherTriangles(job, indices + (tri_i - batch_start) * 3, lane_count, p, uv);
+
+         f32x4 x1 = Util_Sub4(Util_Load4(p[1][0]), Util_Load4(p[0][0]));
+         f32x4 x2 = Util_Sub4(Util_Load4(p[2][0]), Util_Load4(p[0][0]));
+         f32x4 y1 = Util_Sub4(Util_Load4(p[1][1]), Util_Load4(p[0][1]));
+         f32x4 y2 = Util_Sub4(Util_Load4(p[2][1]), Util_Load4(p[0][1]));
+         f32x4 z1 = Util_Sub4(Util_Load4(p[1][2]), Util_Load4(p[0][2]));
+         f32x4 z2 = Util_Sub4(Util_Load4(p[2][2]), Util_Load4(p[0][2]));
+
+         f32x4 s1 = Util_Sub4(Util_Load4(uv[1][0]), Util_Load4(uv[0][0]));
+         f32x4 s2 = Util_Sub4(Util_Load4(uv[2][0]), Util_Load4(uv[0][0]));
+         f32x4 t1 = Util_Sub4(Util_Load4(uv[1][1]), Util_Load4(uv[0][1]));
+         f32x4 t2 = Util_Sub4(Util_Load4(uv[2][1]), Util_Load4(uv[0][1]));
+
+         f32x4 r = Util_Div4(Util_Splat4(1.0f), Util_Sub4(Util_Mul4(s1, t2), Util_Mul4(s2, t1)));
+
+         f32 s_dir[3][4];
+         Util_Store4(s_dir[0], Util_Mul4(Util_Sub4(Util_Mul4(t2, x1), Util_Mul4(t1, x2)), r));
+         Util_Store4(s_dir[1], Util_Mul4(Util_Sub4(Util_Mul4(t2, y1), Util_Mul4(t1, y2)), r));
+         Util_Store4(s_dir[2], Util_Mul4(Util_Sub4(Util_Mul4(t2, z1), Util_Mul4(t1, z2)), r));
+
+         f32 t_dir[3][4];
+         Util_Store4(t_dir[0], Util_Mul4(Util_Sub4(Util_Mul4(s1, x2), Util_Mul4(s2, x1)), r));
+         Util_Store4(t_dir[1], Util_Mul4(Util_Sub4(Util_Mul4(s1, y2), Util_Mul4(s2, y1)), r));
+         Util_Store4(t_dir[2], Util_Mul4(Util_Sub4(Util_Mul4(s1, z2), Util_Mul4(s2, z1)), r));
+
+         for (u32 lane = 0; lane < lane_count; lane++)
+         {
+            job->face_tangent[tri_i + lane] = VEC3(s_dir[0][lane], s_dir[1][lane], s_dir[2][lane]);
+            job->face_bitangent[tri_i + lane] = VEC3(t_dir[0][lane], t_dir[1][lane], t_dir[2][lane]);
+
+         }
+
+      }
+
+   }
+
+   (void)worker_id;
+
+}
+
+static void MSH_SumVertexNormals(void* user_data, u32 start, u32 end, u32 worker_id)
+{
+   MSH_TangentFrameJob* job = (MSH_TangentFrameJob*)user_data;
+
+   for (u32 vert_i = start; vert_i < end; vert_i++)
+   {
+      vec3 sum = { 0 };
+      for (u32 slot_i = job->vertex_start[vert_i]; slot_i < job->vertex_start[vert_i + 1]; slot_i++)
+         sum = Util_AddVec3(sum, job->face_normal[job->vertex_corners[slot_i]]);
+
+      job->normal[vert_i] = Util_NormalizeVec3(sum);
+
+   }
+
+   (void)worker_id;
+
+}
+
+static void MSH_SumVertexTangents(void* user_data, u32 start, u32 end, u32 worker_id)
+{
+   MSH_TangentFrameJob* job = (MSH_TangentFrameJob*)user_data;
+
+   for (u32 vert_i = start; vert_i < end; vert_i++)
+   {
+      vec3 t = { 0 };
+      vec3 b = { 0 };
+
+      for (u32 slot_i = job->vertex_start[vert_i]; slot_i < job->vertex_start[vert_i + 1]; slot_i++)
+      {
+         u32 tri_i = job->vertex_corners[slot_i] / 3;
+         t = Util_AddVec3(t, job->face_tangent[tri_i]);
+         b = Util_AddVec3(b, job->face_bitangent[tri_i]);
+
+      }
+
+      vec3 n = job->normal[vert_i];
+
+      job->tangent[vert_i].xyz = Util_NormalizeVec3(Util_SubVec3(t, Util_ScaleVec3(n, Util_DotVec3(n, t))));
+      job->tangent[vert_i].w = (Util_DotVec3(Util_CrossVec3(n, t), b) < 0.0f) ? 1.0f : -1.0f;
+
+   }
+
+   (void)worker_id;
+
+}
+
+// counting sort of the corners by the vertex they point at. fails if an index is out of range
+static bool MSH_BuildVertexCorners(MSH_TangentFrameJob* job, u32 vertex_count, u32 corner_count)
+{
+   job->vertex_start = calloc((uS)vertex_count + 1, sizeof(u32));
+   job->vertex_corners = malloc(sizeof(u32) * (uS)M_MAX(corner_count, 1u));
+
+   if (job->vertex_start == NULL || job->vertex_corners == NULL)
+      return false;
+
+   u32 indices[MSH_TRIANGLE_BATCH * 3];
+   u32 triangle_count = corner_count / 3;
+
+   for (u32 pass = 0; pass < 2; pass++)
+   {
+      for (u32 batch_start = 0; batch_start < triangle_count; batch_start += MSH_TRIANGLE_BATCH)
+      {
+         u32 batch_count = M_MIN(MSH_TRIANGLE_BATCH, triangle_count - batch_start);
+         MSH_UnpackTriangleIndices(job->mesh, batch_start, batch_count, indices);
+
+         for (u32 idx_i = 0; idx_i < batch_count * 3; idx_i++)
+         {
+            u32 vert_i = indices[idx_i];
+
+            if (pass == 0 && vert_i >= vertex_count)
+               return false;
+
+            if (pass == 0)
+               job->vertex_start[vert_i + 1]++;
+            else
+               job->vertex_corners[job->vertex_start[vert_i]++] = batch_start * 3 + idx_i;
+
+         }
+
+      }
+
+      // turn the counts into starts before filling, then shift them back after since the fill moved them to the ends
+      if (pass == 0)
+      {
+         for (u32 vert_i = 0; vert_i < vertex_count; vert_i++)
+            job->vertex_start[vert_i + 1] += job->vertex_start[vert_i];
+
+      } else {
+         for (u32 vert_i = vertex_count; vert_i > 0; vert_i--)
+            job->vertex_start[vert_i] = job->vertex_start[vert_i - 1];
+
+         job->vertex_start[0] = 0;
+
+      }
+
+   }
+
+   return true;
+}
+
+static void MSH_FreeTangentFrameJob(MSH_TangentFrameJob* job)
+{
+   free(job->face_normal);
+   free(job->face_tangent);
+   free(job->face_bitangent);
+   free(job->vertex_start);
+   free(job->vertex_corners);
+
+}
+
+static u32 MSH_TriangleCount(Mesh mesh)
+{
+   return ((mesh.index_buffer != NULL) ? mesh.index_count : mesh.vertex_count) / 3;
+}
+
+MeshInterface Mesh_GenNormalsParallel(MeshInterface mesh_interface, JobPool* jobs)
+{
+   if (!Mesh_InterfaceIsValid(mesh_interface, true, false, false, false, false))
+      return mesh_interface; // TODO: error tracking...
+
+   u32 vertex_count = mesh_interface.mesh->vertex_count;
+   u32 triangle_count = MSH_TriangleCount(*mesh_interface.mesh);
+
+   MSH_TangentFrameJob job = { 0 };
+   job.mesh = (*mesh_interface.mesh);
+   job.position = (vec3*)mesh_interface.mesh->vertex_buffer;
+   job.face_normal = malloc(sizeof(vec3) * (uS)M_MAX(triangle_count * 3, 1u));
+
+   // everything that can fail happens before the vertices are touched
+   if (job.face_normal == NULL || !MSH_BuildVertexCorners(&job, vertex_count, triangle_count * 3))
+   {
+      MSH_FreeTangentFrameJob(&job);
+
+      return mesh_interface;
+   }
+
+   Util_ParallelFor(jobs, triangle_count, MSH_TRIANGLE_GRAIN_SIZE, MSH_FaceNormals, &job);
+
+   bool has_texcoord0 = (mesh_interface.atr.texcoord_size[0] != 0);
+   bool has_texcoord1 = (mesh_interface.atr.texcoord_size[1] != 0);
+
+   MeshInterface new_mesh_interface = Mesh_ReallocVertices(vertex_count, true, has_texcoord0, has_texcoord1, false, mesh_interface);
+   if (new_mesh_interface.atr.normal_size != 0)
+   {
+      mesh_interface = new_mesh_interface;
+      job.normal = (vec3*)(mesh_interface.mesh->vertex_buffer + mesh_interface.atr.normal_ofs);
+
+      Util_ParallelFor(jobs, vertex_count, MSH_VERTEX_GRAIN_SIZE, MSH_SumVertexNormals, &job);
+
+   }
+
+   MSH_FreeTangentFrameJob(&job);
+
+   return mesh_interface;
+}
+
+MeshInterface Mesh_GenTangentsParallel(MeshInterface mesh_interface, JobPool* jobs)
+{
+   if (!Mesh_InterfaceIsValid(mesh_interface, true, true, true, false, false))
+      return mesh_interface; // TODO: error tracking...
+
+   u32 vertex_count = mesh_interface.mesh->vertex_count;
+   u32 triangle_count = MSH_TriangleCount(*mesh_interface.mesh);
+
+   bool has_texcoord1 = (mesh_interface.atr.texcoord_size[1] != 0);
+
+   MeshInterface new_mesh_interface = Mesh_ReallocVertices(vertex_count, true, true, has_texcoord1, true, mesh_interface);
+   if (new_mesh_interface.atr.tangent_size == 0)
+      return mesh_interface;
+
+   mesh_interface = new_mesh_interface;
+   u8* vertex_buffer = mesh_interface.mesh->vertex_buffer;
+
+   MSH_TangentFrameJob job = { 0 };
+   job.mesh = (*mesh_interface.mesh);
+   job.position = (vec3*)vertex_buffer;
+   job.texcoord = (vec2*)(vertex_buffer + mesh_interface.atr.texcoord_ofs[0]);
+   job.normal = (vec3*)(vertex_buffer + mesh_interface.atr.normal_ofs);
+   job.tangent = (vec4*)(vertex_buffer + mesh_interface.atr.tangent_ofs);
+   job.face_tangent = malloc(sizeof(vec3) * (uS)M_MAX(triangle_count, 1u));
+   job.face_bitangent = malloc(sizeof(vec3) * (uS)M_MAX(triangle_count, 1u));
+
+   if (job.face_tangent != NULL && job.face_bitangent != NULL && MSH_BuildVertexCorners(&job, vertex_count, triangle_count * 3))
+   {
+      Util_ParallelFor(jobs, triangle_count, MSH_TRIANGLE_GRAIN_SIZE, MSH_FaceTangents, &job);
+      Util_ParallelFor(jobs, vertex_count, MSH_VERTEX_GRAIN_SIZE, MSH_SumVertexTangents, &job);
+
+   } else {
+      memset(job.tangent, 0, mesh_interface.atr.tangent_size);
+
+   }
+
+   MSH_FreeTangentFrameJob(&job);
+
+   return mesh_interface;
+}
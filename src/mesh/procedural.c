@@ -14,17 +14,13 @@
 
 Mesh Mesh_CreatePlane(u32 faces_x, u32 faces_y, vec2 size)
 {
-   Mesh mesh = Mesh_EmptyMeshWithIndexType(MESH_PRIMITIVE_TRIANGLE, MESH_INDEXTYPE_32BIT);
-   mesh.attribute_count = 4;
-   mesh.attributes[0] = MESH_ATTRIBUTE_3_CHANNEL;
-   mesh.attributes[1] = MESH_ATTRIBUTE_3_CHANNEL;
-   mesh.attributes[2] = MESH_ATTRIBUTE_2_CHANNEL;
-   mesh.attributes[3] = MESH_ATTRIBUTE_4_CHANNEL;
-
-   MeshInterface mesh_interface = Mesh_NewInterface(&mesh);
+   MeshBuilder builder = Mesh_CreateBuilder((faces_x + 1) * (faces_y + 1), faces_x * faces_y * 6);
 
    mat4x4 t = Util_ScalingMatrix(VEC3(size.x, 1, size.y));
-   mesh_interface = Mesh_AddQuad(faces_x, faces_y, t, mesh_interface);
+   Mesh_BuilderAddQuad(&builder, faces_x, faces_y, t, VEC4(0, 1, 1, 0));
+
+   Mesh mesh = { 0 };
+   Mesh_FinishBuilder(&builder, &mesh);
 
    return mesh;
 }
@@ -36,14 +32,10 @@ Mesh Mesh_CreateBox(u32 faces_x, u32 faces_y, u32 faces_z, vec3 size)
 
 Mesh Mesh_CreateBoxAdvanced(u32 faces_x, u32 faces_y, u32 faces_z, vec3 size, bool smooth_seams)
 {
-   Mesh mesh = Mesh_EmptyMeshWithIndexType(MESH_PRIMITIVE_TRIANGLE, MESH_INDEXTYPE_32BIT);
-   mesh.attribute_count = 4;
-   mesh.attributes[0] = MESH_ATTRIBUTE_3_CHANNEL;
-   mesh.attributes[1] = MESH_ATTRIBUTE_3_CHANNEL;
-   mesh.attributes[2] = MESH_ATTRIBUTE_2_CHANNEL;
-   mesh.attributes[3] = MESH_ATTRIBUTE_4_CHANNEL;
+   u32 vertex_count = 2 * ((faces_x + 1) * (faces_z + 1) + (faces_x + 1) * (faces_y + 1) + (faces_z + 1) * (faces_y + 1));
+   u32 index_count = 12 * (faces_x * faces_z + faces_x * faces_y + faces_z * faces_y);
 
-   MeshInterface mesh_interface = Mesh_NewInterface(&mesh);
+   MeshBuilder builder = Mesh_CreateBuilder(vertex_count, index_count);
 
    mat4x4 s = Util_ScalingMatrix(size);
    mat4x4 t = Util_TranslationMatrix(VEC3(0, 0.5f, 0));
@@ -55,12 +47,16 @@ Mesh Mesh_CreateBoxAdvanced(u32 faces_x, u32 faces_y, u32 faces_z, vec3 size, bo
    mat4x4 t4 = Util_MulMat4(s, Util_MulMat4(Util_MulMat4(Util_RotationMatrix(VEC3(0, 1, 0),150), r), t));
    mat4x4 t5 = Util_MulMat4(s, Util_MulMat4(Util_MulMat4(r, r), t));
 
-   mesh_interface = Mesh_AddQuad(faces_x, faces_z, t0, mesh_interface);
-   mesh_interface = Mesh_AddQuad(faces_x, faces_y, t1, mesh_interface);
-   mesh_interface = Mesh_AddQuad(faces_z, faces_y, t2, mesh_interface);
-   mesh_interface = Mesh_AddQuad(faces_x, faces_y, t3, mesh_interface);
-   mesh_interface = Mesh_AddQuad(faces_z, faces_y, t4, mesh_interface);
-   mesh_interface = Mesh_AddQuad(faces_x, faces_z, t5, mesh_interface);
+   vec4 uv = VEC4(0, 1, 1, 0);
+   Mesh_BuilderAddQuad(&builder, faces_x, faces_z, t0, uv);
+   Mesh_BuilderAddQuad(&builder, faces_x, faces_y, t1, uv);
+   Mesh_BuilderAddQuad(&builder, faces_z, faces_y, t2, uv);
+   Mesh_BuilderAddQuad(&builder, faces_x, faces_y, t3, uv);
+   Mesh_BuilderAddQuad(&builder, faces_z, faces_y, t4, uv);
+   Mesh_BuilderAddQuad(&builder, faces_x, faces_z, t5, uv);
+
+   Mesh mesh = { 0 };
+   MeshInterface mesh_interface = Mesh_FinishBuilder(&builder, &mesh);
 
    if (smooth_seams)
       mesh_interface = Mesh_AverageNormalsOverSeams(mesh_interface);
@@ -70,14 +66,7 @@ Mesh Mesh_CreateBoxAdvanced(u32 faces_x, u32 faces_y, u32 faces_z, vec3 size, bo
 
 Mesh Mesh_CreateSphere(u32 faces, f32 size)
 {
-   Mesh mesh = Mesh_EmptyMeshWithIndexType(MESH_PRIMITIVE_TRIANGLE, MESH_INDEXTYPE_32BIT);
-   mesh.attribute_count = 4;
-   mesh.attributes[0] = MESH_ATTRIBUTE_3_CHANNEL;
-   mesh.attributes[1] = MESH_ATTRIBUTE_3_CHANNEL;
-   mesh.attributes[2] = MESH_ATTRIBUTE_2_CHANNEL;
-   mesh.attributes[3] = MESH_ATTRIBUTE_4_CHANNEL;
-
-   MeshInterface mesh_interface = Mesh_NewInterface(&mesh);
+   MeshBuilder builder = Mesh_CreateBuilder(6 * (faces + 1) * (faces + 1), 6 * faces * faces * 6);
 
    mat4x4 s = Util_ScalingMatrix(Util_FillVec3(size));
    mat4x4 t = Util_TranslationMatrix(VEC3(0, 0.5f, 0));
@@ -89,25 +78,26 @@ Mesh Mesh_CreateSphere(u32 faces, f32 size)
    mat4x4 t4 = Util_MulMat4(s, Util_MulMat4(Util_MulMat4(Util_RotationMatrix(VEC3(0, 1, 0),150), r), t));
    mat4x4 t5 = Util_MulMat4(s, Util_MulMat4(Util_MulMat4(r, r), t));
 
-   mesh_interface = Mesh_AddQuad(faces, faces, t0, mesh_interface);
-   mesh_interface = Mesh_AddQuad(faces, faces, t1, mesh_interface);
-   mesh_interface = Mesh_AddQuad(faces, faces, t2, mesh_interface);
-   mesh_interface = Mesh_AddQuad(faces, faces, t3, mesh_interface);
-   mesh_interface = Mesh_AddQuad(faces, faces, t4, mesh_interface);
-   mesh_interface = Mesh_AddQuad(faces, faces, t5, mesh_interface);
+   vec4 uv = VEC4(0, 1, 1, 0);
+   Mesh_BuilderAddQuad(&builder, faces, faces, t0, uv);
+   Mesh_BuilderAddQuad(&builder, faces, faces, t1, uv);
+   Mesh_BuilderAddQuad(&builder, faces, faces, t2, uv);
+   Mesh_BuilderAddQuad(&builder, faces, faces, t3, uv);
+   Mesh_BuilderAddQuad(&builder, faces, faces, t4, uv);
+   Mesh_BuilderAddQuad(&builder, faces, faces, t5, uv);
 
-   vec3* position = (vec3*)mesh.vertex_buffer;
-   vec3* normal = (vec3*)(mesh.vertex_buffer + mesh_interface.atr.normal_ofs);
-   vec4* tangent = (vec4*)(mesh.vertex_buffer + mesh_interface.atr.tangent_ofs);
-
-   for (u32 vert_i = 0; vert_i < mesh.vertex_count; vert_i++)
+   // the streams are still separate here, so this is cheaper than going through the finished mesh
+   for (u32 vert_i = 0; vert_i < builder.vertex_count; vert_i++)
    {
-      vec3 v_normal = Util_NormalizeVec3(position[vert_i]);
-      position[vert_i] = Util_ScaleVec3(v_normal, size);
-      normal[vert_i] = v_normal;
+      vec3 v_normal = Util_NormalizeVec3(builder.position[vert_i]);
+      builder.position[vert_i] = Util_ScaleVec3(v_normal, size);
+      builder.normal[vert_i] = v_normal;
 
    }
 
+   Mesh mesh = { 0 };
+   MeshInterface mesh_interface = Mesh_FinishBuilder(&builder, &mesh);
+
    Mesh_GenTangents(mesh_interface);
 
    return mesh;
@@ -139,7 +129,8 @@ MSH_RellocAttribute( \
 
 MeshInterface Mesh_ReallocVertices(u32 new_vertex_count, bool use_normal, bool use_texcoord0, bool use_texcoord1, bool use_tangent, MeshInterface mesh_interface)
 {
-   if (mesh_interface.mesh == NULL)
+   // the old buffer gets freed below
+   if (mesh_interface.mesh == NULL || !Mesh_MakeOwned(mesh_interface.mesh))
       return mesh_interface;
 
    uS position_bytes = (uS)new_vertex_count * sizeof(vec3);
@@ -188,41 +179,8 @@ MeshInterface Mesh_ReallocVertices(u32 new_vertex_count, bool use_normal, bool u
    return mesh_interface;
 }
 
-MeshInterface Mesh_AddQuad(u32 faces_x, u32 faces_y, mat4x4 transform, MeshInterface mesh_interface)
-{
-   return Mesh_AddQuadAdvanced(faces_x, faces_y, transform, VEC4(0, 1, 1, 0), mesh_interface);
-}
-
-MeshInterface Mesh_AddQuadAdvanced(u32 faces_x, u32 faces_y, mat4x4 transform, vec4 texture_coords, MeshInterface mesh_interface)
+void MSH_FillQuad(u32 faces_x, u32 faces_y, mat4x4 transform, vec4 texture_coords, u32 first_vertex, vec3* position, vec3* normal, vec2* texcoord, vec4* tangent, u32* indices)
 {
-   if (mesh_interface.mesh == NULL || mesh_interface.mesh->index_type != MESH_INDEXTYPE_32BIT)
-      return mesh_interface;
-
-   u32 vertex_count = (u32)((faces_x + 1) * (faces_y + 1));
-   u32 index_count = (u32)(faces_x * faces_y * 6);
-
-   u32 last_vrt = mesh_interface.mesh->vertex_count;
-   u32 last_idx = mesh_interface.mesh->index_count;
-
-   u32 total_verts = vertex_count + mesh_interface.mesh->vertex_count;
-
-   bool has_texcoord1 = (mesh_interface.atr.texcoord_size[1] != 0);
-
-   MeshInterface new_mesh_interface = Mesh_ReallocVertices(total_verts, true, true, false, true, mesh_interface);
-   u8* vertex_buffer = new_mesh_interface.mesh->vertex_buffer;
-
-   vec3* position = (vec3*)(vertex_buffer + mesh_interface.atr.position_size);
-
-   uS normal_ofs = new_mesh_interface.atr.normal_ofs + mesh_interface.atr.normal_size;
-   uS texcoord0_ofs = new_mesh_interface.atr.texcoord_ofs[0] + mesh_interface.atr.texcoord_size[0];
-   uS tangent_ofs = new_mesh_interface.atr.tangent_ofs + mesh_interface.atr.tangent_size;
-
-   mesh_interface = new_mesh_interface;
-
-   vec3* normal = (vec3*)(vertex_buffer + normal_ofs);
-   vec2* texcoord0 = (vec2*)(vertex_buffer + texcoord0_ofs);
-   vec4* tangent = (vec4*)(vertex_buffer + tangent_ofs);
-
    mat4x4 normal_transform = Util_InverseMat4(Util_TransposeMat4(transform));
 
    vec3 plane_normal = Util_MulMat4Vec4(normal_transform, VEC4(0, 1, 0, 0)).xyz;
@@ -246,7 +204,7 @@ MeshInterface Mesh_AddQuadAdvanced(u32 faces_x, u32 faces_y, mat4x4 transform, v
          vec4 point = VEC4(x - 0.5f, 0, y - 0.5f, 1);
          position[vert_idx] = Util_MulMat4Vec4(transform, point).xyz;
          normal[vert_idx] = plane_normal;
-         texcoord0[vert_idx] = Util_AddVec2(Util_MulVec2(texture_coords.xy, inv_uv_fac), Util_MulVec2(texture_coords.zw, uv_fac));
+         texcoord[vert_idx] = Util_AddVec2(Util_MulVec2(texture_coords.xy, inv_uv_fac), Util_MulVec2(texture_coords.zw, uv_fac));
          tangent[vert_idx] = plane_tangent;
 
          vert_idx++;
@@ -254,103 +212,82 @@ MeshInterface Mesh_AddQuadAdvanced(u32 faces_x, u32 faces_y, mat4x4 transform, v
       }
    }
 
-   uS index_size = (mesh_interface.mesh->index_type == MESH_INDEXTYPE_16BIT) ? sizeof(u16) : sizeof(u32);
-   u32* index_buffer = realloc(mesh_interface.mesh->index_buffer, (uS)(last_idx + index_count) * index_size);
+   if (indices == NULL)
+      return;
 
-   if (index_buffer != NULL)
+   u32 quad_idx = 0;
+   for (u32 i=0; i < faces_y; i++)
    {
-      u32 quad_idx = last_idx;
-      for (u32 i=0; i < faces_y; i++)
+      for (u32 j=0; j < faces_x; j++)
       {
-         for (u32 j=0; j < faces_x; j++)
-         {
-            u32 base_y0 = last_vrt + i * (faces_x + 1) + j;
-            u32 base_y1 = last_vrt + (i + 1) * (faces_x + 1) + j;
-
-            index_buffer[quad_idx++] = base_y0;
-            index_buffer[quad_idx++] = base_y1 + 1;
-            index_buffer[quad_idx++] = base_y0 + 1;
-            index_buffer[quad_idx++] = base_y1;
-            index_buffer[quad_idx++] = base_y1 + 1;
-            index_buffer[quad_idx++] = base_y0;
+         u32 base_y0 = first_vertex + i * (faces_x + 1) + j;
+         u32 base_y1 = first_vertex + (i + 1) * (faces_x + 1) + j;
 
-         }
+         indices[quad_idx++] = base_y0;
+         indices[quad_idx++] = base_y1 + 1;
+         indices[quad_idx++] = base_y0 + 1;
+         indices[quad_idx++] = base_y1;
+         indices[quad_idx++] = base_y1 + 1;
+         indices[quad_idx++] = base_y0;
 
       }
 
-      mesh_interface.mesh->index_buffer = index_buffer;
-      mesh_interface.mesh->index_count += index_count;
-
    }
 
-   return mesh_interface;
 }
 
-MeshInterface Mesh_GenNormals(MeshInterface mesh_interface)
+MeshInterface Mesh_AddQuad(u32 faces_x, u32 faces_y, mat4x4 transform, MeshInterface mesh_interface)
 {
-   if (!Mesh_InterfaceIsValid(mesh_interface, true, false, false, false, false))
-      return mesh_interface; // TODO: error tracking...
+   return Mesh_AddQuadAdvanced(faces_x, faces_y, transform, VEC4(0, 1, 1, 0), mesh_interface);
+}
 
-   u32 vertex_count = mesh_interface.mesh->vertex_count;
-   u32 index_count = mesh_interface.mesh->index_count;
+MeshInterface Mesh_AddQuadAdvanced(u32 faces_x, u32 faces_y, mat4x4 transform, vec4 texture_coords, MeshInterface mesh_interface)
+{
+   if (mesh_interface.mesh == NULL || mesh_interface.mesh->index_type != MESH_INDEXTYPE_32BIT || !Mesh_MakeOwned(mesh_interface.mesh))
+      return mesh_interface;
 
-   bool has_texcoord0 = (mesh_interface.atr.texcoord_size[0] != 0);
-   bool has_texcoord1 = (mesh_interface.atr.texcoord_size[1] != 0);
+   u32 vertex_count = (u32)((faces_x + 1) * (faces_y + 1));
+   u32 index_count = (u32)(faces_x * faces_y * 6);
+
+   u32 last_vrt = mesh_interface.mesh->vertex_count;
+   u32 last_idx = mesh_interface.mesh->index_count;
 
-   MeshInterface new_mesh_interface = Mesh_ReallocVertices(vertex_count, true, has_texcoord0, has_texcoord1, false, mesh_interface);
+   u32 total_verts = vertex_count + mesh_interface.mesh->vertex_count;
+
+   MeshInterface new_mesh_interface = Mesh_ReallocVertices(total_verts, true, true, false, true, mesh_interface);
    u8* vertex_buffer = new_mesh_interface.mesh->vertex_buffer;
 
-   vec3* position = (vec3*)vertex_buffer;
-   vec3* normal = (vec3*)(vertex_buffer + new_mesh_interface.atr.normal_ofs);
-   memset(normal, 0, new_mesh_interface.atr.normal_size);
+   vec3* position = (vec3*)(vertex_buffer + mesh_interface.atr.position_size);
+
+   uS normal_ofs = new_mesh_interface.atr.normal_ofs + mesh_interface.atr.normal_size;
+   uS texcoord0_ofs = new_mesh_interface.atr.texcoord_ofs[0] + mesh_interface.atr.texcoord_size[0];
+   uS tangent_ofs = new_mesh_interface.atr.tangent_ofs + mesh_interface.atr.tangent_size;
 
    mesh_interface = new_mesh_interface;
 
-   for (u32 i = 0; i < index_count; i += 3)
+   vec3* normal = (vec3*)(vertex_buffer + normal_ofs);
+   vec2* texcoord0 = (vec2*)(vertex_buffer + texcoord0_ofs);
+   vec4* tangent = (vec4*)(vertex_buffer + tangent_ofs);
+
+   u32* index_buffer = realloc(mesh_interface.mesh->index_buffer, (uS)(last_idx + index_count) * sizeof(u32));
+
+   MSH_FillQuad(faces_x, faces_y, transform, texture_coords, last_vrt, position, normal, texcoord0, tangent, (index_buffer != NULL) ? index_buffer + last_idx : NULL);
+
+   if (index_buffer != NULL)
    {
-      u32 idx_a = Mesh_GetIndexFromBuffer(*mesh_interface.mesh, i + 0);
-      u32 idx_b = Mesh_GetIndexFromBuffer(*mesh_interface.mesh, i + 1);
-      u32 idx_c = Mesh_GetIndexFromBuffer(*mesh_interface.mesh, i + 2);
-
-      vec3 vrt_a = position[idx_a];
-      vec3 vrt_b = position[idx_b];
-      vec3 vrt_c = position[idx_c];
-
-      vec3 b_a = Util_SubVec3(vrt_b, vrt_a);
-      vec3 c_a = Util_SubVec3(vrt_c, vrt_a);
-      vec3 c_b = Util_SubVec3(vrt_c, vrt_b);
-      vec3 a_b = Util_SubVec3(vrt_a, vrt_b);
-      vec3 a_c = Util_SubVec3(vrt_a, vrt_c);
-      vec3 b_c = Util_SubVec3(vrt_b, vrt_c);
-
-      vec3 face_normal = Util_CrossVec3(b_a, c_a);
-      f32 ang_a = Util_DotVec3(b_a, c_a) + 0.0001f;
-      f32 ang_b = Util_DotVec3(c_b, a_b) + 0.0001f;
-      f32 ang_c = Util_DotVec3(a_c, b_c) + 0.0001f;
-
-      normal[idx_a] = Util_AddVec3(
-         normal[idx_a],
-         Util_ScaleVec3(face_normal, ang_a)
-      );
-
-      normal[idx_b] = Util_AddVec3(
-         normal[idx_b],
-         Util_ScaleVec3(face_normal, ang_b)
-      );
-
-      normal[idx_c] = Util_AddVec3(
-         normal[idx_c],
-         Util_ScaleVec3(face_normal, ang_c)
-      );
+      mesh_interface.mesh->index_buffer = index_buffer;
+      mesh_interface.mesh->index_count += index_count;
 
    }
 
-   for (u32 i = 0; i < vertex_count; i++)
-      normal[i] = Util_NormalizeVec3(normal[i]);
-
    return mesh_interface;
 }
 
+MeshInterface Mesh_GenNormals(MeshInterface mesh_interface)
+{
+   return Mesh_GenNormalsParallel(mesh_interface, NULL);
+}
+
 MeshInterface Mesh_AverageNormalsOverSeams(MeshInterface mesh_interface)
 {
    if (!Mesh_InterfaceIsValid(mesh_interface, true, true, false, false, false))
@@ -358,33 +295,31 @@ MeshInterface Mesh_AverageNormalsOverSeams(MeshInterface mesh_interface)
 
    u32 vertex_count = mesh_interface.mesh->vertex_count;
 
-   vec3* position = (vec3*)mesh_interface.mesh->vertex_buffer;
    vec3* normal = (vec3*)(mesh_interface.mesh->vertex_buffer + mesh_interface.atr.normal_ofs);
-   vec3* tmp_normal = malloc(mesh_interface.atr.normal_size);
+   vec3* tmp_normal = calloc(vertex_count, sizeof(vec3));
+   u32* remap = malloc(sizeof(u32) * (uS)vertex_count);
 
-   if (tmp_normal != NULL)
+   if (tmp_normal != NULL && remap != NULL)
    {
-      memcpy(tmp_normal, normal, mesh_interface.atr.normal_size);
+      // only the position is needed, the interface keeps it at the start of the buffer no matter what the attributes say
+      Mesh position_mesh = (*mesh_interface.mesh);
+      position_mesh.attribute_count = 1;
+      position_mesh.attributes[0] = MESH_ATTRIBUTE_3_CHANNEL;
 
-      for (u32 i = 0; i < vertex_count; i++)
-      {
-         for (u32 j = 0; j < vertex_count; j++)
-         {
-            vec3 diff = Util_SubVec3(position[i], position[j]);
-            if (Util_DotVec3(diff, diff) > 1e-7 || j == i)
-               continue;
-
-            tmp_normal[i] = Util_AddVec3(tmp_normal[i], normal[j]);
-         }
-      }
+      // same distance the old brute force check allowed (1e-7 squared)
+      Mesh_FindCoincidentVertices(position_mesh, 3.1623e-4f, remap);
 
       for (u32 i = 0; i < vertex_count; i++)
-         normal[i] = Util_NormalizeVec3(tmp_normal[i]);
+         tmp_normal[remap[i]] = Util_AddVec3(tmp_normal[remap[i]], normal[i]);
 
-      free(tmp_normal);
+      for (u32 i = 0; i < vertex_count; i++)
+         normal[i] = Util_NormalizeVec3(tmp_normal[remap[i]]);
 
    }
 
+   free(tmp_normal);
+   free(remap);
+
    return mesh_interface;
 }
 
@@ -446,85 +381,7 @@ MeshInterface Mesh_GenTexcoords(MeshInterface mesh_interface, vec3 triplanar_sca
 
 MeshInterface Mesh_GenTangents(MeshInterface mesh_interface)
 {
-   if (!Mesh_InterfaceIsValid(mesh_interface, true, true, true, false, false))
-      return mesh_interface; // TODO: error tracking...
-
-   u32 vertex_count = mesh_interface.mesh->vertex_count;
-   u32 index_count = mesh_interface.mesh->index_count;
-
-   bool has_texcoord1 = (mesh_interface.atr.texcoord_size[1] != 0);
-
-   MeshInterface new_mesh_interface = Mesh_ReallocVertices(vertex_count, true, true, has_texcoord1, true, mesh_interface);
-   u8* vertex_buffer = new_mesh_interface.mesh->vertex_buffer;
-
-   vec3* position = (vec3*)vertex_buffer;
-   vec3* normal = (vec3*)(vertex_buffer + new_mesh_interface.atr.normal_ofs);
-   vec2* texcoord = (vec2*)(vertex_buffer + new_mesh_interface.atr.texcoord_ofs[0]);
-   vec4* tangent = (vec4*)(vertex_buffer + new_mesh_interface.atr.tangent_ofs);
-   vec3* tmp_tangent = malloc(new_mesh_interface.atr.normal_size * 2);
-
-   if (tmp_tangent != NULL)
-   {
-      mesh_interface = new_mesh_interface;
-
-      memset(tmp_tangent, 0, new_mesh_interface.atr.normal_size * 2);
-      vec3* tmp_bitangent = tmp_tangent + vertex_count;
-
-      for (u32 i = 0; i < index_count; i += 3)
-      {
-         u32 idx_a = Mesh_GetIndexFromBuffer(*mesh_interface.mesh, i + 0);
-         u32 idx_b = Mesh_GetIndexFromBuffer(*mesh_interface.mesh, i + 1);
-         u32 idx_c = Mesh_GetIndexFromBuffer(*mesh_interface.mesh, i + 2);
-
-         vec3 vrt_a = position[idx_a];
-         vec3 vrt_b = position[idx_b];
-         vec3 vrt_c = position[idx_c];
-
-         vec2 tex_a = texcoord[idx_a];
-         vec2 tex_b = texcoord[idx_b];
-         vec2 tex_c = texcoord[idx_c];
-
-         f32 x1 = vrt_b.x - vrt_a.x;
-         f32 x2 = vrt_c.x - vrt_a.x;
-         f32 y1 = vrt_b.y - vrt_a.y;
-         f32 y2 = vrt_c.y - vrt_a.y;
-         f32 z1 = vrt_b.z - vrt_a.z;
-         f32 z2 = vrt_c.z - vrt_a.z;
-
-         f32 s1 = tex_b.x - tex_a.x;
-         f32 s2 = tex_c.x - tex_a.x;
-         f32 t1 = tex_b.y - tex_a.y;
-         f32 t2 = tex_c.y - tex_a.y;
-
-         f32 r = 1.0f / (s1 * t2 - s2 * t1);
-         vec3 s_dir = VEC3((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r, (t2 * z1 - t1 * z2) * r);
-         vec3 t_dir = VEC3((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r, (s1 * z2 - s2 * z1) * r);
-
-         tmp_tangent[idx_a] = Util_AddVec3(tmp_tangent[idx_a], s_dir);
-         tmp_tangent[idx_b] = Util_AddVec3(tmp_tangent[idx_b], s_dir);
-         tmp_tangent[idx_c] = Util_AddVec3(tmp_tangent[idx_c], s_dir);
-
-         tmp_bitangent[idx_a] = Util_AddVec3(tmp_bitangent[idx_a], t_dir);
-         tmp_bitangent[idx_b] = Util_AddVec3(tmp_bitangent[idx_b], t_dir);
-         tmp_bitangent[idx_c] = Util_AddVec3(tmp_bitangent[idx_c], t_dir);
-
-      }
-
-      for (u32 i = 0; i < vertex_count; i++)
-      {
-         vec3 n = normal[i];
-         vec3 t = tmp_tangent[i];
-
-         tangent[i].xyz = Util_NormalizeVec3(Util_SubVec3(t, Util_ScaleVec3(n, Util_DotVec3(n, t))));
-         tangent[i].w = (Util_DotVec3(Util_CrossVec3(n, t), tmp_bitangent[i]) < 0.0f) ? 1.0f : -1.0f;
-
-      }
-
-      free(tmp_tangent);
-
-   }
-
-   return mesh_interface;
+   return Mesh_GenTangentsParallel(mesh_interface, NULL);
 }
 
 void MSH_RellocAttribute(u8* new_vertex_buffer, u8* old_vertex_buffer, uS* inout_new_size, uS* inout_new_ofs, uS old_size, uS old_ofs, uS new_bytes, uS* inout_total_bytes, const bool clear_attribute)
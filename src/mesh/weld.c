@@ -0,0 +1,327 @@
+#include "util/types.h"
+#include "util/math.h"
+#include "util/vec3.h"
+
+#include "mesh/internal.h"
+#include "mesh.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// vertices are bucketed by the cell they land in on a grid as fine as the tolerance, so anything close enough to
+// match is at most one cell away. cells are hashed into a table and counting-sorted, no per-cell allocations
+typedef struct MSH_VertexGrid_t
+{
+   u32* cell_start; // table_size + 1 entries, vertices of a bucket are cell_vertices[cell_start[h]..cell_start[h + 1]]
+   u32* cell_vertices;
+   u32 table_mask;
+   f32 inv_cell_size;
+
+} MSH_VertexGrid;
+
+// 2^62, exact as a float
+#define MSH_CELL_COORD_LIMIT 4611686018427387904.0f
+
+static i64 MSH_CellCoord(f32 x, f32 inv_cell_size)
+{
+   // nan and anything past what an i64 holds (easy with a tiny tolerance) go in the outermost cells instead of
+   // hitting an undefined cast. the limit leaves room for the neighbouring cell offsets
+   f32 scaled = x * inv_cell_size;
+   if (isnan(scaled))
+      return 0;
+
+   scaled = M_CLAMP(scaled, -MSH_CELL_COORD_LIMIT, MSH_CELL_COORD_LIMIT);
+   i64 coord = (i64)scaled;
+
+   if ((f32)coord > scaled)
+      coord--;
+
+   return coord;
+}
+
+static u32 MSH_CellHash(i64 x, i64 y, i64 z, u32 table_mask)
+{
+   u64 hash = ((u64)x * 73856093ull) ^ ((u64)y * 19349663ull) ^ ((u64)z * 83492791ull);
+   return (u32)(hash ^ (hash >> 32)) & table_mask;
+}
+
+static u32 MSH_VertexCellHash(MSH_VertexGrid* grid, vec3 position)
+{
+   return MSH_CellHash(
+      MSH_CellCoord(position.x, grid->inv_cell_size),
+      MSH_CellCoord(position.y, grid->inv_cell_size),
+      MSH_CellCoord(position.z, grid->inv_cell_size),
+      grid->table_mask
+   );
+}
+
+static bool MSH_CreateVertexGrid(MSH_VertexGrid* grid, vec3* position, u32 vertex_count, f32 cell_size)
+{
+   u32 table_size = 1;
+   while (table_size < vertex_count * 2u && table_size < (1u << 31))
+      table_size <<= 1;
+
+   grid->table_mask = table_size - 1;
+   grid->inv_cell_size = 1.0f / M_MAX(cell_size, M_FLOAT_FUZZ);
+   grid->cell_start = calloc((uS)table_size + 1, sizeof(u32));
+   grid->cell_vertices = malloc(sizeof(u32) * (uS)M_MAX(vertex_count, 1u));
+
+   u32* vertex_cell = malloc(sizeof(u32) * (uS)M_MAX(vertex_count, 1u));
+
+   if (grid->cell_start == NULL || grid->cell_vertices == NULL || vertex_cell == NULL)
+   {
+      free(grid->cell_start);
+      free(grid->cell_vertices);
+      free(vertex_cell);
+      (*grid) = (MSH_VertexGrid){ 0 };
+
+      return false;
+   }
+
+   for (u32 vert_i = 0; vert_i < vertex_count; vert_i++)
+   {
+      vertex_cell[vert_i] = MSH_VertexCellHash(grid, position[vert_i]);
+      grid->cell_start[vertex_cell[vert_i] + 1]++;
+
+   }
+
+   for (u32 cell_i = 0; cell_i < table_size; cell_i++)
+      grid->cell_start[cell_i + 1] += grid->cell_start[cell_i];
+
+   // filled in vertex order, so every bucket ends up sorted by index
+   for (u32 vert_i = 0; vert_i < vertex_count; vert_i++)
+   {
+      u32 cell = vertex_cell[vert_i];
+      grid->cell_vertices[grid->cell_start[cell]++] = vert_i;
+
+   }
+
+   // the fill pushed every start forward to where the next bucket begins, shift them back
+   for (u32 cell_i = table_size; cell_i > 0; cell_i--)
+      grid->cell_start[cell_i] = grid->cell_start[cell_i - 1];
+
+   grid->cell_start[0] = 0;
+
+   free(vertex_cell);
+
+   return true;
+}
+
+static void MSH_FreeVertexGrid(MSH_VertexGrid* grid)
+{
+   free(grid->cell_start);
+   free(grid->cell_vertices);
+   (*grid) = (MSH_VertexGrid){ 0 };
+
+}
+
+// everything after the position. colors have to match exactly, floats within the tolerance for their channel count
+static bool MSH_AttributesMatch(Mesh mesh, MeshWeldDesc desc, u32 vert_a, u32 vert_b)
+{
+   uS attribute_ofs = MSH_VertexSize(&mesh.attributes[0], 1) * (uS)mesh.vertex_count;
+
+   for (u8 atr_i = 1; atr_i < mesh.attribute_count; atr_i++)
+   {
+      u8 attribute = mesh.attributes[atr_i];
+      uS attribute_size = MSH_VertexSize(&attribute, 1);
+
+      u8* data_a = mesh.vertex_buffer + attribute_ofs + attribute_size * (uS)vert_a;
+      u8* data_b = mesh.vertex_buffer + attribute_ofs + attribute_size * (uS)vert_b;
+      attribute_ofs += attribute_size * (uS)mesh.vertex_count;
+
+      if (attribute == MESH_ATTRIBUTE_COLOR)
+      {
+         if (memcmp(data_a, data_b, attribute_size) != 0)
+            return false;
+
+         continue;
+      }
+
+      f32 tolerance = (attribute == MESH_ATTRIBUTE_3_CHANNEL || attribute == MESH_ATTRIBUTE_4_CHANNEL) ? desc.normal_tolerance : desc.texcoord_tolerance;
+      f32* channel_a = (f32*)data_a;
+      f32* channel_b = (f32*)data_b;
+
+      for (uS channel_i = 0; channel_i < attribute_size / sizeof(f32); channel_i++)
+      {
+         if (M_ABS(channel_a[channel_i] - channel_b[channel_i]) > tolerance)
+            return false;
+
+      }
+
+   }
+
+   return true;
+}
+
+// out_remap[i] is the lowest index i can be merged into, out_remap[i] == i means i starts its own group
+static u32 MSH_GroupVertices(Mesh mesh, MeshWeldDesc desc, bool compare_attributes, u32* out_remap)
+{
+   u32 vertex_count = mesh.vertex_count;
+   vec3* position = (vec3*)mesh.vertex_buffer;
+
+   for (u32 vert_i = 0; vert_i < vertex_count; vert_i++)
+      out_remap[vert_i] = vert_i;
+
+   if (mesh.attribute_count == 0 || mesh.attributes[0] != MESH_ATTRIBUTE_3_CHANNEL || position == NULL)
+      return vertex_count;
+
+   f32 tolerance = M_MAX(desc.position_tolerance, 0.0f);
+   f32 tolerance_sqr = tolerance * tolerance;
+
+   MSH_VertexGrid grid = { 0 };
+   if (!MSH_CreateVertexGrid(&grid, position, vertex_count, tolerance))
+      return vertex_count;
+
+   u32 group_count = 0;
+
+   for (u32 vert_i = 0; vert_i < vertex_count; vert_i++)
+   {
+      vec3 p = position[vert_i];
+      i64 cell_x = MSH_CellCoord(p.x, grid.inv_cell_size);
+      i64 cell_y = MSH_CellCoord(p.y, grid.inv_cell_size);
+      i64 cell_z = MSH_CellCoord(p.z, grid.inv_cell_size);
+
+      u32 leader = vert_i;
+
+      for (i64 ofs_z = -1; ofs_z <= 1; ofs_z++)
+      for (i64 ofs_y = -1; ofs_y <= 1; ofs_y++)
+      for (i64 ofs_x = -1; ofs_x <= 1; ofs_x++)
+      {
+         u32 cell = MSH_CellHash(cell_x + ofs_x, cell_y + ofs_y, cell_z + ofs_z, grid.table_mask);
+
+         for (u32 slot_i = grid.cell_start[cell]; slot_i < grid.cell_start[cell + 1]; slot_i++)
+         {
+            u32 other = grid.cell_vertices[slot_i];
+
+            // buckets are sorted, nothing past here has been grouped yet
+            if (other >= leader)
+               break;
+
+            if (out_remap[other] != other)
+               continue;
+
+            vec3 diff = Util_SubVec3(p, position[other]);
+            if (Util_DotVec3(diff, diff) > tolerance_sqr)
+               continue;
+
+            if (compare_attributes && !MSH_AttributesMatch(mesh, desc, vert_i, other))
+               continue;
+
+            leader = other;
+
+         }
+
+      }
+
+      out_remap[vert_i] = leader;
+
+      if (leader == vert_i)
+         group_count++;
+
+   }
+
+   MSH_FreeVertexGrid(&grid);
+
+   return group_count;
+}
+
+u32 Mesh_FindCoincidentVertices(Mesh mesh, f32 tolerance, u32* out_remap)
+{
+   if (out_remap == NULL)
+      return 0;
+
+   return MSH_GroupVertices(mesh, (MeshWeldDesc){ .position_tolerance = tolerance }, false, out_remap);
+}
+
+bool Mesh_WeldVertices(Mesh* mesh, MeshWeldDesc desc)
+{
+   if (mesh == NULL || mesh->vertex_buffer == NULL || mesh->vertex_count == 0 || !Mesh_MakeOwned(mesh))
+      return false;
+
+   u32 vertex_count = mesh->vertex_count;
+   u32* remap = malloc(sizeof(u32) * (uS)vertex_count);
+   u32* new_index = malloc(sizeof(u32) * (uS)vertex_count);
+
+   if (remap == NULL || new_index == NULL)
+   {
+      free(remap);
+      free(new_index);
+
+      return false;
+   }
+
+   u32 weld_count = MSH_GroupVertices(*mesh, desc, true, remap);
+
+   // leaders keep their order, everything else takes its leader's new slot
+   u32 next_index = 0;
+   for (u32 vert_i = 0; vert_i < vertex_count; vert_i++)
+      new_index[vert_i] = (remap[vert_i] == vert_i) ? next_index++ : new_index[remap[vert_i]];
+
+   uS vertex_size = MSH_VertexSize(mesh->attributes, mesh->attribute_count);
+
+   bool is_32bit = (mesh->index_buffer != NULL) ? (mesh->index_type == MESH_INDEXTYPE_32BIT) : (weld_count > UINT16_MAX);
+   u32 index_count = (mesh->index_buffer != NULL) ? mesh->index_count : vertex_count;
+
+   u8* vertex_buffer = malloc(vertex_size * (uS)weld_count);
+   void* index_buffer = malloc((is_32bit ? sizeof(u32) : sizeof(u16)) * (uS)M_MAX(index_count, 1u));
+
+   if (vertex_buffer == NULL || index_buffer == NULL)
+   {
+      free(vertex_buffer);
+      free(index_buffer);
+      free(remap);
+      free(new_index);
+
+      return false;
+   }
+
+   uS src_ofs = 0;
+   uS dst_ofs = 0;
+
+   for (u8 atr_i = 0; atr_i < mesh->attribute_count; atr_i++)
+   {
+      uS attribute_size = MSH_VertexSize(&mesh->attributes[atr_i], 1);
+
+      for (u32 vert_i = 0; vert_i < vertex_count; vert_i++)
+      {
+         if (remap[vert_i] != vert_i)
+            continue;
+
+         memcpy(vertex_buffer + dst_ofs + attribute_size * (uS)new_index[vert_i], mesh->vertex_buffer + src_ofs + attribute_size * (uS)vert_i, attribute_size);
+
+      }
+
+      src_ofs += attribute_size * (uS)vertex_count;
+      dst_ofs += attribute_size * (uS)weld_count;
+
+   }
+
+   // meshes without indices were a plain triangle list, they get one that points at the welded vertices
+   for (u32 idx_i = 0; idx_i < index_count; idx_i++)
+   {
+      u32 old_index = (mesh->index_buffer != NULL) ? Mesh_GetIndexFromBuffer(*mesh, idx_i) : idx_i;
+      u32 welded_index = (old_index < vertex_count) ? new_index[old_index] : 0;
+
+      if (is_32bit)
+         ((u32*)index_buffer)[idx_i] = welded_index;
+      else
+         ((u16*)index_buffer)[idx_i] = (u16)welded_index;
+
+   }
+
+   free(mesh->vertex_buffer);
+   free(mesh->index_buffer);
+
+   mesh->vertex_buffer = vertex_buffer;
+   mesh->index_buffer = index_buffer;
+   mesh->vertex_count = weld_count;
+   mesh->index_count = index_count;
+   mesh->index_type = is_32bit ? MESH_INDEXTYPE_32BIT : MESH_INDEXTYPE_16BIT;
+
+   free(remap);
+   free(new_index);
+
+   return true;
+}
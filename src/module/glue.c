@@ -71,7 +71,7 @@ void Module_Defaults(Engine* engine, u32 exclude_count, char* module_excludes[])
 
 error MOD_GraphicsInit(Module* self, Engine* engine)
 {
-   self->data = Graphics_Init();
+   self->data = Graphics_InitWithLoader(Engine_GetLoadFunc(engine));
 
    if (self->data == NULL)
    {
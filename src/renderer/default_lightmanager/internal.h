@@ -13,6 +13,9 @@
 
 #define LIGHTMAN_INVALID_LIST_LINK UINT16_MAX
 
+// ssbo with the indices of lights touching the camera frustum, the cluster fill only tests those
+#define LIGHTMAN_VISIBLE_LIGHTS_BINDING 8
+
 struct lightman_Cluster_t
 {
    vec4 center;
@@ -97,6 +100,7 @@ struct DefaultLightManager_t
 {
    lightman_PackedSunLight* packed_sun_lights;
    lightman_PackedLight* packed_lights;
+   u32* visible_lights;
 
    union {
       struct {
@@ -125,6 +129,8 @@ struct DefaultLightManager_t
    Buffer cluster_ssbo;
    Buffer sun_light_ssbo;
    Buffer light_ssbo;
+   Buffer visible_light_ssbo;
+   u32 visible_light_capacity;
    Shader build_clusters_cs;
    Shader fill_clusters_cs;
 
@@ -142,6 +148,13 @@ struct DefaultLightManager_t
 
 };
 
+typedef struct lightman_CasterQuery_t
+{
+   u16 light_drawable_type_idx;
+   bool has_casters;
+
+} lightman_CasterQuery;
+
 static inline u16 LIGHTMAN_U16Norm(f32 value)
 {
    const f32 u16_maxf = (f32)UINT16_MAX;
@@ -162,6 +175,11 @@ static inline uS LIGHTMAN_LightBufferSize(DefaultLightManager* lightmanager)
    return sizeof(i32) * 4 + sizeof(lightman_PackedLight) * light_memory;
 }
 
+static inline uS LIGHTMAN_VisibleLightBufferSize(u32 capacity)
+{
+   return sizeof(u32) * 4 + sizeof(u32) * capacity;
+}
+
 static inline mat4x4 LIGHTMAN_CubemapViewMatrix(vec3 origin, u8 cubemap_face)
 {
    const vec3 s[2] = { { 1, 0, 0 }, {-1, 0, 0 } };
@@ -11,6 +11,90 @@
 #include <stdlib.h>
 #include <string.h>
 
+static void LIGHTMAN_UpdateLightBounds(Renderer* renderer, Drawable light_drawable, lightman_LightDrawable* light_data)
+{
+   f32 radius = light_data->radius;
+   Renderer_SetDrawableBounds(renderer, light_drawable, (BBox){ light_data->origin, VEC3(radius, radius, radius) });
+
+}
+
+static bool LIGHTMAN_FindShadowCaster(Renderer* renderer, Drawable drawable, void* user_data)
+{
+   lightman_CasterQuery* query = (lightman_CasterQuery*)user_data;
+   if (drawable.drawable_type_idx == query->light_drawable_type_idx)
+      return true;
+
+   query->has_casters = true;
+
+   return false;
+}
+
+// drawables without bounds could be anywhere, so only a scene where everything has bounds can skip a light
+static bool LIGHTMAN_HasShadowCasters(Renderer* renderer, DefaultLightManager* lightmanager, lightman_LightDrawable* light_data)
+{
+   if (Renderer_GetUnboundedDrawableCount(renderer) > 0)
+      return true;
+
+   lightman_CasterQuery query = {
+      .light_drawable_type_idx = lightmanager->light_drawable_type_idx,
+      .has_casters = false
+   };
+
+   Renderer_QuerySphere(renderer, light_data->origin, light_data->radius, LIGHTMAN_FindShadowCaster, &query);
+
+   return query.has_casters;
+}
+
+static bool LIGHTMAN_GatherVisibleLight(Renderer* renderer, Drawable drawable, void* user_data)
+{
+   DefaultLightManager* lightmanager = (DefaultLightManager*)user_data;
+   if (drawable.drawable_type_idx != lightmanager->light_drawable_type_idx)
+      return true;
+
+   lightman_LightDrawable* light_data = Renderer_GetDrawableData(renderer, drawable);
+   if (light_data == NULL || !light_data->enabled)
+      return true;
+
+   // the render func never runs for lights outside the frustum, so changes get uploaded here before the clusters read them
+   if (light_data->needs_update)
+   {
+      lightmanager->packed_lights[light_data->light_idx] = LIGHTMAN_CreatePackedLight(*light_data);
+      LIGHTMAN_UpdateLight(renderer, light_data->light_idx);
+      light_data->needs_update = false;
+
+   }
+
+   u32 visible_count = Util_ArrayLength(lightmanager->visible_lights);
+   SET_ARRAY_LENGTH(lightmanager->visible_lights, visible_count + 1);
+   lightmanager->visible_lights[visible_count] = light_data->light_idx;
+
+   return true;
+}
+
+static void LIGHTMAN_UploadVisibleLights(Renderer* renderer, DefaultLightManager* lightmanager)
+{
+   Graphics* graphics = Renderer_GetGraphics(renderer);
+
+   u32 visible_count = Util_ArrayLength(lightmanager->visible_lights);
+   if (visible_count > lightmanager->visible_light_capacity)
+   {
+      lightmanager->visible_light_capacity = (u32)Util_ArrayMemory(lightmanager->visible_lights);
+
+      Graphics_FreeBuffer(graphics, lightmanager->visible_light_ssbo);
+      lightmanager->visible_light_ssbo = Graphics_CreateBufferExplicit(graphics, NULL, LIGHTMAN_VisibleLightBufferSize(lightmanager->visible_light_capacity), GFX_DRAWMODE_DYNAMIC, GFX_BUFFERTYPE_STORAGE);
+
+   }
+
+   u32 visible_info[4] = { visible_count, 0, 0, 0 };
+   Graphics_UpdateBufferExplicit(graphics, lightmanager->visible_light_ssbo, visible_info, 0, sizeof(visible_info));
+
+   if (visible_count > 0)
+      Graphics_UpdateBufferExplicit(graphics, lightmanager->visible_light_ssbo, lightmanager->visible_lights, sizeof(visible_info), visible_count * sizeof(u32));
+
+   Graphics_BindBuffer(graphics, lightmanager->visible_light_ssbo, LIGHTMAN_VISIBLE_LIGHTS_BINDING);
+
+}
+
 LightManagerInfo DefaultLightManager_Info(Renderer* renderer)
 {
    LightManagerInfo lightmanager_info = {
@@ -47,6 +131,7 @@ DefaultLightManager* DefaultLightManager_Init(Renderer* renderer)
 
    lightmanager->packed_lights = NEW_ARRAY_N(lightman_PackedLight, 16);
    lightmanager->packed_sun_lights = NEW_ARRAY_N(lightman_PackedSunLight, 1);
+   lightmanager->visible_lights = NEW_ARRAY_N(u32, 16);
 
    lightmanager->cluster_dimensions[0] = cluster_x;
    lightmanager->cluster_dimensions[1] = cluster_y;
@@ -65,8 +150,8 @@ DefaultLightManager* DefaultLightManager_Init(Renderer* renderer)
       "USE_LIGHTING"
    };
 
-   lightmanager->build_clusters_cs = Renderer_LoadShader(renderer, "assets/core/shaders/cs_build_clusters.glsl", NULL, 0, true);
-   lightmanager->fill_clusters_cs = Renderer_LoadShader(renderer, "assets/core/shaders/cs_cull_lights.glsl", shaderdefs, 1, true);
+   lightmanager->build_clusters_cs = Renderer_GetShaderVariant(renderer, "assets/core/shaders/cs_build_clusters.glsl", NULL, 0, SHADER_VARIANT_COMPUTE);
+   lightmanager->fill_clusters_cs = Renderer_GetShaderVariant(renderer, "assets/core/shaders/cs_cull_lights.glsl", shaderdefs, 1, SHADER_VARIANT_COMPUTE);
 
    lightmanager->cluster_ssbo = Graphics_CreateBufferExplicit(graphics, NULL, LIGHTMAN_ClustersSize(lightmanager), GFX_DRAWMODE_STATIC, GFX_BUFFERTYPE_STORAGE);
    lightmanager->light_ssbo = Graphics_CreateBufferExplicit(graphics, NULL, LIGHTMAN_LightBufferSize(lightmanager), GFX_DRAWMODE_STATIC, GFX_BUFFERTYPE_STORAGE);
@@ -74,17 +159,21 @@ DefaultLightManager* DefaultLightManager_Init(Renderer* renderer)
    Graphics_UpdateBuffer(graphics, lightmanager->cluster_ssbo, &lightmanager->cluster_info, 4, sizeof(u32));
    Graphics_UpdateBuffer(graphics, lightmanager->light_ssbo, &lightmanager->light_list, 1, sizeof(i32));
 
+   lightmanager->visible_light_capacity = (u32)Util_ArrayMemory(lightmanager->visible_lights);
+   lightmanager->visible_light_ssbo = Graphics_CreateBufferExplicit(graphics, NULL, LIGHTMAN_VisibleLightBufferSize(lightmanager->visible_light_capacity), GFX_DRAWMODE_DYNAMIC, GFX_BUFFERTYPE_STORAGE);
+
    Renderer_RegisterDrawableType(renderer, LIGHT_DRAWABLE_TYPE, &(DrawableTypeDesc){
       .render_func = LIGHTMAN_LightRenderFunc,
       .on_enable_func = LIGHTMAN_LightEnableFunc,
       .on_disable_func = LIGHTMAN_LightDisableFunc,
-      .data_size = sizeof(lightman_LightDrawable)
+      .data_size = sizeof(lightman_LightDrawable),
+      .skip_raycasts = true
    });
 
    lightmanager->light_drawable_type_idx = Renderer_GetDrawableTypeIndexFromName(renderer, LIGHT_DRAWABLE_TYPE);
 
-   Renderer_SetUnlitShader(renderer, Renderer_LoadShader(renderer, "assets/core/shaders/builtin.glsl", NULL, 0, false));
-   Renderer_SetBasicShader(renderer, Renderer_LoadShader(renderer, "assets/core/shaders/builtin.glsl", shaderdefs, 2, false));
+   Renderer_SetUnlitShader(renderer, Renderer_GetShaderVariant(renderer, "assets/core/shaders/builtin.glsl", NULL, 0, 0));
+   Renderer_SetBasicShader(renderer, Renderer_GetShaderVariant(renderer, "assets/core/shaders/builtin.glsl", shaderdefs, 2, 0));
 
    lightmanager->shadow.shadow_size = (res2D){ 256, 256 };
    lightmanager->shadow.num_shadows = 32;
@@ -98,7 +187,6 @@ DefaultLightManager* DefaultLightManager_Init(Renderer* renderer)
    };
 
    lightmanager->shadow.pointlight = Graphics_CreateTexture(graphics, NULL, point_shadow_desc);
-   Graphics_SetTextureShadowSampler(graphics, lightmanager->shadow.pointlight, true);
    Graphics_CheckErrors(graphics);
    Graphics_CreateFramebuffer(graphics, lightmanager->shadow.shadow_size, false);
    Graphics_CheckErrors(graphics);
@@ -115,6 +203,7 @@ void DefaultLightManager_Free(DefaultLightManager* lightmanager)
 
    FREE_ARRAY(lightmanager->packed_lights);
    FREE_ARRAY(lightmanager->packed_sun_lights);
+   FREE_ARRAY(lightmanager->visible_lights);
 
    free(lightmanager);
 }
@@ -140,12 +229,32 @@ void DefaultLightManager_PreRender(DefaultLightManager* lightmanager, Renderer*
    while (current_light_idx != INVALID_HANDLE)
    {
       lightman_LightDrawable* light_data = Renderer_GetDrawableDataFromIndex(renderer, lightmanager->light_drawable_type_idx, current_light_idx);
+      if (light_data == NULL)
+         break;
+
+      current_light_idx = light_data->next_idx;
 
       if (!light_data->casts_shadows)
          continue;
 
+      // six faces of nothing, drop the shadow instead of rendering them
+      if (!LIGHTMAN_HasShadowCasters(renderer, lightmanager, light_data))
+      {
+         if (light_data->shadow_idx != 0)
+         {
+            light_data->shadow_idx = 0;
+            lightmanager->packed_lights[light_data->light_idx].shadow_id = 0;
+            LIGHTMAN_UpdateLight(renderer, light_data->light_idx);
+
+         }
+
+         continue;
+      }
+
       Renderer_SetClippingPlanes(renderer, 0.01f, light_data->radius);
-      mat4x4 mat_proj = Util_PerspectiveMatrix(50.0f, 1.0f, 0.01f, light_data->radius);
+      mat4x4 mat_proj = (Renderer_IsReverseZ(renderer)) ?
+         Util_ReverseZPerspectiveMatrix(50.0f, 1.0f, 0.01f, light_data->radius) :
+         Util_PerspectiveMatrix(50.0f, 1.0f, 0.01f, light_data->radius);
       for (u8 face_i = 0; face_i < 6; face_i++)
       {
          Graphics_AttachTextureToFramebuffer(graphics, lightmanager->shadow_fbo, lightmanager->shadow.pointlight, &(AdvancedBindOptions){
@@ -155,6 +264,8 @@ void DefaultLightManager_PreRender(DefaultLightManager* lightmanager, Renderer*
             0
          );
 
+         u32 face_scope = Renderer_BeginProfileScope(renderer, "shadow_face", face_i);
+
          Graphics_BindFramebuffer(graphics, lightmanager->shadow_fbo);
          Graphics_Clear(graphics);
 
@@ -162,18 +273,19 @@ void DefaultLightManager_PreRender(DefaultLightManager* lightmanager, Renderer*
          Renderer_SetProjectionMatrix(renderer, mat_proj);
          Renderer_RenderPass(renderer, lightmanager->shadow.shadow_size, 0, 1);
 
+         Renderer_EndProfileScope(renderer, face_scope);
+
       }
 
       num_shadow_casters++;
 
+      light_data->shadow_idx = num_shadow_casters;
       lightmanager->packed_lights[light_data->light_idx].shadow_id = num_shadow_casters;
       LIGHTMAN_UpdateLight(renderer, light_data->light_idx);
 
       if (num_shadow_casters >= lightmanager->shadow.num_shadows)
          break;
 
-      current_light_idx = light_data->next_idx;
-
    }
 
    Renderer_SetViewMatrix(renderer, mat_view);
@@ -189,10 +301,18 @@ void DefaultLightManager_OnRender(DefaultLightManager* lightmanager, Renderer* r
 
    Graphics* graphics = Renderer_GetGraphics(renderer);
 
+   mat4x4 view_projection = Renderer_GetViewAndProjectionMatrix(renderer);
+   Frustum frustum = (Renderer_IsReverseZ(renderer)) ? Util_FrustumFromMatrixZeroToOne(view_projection) : Util_FrustumFromMatrix(view_projection);
+
+   SET_ARRAY_LENGTH(lightmanager->visible_lights, 0);
+   Renderer_QueryFrustum(renderer, frustum, LIGHTMAN_GatherVisibleLight, lightmanager);
+
    Graphics_UpdateBuffer(graphics, lightmanager->light_ssbo, &lightmanager->light_list, 1, sizeof(i32));
    Graphics_BindBuffer(graphics, lightmanager->cluster_ssbo, 1);
    Graphics_BindBuffer(graphics, lightmanager->light_ssbo, 2);
+   LIGHTMAN_UploadVisibleLights(renderer, lightmanager);
 
+   u32 build_scope = Renderer_BeginProfileScope(renderer, "build_clusters", 0);
    Graphics_Dispatch(
       graphics,
       lightmanager->build_clusters_cs,
@@ -202,7 +322,9 @@ void DefaultLightManager_OnRender(DefaultLightManager* lightmanager, Renderer* r
       (UniformBlockList){ .count = 0 }
    );
    Graphics_DispatchBarrier(graphics);
+   Renderer_EndProfileScope(renderer, build_scope);
 
+   u32 fill_scope = Renderer_BeginProfileScope(renderer, "fill_clusters", 0);
    Graphics_Dispatch(
       graphics,
       lightmanager->fill_clusters_cs,
@@ -212,14 +334,15 @@ void DefaultLightManager_OnRender(DefaultLightManager* lightmanager, Renderer* r
       (UniformBlockList){ .count = 0 }
    );
    Graphics_DispatchBarrier(graphics);
+   Renderer_EndProfileScope(renderer, fill_scope);
 
    TextureInterpolation shadow_interp = {
       .texture_filter = GFX_TEXTUREFILTER_BILINEAR_NO_MIPMAPS,
       .texture_wrap = GFX_TEXTUREWRAP_CLAMP
    };
 
-   Graphics_SetTextureInterpolation(graphics, lightmanager->shadow.pointlight, shadow_interp);
    Graphics_BindTexture(graphics, lightmanager->shadow.pointlight, 5);
+   Graphics_BindSampler(graphics, shadow_interp, true, 5);
 
 }
 
@@ -245,6 +368,9 @@ Drawable DefaultLightManager_CreateLight(Renderer* renderer)
    light_data->spot_softness = 0.0f;
    light_data->theta = 0.0f;
    light_data->phi = 0.0f;
+   light_data->needs_update = true;
+
+   LIGHTMAN_UpdateLightBounds(renderer, light_Drawable, light_data);
 
    return light_Drawable;
 }
@@ -258,6 +384,8 @@ void DefaultLightManager_SetLightOrigin(Renderer* renderer, Drawable light_drawa
    light_data->origin = origin;
    light_data->needs_update = true;
 
+   LIGHTMAN_UpdateLightBounds(renderer, light_drawable, light_data);
+
 }
 
 void DefaultLightManager_SetLightRadius(Renderer* renderer, Drawable light_drawable, f32 radius)
@@ -269,6 +397,8 @@ void DefaultLightManager_SetLightRadius(Renderer* renderer, Drawable light_drawa
    light_data->radius = radius;
    light_data->needs_update = true;
 
+   LIGHTMAN_UpdateLightBounds(renderer, light_drawable, light_data);
+
 }
 
 void DefaultLightManager_SetLightColor(Renderer* renderer, Drawable light_drawable, color8 color)
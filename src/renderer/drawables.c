@@ -1,6 +1,7 @@
 #include "util/handle.h"
 #include "util/types.h"
 #include "util/array.h"
+#include "util/jobs.h"
 
 #include "renderer.h"
 #include "renderer/internal.h"
@@ -10,6 +11,14 @@
 #include <string.h>
 #include <assert.h>
 
+typedef struct rndr_DrawListJob_t
+{
+   Renderer* renderer;
+   u32 query_id;
+   u32 pass_id;
+
+} rndr_DrawListJob;
+
 void Renderer_RegisterDrawableType(Renderer* renderer, const char* name, const DrawableTypeDesc* desc)
 {
    if (renderer == NULL || name == NULL)
@@ -21,6 +30,7 @@ void Renderer_RegisterDrawableType(Renderer* renderer, const char* name, const D
    DrawableFunc on_enable_func = NULL;
    DrawableFunc on_disable_func = NULL;
    uS data_size = 0;
+   bool skip_raycasts = false;
 
    if (desc != NULL)
    {
@@ -30,6 +40,7 @@ void Renderer_RegisterDrawableType(Renderer* renderer, const char* name, const D
       on_enable_func = desc->on_enable_func;
       on_disable_func = desc->on_disable_func;
       data_size = desc->data_size;
+      skip_raycasts = desc->skip_raycasts;
 
    }
 
@@ -53,6 +64,7 @@ void Renderer_RegisterDrawableType(Renderer* renderer, const char* name, const D
    drawable_type->on_disable = on_disable_func;
    drawable_type->freed_drawable_root = RNDR_INVALID_LIST_LINK;
    drawable_type->culled_drawable_count = 0;
+   drawable_type->skip_raycasts = skip_raycasts;
    drawable_type->drawable_buffer = Util_CreateArrayOfLength(4, mem_bytes);
 
    for (u32 slot_i = 0; slot_i < SURF_MAX_TEXTURES; slot_i++)
@@ -101,6 +113,7 @@ Drawable Renderer_CreateDrawable(Renderer* renderer, const char* drawable_type_n
 
    drawable->next_freed = INVALID_HANDLE;
    drawable->compare = drawable_handle.res;
+   RNDR_InitDrawableProxy(renderer, drawable, drawable_type);
    drawable_handle.drawable_type_idx = drawable_type_idx;
 
    drawable->enabled = true;
@@ -133,6 +146,7 @@ void Renderer_RemoveDrawable(Renderer* renderer, Drawable res_drawable)
    if (drawable_type->on_remove != NULL)
       drawable_type->on_remove(renderer, res_drawable);
 
+   RNDR_RemoveDrawableProxy(renderer, drawable, drawable_type);
    drawable->enabled = false;
 
    drawable->next_freed = drawable_type->freed_drawable_root;
@@ -180,6 +194,36 @@ void Renderer_DisableDrawable(Renderer* renderer, Drawable res_drawable)
 
 }
 
+void Renderer_SetDrawableBounds(Renderer* renderer, Drawable res_drawable, BBox bounds)
+{
+   rndr_DrawableType* drawable_type = RNDR_GetDrawableType(renderer, res_drawable.drawable_type_idx);
+   rndr_Drawable* drawable = RNDR_GetDrawable(renderer, res_drawable);
+   if (drawable == NULL)
+      return;
+
+   drawable->bounds = bounds;
+   RNDR_UpdateDrawableProxy(renderer, drawable, drawable_type, res_drawable.drawable_type_idx);
+
+}
+
+BBox Renderer_GetDrawableBounds(Renderer* renderer, Drawable res_drawable)
+{
+   rndr_Drawable* drawable = RNDR_GetDrawable(renderer, res_drawable);
+   if (drawable == NULL)
+      return (BBox){ 0 };
+
+   return drawable->bounds;
+}
+
+bool Renderer_IsDrawableCulled(Renderer* renderer, Drawable res_drawable)
+{
+   rndr_Drawable* drawable = RNDR_GetDrawable(renderer, res_drawable);
+   if (drawable == NULL)
+      return true;
+
+   return drawable->culled;
+}
+
 void* Renderer_GetDrawableData(Renderer* renderer, Drawable res_drawable)
 {
    if (renderer == NULL)
@@ -257,5 +301,125 @@ void RNDR_RegisterDefaultDrawables(Renderer* renderer)
       .on_create_func = RNDR_GeometryOnCreateFunc,
       .render_func = RNDR_GeometryRenderFunc
    });
+   Renderer_RegisterDrawableType(renderer, MESHLET_DRAWABLE_TYPE, &(DrawableTypeDesc){
+      .data_size = sizeof(MeshletDrawable),
+      .on_create_func = RNDR_MeshletOnCreateFunc,
+      .on_remove_func = RNDR_MeshletOnRemoveFunc,
+      .render_func = RNDR_MeshletRenderFunc
+   });
+
+}
+
+static void RNDR_RecordDrawCommands(void* user_data, u32 start, u32 end, u32 worker_id)
+{
+   rndr_DrawListJob* job = (rndr_DrawListJob*)user_data;
+   Renderer* renderer = job->renderer;
+
+   u32 type_i = 0;
+   for (u32 command_i = start; command_i < end; command_i++)
+   {
+      rndr_DrawableType* drawable_type = &renderer->drawable_types[type_i];
+      while (command_i >= drawable_type->draw_list_offset + drawable_type->draw_list_count)
+         drawable_type = &renderer->drawable_types[++type_i];
+
+      rndr_DrawKey* key = &renderer->draw_list.keys[command_i];
+      rndr_DrawCommand* command = &renderer->draw_list.commands[command_i];
+
+      key->command_idx = command_i;
+      key->sort_key = RNDR_DRAW_KEY_SKIP;
+
+      rndr_Drawable* drawable = RNDR_DrawableAtIndex(drawable_type, (u16)(command_i - drawable_type->draw_list_offset));
+      if (drawable == NULL || !drawable->enabled || drawable->next_freed != INVALID_HANDLE)
+         continue;
+
+      // drawables without bounds are never culled, the rest were found by the frustum query or not
+      bool has_bounds = (drawable->bvh_proxy != BVH_NULL_PROXY);
+      drawable->culled = (has_bounds && drawable->visible_query != job->query_id);
+      if (drawable->culled)
+         continue;
+
+      command->drawable = (Drawable){ 0 };
+      command->drawable.id = drawable->compare.id;
+      command->drawable.drawable_type_idx = (u16)type_i;
+      command->is_prepared = false;
+
+      if (drawable_type->render == RNDR_GeometryRenderFunc)
+         RNDR_GeometryPrepareCommand(renderer, drawable, (u16)type_i, job->pass_id, command, key);
+      else
+         key->sort_key = RNDR_MakeDrawKey((u16)type_i, NULLHANDLE, NULLHANDLE, command_i);
+
+   }
+
+}
+
+static i32 RNDR_CompareDrawKeys(const void* a, const void* b)
+{
+   u64 key_a = ((const rndr_DrawKey*)a)->sort_key;
+   u64 key_b = ((const rndr_DrawKey*)b)->sort_key;
+
+   return (key_a > key_b) - (key_a < key_b);
+}
+
+void RNDR_BuildDrawList(Renderer* renderer, u32 pass_id)
+{
+   if (renderer == NULL)
+      return;
+
+   RNDR_UpdateSurfaceStatus(renderer);
+
+   u32 command_count = 0;
+   u32 drawable_type_count = Util_ArrayLength(renderer->drawable_types);
+   for (u32 type_i = 0; type_i < drawable_type_count; type_i++)
+   {
+      rndr_DrawableType* drawable_type = &renderer->drawable_types[type_i];
+      drawable_type->draw_list_offset = command_count;
+      drawable_type->draw_list_count = (drawable_type->render != NULL) ? Util_ArrayLength(drawable_type->drawable_buffer) : 0;
+
+      command_count += drawable_type->draw_list_count;
+
+   }
+
+   SET_ARRAY_LENGTH(renderer->draw_list.commands, command_count);
+   SET_ARRAY_LENGTH(renderer->draw_list.keys, command_count);
+
+   Frustum frustum = (renderer->reverse_z) ? Util_FrustumFromMatrixZeroToOne(renderer->view_projection) : Util_FrustumFromMatrix(renderer->view_projection);
+
+   rndr_DrawListJob job = { 0 };
+   job.renderer = renderer;
+   job.query_id = RNDR_MarkVisibleDrawables(renderer, frustum);
+   job.pass_id = pass_id;
+
+   Util_ParallelFor(renderer->jobs, command_count, RNDR_DRAW_LIST_GRAIN_SIZE, RNDR_RecordDrawCommands, &job);
+
+   qsort(renderer->draw_list.keys, command_count, sizeof(rndr_DrawKey), RNDR_CompareDrawKeys);
+
+   u32 visible_count = command_count;
+   while (visible_count > 0 && renderer->draw_list.keys[visible_count - 1].sort_key == RNDR_DRAW_KEY_SKIP)
+      visible_count--;
+
+   renderer->draw_list.visible_count = visible_count;
+
+}
+
+// replays the draw list on the calling thread, which has to be the one that owns the GL context.
+void RNDR_SubmitDrawList(Renderer* renderer, u32 pass_id)
+{
+   if (renderer == NULL)
+      return;
+
+   for (u32 key_i = 0; key_i < renderer->draw_list.visible_count; key_i++)
+   {
+      rndr_DrawCommand command = renderer->draw_list.commands[renderer->draw_list.keys[key_i].command_idx];
+
+      rndr_DrawableType* drawable_type = RNDR_GetDrawableType(renderer, command.drawable.drawable_type_idx);
+      if (drawable_type == NULL)
+         continue;
+
+      if (command.is_prepared)
+         RNDR_GeometrySubmitCommand(renderer, &command, pass_id);
+      else if (drawable_type->render != NULL)
+         drawable_type->render(renderer, command.drawable, pass_id);
+
+   }
 
 }
@@ -5,10 +5,16 @@
 #include "util/extra_types.h"
 #include "util/array.h"
 #include "util/handle.h"
+#include "util/jobs.h"
+#include "util/bvh.h"
+#include "image.h"
 #include "graphics.h"
 
 #include "renderer.h"
 
+#include <stdatomic.h>
+#include <stdio.h>
+
 #define RNDR_INVALID_LIST_LINK UINT16_MAX
 #define RNDR_INVALID_TYPE_IDX UINT16_MAX
 
@@ -18,6 +24,21 @@
 
 #define RNDR_NAME_MAX 128
 
+#define RNDR_MAX_SHADER_KEYWORDS 32
+
+#define RNDR_STREAM_THREADS 2u
+#define RNDR_DEFAULT_STREAM_BUDGET (4u << 20u)
+
+// textures used this recently are never trimmed, and trimming stops once the top mip is this small
+#define RNDR_RESIDENCY_GRACE_FRAMES 4u
+#define RNDR_RESIDENCY_MIN_SIZE 32
+
+#define RNDR_DRAW_LIST_GRAIN_SIZE 64u
+#define RNDR_DRAW_KEY_SKIP UINT64_MAX
+
+// how far drawable bounds can move before their tree proxy has to be reinserted
+#define RNDR_SPATIAL_MARGIN 0.1f
+
 enum {
    INTERNAL_RNDR_SURF_TEXTURE_RESERVED = 15,
    INTERNAL_RNDR_SURF_TEXTURE_USER_SET = 16
@@ -38,8 +59,13 @@ typedef struct rndr_DrawableType_t
 
    u32 type_size;
 
+   // where this type's drawables start in the draw list, and how many slots it has this pass
+   u32 draw_list_offset;
+   u32 draw_list_count;
+
    u16 freed_drawable_root;
    u16 culled_drawable_count;
+   bool skip_raycasts;
 
 } rndr_DrawableType;
 
@@ -58,6 +84,9 @@ typedef struct rndr_Drawable_t
 
    handle compare;
 
+   u32 bvh_proxy; // BVH_NULL_PROXY while the bounds are empty
+   u32 visible_query; // last frustum query that found it
+
    u8 mem_unused_[4];
 
    u8 data[];
@@ -76,15 +105,139 @@ typedef struct rndr_Surface_t
    u16 next_freed;
    u16 pass_count;
 
+   // bit per pass, set once that pass's shader has finished compiling
+   u8 ready_passes;
+
 } rndr_Surface;
 
+// one per drawable slot. prepared commands already have their model data filled in by a worker,
+// everything else just calls the drawable type's render func when replayed.
+typedef struct rndr_DrawCommand_t
+{
+   Drawable drawable;
+   bool is_prepared;
+
+   ModelData model_data;
+
+} rndr_DrawCommand;
+
+typedef struct rndr_DrawKey_t
+{
+   u64 sort_key;
+   u32 command_idx;
+   u32 mem_unused_;
+
+} rndr_DrawKey;
+
+typedef struct rndr_MaterialParams_t
+{
+   handle compare;
+   u16 next_freed;
+
+} rndr_MaterialParams;
+
+typedef struct rndr_MaterialBlock_t
+{
+   u8 bytes[RNDR_MATERIAL_PARAMS_SIZE];
+
+} rndr_MaterialBlock;
+
+// last data uploaded to a surface's uniform block, so unchanged blocks aren't uploaded again every draw
+typedef struct rndr_UniformBlockCache_t
+{
+   Buffer ubo;
+   uS size;
+   u8* data;
+
+} rndr_UniformBlockCache;
+
+typedef struct rndr_ProfileScope_t
+{
+   const char* name;
+   u32 index;
+   u32 gpu_timer;
+   f64 cpu_start;
+   f64 cpu_ms;
+
+} rndr_ProfileScope;
+
+// a shader file with all its includes pasted in. dependencies are hashes of every file path that went into it.
+typedef struct rndr_ShaderSource_t
+{
+   char* code;
+   u64 content_hash;
+   u64* dependencies;
+
+} rndr_ShaderSource;
+
+enum {
+   RNDR_STREAM_DECODING = 0,
+   RNDR_STREAM_DECODED,
+   RNDR_STREAM_FAILED
+
+};
+
+// the worker owns everything but state until it flips state away from decoding
+typedef struct rndr_TextureStream_t
+{
+   char* file_path;
+   Texture texture;
+   Image image;
+
+   u32 next_mip; // counts down, mips above it are already on the gpu
+   bool is_srgb;
+   bool is_allocated;
+
+   _Atomic u32 state;
+
+} rndr_TextureStream;
+
+// a cached texture the residency budget is allowed to shrink. trimmed ones have lost some top mips,
+// evicted ones are down to a single texel, both get streamed back in the next time they're bound.
+typedef struct rndr_TextureResidency_t
+{
+   char* file_path; // relative to the app path, same as the texture map key
+   Texture texture;
+   u64 last_used_frame;
+   u8 placeholder;
+   bool is_srgb;
+   bool is_trimmed;
+   bool is_evicted;
+   bool is_streaming;
+
+} rndr_TextureResidency;
+
+typedef struct rndr_ResidencyCandidate_t
+{
+   u64 last_used_frame;
+   u32 entry_idx;
+
+} rndr_ResidencyCandidate;
+
+typedef struct rndr_ShaderVariant_t
+{
+   u64 key;
+   Shader shader;
+
+} rndr_ShaderVariant;
+
 ARRAY_TYPEDEF(rndr_DrawableType);
 ARRAY_TYPEDEF(rndr_Surface);
+ARRAY_TYPEDEF(rndr_MaterialParams);
+ARRAY_TYPEDEF(rndr_MaterialBlock);
+ARRAY_TYPEDEF(rndr_UniformBlockCache);
+ARRAY_TYPEDEF(rndr_DrawCommand);
+ARRAY_TYPEDEF(rndr_DrawKey);
+ARRAY_TYPEDEF(rndr_ShaderVariant);
+ARRAY_TYPEDEF(rndr_TextureResidency);
+ARRAY_TYPEDEF(rndr_ResidencyCandidate);
 MAP_TYPEDEF(Texture);
+MAP_TYPEDEF(rndr_ShaderSource);
 
 struct Renderer_t
 {
    const char* app_path;
+   char* material_cache_directory; // ends in a slash, NULL if compiled materials aren't cached
 
    Graphics* graphics;
 
@@ -92,14 +245,91 @@ struct Renderer_t
    ARRAY_TYPE(rndr_Surface) surfaces;
    MAP_TYPE(Texture) textures;
 
+   struct {
+      JobQueue* queue;
+      rndr_TextureStream** streams;
+      uS frame_budget;
+
+   } streaming;
+
+   struct {
+      ARRAY_TYPE(rndr_TextureResidency) entries;
+      ARRAY_TYPE(rndr_ResidencyCandidate) candidates; // scratch, kept around so trimming doesn't allocate every frame
+      u32* lookup; // texture handle -> entry index + 1, 0 if the texture isn't tracked
+      uS budget; // 0 means no budget
+      u64 frame;
+
+   } residency;
+
+   struct {
+      MAP_TYPE(rndr_ShaderSource) sources;
+      ARRAY_TYPE(rndr_ShaderVariant) variants;
+
+   } shader_library;
+
    LightManagerInfo lightmanager_info;
 
+   JobPool* jobs;
+
+   struct {
+      ARRAY_TYPE(rndr_DrawCommand) commands;
+      ARRAY_TYPE(rndr_DrawKey) keys;
+      u32 visible_count;
+
+   } draw_list;
+
+   struct {
+      BVH* tree;
+      u32 query_id;
+      u32 unbounded_count; // drawables with a render func and no bounds
+
+   } spatial;
+
+   struct {
+      ARRAY_TYPE(rndr_MaterialParams) slots;
+      ARRAY_TYPE(rndr_MaterialBlock) blocks; // same layout as the storage buffer
+      ARRAY_TYPE(rndr_UniformBlockCache) ubo_cache;
+
+      Buffer ssbo;
+      u32 ssbo_capacity;
+      u32 dirty_min;
+      u32 dirty_max;
+
+      u16 freed_root;
+
+   } materials;
+
+   struct {
+      // one set of scopes per in-flight gpu timer frame, names are needed again when the gpu results come back
+      rndr_ProfileScope scopes[GFX_GPU_TIMER_LATENCY][RNDR_MAX_PROFILE_SCOPES];
+      u32 scope_counts[GFX_GPU_TIMER_LATENCY];
+      u32 frame_slot;
+
+      u64 frame_index;
+      f64 frame_start;
+      u32 visible_draws;
+
+      FrameStats last_stats;
+      FILE* dump_file;
+      bool is_enabled;
+
+   } profiler;
+
    struct {
       Buffer camera_buffer;
       Buffer model_buffer;
 
    } ubo;
 
+   struct {
+      Shader cull_shader; // loaded the first time a meshlet drawable renders
+      Buffer cull_buffer;
+      Texture pyramid;
+      mat4x4 pyramid_view_projection;
+      u32 pyramid_pass_id;
+
+   } meshlets;
+
    struct {
       union {
          Texture textures[RNDR_SURF_DEFAULT_TEXTURE_COUNT];
@@ -150,6 +380,7 @@ struct Renderer_t
       u16 update_projection: 1;
       u16 update_view_projection: 1;
       u16 user_supplied_projection: 1;
+      u16 reverse_z: 1;
 
    };
 
@@ -165,25 +396,111 @@ static inline rndr_Drawable* RNDR_DrawableAtIndex(rndr_DrawableType* drawable_ty
    return (rndr_Drawable*)(drawable_type->drawable_buffer + (uS)drawable_idx * (uS)drawable_type->type_size);
 }
 
+// sort keys group draws by drawable type first (so types draw in registration order like before).
+// opaque draws are then grouped by shader and geometry to cut down on state changes, blended ones come after them
+// back to front, since grouping those would change what ends up on top. order keeps the sort stable.
+#define RNDR_DRAW_KEY_BLENDED (1ull << 54u)
+
+static inline u64 RNDR_MakeDrawKey(u16 drawable_type_idx, Shader shader, Geometry geometry, u32 order)
+{
+   u64 key = 0;
+   key |= ((u64)(drawable_type_idx & 0xFFu)) << 55u;
+   key |= ((u64)shader.handle) << 38u;
+   key |= ((u64)geometry.handle) << 20u;
+   key |= ((u64)(order & 0xFFFFFu));
+
+   return key;
+}
+
+// view_distance is anything that grows with distance from the camera, farther draws sort first
+static inline u64 RNDR_MakeBlendedDrawKey(u16 drawable_type_idx, f32 view_distance, u32 order)
+{
+   union { f32 f; u32 u; } distance_bits = { .f = M_MAX(view_distance, 0.0f) };
+
+   u64 key = RNDR_DRAW_KEY_BLENDED;
+   key |= ((u64)(drawable_type_idx & 0xFFu)) << 55u;
+   key |= ((u64)(~distance_bits.u)) << 22u;
+   key |= ((u64)(order & 0xFFFFFu));
+
+   return key;
+}
+
+static inline color8 RNDR_PlaceholderColor(u8 placeholder)
+{
+   const color8 placeholder_colors[RNDR_SURF_DEFAULT_TEXTURE_COUNT] = {
+      { 255, 255, 255, 255 },
+      { 128, 128, 128, 255 },
+      { 0, 0, 0, 255 },
+      { 128, 128, 255, 255 }
+   };
+
+   return placeholder_colors[(placeholder < RNDR_SURF_DEFAULT_TEXTURE_COUNT) ? placeholder : RNDR_SURF_TEXTURE_GRAY];
+}
+
 Texture RNDR_CreateFloatColorTexture(Renderer* renderer, vec4 color, u8 texture_type);
 Texture RNDR_LoadTexture(Renderer* renderer, const char* texture_file_path, res2D slice_size, bool generate_mipmaps, bool is_srgb);
+TextureDesc RNDR_ImageTextureDesc(const Image* image);
+
+void RNDR_InitTextureStreaming(Renderer* renderer);
+void RNDR_FreeTextureStreaming(Renderer* renderer);
+void RNDR_UpdateTextureStreaming(Renderer* renderer);
+bool RNDR_QueueTextureStream(Renderer* renderer, const char* texture_file_path, Texture texture, bool is_srgb);
+
+void RNDR_InitTextureResidency(Renderer* renderer);
+void RNDR_FreeTextureResidency(Renderer* renderer);
+void RNDR_UpdateTextureResidency(Renderer* renderer);
+void RNDR_TrackTexture(Renderer* renderer, const char* texture_file_path, Texture texture, bool is_srgb, u8 placeholder, bool is_streaming);
+void RNDR_TouchTexture(Renderer* renderer, Texture texture);
+void RNDR_OnTextureStreamed(Renderer* renderer, Texture texture, bool is_loaded);
 
 Geometry RNDR_CreateDefaultPlane(Graphics* graphics);
 Geometry RNDR_CreateDefaultBox(Graphics* graphics);
 
 void RNDR_HandleMatrices(Renderer* renderer, res2D size);
+void RNDR_BuildDrawList(Renderer* renderer, u32 pass_id);
+void RNDR_SubmitDrawList(Renderer* renderer, u32 pass_id);
+ModelData RNDR_MakeModelData(Renderer* renderer, mat4x4 matrix, color8 color);
+void RNDR_UploadModelData(Renderer* renderer, const ModelData* model_data);
 
 u16 RNDR_GetSurfaceIndex(Renderer* renderer, const char* surface_name);
 u16 RNDR_GetDrawableTypeIndex(Renderer* renderer, const char* drawable_type_name);
 rndr_Surface* RNDR_GetSurface(Renderer* renderer, Surface res_surface);
+void RNDR_UpdateSurfaceStatus(Renderer* renderer);
 rndr_DrawableType* RNDR_GetDrawableType(Renderer* renderer, u16 drawable_type_idx);
 rndr_Drawable* RNDR_GetDrawable(Renderer* renderer, Drawable res_drawable);
 void RNDR_RegisterDefaultDrawables(Renderer* renderer);
 void RNDR_BindTextureAtSlot(Renderer* renderer, u32 bind_slot, u8 texture_default, Texture texture);
 
+void RNDR_InitSpatialIndex(Renderer* renderer);
+void RNDR_FreeSpatialIndex(Renderer* renderer);
+void RNDR_InitDrawableProxy(Renderer* renderer, rndr_Drawable* drawable, rndr_DrawableType* drawable_type);
+void RNDR_UpdateDrawableProxy(Renderer* renderer, rndr_Drawable* drawable, rndr_DrawableType* drawable_type, u16 drawable_type_idx);
+void RNDR_RemoveDrawableProxy(Renderer* renderer, rndr_Drawable* drawable, rndr_DrawableType* drawable_type);
+u32 RNDR_MarkVisibleDrawables(Renderer* renderer, Frustum frustum);
+
+void RNDR_InitShaderLibrary(Renderer* renderer);
+void RNDR_FreeShaderLibrary(Renderer* renderer);
+
+void RNDR_InitProfiler(Renderer* renderer);
+void RNDR_FreeProfiler(Renderer* renderer);
+
+void RNDR_InitMaterialTable(Renderer* renderer);
+void RNDR_FreeMaterialTable(Renderer* renderer);
+void RNDR_UploadMaterialTable(Renderer* renderer);
+u32 RNDR_MaterialParamsIndex(Renderer* renderer, MaterialParams res_params);
+void RNDR_UploadUniformBlock(Renderer* renderer, UniformBlock block, void* block_data);
+
 UniformBlockList RNDR_UpdateMaterialUBOs(Renderer* renderer, SurfaceMaterial material, u32 pass_id);
+UniformBlockList RNDR_UsePreparedSurfaceMaterial(Renderer* renderer, const ModelData* model_data, SurfaceMaterial material, u32 pass_id);
 
 void RNDR_GeometryOnCreateFunc(Renderer* renderer, Drawable self);
 void RNDR_GeometryRenderFunc(Renderer* renderer, Drawable self, u32 pass_id);
+void RNDR_GeometryPrepareCommand(Renderer* renderer, rndr_Drawable* drawable, u16 drawable_type_idx, u32 pass_id, rndr_DrawCommand* out_command, rndr_DrawKey* out_key);
+void RNDR_GeometrySubmitCommand(Renderer* renderer, const rndr_DrawCommand* command, u32 pass_id);
+
+void RNDR_InitMeshletCulling(Renderer* renderer);
+void RNDR_MeshletOnCreateFunc(Renderer* renderer, Drawable self);
+void RNDR_MeshletOnRemoveFunc(Renderer* renderer, Drawable self);
+void RNDR_MeshletRenderFunc(Renderer* renderer, Drawable self, u32 pass_id);
 
 #endif
@@ -0,0 +1,208 @@
+#include "util/types.h"
+#include "util/math.h"
+#include "util/array.h"
+#include "util/handle.h"
+#include "graphics.h"
+
+#include "renderer.h"
+#include "renderer/internal.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+MaterialParams Renderer_AddMaterialParams(Renderer* renderer, void* params, uS size)
+{
+   if (renderer == NULL)
+      return NULLHANDLE;
+
+   rndr_MaterialParams slot = { 0 };
+   MaterialParams res_params = NULLHANDLE;
+
+   if (renderer->materials.freed_root == INVALID_HANDLE)
+   {
+      res_params = ADD_HANDLE(renderer->materials.slots, slot);
+      SET_ARRAY_LENGTH(renderer->materials.blocks, Util_ArrayLength(renderer->materials.slots));
+
+   } else
+      res_params = REUSE_HANDLE(renderer->materials.slots, slot, renderer->materials.freed_root);
+
+   renderer->materials.slots[res_params.handle].next_freed = INVALID_HANDLE;
+
+   memset(&renderer->materials.blocks[res_params.handle], 0, sizeof(rndr_MaterialBlock));
+   Renderer_UpdateMaterialParams(renderer, res_params, params, size);
+
+   return res_params;
+}
+
+void Renderer_UpdateMaterialParams(Renderer* renderer, MaterialParams res_params, void* params, uS size)
+{
+   if (renderer == NULL || !Util_IsHandleValid(renderer->materials.slots, res_params))
+      return;
+
+   rndr_MaterialParams* slot = &renderer->materials.slots[res_params.handle];
+   if (slot->compare.ref != res_params.ref)
+      return;
+
+   u32 slot_idx = (u32)res_params.handle;
+   rndr_MaterialBlock* block = &renderer->materials.blocks[slot_idx];
+
+   if (params != NULL && size > 0)
+      memcpy(block->bytes, params, M_MIN(size, (uS)RNDR_MATERIAL_PARAMS_SIZE));
+
+   renderer->materials.dirty_min = M_MIN(renderer->materials.dirty_min, slot_idx);
+   renderer->materials.dirty_max = M_MAX(renderer->materials.dirty_max, slot_idx + 1);
+
+}
+
+void Renderer_RemoveMaterialParams(Renderer* renderer, MaterialParams res_params)
+{
+   // slot zero is the default material, keep it around
+   if (renderer == NULL || res_params.handle == 0 || !Util_IsHandleValid(renderer->materials.slots, res_params))
+      return;
+
+   rndr_MaterialParams* slot = &renderer->materials.slots[res_params.handle];
+   if (slot->compare.ref != res_params.ref)
+      return;
+
+   slot->next_freed = renderer->materials.freed_root;
+   renderer->materials.freed_root = res_params.handle;
+
+}
+
+Buffer Renderer_GetMaterialBuffer(Renderer* renderer)
+{
+   if (renderer == NULL)
+      return NULLHANDLE;
+
+   return renderer->materials.ssbo;
+}
+
+void RNDR_InitMaterialTable(Renderer* renderer)
+{
+   renderer->materials.slots = NEW_ARRAY_N(rndr_MaterialParams, 16);
+   renderer->materials.blocks = NEW_ARRAY_N(rndr_MaterialBlock, 16);
+   renderer->materials.ubo_cache = NEW_ARRAY_N(rndr_UniformBlockCache, 8);
+   renderer->materials.ssbo = NULLHANDLE;
+   renderer->materials.ssbo_capacity = 0;
+   renderer->materials.dirty_min = UINT32_MAX;
+   renderer->materials.dirty_max = 0;
+   renderer->materials.freed_root = INVALID_HANDLE;
+
+   Renderer_AddMaterialParams(renderer, NULL, 0);
+
+}
+
+void RNDR_FreeMaterialTable(Renderer* renderer)
+{
+   u32 cache_count = Util_ArrayLength(renderer->materials.ubo_cache);
+   for (u32 cache_i = 0; cache_i < cache_count; cache_i++)
+      free(renderer->materials.ubo_cache[cache_i].data);
+
+   FREE_ARRAY(renderer->materials.slots);
+   FREE_ARRAY(renderer->materials.blocks);
+   FREE_ARRAY(renderer->materials.ubo_cache);
+
+}
+
+void RNDR_UploadMaterialTable(Renderer* renderer)
+{
+   if (renderer == NULL)
+      return;
+
+   u32 block_count = Util_ArrayLength(renderer->materials.blocks);
+
+   if (block_count > renderer->materials.ssbo_capacity)
+   {
+      Graphics_FreeBuffer(renderer->graphics, renderer->materials.ssbo);
+
+      u32 capacity = M_MAX(renderer->materials.ssbo_capacity, 16u);
+      while (capacity < block_count)
+         capacity *= 2u;
+
+      renderer->materials.ssbo = Graphics_CreateBuffer(
+         renderer->graphics, NULL, capacity, sizeof(rndr_MaterialBlock), GFX_DRAWMODE_DYNAMIC, GFX_BUFFERTYPE_STORAGE);
+      renderer->materials.ssbo_capacity = capacity;
+      renderer->materials.dirty_min = 0;
+      renderer->materials.dirty_max = block_count;
+
+   }
+
+   u32 dirty_max = M_MIN(renderer->materials.dirty_max, block_count);
+   if (renderer->materials.dirty_min < dirty_max)
+   {
+      u32 dirty_min = renderer->materials.dirty_min;
+      Graphics_UpdateBufferRange(
+         renderer->graphics,
+         renderer->materials.ssbo,
+         &renderer->materials.blocks[dirty_min],
+         dirty_min,
+         dirty_max - dirty_min,
+         sizeof(rndr_MaterialBlock)
+      );
+
+   }
+
+   renderer->materials.dirty_min = UINT32_MAX;
+   renderer->materials.dirty_max = 0;
+
+   Graphics_BindBuffer(renderer->graphics, renderer->materials.ssbo, RNDR_MATERIAL_SSBO_BINDING);
+
+}
+
+// safe to call from a worker, only reads the table.
+u32 RNDR_MaterialParamsIndex(Renderer* renderer, MaterialParams res_params)
+{
+   if (renderer == NULL || !Util_IsHandleValid(renderer->materials.slots, res_params))
+      return 0;
+
+   rndr_MaterialParams* slot = &renderer->materials.slots[res_params.handle];
+   if (slot->compare.ref != res_params.ref || slot->next_freed != INVALID_HANDLE)
+      return 0;
+
+   return (u32)res_params.handle;
+}
+
+// uniform blocks are shared by every material using a surface pass, so the cache is keyed by buffer, not material.
+void RNDR_UploadUniformBlock(Renderer* renderer, UniformBlock block, void* block_data)
+{
+   if (renderer == NULL || block_data == NULL || block.size == 0)
+      return;
+
+   rndr_UniformBlockCache* cache = NULL;
+
+   u32 cache_count = Util_ArrayLength(renderer->materials.ubo_cache);
+   for (u32 cache_i = 0; cache_i < cache_count && cache == NULL; cache_i++)
+   {
+      if (renderer->materials.ubo_cache[cache_i].ubo.id == block.ubo.id)
+         cache = &renderer->materials.ubo_cache[cache_i];
+
+   }
+
+   if (cache == NULL)
+   {
+      rndr_UniformBlockCache new_cache = { .ubo = block.ubo, .size = 0, .data = NULL };
+      ADD_BACK_ARRAY(renderer->materials.ubo_cache, new_cache);
+
+      cache = &renderer->materials.ubo_cache[cache_count];
+
+   }
+
+   if (cache->size == block.size && memcmp(cache->data, block_data, block.size) == 0)
+      return;
+
+   if (cache->size != block.size)
+   {
+      free(cache->data);
+      cache->data = malloc(block.size);
+      cache->size = (cache->data != NULL) ? block.size : 0;
+
+   }
+
+   if (cache->data != NULL)
+      memcpy(cache->data, block_data, block.size);
+
+   Graphics_UpdateBuffer(renderer->graphics, block.ubo, block_data, 1, block.size);
+
+}
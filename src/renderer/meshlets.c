@@ -0,0 +1,332 @@
+#include "util/types.h"
+#include "util/math.h"
+#include "mesh.h"
+#include "graphics.h"
+
+#include "renderer.h"
+#include "renderer/internal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define RNDR_MESHLET_GROUP_LIMIT 65535u
+
+enum {
+   RNDR_MESHLET_CULL_CONE = (1u << 0),
+   RNDR_MESHLET_CULL_OCCLUSION = (1u << 1),
+   RNDR_MESHLET_REVERSE_Z = (1u << 2)
+
+};
+
+// std430, matches Meshlet in cs_cull_meshlets.glsl
+typedef struct rndr_PackedMeshlet_t
+{
+   vec4 bounding_sphere;
+   vec4 cone_apex;
+   vec4 cone_axis_cutoff;
+   u32 first_index;
+   u32 index_count;
+   u32 mem_unused_[2];
+
+} rndr_PackedMeshlet;
+
+// std140, matches MeshletCullUBO in cs_cull_meshlets.glsl
+typedef struct rndr_MeshletCullData_t
+{
+   mat4x4 mat_occlusion_mvp;
+   vec4 u_camera_origin; // in the drawable's object space
+   u32 u_meshlet_count;
+   u32 u_cull_flags;
+   u32 u_pyramid_width;
+   u32 u_pyramid_height;
+   u32 u_pyramid_mips;
+   u32 mem_unused_[3];
+
+} rndr_MeshletCullData;
+
+// same layout as glDrawElementsIndirect's command
+typedef struct rndr_DrawIndirectCommand_t
+{
+   u32 index_count;
+   u32 instance_count;
+   u32 first_index;
+   i32 base_vertex;
+   u32 base_instance;
+
+} rndr_DrawIndirectCommand;
+
+void RNDR_InitMeshletCulling(Renderer* renderer)
+{
+   renderer->meshlets.cull_shader.id = INVALID_HANDLE_ID;
+   renderer->meshlets.cull_buffer = Graphics_CreateBufferExplicit(
+      renderer->graphics, NULL, sizeof(rndr_MeshletCullData), GFX_DRAWMODE_DYNAMIC, GFX_BUFFERTYPE_UNIFORM);
+   renderer->meshlets.pyramid.id = INVALID_HANDLE_ID;
+   renderer->meshlets.pyramid_view_projection = Util_IdentityMat4();
+   renderer->meshlets.pyramid_pass_id = 0;
+
+}
+
+static void RNDR_FreeMeshletBuffers(Renderer* renderer, MeshletDrawable* drawable_data)
+{
+   Graphics_FreeGeometry(renderer->graphics, drawable_data->geometry);
+   Graphics_FreeBuffer(renderer->graphics, drawable_data->meshlet_buffer);
+   Graphics_FreeBuffer(renderer->graphics, drawable_data->index_buffer);
+   Graphics_FreeBuffer(renderer->graphics, drawable_data->draw_buffer);
+
+   drawable_data->geometry.id = INVALID_HANDLE_ID;
+   drawable_data->meshlet_buffer.id = INVALID_HANDLE_ID;
+   drawable_data->index_buffer.id = INVALID_HANDLE_ID;
+   drawable_data->draw_buffer.id = INVALID_HANDLE_ID;
+   drawable_data->meshlet_count = 0;
+
+}
+
+void RNDR_MeshletOnCreateFunc(Renderer* renderer, Drawable self)
+{
+   rndr_Drawable* drawable = RNDR_GetDrawable(renderer, self);
+   if (drawable == NULL)
+      return;
+
+   MeshletDrawable* drawable_data = (MeshletDrawable*)drawable->data;
+   drawable_data->geometry.id = INVALID_HANDLE_ID;
+   drawable_data->meshlet_buffer.id = INVALID_HANDLE_ID;
+   drawable_data->index_buffer.id = INVALID_HANDLE_ID;
+   drawable_data->draw_buffer.id = INVALID_HANDLE_ID;
+   drawable_data->color.hex = 0xFFFFFFFF;
+   drawable_data->transform = Util_IdentityTransform();
+
+}
+
+void RNDR_MeshletOnRemoveFunc(Renderer* renderer, Drawable self)
+{
+   rndr_Drawable* drawable = RNDR_GetDrawable(renderer, self);
+   if (drawable == NULL)
+      return;
+
+   RNDR_FreeMeshletBuffers(renderer, (MeshletDrawable*)drawable->data);
+
+}
+
+bool Renderer_SetMeshletDrawableMesh(Renderer* renderer, Drawable res_drawable, Mesh mesh, MeshletData meshlets)
+{
+   if (renderer == NULL)
+      return false;
+
+   rndr_DrawableType* drawable_type = RNDR_GetDrawableType(renderer, res_drawable.drawable_type_idx);
+   rndr_Drawable* drawable = RNDR_GetDrawable(renderer, res_drawable);
+   if (drawable_type == NULL || drawable == NULL || drawable_type->render != RNDR_MeshletRenderFunc)
+      return false;
+
+   u32 first_meshlet = mesh.first_meshlet;
+   u32 meshlet_count = mesh.meshlet_count;
+   if (meshlet_count == 0)
+   {
+      first_meshlet = 0;
+      meshlet_count = meshlets.meshlet_count;
+
+   }
+
+   if (mesh.vertex_buffer == NULL || meshlets.meshlets == NULL || meshlet_count == 0 || first_meshlet > meshlets.meshlet_count || meshlet_count > meshlets.meshlet_count - first_meshlet)
+      return false;
+
+   u32 index_count = 0;
+   for (u32 meshlet_i = 0; meshlet_i < meshlet_count; meshlet_i++)
+   {
+      Meshlet meshlet = meshlets.meshlets[first_meshlet + meshlet_i];
+      if ((u64)meshlet.vertex_offset + meshlet.vertex_count > meshlets.vertex_count || (u64)meshlet.triangle_offset + meshlet.triangle_count > meshlets.triangle_count)
+         return false;
+
+      index_count += meshlet.triangle_count * 3u;
+
+   }
+
+   u32* indices = malloc(sizeof(u32) * (uS)M_MAX(index_count, 1u));
+   rndr_PackedMeshlet* packed_meshlets = malloc(sizeof(rndr_PackedMeshlet) * (uS)meshlet_count);
+   if (indices == NULL || packed_meshlets == NULL)
+   {
+      free(indices);
+      free(packed_meshlets);
+
+      return false;
+   }
+
+   // the meshlet's local triangles are resolved to mesh vertices here, so the culling only has to copy them
+   u32 first_index = 0;
+   for (u32 meshlet_i = 0; meshlet_i < meshlet_count; meshlet_i++)
+   {
+      Meshlet meshlet = meshlets.meshlets[first_meshlet + meshlet_i];
+      const u8* triangles = meshlets.triangles + (uS)meshlet.triangle_offset * 3u;
+      const u32* vertices = meshlets.vertices + meshlet.vertex_offset;
+
+      for (u32 corner_i = 0; corner_i < meshlet.triangle_count * 3u; corner_i++)
+      {
+         u32 local_index = triangles[corner_i];
+         if (local_index >= meshlet.vertex_count || vertices[local_index] >= mesh.vertex_count)
+         {
+            free(indices);
+            free(packed_meshlets);
+
+            return false;
+         }
+
+         indices[first_index + corner_i] = vertices[local_index];
+
+      }
+
+      packed_meshlets[meshlet_i] = (rndr_PackedMeshlet){
+         .bounding_sphere = meshlet.bounding_sphere,
+         .cone_apex = (vec4){ .xyz = meshlet.cone_apex, .w = 1.0f },
+         .cone_axis_cutoff = (vec4){ .xyz = meshlet.cone_axis, .w = meshlet.cone_cutoff },
+         .first_index = first_index,
+         .index_count = meshlet.triangle_count * 3u
+      };
+
+      first_index += meshlet.triangle_count * 3u;
+
+   }
+
+   Mesh draw_mesh = mesh;
+   draw_mesh.index_buffer = indices;
+   draw_mesh.index_count = index_count;
+   draw_mesh.index_type = MESH_INDEXTYPE_32BIT;
+
+   // built on the side, so a failure leaves whatever the drawable had before alone
+   MeshletDrawable built = { 0 };
+   rndr_DrawIndirectCommand command = { .index_count = 0, .instance_count = 1 };
+   built.geometry = Graphics_CreateGeometry(renderer->graphics, draw_mesh, GFX_DRAWMODE_STATIC);
+   built.meshlet_buffer = Graphics_CreateBuffer(
+      renderer->graphics, packed_meshlets, meshlet_count, sizeof(rndr_PackedMeshlet), GFX_DRAWMODE_STATIC, GFX_BUFFERTYPE_STORAGE);
+   built.index_buffer = Graphics_CreateBuffer(
+      renderer->graphics, indices, index_count, sizeof(u32), GFX_DRAWMODE_STATIC, GFX_BUFFERTYPE_STORAGE);
+   built.draw_buffer = Graphics_CreateBufferExplicit(
+      renderer->graphics, &command, sizeof(rndr_DrawIndirectCommand), GFX_DRAWMODE_DYNAMIC, GFX_BUFFERTYPE_STORAGE);
+
+   free(indices);
+   free(packed_meshlets);
+
+   bool is_created =
+      (built.geometry.id != INVALID_HANDLE_ID) && (built.meshlet_buffer.id != INVALID_HANDLE_ID) &&
+      (built.index_buffer.id != INVALID_HANDLE_ID) && (built.draw_buffer.id != INVALID_HANDLE_ID);
+
+   if (!is_created)
+   {
+      RNDR_FreeMeshletBuffers(renderer, &built);
+
+      return false;
+   }
+
+   MeshletDrawable* drawable_data = (MeshletDrawable*)drawable->data;
+   RNDR_FreeMeshletBuffers(renderer, drawable_data);
+
+   drawable_data->geometry = built.geometry;
+   drawable_data->meshlet_buffer = built.meshlet_buffer;
+   drawable_data->index_buffer = built.index_buffer;
+   drawable_data->draw_buffer = built.draw_buffer;
+   drawable_data->meshlet_count = meshlet_count;
+
+   return true;
+}
+
+void Renderer_SetOcclusionPyramid(Renderer* renderer, Texture pyramid, mat4x4 view_projection, u32 pass_id)
+{
+   if (renderer == NULL)
+      return;
+
+   renderer->meshlets.pyramid = pyramid;
+   renderer->meshlets.pyramid_view_projection = view_projection;
+   renderer->meshlets.pyramid_pass_id = pass_id;
+
+}
+
+// returns false if nothing was dispatched, the draw buffer can't be trusted then
+static bool RNDR_CullMeshlets(Renderer* renderer, MeshletDrawable* drawable_data, const ModelData* model_data, u8 cull_mode, u32 pass_id)
+{
+   if (renderer->meshlets.cull_shader.id == INVALID_HANDLE_ID)
+      renderer->meshlets.cull_shader = Renderer_GetShaderVariant(renderer, "assets/core/shaders/cs_cull_meshlets.glsl", NULL, 0, SHADER_VARIANT_COMPUTE);
+
+   if (renderer->meshlets.cull_shader.id == INVALID_HANDLE_ID)
+      return false;
+
+   rndr_MeshletCullData cull_data = { 0 };
+   cull_data.mat_occlusion_mvp = Util_MulMat4(renderer->meshlets.pyramid_view_projection, model_data->mat_model);
+   cull_data.u_camera_origin = Util_MulMat4Vec4(model_data->mat_invmodel, renderer->inv_view.v[3]);
+   cull_data.u_meshlet_count = drawable_data->meshlet_count;
+
+   // cones only hold for back face culling, and a mirroring transform flips which side is the front
+   mat4x4 matrix = model_data->mat_model;
+   f32 determinant = Util_DotVec3(Util_CrossVec3(matrix.v[0].xyz, matrix.v[1].xyz), matrix.v[2].xyz);
+   if (cull_mode == GFX_FACECULL_BACK && determinant > 0.0f)
+      cull_data.u_cull_flags |= RNDR_MESHLET_CULL_CONE;
+
+   if (renderer->reverse_z)
+      cull_data.u_cull_flags |= RNDR_MESHLET_REVERSE_Z;
+
+   TextureDesc pyramid_desc = Graphics_GetTextureDesc(renderer->graphics, renderer->meshlets.pyramid);
+   if (renderer->meshlets.pyramid_pass_id == pass_id && pyramid_desc.size.width > 0 && pyramid_desc.size.height > 0)
+   {
+      cull_data.u_cull_flags |= RNDR_MESHLET_CULL_OCCLUSION;
+      cull_data.u_pyramid_width = (u32)pyramid_desc.size.width;
+      cull_data.u_pyramid_height = (u32)pyramid_desc.size.height;
+      cull_data.u_pyramid_mips = M_MAX((u32)pyramid_desc.mipmap_count, 1u);
+
+      Graphics_BindTexture(renderer->graphics, renderer->meshlets.pyramid, RNDR_MESHLET_PYRAMID_SLOT);
+
+   }
+
+   rndr_DrawIndirectCommand command = { .index_count = 0, .instance_count = 1 };
+   Graphics_UpdateBuffer(renderer->graphics, drawable_data->draw_buffer, &command, 1, sizeof(rndr_DrawIndirectCommand));
+   Graphics_UpdateBuffer(renderer->graphics, renderer->meshlets.cull_buffer, &cull_data, 1, sizeof(rndr_MeshletCullData));
+
+   Graphics_BindBuffer(renderer->graphics, renderer->meshlets.cull_buffer, RNDR_MESHLET_UBO_BINDING);
+   Graphics_BindBuffer(renderer->graphics, drawable_data->meshlet_buffer, RNDR_MESHLET_SSBO_BINDING);
+   Graphics_BindBuffer(renderer->graphics, drawable_data->index_buffer, RNDR_MESHLET_SSBO_BINDING + 1);
+   if (!Graphics_BindGeometryIndexBuffer(renderer->graphics, drawable_data->geometry, RNDR_MESHLET_SSBO_BINDING + 2))
+      return false;
+
+   Graphics_BindBuffer(renderer->graphics, drawable_data->draw_buffer, RNDR_MESHLET_SSBO_BINDING + 3);
+
+   // one workgroup per meshlet, folded into rows when there are more than a dispatch dimension allows
+   u32 group_x = M_MIN(drawable_data->meshlet_count, RNDR_MESHLET_GROUP_LIMIT);
+   u32 group_y = (drawable_data->meshlet_count + group_x - 1u) / group_x;
+
+   Graphics_Dispatch(renderer->graphics, renderer->meshlets.cull_shader, group_x, group_y, 1, (UniformBlockList){ .count = 0 });
+   Graphics_DispatchBarrier(renderer->graphics);
+
+   return true;
+}
+
+void RNDR_MeshletRenderFunc(Renderer* renderer, Drawable self, u32 pass_id)
+{
+   rndr_Drawable* drawable = RNDR_GetDrawable(renderer, self);
+   if (drawable == NULL)
+      return;
+
+   MeshletDrawable* drawable_data = (MeshletDrawable*)drawable->data;
+   if (drawable_data->meshlet_count == 0)
+      return;
+
+   rndr_Surface* surface = RNDR_GetSurface(renderer, drawable_data->material.surface);
+   if (surface == NULL || surface->pass_count < pass_id + 1)
+      return;
+
+   SurfacePass pass = surface->passes[pass_id];
+
+   ModelData model_data = RNDR_MakeModelData(renderer, Util_TransformationMatrix(drawable_data->transform), drawable_data->color);
+   model_data.u_material_id = RNDR_MaterialParamsIndex(renderer, drawable_data->material.params);
+
+   // uploads the model UBO, which the culling reads too
+   UniformBlockList uniform_blocks = RNDR_UsePreparedSurfaceMaterial(renderer, &model_data, drawable_data->material, pass_id);
+
+   bool is_culled = RNDR_CullMeshlets(renderer, drawable_data, &model_data, pass.cull_mode, pass_id);
+
+   Graphics_SetBlending(renderer->graphics, pass.blend_mode);
+   Graphics_SetGeometryFaceCullMode(renderer->graphics, drawable_data->geometry, pass.cull_mode);
+   Graphics_SetDepthTest(renderer->graphics, pass.depth_mode);
+
+   // culling never ran on this geometry if it can't run now, so its index buffer still has every meshlet in it
+   if (is_culled)
+      Graphics_DrawIndirect(renderer->graphics, pass.shader, drawable_data->geometry, drawable_data->draw_buffer, 0, uniform_blocks);
+   else
+      Graphics_Draw(renderer->graphics, pass.shader, drawable_data->geometry, uniform_blocks);
+
+}
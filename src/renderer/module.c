@@ -3,6 +3,7 @@
 #include "util/array.h"
 #include "util/files.h"
 #include "util/matrix.h"
+#include "util/jobs.h"
 #include "mesh.h"
 #include "image.h"
 #include "graphics.h"
@@ -12,7 +13,9 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 Renderer* Renderer_Init(Graphics* graphics, const char* app_path)
@@ -25,6 +28,7 @@ Renderer* Renderer_Init(Graphics* graphics, const char* app_path)
       return NULL;
 
    renderer->app_path = app_path;
+   renderer->material_cache_directory = NULL;
    renderer->graphics = graphics;
 
    renderer->surfaces = NEW_ARRAY_N(rndr_Surface, 16);
@@ -33,8 +37,25 @@ Renderer* Renderer_Init(Graphics* graphics, const char* app_path)
 
    renderer->lightmanager_info = (LightManagerInfo){ 0 };
 
+   renderer->jobs = Util_CreateJobPool(0);
+   renderer->draw_list.commands = NEW_ARRAY_N(rndr_DrawCommand, 64);
+   renderer->draw_list.keys = NEW_ARRAY_N(rndr_DrawKey, 64);
+   renderer->draw_list.visible_count = 0;
+
    renderer->freed_surface_root = RNDR_INVALID_LIST_LINK;
 
+   if (app_path != NULL)
+   {
+      char* cache_path = Util_MakeFilePath(app_path, "shader_cache");
+      Graphics_SetShaderCacheDirectory(graphics, cache_path);
+      free(cache_path);
+
+      cache_path = Util_MakeFilePath(app_path, "material_cache");
+      Renderer_SetMaterialCacheDirectory(renderer, cache_path);
+      free(cache_path);
+
+   }
+
    renderer->built_in.texture.white = Renderer_CreateColorTexture(renderer, Util_IntToColor(0XFFFFFFFF), GFX_TEXTURETYPE_2D);
    renderer->built_in.texture.black = Renderer_CreateColorTexture(renderer, Util_IntToColor(0x000000FF), GFX_TEXTURETYPE_2D);
    renderer->built_in.texture.gray = Renderer_CreateColorTexture(renderer, (color8){ 128, 128, 128, 255 }, GFX_TEXTURETYPE_2D);
@@ -51,6 +72,14 @@ Renderer* Renderer_Init(Graphics* graphics, const char* app_path)
    renderer->ubo.model_buffer = Graphics_CreateBufferExplicit(
       renderer->graphics, NULL, sizeof(ModelData), GFX_DRAWMODE_DYNAMIC, GFX_BUFFERTYPE_UNIFORM);
 
+   RNDR_InitMaterialTable(renderer);
+   RNDR_InitProfiler(renderer);
+   RNDR_InitShaderLibrary(renderer);
+   RNDR_InitTextureStreaming(renderer);
+   RNDR_InitTextureResidency(renderer);
+   RNDR_InitMeshletCulling(renderer);
+   RNDR_InitSpatialIndex(renderer);
+
    Graphics_CheckErrors(graphics);
 
    renderer->near_clip = 0.05f;
@@ -60,6 +89,7 @@ Renderer* Renderer_Init(Graphics* graphics, const char* app_path)
    renderer->size = (res2D){ 1, 1 };
    renderer->update_projection = true;
    renderer->update_view_projection = true;
+   renderer->reverse_z = false;
 
    renderer->view = Util_IdentityMat4();
    renderer->inv_view = Util_IdentityMat4();
@@ -83,7 +113,18 @@ void Renderer_Free(Renderer* renderer)
    FREE_ARRAY(renderer->surfaces);
    FREE_ARRAY(renderer->drawable_types);
    FREE_MAP(renderer->textures);
-
+   FREE_ARRAY(renderer->draw_list.commands);
+   FREE_ARRAY(renderer->draw_list.keys);
+
+   RNDR_FreeMaterialTable(renderer);
+   RNDR_FreeProfiler(renderer);
+   RNDR_FreeShaderLibrary(renderer);
+   RNDR_FreeTextureStreaming(renderer);
+   RNDR_FreeTextureResidency(renderer);
+   RNDR_FreeSpatialIndex(renderer);
+   Util_FreeJobPool(renderer->jobs);
+
+   free(renderer->material_cache_directory);
    free(renderer);
 
 }
@@ -96,11 +137,22 @@ Graphics* Renderer_GetGraphics(Renderer* renderer)
    return renderer->graphics;
 }
 
+JobPool* Renderer_GetJobPool(Renderer* renderer)
+{
+   if (renderer == NULL)
+      return NULL;
+
+   return renderer->jobs;
+}
+
 void Renderer_PreRender(Renderer* renderer)
 {
    if (renderer == NULL)
       return;
 
+   RNDR_UpdateTextureStreaming(renderer);
+   RNDR_UpdateTextureResidency(renderer);
+
    if (renderer->lightmanager_info.lightman_prerender != NULL)
       renderer->lightmanager_info.lightman_prerender(renderer, 0);
 
@@ -113,6 +165,8 @@ void Renderer_RenderPass(Renderer* renderer, res2D size, f64 engine_frame_delta,
 
    renderer->frame_delta = (f32)engine_frame_delta;
 
+   u32 pass_scope = Renderer_BeginProfileScope(renderer, "render_pass", pass_id);
+
    RNDR_HandleMatrices(renderer, size);
 
    CameraData camera_data = { 0 };
@@ -124,37 +178,27 @@ void Renderer_RenderPass(Renderer* renderer, res2D size, f64 engine_frame_delta,
    camera_data.u_height = (u32)size.height;
    camera_data.u_near_clip = renderer->near_clip;
    camera_data.u_far_clip = renderer->far_clip;
+   camera_data.u_proj_info = (renderer->reverse_z) ? VEC4(1, 1, 0, 0) : VEC4(-1, 0, 0, 0);
 
    Graphics_UpdateBuffer(renderer->graphics, renderer->ubo.camera_buffer, &camera_data, 1, sizeof(CameraData));
    Graphics_BindBuffer(renderer->graphics, renderer->ubo.camera_buffer, 1);
 
+   RNDR_UploadMaterialTable(renderer);
+
    if (renderer->lightmanager_info.lightman_on_render != NULL)
       renderer->lightmanager_info.lightman_on_render(renderer, pass_id);
 
-   u32 drawable_type_count = Util_ArrayLength(renderer->drawable_types);
-   for (u32 type_i = 0; type_i < drawable_type_count; type_i++)
-   {
-      rndr_DrawableType* drawable_type = &renderer->drawable_types[type_i];
-      if (drawable_type->render == NULL)
-         continue;
-
-      u32 drawable_count = Util_ArrayLength(drawable_type->drawable_buffer);
-
-      for (u32 drawable_i = 0; drawable_i < drawable_count; drawable_i++)
-      {
-         rndr_Drawable* drawable = RNDR_DrawableAtIndex(drawable_type, drawable_i);
-         if (drawable == NULL || !drawable->enabled || drawable->next_freed != INVALID_HANDLE)
-            continue;
+   u32 build_scope = Renderer_BeginProfileScope(renderer, "build_draw_list", pass_id);
+   RNDR_BuildDrawList(renderer, pass_id);
+   Renderer_EndProfileScope(renderer, build_scope);
 
-         Drawable drawable_handle = { 0 };
-         drawable_handle.id = drawable->compare.id;
-         drawable_handle.drawable_type_idx = type_i;
+   u32 submit_scope = Renderer_BeginProfileScope(renderer, "submit_draw_list", pass_id);
+   RNDR_SubmitDrawList(renderer, pass_id);
+   Renderer_EndProfileScope(renderer, submit_scope);
 
-         drawable_type->render(renderer, drawable_handle, pass_id);
+   renderer->profiler.visible_draws += renderer->draw_list.visible_count;
 
-      }
-
-   }
+   Renderer_EndProfileScope(renderer, pass_scope);
 
 }
 
@@ -162,6 +206,10 @@ void Renderer_SetTexture(Renderer* renderer, Texture texture, u32 bind_slot)
 {
    RNDR_BindTextureAtSlot(renderer, bind_slot, INTERNAL_RNDR_SURF_TEXTURE_USER_SET, texture);
 
+   // textures set this way keep their own parameters, don't let a material's sampler override them
+   if (renderer != NULL && bind_slot < SURF_MAX_TEXTURES && renderer->texture_slots[bind_slot] == INTERNAL_RNDR_SURF_TEXTURE_USER_SET)
+      Graphics_UnbindSampler(renderer->graphics, bind_slot);
+
 }
 
 void Renderer_SetTextureToDefault(Renderer* renderer, u8 texture_default, u32 bind_slot)
@@ -199,6 +247,14 @@ void Renderer_UploadModelData(Renderer* renderer, mat4x4 matrix, color8 color)
    if (renderer == NULL)
       return;
 
+   ModelData model_data = RNDR_MakeModelData(renderer, matrix, color);
+   RNDR_UploadModelData(renderer, &model_data);
+
+}
+
+// doesn't touch any GL state, so it's safe to call from a worker.
+ModelData RNDR_MakeModelData(Renderer* renderer, mat4x4 matrix, color8 color)
+{
    ModelData model_data = { 0 };
    model_data.mat_model = matrix;
    model_data.mat_invmodel = Util_InverseMat4(model_data.mat_model);
@@ -210,7 +266,15 @@ void Renderer_UploadModelData(Renderer* renderer, mat4x4 matrix, color8 color)
    model_data.mat_normal_model[1].xyz = mat_normal_model.v[1].xyz;
    model_data.mat_normal_model[2].xyz = mat_normal_model.v[2].xyz;
 
-   Graphics_UpdateBuffer(renderer->graphics, renderer->ubo.model_buffer, &model_data, 1, sizeof(ModelData));
+   return model_data;
+}
+
+void RNDR_UploadModelData(Renderer* renderer, const ModelData* model_data)
+{
+   if (renderer == NULL || model_data == NULL)
+      return;
+
+   Graphics_UpdateBuffer(renderer->graphics, renderer->ubo.model_buffer, (void*)model_data, 1, sizeof(ModelData));
    Graphics_BindBuffer(renderer->graphics, renderer->ubo.model_buffer, 2);
 
 }
@@ -261,6 +325,25 @@ void Renderer_SetClippingPlanes(Renderer* renderer, f32 near_clip, f32 far_clip)
 
 }
 
+bool Renderer_EnableReverseZ(Renderer* renderer, bool enable_reverse_z)
+{
+   if (renderer == NULL)
+      return false;
+
+   renderer->reverse_z = Graphics_EnableReverseZ(renderer->graphics, enable_reverse_z);
+   renderer->update_projection = true;
+
+   return renderer->reverse_z;
+}
+
+bool Renderer_IsReverseZ(Renderer* renderer)
+{
+   if (renderer == NULL)
+      return false;
+
+   return renderer->reverse_z;
+}
+
 void Renderer_UpdateCamera(Renderer* renderer, vec3 origin, vec3 euler, f32 distance)
 {
    if (renderer == NULL)
@@ -479,6 +562,10 @@ Texture Renderer_LoadTexture(Renderer* renderer, const char* texture_file_path,
       Texture texture = RNDR_LoadTexture(renderer, texture_file_path, slice_size, generate_mipmaps, is_srgb);
       texture_ptr = ADD_MAP_ITEM(renderer->textures, texture_file_path, texture);
 
+      // slice atlases can't be streamed back in, so they stay out of the budget
+      if (slice_size.width <= 0 || slice_size.height <= 0)
+         RNDR_TrackTexture(renderer, texture_file_path, texture, is_srgb, RNDR_SURF_TEXTURE_GRAY, false);
+
    }
 
    if (texture_ptr == NULL)
@@ -502,6 +589,21 @@ Shader Renderer_LoadShader(Renderer* renderer, const char* shader_file_path, con
    return shader;
 }
 
+Shader Renderer_LoadShaderAsync(Renderer* renderer, const char* shader_file_path, const char* defines[], const u32 defines_count, bool is_compute)
+{
+   if (renderer == NULL || renderer->app_path == NULL || shader_file_path == NULL)
+      return NULLHANDLE;
+
+   char* file_path = Util_MakeFilePath(renderer->app_path, shader_file_path);
+
+   Shader shader = Graphics_LoadShaderFromFileAsync(renderer->graphics, file_path, defines, defines_count, is_compute);
+
+   if (file_path != NULL)
+      free(file_path);
+
+   return shader;
+}
+
 Model Renderer_LoadModel(Renderer* renderer, const char* model_file_path)
 {
    if (renderer == NULL || renderer->app_path == NULL || model_file_path == NULL)
@@ -509,14 +611,47 @@ Model Renderer_LoadModel(Renderer* renderer, const char* model_file_path)
 
    char* file_path = Util_MakeFilePath(renderer->app_path, model_file_path);
    char* mat_path = Util_ReplaceFileExtension(file_path, ".mat");
-   memblob file_data = Util_LoadFileIntoMemory(file_path, true);
    memblob mat_data = Util_LoadFileIntoMemory(mat_path, false);
 
-   Model model = Mesh_LoadEctorModel(file_data);
-   Mesh_ParseEctorMaterials(mat_data, &model);
+   // the meshes read straight out of the mapping, so the file is never copied onto the heap. any that still need
+   // decoding get spread across the renderer's pool
+   Model model = { 0 };
+   MmapBlob mapping = Util_MapFile(file_path);
 
-   if (file_data.data != NULL)
-      free(file_data.data);
+   if (mapping.data != NULL)
+   {
+      model = Mesh_LoadEctorModelMappedParallel(mapping, (MeshLoadDesc){ 0 }, renderer->jobs);
+
+   } else {
+      memblob file_data = Util_LoadFileIntoMemory(file_path, true);
+      model = Mesh_LoadEctorModelParallel(file_data, (MeshLoadDesc){ 0 }, renderer->jobs);
+
+      if (file_data.data != NULL)
+         free(file_data.data);
+
+   }
+
+   // the compiled cache is only used while it still matches the .mat, otherwise it gets rebuilt
+   char* cache_path = NULL;
+   if (renderer->material_cache_directory != NULL)
+   {
+      char cache_name[32] = { 0 };
+      snprintf(cache_name, sizeof(cache_name), "%016llx.matb", (unsigned long long)Util_HashBytes(model_file_path, strlen(model_file_path), UTIL_HASH_SEED));
+      cache_path = Util_MakeFilePath(renderer->material_cache_directory, cache_name);
+
+   }
+
+   if (mat_data.data != NULL && (cache_path == NULL || !Mesh_LoadEctorMaterialCache(Util_MapFile(cache_path), mat_data, &model)))
+   {
+      Mesh_ParseEctorMaterials(mat_data, &model);
+
+      memblob cache_data = (cache_path != NULL) ? Mesh_WriteEctorMaterialCache(model, mat_data) : (memblob){ 0 };
+      if (cache_data.data != NULL && !Util_SaveMemoryToFile(cache_path, cache_data))
+         Util_Log(NULL, RENDERER_MODULE, (error){ .general = ERR_LEVEL_WARN }, "Couldn't write material cache '%s'", cache_path);
+
+      free(cache_data.data);
+
+   }
 
    if (file_path != NULL)
       free(file_path);
@@ -524,12 +659,37 @@ Model Renderer_LoadModel(Renderer* renderer, const char* model_file_path)
    if (mat_path != NULL)
       free(mat_path);
 
+   if (cache_path != NULL)
+      free(cache_path);
+
    if (mat_data.data != NULL)
       free(mat_data.data);
 
    return model;
 }
 
+void Renderer_SetMaterialCacheDirectory(Renderer* renderer, const char* directory_path)
+{
+   if (renderer == NULL)
+      return;
+
+   free(renderer->material_cache_directory);
+   renderer->material_cache_directory = NULL;
+
+   if (directory_path == NULL)
+      return;
+
+   if (!Util_MakeDirectory(directory_path))
+   {
+      Util_Log(NULL, RENDERER_MODULE, (error){ .general = ERR_LEVEL_WARN }, "Material cache disabled (directory: %s)", directory_path);
+
+      return;
+   }
+
+   renderer->material_cache_directory = Util_MakeDirectoryPath(directory_path);
+
+}
+
 Texture RNDR_CreateFloatColorTexture(Renderer* renderer, vec4 color, u8 texture_type)
 {
    return Graphics_CreateTexture(renderer->graphics, (u8*)color.arr, (TextureDesc){ { 1, 1 }, 1, 1, texture_type, GFX_TEXTUREFORMAT_RGBA_F32 });
@@ -546,7 +706,10 @@ Texture RNDR_LoadTexture(Renderer* renderer, const char* texture_file_path, res2
 
    memblob file_data = Util_LoadFileIntoMemory(file_path, true);
    Image image = Image_CreateImage(file_data, image_type, slice_size, is_srgb);
-   if (generate_mipmaps)
+
+   // plain 2D textures get their mips built on the gpu, slice atlases keep the cpu path
+   bool gpu_mipmaps = (generate_mipmaps && image_type == IMG_TYPE_2D && image.mipmap_count <= 1 && !Image_IsCompressed(image.image_format));
+   if (generate_mipmaps && !gpu_mipmaps)
       Image_GenerateMipmaps(&image);
 
    if (file_data.data != NULL)
@@ -558,22 +721,55 @@ Texture RNDR_LoadTexture(Renderer* renderer, const char* texture_file_path, res2
    if (image.data == NULL)
       return NULLHANDLE;
 
-   TextureDesc desc = { 0 };
-   desc.size = image.size.width_height;
-   desc.depth = image.size.depth;
-   desc.mipmap_count = image.mipmap_count;
-   desc.texture_type = (image_type == IMG_TYPE_2D) ? GFX_TEXTURETYPE_2D : GFX_TEXTURETYPE_3D;
-   if (image.image_format == IMG_FORMAT_U8_SRGB)
-      desc.texture_format = (image.channel_count == 4) ? GFX_TEXTUREFORMAT_SRGB_ALPHA : GFX_TEXTUREFORMAT_SRGB;
-   else
-      desc.texture_format = ((image.image_format == IMG_FORMAT_F32) ? GFX_TEXTUREFORMAT_R_F32 : GFX_TEXTUREFORMAT_R_U8_NORM) + image.channel_count - 1;
+   TextureDesc desc = RNDR_ImageTextureDesc(&image);
+
+   Texture texture = NULLHANDLE;
+   if (gpu_mipmaps)
+   {
+      desc.mipmap_count = 0;
+      texture = Graphics_CreateTextureWithMips(renderer->graphics, image.data, desc, GFX_MIPFILTER_BOX);
+
+   } else
+      texture = Graphics_CreateTexture(renderer->graphics, image.data, desc);
 
-   Texture texture = Graphics_CreateTexture(renderer->graphics, image.data, desc);
    Image_Free(&image);
 
    return texture;
 }
 
+TextureDesc RNDR_ImageTextureDesc(const Image* image)
+{
+   TextureDesc desc = { 0 };
+   desc.size = image->size.width_height;
+   desc.depth = image->size.depth;
+   desc.mipmap_count = image->mipmap_count;
+   desc.texture_type = (image->image_type == IMG_TYPE_2D) ? GFX_TEXTURETYPE_2D : GFX_TEXTURETYPE_3D;
+
+   switch (image->image_format)
+   {
+      default:
+         break;
+
+      case IMG_FORMAT_BC1: desc.texture_format = GFX_TEXTUREFORMAT_RGBA_BC1; return desc;
+      case IMG_FORMAT_BC1_SRGB: desc.texture_format = GFX_TEXTUREFORMAT_SRGB_ALPHA_BC1; return desc;
+      case IMG_FORMAT_BC3: desc.texture_format = GFX_TEXTUREFORMAT_RGBA_BC3; return desc;
+      case IMG_FORMAT_BC3_SRGB: desc.texture_format = GFX_TEXTUREFORMAT_SRGB_ALPHA_BC3; return desc;
+      case IMG_FORMAT_BC4: desc.texture_format = GFX_TEXTUREFORMAT_R_BC4; return desc;
+      case IMG_FORMAT_BC5: desc.texture_format = GFX_TEXTUREFORMAT_RG_BC5; return desc;
+      case IMG_FORMAT_BC6H: desc.texture_format = GFX_TEXTUREFORMAT_RGB_UNSIGNED_BC6; return desc;
+      case IMG_FORMAT_BC7: desc.texture_format = GFX_TEXTUREFORMAT_RGBA_BC7; return desc;
+      case IMG_FORMAT_BC7_SRGB: desc.texture_format = GFX_TEXTUREFORMAT_SRGB_ALPHA_BC7; return desc;
+
+   }
+
+   if (image->image_format == IMG_FORMAT_U8_SRGB)
+      desc.texture_format = (image->channel_count == 4) ? GFX_TEXTUREFORMAT_SRGB_ALPHA : GFX_TEXTUREFORMAT_SRGB;
+   else
+      desc.texture_format = ((image->image_format == IMG_FORMAT_F32) ? GFX_TEXTUREFORMAT_R_F32 : GFX_TEXTUREFORMAT_R_U8_NORM) + image->channel_count - 1;
+
+   return desc;
+}
+
 Geometry RNDR_CreateDefaultPlane(Graphics* graphics)
 {
    if (graphics == NULL)
@@ -614,7 +810,11 @@ void RNDR_HandleMatrices(Renderer* renderer, res2D size)
 
    if (renderer->update_projection && !renderer->user_supplied_projection)
    {
-      renderer->projection = Util_PerspectiveMatrix(renderer->fov, renderer->aspect_ratio, renderer->near_clip, renderer->far_clip);
+      if (renderer->reverse_z)
+         renderer->projection = Util_InfiniteReverseZPerspectiveMatrix(renderer->fov, renderer->aspect_ratio, renderer->near_clip);
+      else
+         renderer->projection = Util_PerspectiveMatrix(renderer->fov, renderer->aspect_ratio, renderer->near_clip, renderer->far_clip);
+
       renderer->inv_projection = Util_InverseMat4(renderer->projection);
       renderer->update_view_projection = true;
       renderer->update_projection = false;
@@ -644,14 +844,8 @@ void RNDR_GeometryOnCreateFunc(Renderer* renderer, Drawable self)
 
 }
 
-void RNDR_GeometryRenderFunc(Renderer* renderer, Drawable self, u32 pass_id)
+static void RNDR_DrawGeometry(Renderer* renderer, GeometryDrawable* drawable_data, const ModelData* model_data, u32 pass_id)
 {
-   rndr_Drawable* drawable = RNDR_GetDrawable(renderer, self);
-   GeometryDrawable* drawable_data = (GeometryDrawable*)drawable->data;
-
-   if (drawable_data == NULL)
-      return;
-
    rndr_Surface* surface = RNDR_GetSurface(renderer, drawable_data->material.surface);
    if (surface == NULL || surface->pass_count < pass_id + 1)
       return;
@@ -665,13 +859,75 @@ void RNDR_GeometryRenderFunc(Renderer* renderer, Drawable self, u32 pass_id)
       renderer->graphics,
       surface->passes[pass_id].shader,
       drawable_data->geometry,
-      Renderer_UseSurfaceMaterial(
+      RNDR_UsePreparedSurfaceMaterial(
          renderer,
-         drawable_data->transform,
+         model_data,
          drawable_data->material,
-         drawable_data->color,
          pass_id
       )
    );
 
 }
+
+void RNDR_GeometryRenderFunc(Renderer* renderer, Drawable self, u32 pass_id)
+{
+   rndr_Drawable* drawable = RNDR_GetDrawable(renderer, self);
+   if (drawable == NULL)
+      return;
+
+   GeometryDrawable* drawable_data = (GeometryDrawable*)drawable->data;
+   if (drawable_data == NULL)
+      return;
+
+   ModelData model_data = RNDR_MakeModelData(renderer, Util_TransformationMatrix(drawable_data->transform), drawable_data->color);
+   model_data.u_material_id = RNDR_MaterialParamsIndex(renderer, drawable_data->material.params);
+
+   RNDR_DrawGeometry(renderer, drawable_data, &model_data, pass_id);
+
+}
+
+// runs on a worker while the draw list is being built. only reads renderer state.
+void RNDR_GeometryPrepareCommand(Renderer* renderer, rndr_Drawable* drawable, u16 drawable_type_idx, u32 pass_id, rndr_DrawCommand* out_command, rndr_DrawKey* out_key)
+{
+   GeometryDrawable* drawable_data = (GeometryDrawable*)drawable->data;
+   if (drawable_data == NULL)
+   {
+      out_key->sort_key = RNDR_DRAW_KEY_SKIP;
+
+      return;
+   }
+
+   rndr_Surface* surface = RNDR_GetSurface(renderer, drawable_data->material.surface);
+   if (surface == NULL || surface->pass_count < pass_id + 1 || !(surface->ready_passes & (1u << pass_id)))
+   {
+      out_key->sort_key = RNDR_DRAW_KEY_SKIP;
+
+      return;
+   }
+
+   SurfacePass* pass = &surface->passes[pass_id];
+
+   out_command->is_prepared = true;
+   out_command->model_data = RNDR_MakeModelData(renderer, Util_TransformationMatrix(drawable_data->transform), drawable_data->color);
+   out_command->model_data.u_material_id = RNDR_MaterialParamsIndex(renderer, drawable_data->material.params);
+
+   if (pass->blend_mode != GFX_BLENDMODE_NONE)
+   {
+      vec3 camera_origin = renderer->inv_view.v[3].xyz;
+      f32 view_distance = Util_MagSqrVec3(Util_SubVec3(drawable_data->transform.origin, camera_origin));
+      out_key->sort_key = RNDR_MakeBlendedDrawKey(drawable_type_idx, view_distance, out_key->command_idx);
+
+   } else
+      out_key->sort_key = RNDR_MakeDrawKey(drawable_type_idx, pass->shader, drawable_data->geometry, out_key->command_idx);
+
+}
+
+void RNDR_GeometrySubmitCommand(Renderer* renderer, const rndr_DrawCommand* command, u32 pass_id)
+{
+   rndr_Drawable* drawable = RNDR_GetDrawable(renderer, command->drawable);
+   if (drawable == NULL)
+      return;
+
+   RNDR_DrawGeometry(renderer, (GeometryDrawable*)drawable->data, &command->model_data, pass_id);
+
+}
@@ -0,0 +1,265 @@
+#include "util/types.h"
+#include "util/math.h"
+#include "util/files.h"
+#include "util/jobs.h"
+#include "graphics.h"
+
+#include "renderer.h"
+#include "renderer/internal.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+static FrameTiming* RNDR_FindFrameTiming(FrameStats* stats, const char* name, u32 index)
+{
+   for (u32 timing_i = 0; timing_i < stats->timing_count; timing_i++)
+   {
+      FrameTiming* timing = &stats->timings[timing_i];
+      if (timing->index == index && strcmp(timing->name, name) == 0)
+         return timing;
+
+   }
+
+   if (stats->timing_count >= RNDR_MAX_FRAME_TIMINGS)
+      return NULL;
+
+   FrameTiming* timing = &stats->timings[stats->timing_count++];
+   *timing = (FrameTiming){ .name = name, .index = index, .gpu_ms = -1.0 };
+
+   return timing;
+}
+
+// scope names can be anything, so quotes, backslashes and control characters get escaped
+static void RNDR_WriteJSONString(FILE* stream, const char* string)
+{
+   fputc('"', stream);
+
+   for (const char* c = string; c != NULL && *c != '\0'; c++)
+   {
+      if (*c == '"' || *c == '\\')
+         fprintf(stream, "\\%c", *c);
+      else if ((u8)*c < 0x20)
+         fprintf(stream, "\\u%04x", (u32)(u8)*c);
+      else
+         fputc(*c, stream);
+
+   }
+
+   fputc('"', stream);
+
+}
+
+static void RNDR_DumpFrameStats(FILE* stream, const FrameStats* stats)
+{
+   const GraphicsStats* counters = &stats->counters;
+
+   fprintf(
+      stream,
+      "{\"frame\":%llu,\"cpu_frame_ms\":%.4f,\"visible_draws\":%u,\"texture_memory\":%llu,"
+      "\"counters\":{\"draw_calls\":%u,\"instances\":%u,\"primitives\":%llu,\"dispatches\":%u,\"state_changes\":%u,"
+      "\"shader_binds\":%u,\"texture_binds\":%u,\"sampler_binds\":%u,\"buffer_uploads\":%u,\"buffer_upload_bytes\":%llu},"
+      "\"timings\":[",
+      (unsigned long long)stats->frame_index,
+      stats->cpu_frame_ms,
+      stats->visible_draws,
+      (unsigned long long)stats->texture_memory,
+      counters->draw_calls,
+      counters->instances,
+      (unsigned long long)counters->primitives,
+      counters->dispatches,
+      counters->state_changes,
+      counters->shader_binds,
+      counters->texture_binds,
+      counters->sampler_binds,
+      counters->buffer_uploads,
+      (unsigned long long)counters->buffer_upload_bytes
+   );
+
+   for (u32 timing_i = 0; timing_i < stats->timing_count; timing_i++)
+   {
+      const FrameTiming* timing = &stats->timings[timing_i];
+
+      fprintf(stream, "%s{\"name\":", (timing_i > 0) ? "," : "");
+      RNDR_WriteJSONString(stream, timing->name);
+      fprintf(
+         stream,
+         ",\"index\":%u,\"count\":%u,\"cpu_ms\":%.4f,",
+         timing->index,
+         timing->count,
+         timing->cpu_ms
+      );
+
+      if (timing->gpu_ms < 0.0)
+         fprintf(stream, "\"gpu_ms\":null}");
+      else
+         fprintf(stream, "\"gpu_ms\":%.4f}", timing->gpu_ms);
+
+   }
+
+   fprintf(stream, "]}\n");
+
+}
+
+void RNDR_InitProfiler(Renderer* renderer)
+{
+   memset(&renderer->profiler, 0, sizeof(renderer->profiler));
+   renderer->profiler.frame_start = Util_MonotonicTime();
+
+}
+
+void RNDR_FreeProfiler(Renderer* renderer)
+{
+   if (renderer->profiler.dump_file != NULL)
+      fclose(renderer->profiler.dump_file);
+
+   renderer->profiler.dump_file = NULL;
+
+}
+
+void Renderer_EnableProfiling(Renderer* renderer, bool enable_profiling)
+{
+   if (renderer == NULL)
+      return;
+
+   renderer->profiler.is_enabled = enable_profiling;
+
+}
+
+u32 Renderer_BeginProfileScope(Renderer* renderer, const char* name, u32 index)
+{
+   if (renderer == NULL || name == NULL || !renderer->profiler.is_enabled)
+      return GFX_INVALID_INDEX;
+
+   u32 slot = renderer->profiler.frame_slot;
+   u32 scope_id = renderer->profiler.scope_counts[slot];
+   if (scope_id >= RNDR_MAX_PROFILE_SCOPES)
+      return GFX_INVALID_INDEX;
+
+   rndr_ProfileScope* scope = &renderer->profiler.scopes[slot][scope_id];
+   scope->name = name;
+   scope->index = index;
+   scope->gpu_timer = Graphics_BeginGpuTimer(renderer->graphics);
+   scope->cpu_start = Util_MonotonicTime();
+   scope->cpu_ms = 0.0;
+
+   renderer->profiler.scope_counts[slot]++;
+
+   return scope_id;
+}
+
+void Renderer_EndProfileScope(Renderer* renderer, u32 scope_id)
+{
+   if (renderer == NULL || !renderer->profiler.is_enabled)
+      return;
+
+   u32 slot = renderer->profiler.frame_slot;
+   if (scope_id >= renderer->profiler.scope_counts[slot])
+      return;
+
+   rndr_ProfileScope* scope = &renderer->profiler.scopes[slot][scope_id];
+   scope->cpu_ms = (Util_MonotonicTime() - scope->cpu_start) * 1000.0;
+
+   Graphics_EndGpuTimer(renderer->graphics, scope->gpu_timer);
+
+}
+
+void Renderer_EndFrame(Renderer* renderer)
+{
+   if (renderer == NULL)
+      return;
+
+   f64 frame_end = Util_MonotonicTime();
+
+   FrameStats stats = { 0 };
+   stats.frame_index = renderer->profiler.frame_index;
+   stats.cpu_frame_ms = (frame_end - renderer->profiler.frame_start) * 1000.0;
+   stats.visible_draws = renderer->profiler.visible_draws;
+   stats.texture_memory = Graphics_GetTextureMemory(renderer->graphics);
+   stats.counters = Graphics_GetStats(renderer->graphics);
+
+   if (renderer->profiler.is_enabled)
+   {
+      u32 slot = renderer->profiler.frame_slot;
+      for (u32 scope_i = 0; scope_i < renderer->profiler.scope_counts[slot]; scope_i++)
+      {
+         rndr_ProfileScope* scope = &renderer->profiler.scopes[slot][scope_i];
+
+         FrameTiming* timing = RNDR_FindFrameTiming(&stats, scope->name, scope->index);
+         if (timing == NULL)
+            continue;
+
+         timing->count++;
+         timing->cpu_ms += scope->cpu_ms;
+
+      }
+
+      // the slot being reused holds the scopes that match the gpu results coming back
+      u32 next_slot = (slot + 1) % GFX_GPU_TIMER_LATENCY;
+      Graphics_NextGpuTimerFrame(renderer->graphics);
+
+      u64 gpu_results[RNDR_MAX_PROFILE_SCOPES] = { 0 };
+      u32 result_count = Graphics_GetGpuTimerResults(renderer->graphics, gpu_results, RNDR_MAX_PROFILE_SCOPES);
+
+      for (u32 scope_i = 0; scope_i < renderer->profiler.scope_counts[next_slot]; scope_i++)
+      {
+         rndr_ProfileScope* scope = &renderer->profiler.scopes[next_slot][scope_i];
+         if (scope->gpu_timer >= result_count || gpu_results[scope->gpu_timer] == GFX_GPU_TIMER_NOT_READY)
+            continue;
+
+         FrameTiming* timing = RNDR_FindFrameTiming(&stats, scope->name, scope->index);
+         if (timing == NULL)
+            continue;
+
+         timing->gpu_ms = M_MAX(timing->gpu_ms, 0.0) + (f64)gpu_results[scope->gpu_timer] * 1e-6;
+
+      }
+
+      renderer->profiler.scope_counts[next_slot] = 0;
+      renderer->profiler.frame_slot = next_slot;
+
+   }
+
+   if (renderer->profiler.dump_file != NULL)
+      RNDR_DumpFrameStats(renderer->profiler.dump_file, &stats);
+
+   renderer->profiler.last_stats = stats;
+   renderer->profiler.frame_index++;
+   renderer->profiler.frame_start = frame_end;
+   renderer->profiler.visible_draws = 0;
+
+   Graphics_ResetStats(renderer->graphics);
+
+}
+
+FrameStats Renderer_GetFrameStats(Renderer* renderer)
+{
+   if (renderer == NULL)
+      return (FrameStats){ 0 };
+
+   return renderer->profiler.last_stats;
+}
+
+bool Renderer_SetFrameStatsDump(Renderer* renderer, const char* file_path)
+{
+   if (renderer == NULL)
+      return false;
+
+   RNDR_FreeProfiler(renderer);
+
+   if (file_path == NULL)
+      return true;
+
+   renderer->profiler.dump_file = fopen(file_path, "w");
+   if (renderer->profiler.dump_file == NULL)
+   {
+      error err = { 0 };
+      err.general = ERR_LEVEL_ERROR;
+
+      Util_Log(NULL, RENDERER_MODULE, err, "Couldn't open frame stats dump file: %s", file_path);
+
+      return false;
+   }
+
+   return true;
+}
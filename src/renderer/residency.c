@@ -0,0 +1,240 @@
+#include "util/types.h"
+#include "util/extra_types.h"
+#include "util/array.h"
+#include "util/math.h"
+#include "graphics.h"
+
+#include "renderer.h"
+#include "renderer/internal.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int RNDR_CompareResidencyCandidates(const void* a, const void* b)
+{
+   const rndr_ResidencyCandidate* candidate_a = (const rndr_ResidencyCandidate*)a;
+   const rndr_ResidencyCandidate* candidate_b = (const rndr_ResidencyCandidate*)b;
+
+   if (candidate_a->last_used_frame != candidate_b->last_used_frame)
+      return (candidate_a->last_used_frame < candidate_b->last_used_frame) ? -1 : 1;
+
+   return (candidate_a->entry_idx < candidate_b->entry_idx) ? -1 : (candidate_a->entry_idx > candidate_b->entry_idx);
+}
+
+static rndr_TextureResidency* RNDR_GetTextureResidency(Renderer* renderer, Texture texture)
+{
+   if (texture.id == INVALID_HANDLE_ID || texture.handle >= Util_ArrayLength(renderer->residency.lookup))
+      return NULL;
+
+   u32 entry_idx = renderer->residency.lookup[texture.handle];
+   if (entry_idx == 0)
+      return NULL;
+
+   rndr_TextureResidency* entry = &renderer->residency.entries[entry_idx - 1];
+   if (entry->texture.id != texture.id)
+      return NULL;
+
+   return entry;
+}
+
+static uS RNDR_ResidentTextureMemory(Renderer* renderer)
+{
+   uS memory = 0;
+   for (u32 entry_i = 0; entry_i < Util_ArrayLength(renderer->residency.entries); entry_i++)
+      memory += Graphics_GetTextureSize(renderer->graphics, renderer->residency.entries[entry_i].texture);
+
+   return memory;
+}
+
+// drops top mips until the texture is down to RNDR_RESIDENCY_MIN_SIZE or the budget is met
+static uS RNDR_TrimTexture(Renderer* renderer, rndr_TextureResidency* entry, uS memory, uS budget)
+{
+   while (memory > budget)
+   {
+      TextureDesc desc = Graphics_GetTextureDesc(renderer->graphics, entry->texture);
+      if (desc.mipmap_count <= 1 || M_MIN(desc.size.width, desc.size.height) / 2 < RNDR_RESIDENCY_MIN_SIZE)
+         break;
+
+      uS old_size = Graphics_GetTextureSize(renderer->graphics, entry->texture);
+      if (!Graphics_DropTextureMips(renderer->graphics, entry->texture, 1))
+         break;
+
+      memory -= old_size - Graphics_GetTextureSize(renderer->graphics, entry->texture);
+      entry->is_trimmed = true;
+
+   }
+
+   return memory;
+}
+
+// shrinks the texture down to one texel. if it has a mip chain the last mip is kept, so it still shows roughly the right color.
+static uS RNDR_EvictTexture(Renderer* renderer, rndr_TextureResidency* entry, uS memory)
+{
+   uS old_size = Graphics_GetTextureSize(renderer->graphics, entry->texture);
+   TextureDesc desc = Graphics_GetTextureDesc(renderer->graphics, entry->texture);
+
+   if (desc.mipmap_count <= 1 || !Graphics_DropTextureMips(renderer->graphics, entry->texture, (u32)desc.mipmap_count - 1))
+   {
+      TextureDesc placeholder_desc = { 0 };
+      placeholder_desc.size = (res2D){ 1, 1 };
+      placeholder_desc.depth = 1;
+      placeholder_desc.mipmap_count = 1;
+      placeholder_desc.texture_type = GFX_TEXTURETYPE_2D;
+      placeholder_desc.texture_format = GFX_TEXTUREFORMAT_RGBA_U8_NORM;
+
+      Graphics_ReallocateTexture(renderer->graphics, entry->texture, placeholder_desc);
+      color8 placeholder_color = RNDR_PlaceholderColor(entry->placeholder);
+      Graphics_UpdateTexture(renderer->graphics, placeholder_color.arr, entry->texture);
+
+   }
+
+   entry->is_trimmed = true;
+   entry->is_evicted = true;
+
+   uS new_size = Graphics_GetTextureSize(renderer->graphics, entry->texture);
+   if (new_size >= old_size)
+      return memory;
+
+   return memory - M_MIN(memory, old_size - new_size);
+}
+
+void RNDR_InitTextureResidency(Renderer* renderer)
+{
+   renderer->residency.entries = NEW_ARRAY_N(rndr_TextureResidency, 32);
+   renderer->residency.candidates = NEW_ARRAY_N(rndr_ResidencyCandidate, 32);
+   renderer->residency.lookup = NEW_ARRAY_N(u32, 32);
+   renderer->residency.budget = 0;
+   renderer->residency.frame = 0;
+
+}
+
+void RNDR_FreeTextureResidency(Renderer* renderer)
+{
+   for (u32 entry_i = 0; entry_i < Util_ArrayLength(renderer->residency.entries); entry_i++)
+      free(renderer->residency.entries[entry_i].file_path);
+
+   FREE_ARRAY(renderer->residency.entries);
+   FREE_ARRAY(renderer->residency.candidates);
+   FREE_ARRAY(renderer->residency.lookup);
+
+}
+
+void RNDR_TrackTexture(Renderer* renderer, const char* texture_file_path, Texture texture, bool is_srgb, u8 placeholder, bool is_streaming)
+{
+   if (texture.id == INVALID_HANDLE_ID || texture_file_path == NULL || RNDR_GetTextureResidency(renderer, texture) != NULL)
+      return;
+
+   uS path_length = strlen(texture_file_path);
+   char* file_path = malloc(path_length + 1);
+   if (file_path == NULL)
+      return;
+
+   memcpy(file_path, texture_file_path, path_length + 1);
+
+   rndr_TextureResidency entry = { 0 };
+   entry.file_path = file_path;
+   entry.texture = texture;
+   entry.last_used_frame = renderer->residency.frame;
+   entry.placeholder = placeholder;
+   entry.is_srgb = is_srgb;
+   entry.is_streaming = is_streaming;
+
+   ADD_BACK_ARRAY(renderer->residency.entries, entry);
+
+   u32 lookup_length = Util_ArrayLength(renderer->residency.lookup);
+   if (texture.handle >= lookup_length)
+   {
+      SET_ARRAY_LENGTH(renderer->residency.lookup, (u32)texture.handle + 1);
+      memset(renderer->residency.lookup + lookup_length, 0, ((u32)texture.handle + 1 - lookup_length) * sizeof(u32));
+
+   }
+
+   renderer->residency.lookup[texture.handle] = Util_ArrayLength(renderer->residency.entries);
+
+}
+
+void RNDR_TouchTexture(Renderer* renderer, Texture texture)
+{
+   rndr_TextureResidency* entry = RNDR_GetTextureResidency(renderer, texture);
+   if (entry == NULL)
+      return;
+
+   entry->last_used_frame = renderer->residency.frame;
+
+   if (!entry->is_trimmed || entry->is_streaming)
+      return;
+
+   entry->is_streaming = RNDR_QueueTextureStream(renderer, entry->file_path, entry->texture, entry->is_srgb);
+
+}
+
+void RNDR_OnTextureStreamed(Renderer* renderer, Texture texture, bool is_loaded)
+{
+   rndr_TextureResidency* entry = RNDR_GetTextureResidency(renderer, texture);
+   if (entry == NULL)
+      return;
+
+   entry->is_streaming = false;
+
+   // a failed reload keeps whatever's left, it'll be tried again the next time it's bound
+   if (is_loaded)
+      entry->is_trimmed = entry->is_evicted = false;
+
+}
+
+void RNDR_UpdateTextureResidency(Renderer* renderer)
+{
+   renderer->residency.frame++;
+
+   uS budget = renderer->residency.budget;
+   if (budget == 0)
+      return;
+
+   uS memory = RNDR_ResidentTextureMemory(renderer);
+   if (memory <= budget)
+      return;
+
+   SET_ARRAY_LENGTH(renderer->residency.candidates, 0);
+
+   for (u32 entry_i = 0; entry_i < Util_ArrayLength(renderer->residency.entries); entry_i++)
+   {
+      rndr_TextureResidency* entry = &renderer->residency.entries[entry_i];
+
+      // anything in flight gets reallocated when its stream starts uploading, trimming it now would be wasted
+      if (entry->is_evicted || entry->is_streaming || entry->last_used_frame + RNDR_RESIDENCY_GRACE_FRAMES > renderer->residency.frame)
+         continue;
+
+      rndr_ResidencyCandidate candidate = { .last_used_frame = entry->last_used_frame, .entry_idx = entry_i };
+      ADD_BACK_ARRAY(renderer->residency.candidates, candidate);
+
+   }
+
+   u32 candidate_count = Util_ArrayLength(renderer->residency.candidates);
+   qsort(renderer->residency.candidates, candidate_count, sizeof(rndr_ResidencyCandidate), RNDR_CompareResidencyCandidates);
+
+   // least recently used first. everything gets a chance to lose mips before anything is evicted outright
+   for (u32 candidate_i = 0; candidate_i < candidate_count && memory > budget; candidate_i++)
+      memory = RNDR_TrimTexture(renderer, &renderer->residency.entries[renderer->residency.candidates[candidate_i].entry_idx], memory, budget);
+
+   for (u32 candidate_i = 0; candidate_i < candidate_count && memory > budget; candidate_i++)
+      memory = RNDR_EvictTexture(renderer, &renderer->residency.entries[renderer->residency.candidates[candidate_i].entry_idx], memory);
+
+}
+
+void Renderer_SetTextureBudget(Renderer* renderer, uS budget_bytes)
+{
+   if (renderer == NULL)
+      return;
+
+   renderer->residency.budget = budget_bytes;
+
+}
+
+uS Renderer_GetTextureMemory(Renderer* renderer)
+{
+   if (renderer == NULL)
+      return 0;
+
+   return RNDR_ResidentTextureMemory(renderer);
+}
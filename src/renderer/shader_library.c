@@ -0,0 +1,426 @@
+#include "util/types.h"
+#include "util/array.h"
+#include "util/files.h"
+#include "graphics.h"
+
+#include "renderer.h"
+#include "renderer/internal.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static u64 RNDR_HashString(const char* string, u64 seed)
+{
+   return Util_HashBytes(string, strlen(string), seed);
+}
+
+static bool RNDR_HasShaderDependency(u64* dependencies, u64 path_hash)
+{
+   u32 dependency_count = Util_ArrayLength(dependencies);
+   for (u32 dependency_i = 0; dependency_i < dependency_count; dependency_i++)
+   {
+      if (dependencies[dependency_i] == path_hash)
+         return true;
+
+   }
+
+   return false;
+}
+
+static void RNDR_AppendShaderText(char** code, const char* text, uS length)
+{
+   u32 offset = Util_ArrayLength(*code);
+   SET_ARRAY_LENGTH(*code, offset + (u32)length);
+
+   memcpy((*code) + offset, text, length);
+
+}
+
+// pastes a file into the code array, following its includes. files only ever go in once, so include loops just stop.
+static bool RNDR_ExpandShaderFile(const char* file_path, char** code, u64** dependencies)
+{
+   u64 path_hash = RNDR_HashString(file_path, UTIL_HASH_SEED);
+   if (RNDR_HasShaderDependency(*dependencies, path_hash))
+      return true;
+
+   ADD_BACK_ARRAY(*dependencies, path_hash);
+
+   memblob file_data = Util_LoadFileIntoMemory(file_path, false);
+   if (file_data.data == NULL)
+   {
+      error err = { 0 };
+      err.general = ERR_LEVEL_ERROR;
+
+      Util_Log(NULL, RENDERER_MODULE, err, "Couldn't open shader file: %s", file_path);
+
+      return false;
+   }
+
+   bool is_ok = true;
+   const char* line = file_data.data;
+
+   while (*line != '\0' && is_ok)
+   {
+      const char* line_end = strchr(line, '\n');
+      uS line_length = (line_end != NULL) ? (uS)(line_end - line) + 1 : strlen(line);
+
+      const char* directive = line + strspn(line, " \t");
+      if (strncmp(directive, "#include", 8) != 0)
+      {
+         RNDR_AppendShaderText(code, line, line_length);
+         line += line_length;
+
+         continue;
+      }
+
+      uS directive_length = line_length - (uS)(directive - line);
+      const char* name_start = memchr(directive, '"', directive_length);
+      const char* name_end = (name_start != NULL) ? memchr(name_start + 1, '"', directive_length - (uS)(name_start + 1 - directive)) : NULL;
+
+      if (name_end == NULL)
+      {
+         error err = { 0 };
+         err.general = ERR_LEVEL_ERROR;
+
+         Util_Log(NULL, RENDERER_MODULE, err, "Bad #include in shader file: %s", file_path);
+
+         is_ok = false;
+
+      } else {
+         char include_name[RNDR_NAME_MAX] = { 0 };
+         snprintf(include_name, sizeof(include_name), "%.*s", (i32)(name_end - name_start - 1), name_start + 1);
+
+         char* include_path = Util_MakeFilePath(file_path, include_name);
+         is_ok = RNDR_ExpandShaderFile(include_path, code, dependencies);
+         free(include_path);
+
+         // keep the line break the directive had
+         RNDR_AppendShaderText(code, "\n", 1);
+
+      }
+
+      line += line_length;
+
+   }
+
+   free(file_data.data);
+
+   return is_ok;
+}
+
+static rndr_ShaderSource* RNDR_GetShaderSource(Renderer* renderer, const char* shader_file_path)
+{
+   rndr_ShaderSource* source = GET_MAP_ITEM(renderer->shader_library.sources, shader_file_path);
+   if (source != NULL && source->code != NULL)
+      return source;
+
+   rndr_ShaderSource new_source = { 0 };
+   new_source.code = NEW_ARRAY_N(char, 4096);
+   new_source.dependencies = NEW_ARRAY_N(u64, 4);
+
+   char* file_path = Util_MakeFilePath(renderer->app_path, shader_file_path);
+   bool is_ok = RNDR_ExpandShaderFile(file_path, &new_source.code, &new_source.dependencies);
+   free(file_path);
+
+   if (!is_ok)
+   {
+      FREE_ARRAY(new_source.code);
+      FREE_ARRAY(new_source.dependencies);
+
+      return NULL;
+   }
+
+   RNDR_AppendShaderText(&new_source.code, "", 1);
+   new_source.content_hash = Util_HashBytes(new_source.code, Util_ArrayLength(new_source.code), UTIL_HASH_SEED);
+
+   // invalidated sources keep their map slot, they just get refilled
+   if (source != NULL)
+   {
+      (*source) = new_source;
+
+      return source;
+   }
+
+   return ADD_MAP_ITEM(renderer->shader_library.sources, shader_file_path, new_source);
+}
+
+static i32 RNDR_CompareKeywordHashes(const void* a, const void* b)
+{
+   u64 hash_a = *(const u64*)a;
+   u64 hash_b = *(const u64*)b;
+
+   return (hash_a > hash_b) - (hash_a < hash_b);
+}
+
+// keywords are hashed on their own and sorted first, so the order they were given in doesn't change the key
+static u64 RNDR_ShaderVariantKey(u64 content_hash, const char* keywords[], u32 keyword_count, bool is_compute)
+{
+   u64 keyword_hashes[RNDR_MAX_SHADER_KEYWORDS] = { 0 };
+   for (u32 keyword_i = 0; keyword_i < keyword_count; keyword_i++)
+      keyword_hashes[keyword_i] = RNDR_HashString(keywords[keyword_i], UTIL_HASH_SEED);
+
+   qsort(keyword_hashes, keyword_count, sizeof(u64), RNDR_CompareKeywordHashes);
+
+   u64 key = Util_HashBytes(&is_compute, sizeof(is_compute), content_hash);
+   key = Util_HashBytes(keyword_hashes, sizeof(u64) * keyword_count, key);
+
+   return key;
+}
+
+static Shader RNDR_CompileShaderVariant(Renderer* renderer, rndr_ShaderSource* source, const char* keywords[], u32 keyword_count, u32 variant_flags)
+{
+   memblob code = { .data = source->code, .size = Util_ArrayLength(source->code) };
+   bool is_async = (variant_flags & SHADER_VARIANT_ASYNC);
+
+   Shader shader = (handle){ .id = INVALID_HANDLE_ID };
+
+   if (variant_flags & SHADER_VARIANT_COMPUTE)
+   {
+      memblob compute_code = Util_PrependShaderDefines(code, keywords, keyword_count, NULL);
+
+      if (is_async)
+         shader = Graphics_CreateComputeShaderAsync(renderer->graphics, compute_code.data);
+      else
+         shader = Graphics_CreateComputeShader(renderer->graphics, compute_code.data);
+
+      free(compute_code.data);
+
+   } else {
+      memblob vert_code = Util_PrependShaderDefines(code, keywords, keyword_count, "#define VERT");
+      memblob frag_code = Util_PrependShaderDefines(code, keywords, keyword_count, "#define FRAG");
+
+      if (is_async)
+         shader = Graphics_CreateShaderAsync(renderer->graphics, vert_code.data, frag_code.data);
+      else
+         shader = Graphics_CreateShader(renderer->graphics, vert_code.data, frag_code.data);
+
+      free(vert_code.data);
+      free(frag_code.data);
+
+   }
+
+   return shader;
+}
+
+void RNDR_InitShaderLibrary(Renderer* renderer)
+{
+   renderer->shader_library.sources = NEW_MAP_N(rndr_ShaderSource, 8);
+   renderer->shader_library.variants = NEW_ARRAY_N(rndr_ShaderVariant, 16);
+
+}
+
+void RNDR_FreeShaderLibrary(Renderer* renderer)
+{
+   u32 source_count = MAP_LENGTH(renderer->shader_library.sources);
+   for (u32 source_i = 0; source_i < source_count; source_i++)
+   {
+      MapItem* map_item = Util_GetMapItemFromIndex(renderer->shader_library.sources, source_i);
+      rndr_ShaderSource* source = (rndr_ShaderSource*)map_item->value;
+
+      FREE_ARRAY(source->code);
+      FREE_ARRAY(source->dependencies);
+
+   }
+
+   FREE_MAP(renderer->shader_library.sources);
+
+   for (u32 variant_i = 0; variant_i < Util_ArrayLength(renderer->shader_library.variants); variant_i++)
+   {
+      if (renderer->shader_library.variants[variant_i].shader.id != INVALID_HANDLE_ID)
+         Graphics_FreeShader(renderer->graphics, renderer->shader_library.variants[variant_i].shader);
+
+   }
+
+   FREE_ARRAY(renderer->shader_library.variants);
+
+}
+
+Shader Renderer_GetShaderVariant(Renderer* renderer, const char* shader_file_path, const char* keywords[], u32 keyword_count, u32 variant_flags)
+{
+   if (renderer == NULL || renderer->app_path == NULL || shader_file_path == NULL || (keywords == NULL && keyword_count != 0))
+      return NULLHANDLE;
+
+   const char* all_keywords[RNDR_MAX_SHADER_KEYWORDS] = { 0 };
+   u32 all_keyword_count = 0;
+   u32 dropped_keywords = 0;
+
+   for (u32 keyword_i = 0; keyword_i < keyword_count; keyword_i++)
+   {
+      if (all_keyword_count < RNDR_MAX_SHADER_KEYWORDS)
+         all_keywords[all_keyword_count++] = keywords[keyword_i];
+      else
+         dropped_keywords++;
+
+   }
+
+   if ((variant_flags & SHADER_VARIANT_LIGHTING) && renderer->lightmanager_info.lightman_defs != NULL)
+   {
+      ShaderDefines light_defines = renderer->lightmanager_info.lightman_defs(renderer);
+      for (u32 define_i = 0; define_i < light_defines.define_count; define_i++)
+      {
+         if (all_keyword_count < RNDR_MAX_SHADER_KEYWORDS)
+            all_keywords[all_keyword_count++] = light_defines.defines[define_i];
+         else
+            dropped_keywords++;
+
+      }
+
+   }
+
+   if (dropped_keywords > 0)
+   {
+      error err = { 0 };
+      err.general = ERR_LEVEL_WARN;
+
+      Util_Log(NULL, RENDERER_MODULE, err, "Too many shader keywords for %s, %u were dropped", shader_file_path, dropped_keywords);
+
+   }
+
+   rndr_ShaderSource* source = RNDR_GetShaderSource(renderer, shader_file_path);
+   if (source == NULL)
+      return NULLHANDLE;
+
+   u64 variant_key = RNDR_ShaderVariantKey(source->content_hash, all_keywords, all_keyword_count, (variant_flags & SHADER_VARIANT_COMPUTE));
+
+   u32 variant_count = Util_ArrayLength(renderer->shader_library.variants);
+   for (u32 variant_i = 0; variant_i < variant_count; variant_i++)
+   {
+      rndr_ShaderVariant* variant = &renderer->shader_library.variants[variant_i];
+      if (variant->key != variant_key)
+         continue;
+
+      // could have been started by a prewarm, a synchronous request still expects it ready to use.
+      // if that compile failed it gets the same invalid handle a failed synchronous compile would
+      if (!(variant_flags & SHADER_VARIANT_ASYNC) && variant->shader.id != INVALID_HANDLE_ID)
+      {
+         if (Graphics_WaitForShader(renderer->graphics, variant->shader) == GFX_SHADERSTATUS_FAILED)
+            return NULLHANDLE;
+
+      }
+
+      return variant->shader;
+   }
+
+   rndr_ShaderVariant variant = { 0 };
+   variant.key = variant_key;
+   variant.shader = RNDR_CompileShaderVariant(renderer, source, all_keywords, all_keyword_count, variant_flags);
+
+   if (variant.shader.id == INVALID_HANDLE_ID)
+   {
+      error err = { 0 };
+      err.general = ERR_LEVEL_WARN;
+      err.extra = ERR_GFX_SHADER_COMPILATION_FAILED;
+
+      Util_Log(NULL, RENDERER_MODULE, err, "Shader File [%s] Failed To Compile!", shader_file_path);
+
+   }
+
+   // failed variants are kept too, so they aren't recompiled every time they're asked for
+   ADD_BACK_ARRAY(renderer->shader_library.variants, variant);
+
+   return variant.shader;
+}
+
+void Renderer_InvalidateShaderFile(Renderer* renderer, const char* shader_file_path)
+{
+   if (renderer == NULL || renderer->app_path == NULL || shader_file_path == NULL)
+      return;
+
+   char* file_path = Util_MakeFilePath(renderer->app_path, shader_file_path);
+   u64 path_hash = RNDR_HashString(file_path, UTIL_HASH_SEED);
+   free(file_path);
+
+   u32 source_count = MAP_LENGTH(renderer->shader_library.sources);
+   for (u32 source_i = 0; source_i < source_count; source_i++)
+   {
+      MapItem* map_item = Util_GetMapItemFromIndex(renderer->shader_library.sources, source_i);
+      rndr_ShaderSource* source = (rndr_ShaderSource*)map_item->value;
+
+      if (source->code == NULL || !RNDR_HasShaderDependency(source->dependencies, path_hash))
+         continue;
+
+      FREE_ARRAY(source->code);
+      FREE_ARRAY(source->dependencies);
+      source->code = NULL;
+      source->dependencies = NULL;
+
+   }
+
+}
+
+u32 Renderer_PrewarmShaderVariants(Renderer* renderer, const char* manifest_file_path)
+{
+   if (renderer == NULL || renderer->app_path == NULL || manifest_file_path == NULL)
+      return 0;
+
+   memblob manifest = Util_LoadFileFromBasePath(renderer->app_path, manifest_file_path, false);
+   if (manifest.data == NULL)
+   {
+      error err = { 0 };
+      err.general = ERR_LEVEL_WARN;
+
+      Util_Log(NULL, RENDERER_MODULE, err, "Couldn't open shader manifest: %s", manifest_file_path);
+
+      return 0;
+   }
+
+   u32 requested_count = 0;
+   char* line = manifest.data;
+
+   while (*line != '\0')
+   {
+      char* line_end = line + strcspn(line, "\r\n");
+      bool is_last_line = (*line_end == '\0');
+      *line_end = '\0';
+
+      char* comment = strchr(line, '#');
+      if (comment != NULL)
+         *comment = '\0';
+
+      const char* shader_file_path = NULL;
+      const char* keywords[RNDR_MAX_SHADER_KEYWORDS] = { 0 };
+      u32 keyword_count = 0;
+      u32 variant_flags = SHADER_VARIANT_ASYNC;
+
+      char* token = line;
+      while (*token != '\0')
+      {
+         token += strspn(token, " \t");
+         if (*token == '\0')
+            break;
+
+         char* token_end = token + strcspn(token, " \t");
+         bool is_last_token = (*token_end == '\0');
+         *token_end = '\0';
+
+         if (shader_file_path == NULL)
+            shader_file_path = token;
+         else if (strcmp(token, "@compute") == 0)
+            variant_flags |= SHADER_VARIANT_COMPUTE;
+         else if (strcmp(token, "@lighting") == 0)
+            variant_flags |= SHADER_VARIANT_LIGHTING;
+         else if (keyword_count < RNDR_MAX_SHADER_KEYWORDS)
+            keywords[keyword_count++] = token;
+
+         token = (is_last_token) ? token_end : token_end + 1;
+
+      }
+
+      if (shader_file_path != NULL)
+      {
+         Renderer_GetShaderVariant(renderer, shader_file_path, keywords, keyword_count, variant_flags);
+         requested_count++;
+
+      }
+
+      line = (is_last_line) ? line_end : line_end + 1;
+
+   }
+
+   free(manifest.data);
+
+   return requested_count;
+}
@@ -0,0 +1,306 @@
+#include "util/types.h"
+#include "util/extra_types.h"
+#include "util/vec3.h"
+#include "util/bvh.h"
+
+#include "renderer.h"
+#include "renderer/internal.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+enum {
+   RNDR_QUERY_BOX = 0,
+   RNDR_QUERY_SPHERE,
+   RNDR_QUERY_FRUSTUM
+
+};
+
+// the tree only knows fat boxes, so every query checks the drawable's real bounds again before handing it out
+typedef struct rndr_SpatialQuery_t
+{
+   Renderer* renderer;
+   DrawableQueryFunc func;
+   void* user_data;
+
+   u32 shape;
+   BBox box;
+   vec3 center;
+   f32 radius;
+   Frustum frustum;
+
+} rndr_SpatialQuery;
+
+typedef struct rndr_RaycastQuery_t
+{
+   Renderer* renderer;
+   RaycastHit hit;
+   bool has_hit;
+
+} rndr_RaycastQuery;
+
+typedef struct rndr_VisibilityQuery_t
+{
+   Renderer* renderer;
+   Frustum frustum;
+   u32 query_id;
+
+} rndr_VisibilityQuery;
+
+static inline u64 RNDR_MakeProxyData(rndr_Drawable* drawable, u16 drawable_type_idx)
+{
+   Drawable res_drawable = { 0 };
+   res_drawable.res = drawable->compare;
+   res_drawable.drawable_type_idx = drawable_type_idx;
+
+   return res_drawable.total_bits;
+}
+
+static inline rndr_Drawable* RNDR_ProxyDrawable(Renderer* renderer, u64 proxy_data, Drawable* out_drawable)
+{
+   Drawable res_drawable = { .total_bits = proxy_data };
+
+   rndr_Drawable* drawable = RNDR_GetDrawable(renderer, res_drawable);
+   if (drawable == NULL || !drawable->enabled || drawable->next_freed != INVALID_HANDLE)
+      return NULL;
+
+   if (out_drawable != NULL)
+      *out_drawable = res_drawable;
+
+   return drawable;
+}
+
+static inline bool RNDR_OverlapSphereBBox(vec3 center, f32 radius, BBox bbox)
+{
+   vec3 diff = Util_SubVec3(Util_AbsVec3(Util_SubVec3(center, bbox.center)), bbox.extents);
+   diff = Util_MaxVec3(diff, VEC3(0));
+
+   return Util_MagSqrVec3(diff) <= radius * radius;
+}
+
+static bool RNDR_SpatialQueryFunc(void* user_data, u32 proxy_id, u64 proxy_data)
+{
+   rndr_SpatialQuery* query = (rndr_SpatialQuery*)user_data;
+
+   Drawable res_drawable = { 0 };
+   rndr_Drawable* drawable = RNDR_ProxyDrawable(query->renderer, proxy_data, &res_drawable);
+   if (drawable == NULL)
+      return true;
+
+   bool is_overlapping = false;
+   switch (query->shape)
+   {
+      case RNDR_QUERY_BOX:
+         is_overlapping = Util_OverlapBBox(query->box, drawable->bounds);
+         break;
+
+      case RNDR_QUERY_SPHERE:
+         is_overlapping = RNDR_OverlapSphereBBox(query->center, query->radius, drawable->bounds);
+         break;
+
+      case RNDR_QUERY_FRUSTUM:
+         is_overlapping = Util_FrustumOverlapBBox(query->frustum, drawable->bounds);
+         break;
+
+      default:
+         break;
+
+   }
+
+   if (!is_overlapping)
+      return true;
+
+   return query->func(query->renderer, res_drawable, query->user_data);
+}
+
+static f32 RNDR_RaycastQueryFunc(void* user_data, u32 proxy_id, u64 proxy_data, vec3 origin, vec3 direction, f32 max_distance)
+{
+   rndr_RaycastQuery* query = (rndr_RaycastQuery*)user_data;
+
+   Drawable res_drawable = { 0 };
+   rndr_Drawable* drawable = RNDR_ProxyDrawable(query->renderer, proxy_data, &res_drawable);
+   if (drawable == NULL || RNDR_GetDrawableType(query->renderer, res_drawable.drawable_type_idx)->skip_raycasts)
+      return -1.0f;
+
+   f32 distance = Util_RayBBoxDistance(origin, direction, max_distance, drawable->bounds);
+   if (distance < 0.0f)
+      return -1.0f;
+
+   query->hit.drawable = res_drawable;
+   query->hit.distance = distance;
+   query->has_hit = true;
+
+   return distance;
+}
+
+static bool RNDR_VisibilityQueryFunc(void* user_data, u32 proxy_id, u64 proxy_data)
+{
+   rndr_VisibilityQuery* query = (rndr_VisibilityQuery*)user_data;
+
+   rndr_Drawable* drawable = RNDR_ProxyDrawable(query->renderer, proxy_data, NULL);
+   if (drawable != NULL && Util_FrustumOverlapBBox(query->frustum, drawable->bounds))
+      drawable->visible_query = query->query_id;
+
+   return true;
+}
+
+void RNDR_InitSpatialIndex(Renderer* renderer)
+{
+   renderer->spatial.tree = Util_CreateBVH(RNDR_SPATIAL_MARGIN);
+   renderer->spatial.query_id = 0;
+   renderer->spatial.unbounded_count = 0;
+
+}
+
+void RNDR_FreeSpatialIndex(Renderer* renderer)
+{
+   Util_FreeBVH(renderer->spatial.tree);
+   renderer->spatial.tree = NULL;
+
+}
+
+// drawables start out without bounds. the ones that draw something are counted, since no query can ever find them
+void RNDR_InitDrawableProxy(Renderer* renderer, rndr_Drawable* drawable, rndr_DrawableType* drawable_type)
+{
+   drawable->bvh_proxy = BVH_NULL_PROXY;
+
+   if (drawable_type->render != NULL)
+      renderer->spatial.unbounded_count++;
+
+}
+
+void RNDR_UpdateDrawableProxy(Renderer* renderer, rndr_Drawable* drawable, rndr_DrawableType* drawable_type, u16 drawable_type_idx)
+{
+   bool has_bounds = (Util_MagSqrVec3(drawable->bounds.extents) > 0.0f);
+   bool had_bounds = (drawable->bvh_proxy != BVH_NULL_PROXY);
+
+   if (has_bounds && had_bounds)
+   {
+      Util_BVHMoveProxy(renderer->spatial.tree, drawable->bvh_proxy, drawable->bounds);
+
+   } else if (has_bounds) {
+      drawable->bvh_proxy = Util_BVHCreateProxy(renderer->spatial.tree, drawable->bounds, RNDR_MakeProxyData(drawable, drawable_type_idx));
+      if (drawable_type->render != NULL && renderer->spatial.unbounded_count > 0)
+         renderer->spatial.unbounded_count--;
+
+   } else if (had_bounds) {
+      Util_BVHDestroyProxy(renderer->spatial.tree, drawable->bvh_proxy);
+      drawable->bvh_proxy = BVH_NULL_PROXY;
+      if (drawable_type->render != NULL)
+         renderer->spatial.unbounded_count++;
+
+   }
+
+}
+
+void RNDR_RemoveDrawableProxy(Renderer* renderer, rndr_Drawable* drawable, rndr_DrawableType* drawable_type)
+{
+   if (drawable->bvh_proxy == BVH_NULL_PROXY)
+   {
+      if (drawable_type->render != NULL && renderer->spatial.unbounded_count > 0)
+         renderer->spatial.unbounded_count--;
+
+      return;
+   }
+
+   Util_BVHDestroyProxy(renderer->spatial.tree, drawable->bvh_proxy);
+   drawable->bvh_proxy = BVH_NULL_PROXY;
+
+}
+
+// stamps every enabled drawable in the frustum with a new query id, the draw list treats anything else with bounds as culled
+u32 RNDR_MarkVisibleDrawables(Renderer* renderer, Frustum frustum)
+{
+   // 0 is what new drawables start with, so it's never handed out
+   if (++renderer->spatial.query_id == 0)
+      renderer->spatial.query_id = 1;
+
+   rndr_VisibilityQuery query = {
+      .renderer = renderer,
+      .frustum = frustum,
+      .query_id = renderer->spatial.query_id
+   };
+
+   Util_BVHQueryFrustum(renderer->spatial.tree, frustum, RNDR_VisibilityQueryFunc, &query);
+
+   return query.query_id;
+}
+
+void Renderer_QueryBox(Renderer* renderer, BBox box, DrawableQueryFunc func, void* user_data)
+{
+   if (renderer == NULL || func == NULL)
+      return;
+
+   rndr_SpatialQuery query = {
+      .renderer = renderer,
+      .func = func,
+      .user_data = user_data,
+      .shape = RNDR_QUERY_BOX,
+      .box = box
+   };
+
+   Util_BVHQueryBox(renderer->spatial.tree, box, RNDR_SpatialQueryFunc, &query);
+
+}
+
+void Renderer_QuerySphere(Renderer* renderer, vec3 center, f32 radius, DrawableQueryFunc func, void* user_data)
+{
+   if (renderer == NULL || func == NULL)
+      return;
+
+   rndr_SpatialQuery query = {
+      .renderer = renderer,
+      .func = func,
+      .user_data = user_data,
+      .shape = RNDR_QUERY_SPHERE,
+      .center = center,
+      .radius = radius
+   };
+
+   Util_BVHQuerySphere(renderer->spatial.tree, center, radius, RNDR_SpatialQueryFunc, &query);
+
+}
+
+void Renderer_QueryFrustum(Renderer* renderer, Frustum frustum, DrawableQueryFunc func, void* user_data)
+{
+   if (renderer == NULL || func == NULL)
+      return;
+
+   rndr_SpatialQuery query = {
+      .renderer = renderer,
+      .func = func,
+      .user_data = user_data,
+      .shape = RNDR_QUERY_FRUSTUM,
+      .frustum = frustum
+   };
+
+   Util_BVHQueryFrustum(renderer->spatial.tree, frustum, RNDR_SpatialQueryFunc, &query);
+
+}
+
+u32 Renderer_GetUnboundedDrawableCount(Renderer* renderer)
+{
+   if (renderer == NULL)
+      return 0;
+
+   return renderer->spatial.unbounded_count;
+}
+
+bool Renderer_Raycast(Renderer* renderer, vec3 origin, vec3 direction, f32 max_distance, RaycastHit* out_hit)
+{
+   if (renderer == NULL || Util_MagSqrVec3(direction) <= 0.0f)
+      return false;
+
+   rndr_RaycastQuery query = { .renderer = renderer };
+
+   Util_BVHRaycast(renderer->spatial.tree, origin, direction, max_distance, RNDR_RaycastQueryFunc, &query);
+   if (!query.has_hit)
+      return false;
+
+   query.hit.point = Util_AddVec3(origin, Util_ScaleVec3(direction, query.hit.distance));
+
+   if (out_hit != NULL)
+      *out_hit = query.hit;
+
+   return true;
+}
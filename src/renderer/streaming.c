@@ -0,0 +1,238 @@
+#include "util/types.h"
+#include "util/extra_types.h"
+#include "util/array.h"
+#include "util/files.h"
+#include "util/jobs.h"
+#include "image.h"
+#include "graphics.h"
+
+#include "renderer.h"
+#include "renderer/internal.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+static void RNDR_DecodeTextureJob(void* user_data)
+{
+   rndr_TextureStream* stream = (rndr_TextureStream*)user_data;
+
+   memblob file_data = Util_LoadFileIntoMemory(stream->file_path, true);
+   stream->image = Image_CreateImage(file_data, IMG_TYPE_2D, (res2D){ 0 }, stream->is_srgb);
+   Image_GenerateMipmaps(&stream->image);
+
+   if (file_data.data != NULL)
+      free(file_data.data);
+
+   u32 state = (stream->image.data != NULL) ? RNDR_STREAM_DECODED : RNDR_STREAM_FAILED;
+   atomic_store_explicit(&stream->state, state, memory_order_release);
+
+}
+
+static void RNDR_FreeTextureStream(rndr_TextureStream* stream)
+{
+   Image_Free(&stream->image);
+
+   if (stream->file_path != NULL)
+      free(stream->file_path);
+
+   free(stream);
+
+}
+
+static uS RNDR_ImageMipOffset(const Image* image, u32 mip_level, uS* out_size)
+{
+   uS offset = 0;
+   for (u32 mip_i = 0; mip_i < mip_level; mip_i++)
+      offset += Image_MipSize(image, mip_i);
+
+   (*out_size) = Image_MipSize(image, mip_level);
+
+   return offset;
+}
+
+// uploads as many of the stream's remaining mips as fit in the budget, returns true once the whole chain is on the gpu
+// or a mip turns out to be impossible to stage.
+static bool RNDR_UploadStreamMips(Renderer* renderer, rndr_TextureStream* stream, uS* budget_left, bool* ring_busy)
+{
+   Image* image = &stream->image;
+
+   if (!stream->is_allocated)
+      stream->next_mip = (u32)image->mipmap_count;
+
+   while (stream->next_mip > 0)
+   {
+      u32 mip_level = stream->next_mip - 1;
+
+      uS mip_size = 0;
+      uS mip_offset = RNDR_ImageMipOffset(image, mip_level, &mip_size);
+
+      // always let the first mip of the frame through, otherwise a mip bigger than the budget would never go up
+      if (mip_size > (*budget_left) && (*budget_left) < renderer->streaming.frame_budget)
+         return false;
+
+      // the new storage only replaces the placeholder once its first mip is actually going up
+      u8 stage_status = (stream->is_allocated) ?
+         Graphics_StageTextureMip(renderer->graphics, stream->texture, mip_level, image->data + mip_offset, mip_size) :
+         Graphics_ReallocateTextureStaged(renderer->graphics, stream->texture, RNDR_ImageTextureDesc(image), mip_level, image->data + mip_offset, mip_size);
+
+      if (stage_status == GFX_STAGE_BUSY)
+      {
+         (*ring_busy) = true;
+
+         return false;
+      }
+
+      // retrying won't help. before the first mip that means keeping the placeholder, after it the smaller mips already work
+      if (stage_status == GFX_STAGE_INVALID)
+      {
+         if (!stream->is_allocated)
+            atomic_store_explicit(&stream->state, RNDR_STREAM_FAILED, memory_order_relaxed);
+
+         return true;
+      }
+
+      stream->is_allocated = true;
+
+      Graphics_SetTextureMipRange(renderer->graphics, stream->texture, mip_level, (u32)image->mipmap_count - 1);
+
+      (*budget_left) -= M_MIN(mip_size, (*budget_left));
+      stream->next_mip = mip_level;
+
+   }
+
+   return true;
+}
+
+void RNDR_InitTextureStreaming(Renderer* renderer)
+{
+   renderer->streaming.queue = NULL; // only spun up once something actually streams
+   renderer->streaming.streams = NEW_ARRAY_N(rndr_TextureStream*, 8);
+   renderer->streaming.frame_budget = RNDR_DEFAULT_STREAM_BUDGET;
+
+}
+
+void RNDR_FreeTextureStreaming(Renderer* renderer)
+{
+   // has to go first, a running decode still writes into its stream
+   Util_FreeJobQueue(renderer->streaming.queue);
+   renderer->streaming.queue = NULL;
+
+   for (u32 stream_i = 0; stream_i < Util_ArrayLength(renderer->streaming.streams); stream_i++)
+      RNDR_FreeTextureStream(renderer->streaming.streams[stream_i]);
+
+   FREE_ARRAY(renderer->streaming.streams);
+
+}
+
+void RNDR_UpdateTextureStreaming(Renderer* renderer)
+{
+   uS budget_left = renderer->streaming.frame_budget;
+   bool ring_busy = false;
+
+   u32 stream_i = 0;
+   while (stream_i < Util_ArrayLength(renderer->streaming.streams) && !ring_busy && budget_left > 0)
+   {
+      rndr_TextureStream* stream = renderer->streaming.streams[stream_i];
+
+      u32 state = atomic_load_explicit(&stream->state, memory_order_acquire);
+      bool is_done = false;
+
+      if (state == RNDR_STREAM_FAILED)
+      {
+         error err = { 0 };
+         err.general = ERR_LEVEL_WARN;
+
+         Util_Log(NULL, RENDERER_MODULE, err, "Couldn't stream texture '%s', keeping its placeholder", stream->file_path);
+
+         is_done = true;
+
+      } else if (state == RNDR_STREAM_DECODED) {
+         is_done = RNDR_UploadStreamMips(renderer, stream, &budget_left, &ring_busy);
+         state = atomic_load_explicit(&stream->state, memory_order_relaxed);
+
+      }
+
+      if (!is_done)
+      {
+         stream_i++;
+         continue;
+      }
+
+      RNDR_OnTextureStreamed(renderer, stream->texture, (state != RNDR_STREAM_FAILED));
+      RNDR_FreeTextureStream(stream);
+
+      u32 last_i = Util_ArrayLength(renderer->streaming.streams) - 1;
+      renderer->streaming.streams[stream_i] = renderer->streaming.streams[last_i];
+      SET_ARRAY_LENGTH(renderer->streaming.streams, last_i);
+
+   }
+
+}
+
+bool RNDR_QueueTextureStream(Renderer* renderer, const char* texture_file_path, Texture texture, bool is_srgb)
+{
+   if (renderer->streaming.queue == NULL)
+      renderer->streaming.queue = Util_CreateJobQueue(RNDR_STREAM_THREADS);
+
+   rndr_TextureStream* stream = calloc(1, sizeof(rndr_TextureStream));
+   if (stream == NULL)
+      return false;
+
+   stream->file_path = Util_MakeFilePath(renderer->app_path, texture_file_path);
+   stream->texture = texture;
+   stream->is_srgb = is_srgb;
+   atomic_init(&stream->state, RNDR_STREAM_DECODING);
+
+   if (stream->file_path == NULL || !Util_PushJob(renderer->streaming.queue, RNDR_DecodeTextureJob, stream))
+   {
+      RNDR_FreeTextureStream(stream);
+
+      return false;
+   }
+
+   ADD_BACK_ARRAY(renderer->streaming.streams, stream);
+
+   return true;
+}
+
+Texture Renderer_StreamTexture(Renderer* renderer, const char* texture_file_path, bool is_srgb, u8 placeholder)
+{
+   if (renderer == NULL || renderer->app_path == NULL || texture_file_path == NULL)
+      return NULLHANDLE;
+
+   Texture* texture_ptr = GET_MAP_ITEM(renderer->textures, texture_file_path);
+   if (texture_ptr != NULL)
+      return (*texture_ptr);
+
+   if (placeholder >= RNDR_SURF_DEFAULT_TEXTURE_COUNT)
+      placeholder = RNDR_SURF_TEXTURE_GRAY;
+
+   Texture texture = Renderer_CreateColorTexture(renderer, RNDR_PlaceholderColor(placeholder), GFX_TEXTURETYPE_2D);
+   if (texture.id == INVALID_HANDLE_ID)
+      return NULLHANDLE;
+
+   ADD_MAP_ITEM(renderer->textures, texture_file_path, texture);
+
+   bool is_streaming = RNDR_QueueTextureStream(renderer, texture_file_path, texture, is_srgb);
+   RNDR_TrackTexture(renderer, texture_file_path, texture, is_srgb, placeholder, is_streaming);
+
+   return texture;
+}
+
+void Renderer_SetTextureStreamingBudget(Renderer* renderer, uS bytes_per_frame)
+{
+   if (renderer == NULL)
+      return;
+
+   renderer->streaming.frame_budget = M_MAX(bytes_per_frame, 1);
+
+}
+
+u32 Renderer_PendingTextureStreams(Renderer* renderer)
+{
+   if (renderer == NULL)
+      return 0;
+
+   return Util_ArrayLength(renderer->streaming.streams);
+}
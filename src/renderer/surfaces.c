@@ -89,14 +89,13 @@ UniformBlockList Renderer_UseSurfaceMaterial(Renderer* renderer, Transform3D tra
 
 UniformBlockList Renderer_UseSurfaceMaterialAdvanced(Renderer* renderer, mat4x4 matrix, SurfaceMaterial material, color8 color, u32 pass_id)
 {
-   rndr_Surface* surface = RNDR_GetSurface(renderer, material.surface);
-   if (surface == NULL || surface->pass_count  < pass_id + 1)
+   if (renderer == NULL)
       return (UniformBlockList){ 0 };
 
-   Renderer_UseMaterialTextures(renderer, material);
-   Renderer_UploadModelData(renderer, matrix, color);
+   ModelData model_data = RNDR_MakeModelData(renderer, matrix, color);
+   model_data.u_material_id = RNDR_MaterialParamsIndex(renderer, material.params);
 
-   return RNDR_UpdateMaterialUBOs(renderer, material, pass_id);
+   return RNDR_UsePreparedSurfaceMaterial(renderer, &model_data, material, pass_id);
 }
 
 void Renderer_SetSurfaceMaterialTexture(SurfaceMaterial* material, i32 index, i32 bind_slot, Texture texture)
@@ -152,7 +151,7 @@ void Renderer_UseMaterialTextures(Renderer* renderer, SurfaceMaterial material)
       if (user_texture_slots[slot_i].is_set)
       {
          RNDR_BindTextureAtSlot(renderer, slot_i, INTERNAL_RNDR_SURF_TEXTURE_USER_SET, user_texture_slots[slot_i].texture);
-         Graphics_SetTextureInterpolation(renderer->graphics, user_texture_slots[slot_i].texture, user_texture_slots[slot_i].interpolation_settings);
+         Graphics_BindSampler(renderer->graphics, user_texture_slots[slot_i].interpolation_settings, false, slot_i);
 
       } else
          RNDR_BindTextureAtSlot(renderer, slot_i, surface->textures[slot_i], (Texture){ .id = INVALID_HANDLE_ID });
@@ -187,6 +186,32 @@ rndr_Surface* RNDR_GetSurface(Renderer* renderer, Surface res_surface)
    return surface;
 }
 
+// has to run on the GL thread, the draw list workers only read the result.
+void RNDR_UpdateSurfaceStatus(Renderer* renderer)
+{
+   if (renderer == NULL)
+      return;
+
+   u32 surface_count = Util_ArrayLength(renderer->surfaces);
+   for (u32 surf_i = 0; surf_i < surface_count; surf_i++)
+   {
+      rndr_Surface* surface = &renderer->surfaces[surf_i];
+
+      // removed surfaces can have stale shader handles, those just come back as failed
+      for (u32 pass_i = 0; pass_i < surface->pass_count; pass_i++)
+      {
+         if (surface->ready_passes & (1u << pass_i))
+            continue;
+
+         if (Graphics_GetShaderStatus(renderer->graphics, surface->passes[pass_i].shader) == GFX_SHADERSTATUS_READY)
+            surface->ready_passes |= (u8)(1u << pass_i);
+
+      }
+
+   }
+
+}
+
 void RNDR_BindTextureAtSlot(Renderer* renderer, u32 bind_slot, u8 texture_default, Texture texture)
 {
    if (renderer == NULL || bind_slot >= SURF_MAX_TEXTURES)
@@ -202,6 +227,7 @@ void RNDR_BindTextureAtSlot(Renderer* renderer, u32 bind_slot, u8 texture_defaul
 
       renderer->texture_slots[bind_slot] = INTERNAL_RNDR_SURF_TEXTURE_USER_SET;
       Graphics_BindTexture(renderer->graphics, texture, bind_slot);
+      RNDR_TouchTexture(renderer, texture);
 
    }
 
@@ -212,10 +238,23 @@ void RNDR_BindTextureAtSlot(Renderer* renderer, u32 bind_slot, u8 texture_defaul
 
       renderer->texture_slots[bind_slot] = texture_default;
       Graphics_BindTexture(renderer->graphics, renderer->built_in.textures[texture_default], bind_slot);
+      Graphics_UnbindSampler(renderer->graphics, bind_slot);
    }
 
 }
 
+UniformBlockList RNDR_UsePreparedSurfaceMaterial(Renderer* renderer, const ModelData* model_data, SurfaceMaterial material, u32 pass_id)
+{
+   rndr_Surface* surface = RNDR_GetSurface(renderer, material.surface);
+   if (surface == NULL || surface->pass_count  < pass_id + 1)
+      return (UniformBlockList){ 0 };
+
+   Renderer_UseMaterialTextures(renderer, material);
+   RNDR_UploadModelData(renderer, model_data);
+
+   return RNDR_UpdateMaterialUBOs(renderer, material, pass_id);
+}
+
 UniformBlockList RNDR_UpdateMaterialUBOs(Renderer* renderer, SurfaceMaterial material, u32 pass_id)
 {
    if (renderer == NULL)
@@ -232,7 +271,7 @@ UniformBlockList RNDR_UpdateMaterialUBOs(Renderer* renderer, SurfaceMaterial mat
    {
       UniformBlock block = pass.uniform_blocks[block_i];
       void* block_data = material.uniform_block_data[pass_id][block_i];
-      Graphics_UpdateBuffer(renderer->graphics, block.ubo, block_data, 1, block.size);
+      RNDR_UploadUniformBlock(renderer, block, block_data);
 
       uniform_blocks.blocks[block_i] = block;
 
@@ -49,6 +49,7 @@ error SCRP_RegisterEngine(lua_State* script_state, Engine* engine)
       { "SetWindowTitle", SCRP_SetWindowTitle },
       { "RadiansToTurns", SCRP_RadiansToTurns },
       { "TurnsToRadians", SCRP_TurnsToRadians },
+      { "Raycast", SCRP_Raycast },
       { NULL, NULL }
    };
 
@@ -4,6 +4,7 @@
 #include "scripting.h"
 #include "util/types.h"
 #include "engine.h"
+#include "renderer.h"
 
 #include "scripting/internal.h"
 
@@ -106,6 +107,31 @@ static inline int SCRP_SetWindowTitle(lua_State* script_state)
    return 0;
 }
 
+// returns distance, hit point and drawable id of the closest drawable, or nothing if the ray didn't hit one
+static inline int SCRP_Raycast(lua_State* script_state)
+{
+   lua_pushstring(script_state, ENGINE_DATA);
+   lua_gettable(script_state, LUA_REGISTRYINDEX);
+   Engine* engine = lua_touserdata(script_state, -1);
+
+   Renderer* renderer = Engine_FetchModule(engine, RENDERER_MODULE);
+
+   vec3 origin = Scripting_GetVec4(script_state, 1).xyz;
+   vec3 direction = Scripting_GetVec4(script_state, 2).xyz;
+   f32 max_distance = (lua_isnoneornil(script_state, 3)) ? 1000.0f : Scripting_GetF32(script_state, 3);
+
+   RaycastHit hit = { 0 };
+   if (!Renderer_Raycast(renderer, origin, direction, max_distance, &hit))
+      return 0;
+
+   lua_pushnumber(script_state, (lua_Number)hit.distance);
+   Scripting_PushVec4(script_state, (vec4){ .xyz = hit.point, .w = 0.0f });
+   // all 64 bits, the id alone drops the drawable's type
+   lua_pushinteger(script_state, (lua_Integer)hit.drawable.total_bits);
+
+   return 3;
+}
+
 error SCRP_RegisterEngine(lua_State* script_state, Engine* engine);
 
 #endif
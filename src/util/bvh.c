@@ -0,0 +1,792 @@
+#include "util/types.h"
+#include "util/math.h"
+#include "util/vec3.h"
+#include "util/array.h"
+#include "util/extra_types.h"
+#include "util/simd.h"
+
+#include "util/bvh.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BVH_NULL_NODE INVALID_INDEX_U32
+#define BVH_LOCAL_STACK_SIZE 64
+// set on stack entries whose whole subtree is already known to be inside the frustum
+#define BVH_INSIDE_BIT (1u << 31u)
+// a fat box this much bigger than it needs to be gets shrunk, so things that moved far don't keep a huge box
+#define BVH_SHRINK_RATIO 4.0f
+
+enum {
+   BVH_OUTSIDE = 0,
+   BVH_INTERSECTING,
+   BVH_INSIDE
+
+};
+
+typedef struct bvh_Node_t
+{
+   vec3 min;
+   vec3 max;
+   u64 proxy_data;
+   u32 parent; // next free node while the node is on the free list
+   u32 children[2];
+   i32 height; // 0 for leaves, -1 for free nodes
+
+} bvh_Node;
+
+ARRAY_TYPEDEF(bvh_Node);
+
+struct BVH_t
+{
+   ARRAY_TYPE(bvh_Node) nodes;
+   u32 root;
+   u32 free_root;
+   u32 proxy_count;
+   f32 margin;
+
+};
+
+// traversal stack, starts out on the C stack and moves to the heap if a query goes deeper than that
+typedef struct bvh_Stack_t
+{
+   u32* items;
+   u32 count;
+   u32 capacity;
+   u32 local[BVH_LOCAL_STACK_SIZE];
+
+} bvh_Stack;
+
+typedef struct bvh_FrustumPlanes_t
+{
+   f32x4 x[2], y[2], z[2], w[2];
+   f32x4 abs_x[2], abs_y[2], abs_z[2];
+
+} bvh_FrustumPlanes;
+
+static inline void BVH_InitStack(bvh_Stack* stack)
+{
+   stack->items = stack->local;
+   stack->count = 0;
+   stack->capacity = BVH_LOCAL_STACK_SIZE;
+
+}
+
+static inline void BVH_FreeStack(bvh_Stack* stack)
+{
+   if (stack->items != stack->local)
+      free(stack->items);
+
+}
+
+static bool BVH_Push(bvh_Stack* stack, u32 item)
+{
+   if (stack->count == stack->capacity)
+   {
+      u32 new_capacity = stack->capacity * 2u;
+      u32* new_items = (stack->items == stack->local) ? malloc(sizeof(u32) * new_capacity) : realloc(stack->items, sizeof(u32) * new_capacity);
+      if (new_items == NULL)
+         return false;
+
+      if (stack->items == stack->local)
+         memcpy(new_items, stack->local, sizeof(u32) * stack->count);
+
+      stack->items = new_items;
+      stack->capacity = new_capacity;
+
+   }
+
+   stack->items[stack->count++] = item;
+
+   return true;
+}
+
+// half the surface area, only ever compared against other areas
+static inline f32 BVH_Area(vec3 min, vec3 max)
+{
+   vec3 d = Util_SubVec3(max, min);
+   return d.x*d.y + d.y*d.z + d.z*d.x;
+}
+
+static inline f32 BVH_UnionArea(const bvh_Node* a, const bvh_Node* b)
+{
+   return BVH_Area(Util_MinVec3(a->min, b->min), Util_MaxVec3(a->max, b->max));
+}
+
+static inline bool BVH_IsLeaf(BVH* bvh, u32 proxy_id)
+{
+   return (bvh != NULL && proxy_id < Util_ArrayLength(bvh->nodes) && bvh->nodes[proxy_id].height == 0);
+}
+
+static u32 BVH_AllocateNode(BVH* bvh)
+{
+   if (bvh->free_root == BVH_NULL_NODE)
+   {
+      u32 node_count = Util_ArrayLength(bvh->nodes);
+      u32 new_count = M_MAX(node_count * 2u, 16u);
+      SET_ARRAY_LENGTH(bvh->nodes, new_count);
+
+      for (u32 node_i = node_count; node_i < new_count; node_i++)
+      {
+         bvh->nodes[node_i].parent = (node_i + 1u < new_count) ? node_i + 1u : BVH_NULL_NODE;
+         bvh->nodes[node_i].height = -1;
+
+      }
+
+      bvh->free_root = node_count;
+
+   }
+
+   u32 node_idx = bvh->free_root;
+   bvh_Node* node = &bvh->nodes[node_idx];
+   bvh->free_root = node->parent;
+
+   *node = (bvh_Node){ 0 };
+   node->parent = BVH_NULL_NODE;
+   node->children[0] = BVH_NULL_NODE;
+   node->children[1] = BVH_NULL_NODE;
+
+   return node_idx;
+}
+
+static void BVH_FreeNode(BVH* bvh, u32 node_idx)
+{
+   bvh->nodes[node_idx].parent = bvh->free_root;
+   bvh->nodes[node_idx].height = -1;
+   bvh->free_root = node_idx;
+
+}
+
+// greedy walk down from the root. at every node the cost of pairing the leaf with it is its combined area plus how
+// much every ancestor had to grow, and a child is only entered if that lower bound can still beat the best so far.
+static u32 BVH_FindBestSibling(BVH* bvh, const bvh_Node* leaf)
+{
+   bvh_Node* nodes = bvh->nodes;
+   f32 leaf_area = BVH_Area(leaf->min, leaf->max);
+
+   u32 best_sibling = bvh->root;
+   f32 best_cost = BVH_UnionArea(&nodes[bvh->root], leaf);
+   f32 inherited_cost = 0.0f;
+
+   u32 node_idx = bvh->root;
+   while (nodes[node_idx].height > 0)
+   {
+      bvh_Node* node = &nodes[node_idx];
+      f32 combined_area = BVH_UnionArea(node, leaf);
+
+      f32 cost = combined_area + inherited_cost;
+      if (cost < best_cost)
+      {
+         best_sibling = node_idx;
+         best_cost = cost;
+
+      }
+
+      inherited_cost += combined_area - BVH_Area(node->min, node->max);
+
+      f32 lower_bound[2] = { 0 };
+      for (u32 child_i = 0; child_i < 2; child_i++)
+      {
+         u32 child_idx = node->children[child_i];
+         bvh_Node* child = &nodes[child_idx];
+         f32 direct_cost = BVH_UnionArea(child, leaf) + inherited_cost;
+
+         if (child->height == 0)
+         {
+            if (direct_cost < best_cost)
+            {
+               best_sibling = child_idx;
+               best_cost = direct_cost;
+
+            }
+
+            lower_bound[child_i] = INFINITY;
+            continue;
+         }
+
+         // anything further down still needs a new parent at least as big as the leaf
+         f32 descend_cost = direct_cost - BVH_Area(child->min, child->max) + leaf_area;
+         lower_bound[child_i] = M_MIN(direct_cost, descend_cost);
+
+      }
+
+      u32 next_i = (lower_bound[1] < lower_bound[0]) ? 1u : 0u;
+      if (lower_bound[next_i] >= best_cost)
+         break;
+
+      node_idx = node->children[next_i];
+
+   }
+
+   return best_sibling;
+}
+
+// swaps a child of node with a grandchild on the other side when that shrinks the other child's box the most.
+// the node's own box never changes, only its height can.
+static void BVH_RotateNodes(BVH* bvh, u32 node_idx)
+{
+   bvh_Node* nodes = bvh->nodes;
+   bvh_Node* node = &nodes[node_idx];
+   if (node->height < 2)
+      return;
+
+   f32 best_gain = 0.0f;
+   u32 best_down = 0;
+   u32 best_up = 0;
+
+   for (u32 down_i = 0; down_i < 2; down_i++)
+   {
+      bvh_Node* down = &nodes[node->children[down_i]];
+      bvh_Node* other = &nodes[node->children[1u - down_i]];
+      if (other->height == 0)
+         continue;
+
+      f32 other_area = BVH_Area(other->min, other->max);
+      for (u32 up_i = 0; up_i < 2; up_i++)
+      {
+         // the grandchild that stays behind ends up sharing a box with the child coming down
+         bvh_Node* stays = &nodes[other->children[1u - up_i]];
+         f32 gain = other_area - BVH_UnionArea(down, stays);
+         if (gain > best_gain)
+         {
+            best_gain = gain;
+            best_down = down_i;
+            best_up = up_i;
+
+         }
+
+      }
+
+   }
+
+   if (best_gain <= 0.0f)
+      return;
+
+   u32 down_idx = node->children[best_down];
+   u32 other_idx = node->children[1u - best_down];
+   bvh_Node* other = &nodes[other_idx];
+   u32 up_idx = other->children[best_up];
+   u32 stays_idx = other->children[1u - best_up];
+
+   node->children[best_down] = up_idx;
+   nodes[up_idx].parent = node_idx;
+
+   other->children[best_up] = down_idx;
+   nodes[down_idx].parent = other_idx;
+
+   other->min = Util_MinVec3(nodes[down_idx].min, nodes[stays_idx].min);
+   other->max = Util_MaxVec3(nodes[down_idx].max, nodes[stays_idx].max);
+   other->height = 1 + M_MAX(nodes[down_idx].height, nodes[stays_idx].height);
+
+   node->height = 1 + M_MAX(nodes[up_idx].height, other->height);
+
+}
+
+static void BVH_RefitAncestors(BVH* bvh, u32 node_idx, bool rotate)
+{
+   bvh_Node* nodes = bvh->nodes;
+   while (node_idx != BVH_NULL_NODE)
+   {
+      bvh_Node* node = &nodes[node_idx];
+      bvh_Node* child_a = &nodes[node->children[0]];
+      bvh_Node* child_b = &nodes[node->children[1]];
+
+      node->min = Util_MinVec3(child_a->min, child_b->min);
+      node->max = Util_MaxVec3(child_a->max, child_b->max);
+      node->height = 1 + M_MAX(child_a->height, child_b->height);
+
+      if (rotate)
+         BVH_RotateNodes(bvh, node_idx);
+
+      node_idx = node->parent;
+
+   }
+
+}
+
+static void BVH_InsertLeaf(BVH* bvh, u32 leaf_idx)
+{
+   if (bvh->root == BVH_NULL_NODE)
+   {
+      bvh->root = leaf_idx;
+      bvh->nodes[leaf_idx].parent = BVH_NULL_NODE;
+
+      return;
+   }
+
+   u32 sibling_idx = BVH_FindBestSibling(bvh, &bvh->nodes[leaf_idx]);
+   u32 parent_idx = BVH_AllocateNode(bvh);
+
+   bvh_Node* nodes = bvh->nodes;
+   u32 old_parent_idx = nodes[sibling_idx].parent;
+
+   bvh_Node* parent = &nodes[parent_idx];
+   parent->parent = old_parent_idx;
+   parent->children[0] = sibling_idx;
+   parent->children[1] = leaf_idx;
+   parent->min = Util_MinVec3(nodes[sibling_idx].min, nodes[leaf_idx].min);
+   parent->max = Util_MaxVec3(nodes[sibling_idx].max, nodes[leaf_idx].max);
+   parent->height = nodes[sibling_idx].height + 1;
+
+   nodes[sibling_idx].parent = parent_idx;
+   nodes[leaf_idx].parent = parent_idx;
+
+   if (old_parent_idx == BVH_NULL_NODE)
+      bvh->root = parent_idx;
+   else
+   {
+      bvh_Node* old_parent = &nodes[old_parent_idx];
+      old_parent->children[(old_parent->children[0] == sibling_idx) ? 0 : 1] = parent_idx;
+
+   }
+
+   BVH_RefitAncestors(bvh, old_parent_idx, true);
+
+}
+
+static void BVH_RemoveLeaf(BVH* bvh, u32 leaf_idx)
+{
+   if (leaf_idx == bvh->root)
+   {
+      bvh->root = BVH_NULL_NODE;
+
+      return;
+   }
+
+   bvh_Node* nodes = bvh->nodes;
+   u32 parent_idx = nodes[leaf_idx].parent;
+   u32 grandparent_idx = nodes[parent_idx].parent;
+   u32 sibling_idx = (nodes[parent_idx].children[0] == leaf_idx) ? nodes[parent_idx].children[1] : nodes[parent_idx].children[0];
+
+   nodes[sibling_idx].parent = grandparent_idx;
+   BVH_FreeNode(bvh, parent_idx);
+
+   if (grandparent_idx == BVH_NULL_NODE)
+   {
+      bvh->root = sibling_idx;
+
+      return;
+   }
+
+   bvh_Node* grandparent = &nodes[grandparent_idx];
+   grandparent->children[(grandparent->children[0] == parent_idx) ? 0 : 1] = sibling_idx;
+
+   BVH_RefitAncestors(bvh, grandparent_idx, false);
+
+}
+
+static inline void BVH_FatBox(BVH* bvh, BBox bounds, vec3* fat_min, vec3* fat_max)
+{
+   vec3 extents = Util_AddVec3(Util_AbsVec3(bounds.extents), Util_FillVec3(bvh->margin));
+   *fat_min = Util_SubVec3(bounds.center, extents);
+   *fat_max = Util_AddVec3(bounds.center, extents);
+
+}
+
+BVH* Util_CreateBVH(f32 margin)
+{
+   BVH* bvh = malloc(sizeof(BVH));
+   if (bvh == NULL)
+      return NULL;
+
+   bvh->nodes = NEW_ARRAY_N(bvh_Node, 16);
+   bvh->root = BVH_NULL_NODE;
+   bvh->free_root = BVH_NULL_NODE;
+   bvh->proxy_count = 0;
+   bvh->margin = M_MAX(margin, 0.0f);
+
+   if (bvh->nodes == NULL)
+   {
+      free(bvh);
+
+      return NULL;
+   }
+
+   return bvh;
+}
+
+void Util_FreeBVH(BVH* bvh)
+{
+   if (bvh == NULL)
+      return;
+
+   FREE_ARRAY(bvh->nodes);
+   free(bvh);
+
+}
+
+u32 Util_BVHCreateProxy(BVH* bvh, BBox bounds, u64 proxy_data)
+{
+   if (bvh == NULL)
+      return BVH_NULL_PROXY;
+
+   u32 leaf_idx = BVH_AllocateNode(bvh);
+   bvh_Node* leaf = &bvh->nodes[leaf_idx];
+   BVH_FatBox(bvh, bounds, &leaf->min, &leaf->max);
+   leaf->proxy_data = proxy_data;
+   leaf->height = 0;
+
+   BVH_InsertLeaf(bvh, leaf_idx);
+   bvh->proxy_count++;
+
+   return leaf_idx;
+}
+
+void Util_BVHDestroyProxy(BVH* bvh, u32 proxy_id)
+{
+   if (!BVH_IsLeaf(bvh, proxy_id))
+      return;
+
+   BVH_RemoveLeaf(bvh, proxy_id);
+   BVH_FreeNode(bvh, proxy_id);
+   bvh->proxy_count--;
+
+}
+
+bool Util_BVHMoveProxy(BVH* bvh, u32 proxy_id, BBox bounds)
+{
+   if (!BVH_IsLeaf(bvh, proxy_id))
+      return false;
+
+   vec3 fat_min, fat_max;
+   BVH_FatBox(bvh, bounds, &fat_min, &fat_max);
+
+   vec3 bounds_min, bounds_max;
+   Util_BBoxMinMax(bounds, &bounds_min, &bounds_max);
+
+   bvh_Node* leaf = &bvh->nodes[proxy_id];
+   bool is_contained =
+      (leaf->min.x <= bounds_min.x) && (leaf->min.y <= bounds_min.y) && (leaf->min.z <= bounds_min.z) &&
+      (leaf->max.x >= bounds_max.x) && (leaf->max.y >= bounds_max.y) && (leaf->max.z >= bounds_max.z);
+
+   if (is_contained && BVH_Area(leaf->min, leaf->max) <= BVH_Area(fat_min, fat_max) * BVH_SHRINK_RATIO)
+      return false;
+
+   BVH_RemoveLeaf(bvh, proxy_id);
+
+   leaf = &bvh->nodes[proxy_id];
+   leaf->min = fat_min;
+   leaf->max = fat_max;
+
+   BVH_InsertLeaf(bvh, proxy_id);
+
+   return true;
+}
+
+u64 Util_BVHProxyData(BVH* bvh, u32 proxy_id)
+{
+   if (!BVH_IsLeaf(bvh, proxy_id))
+      return 0;
+
+   return bvh->nodes[proxy_id].proxy_data;
+}
+
+BBox Util_BVHFatBounds(BVH* bvh, u32 proxy_id)
+{
+   if (!BVH_IsLeaf(bvh, proxy_id))
+      return (BBox){ 0 };
+
+   bvh_Node* leaf = &bvh->nodes[proxy_id];
+   vec3 center = Util_ScaleVec3(Util_AddVec3(leaf->min, leaf->max), 0.5f);
+
+   return (BBox){ center, Util_SubVec3(leaf->max, center) };
+}
+
+u32 Util_BVHProxyCount(BVH* bvh)
+{
+   if (bvh == NULL)
+      return 0;
+
+   return bvh->proxy_count;
+}
+
+u32 Util_BVHHeight(BVH* bvh)
+{
+   if (bvh == NULL || bvh->root == BVH_NULL_NODE)
+      return 0;
+
+   return (u32)bvh->nodes[bvh->root].height;
+}
+
+f32 Util_BVHAreaRatio(BVH* bvh)
+{
+   if (bvh == NULL || bvh->root == BVH_NULL_NODE)
+      return 0.0f;
+
+   f32 root_area = BVH_Area(bvh->nodes[bvh->root].min, bvh->nodes[bvh->root].max);
+   if (root_area <= 0.0f)
+      return 0.0f;
+
+   f32 total_area = 0.0f;
+   u32 node_count = Util_ArrayLength(bvh->nodes);
+   for (u32 node_i = 0; node_i < node_count; node_i++)
+   {
+      if (bvh->nodes[node_i].height > 0)
+         total_area += BVH_Area(bvh->nodes[node_i].min, bvh->nodes[node_i].max);
+
+   }
+
+   return total_area / root_area;
+}
+
+void Util_BVHQueryBox(BVH* bvh, BBox box, BVHQueryFunc func, void* user_data)
+{
+   if (bvh == NULL || func == NULL || bvh->root == BVH_NULL_NODE)
+      return;
+
+   vec3 box_min, box_max;
+   Util_BBoxMinMax(box, &box_min, &box_max);
+
+   bvh_Stack stack;
+   BVH_InitStack(&stack);
+   BVH_Push(&stack, bvh->root);
+
+   while (stack.count > 0)
+   {
+      u32 node_idx = stack.items[--stack.count];
+      const bvh_Node* node = &bvh->nodes[node_idx];
+
+      bool is_overlapping =
+         (node->min.x <= box_max.x) && (node->min.y <= box_max.y) && (node->min.z <= box_max.z) &&
+         (node->max.x >= box_min.x) && (node->max.y >= box_min.y) && (node->max.z >= box_min.z);
+
+      if (!is_overlapping)
+         continue;
+
+      if (node->height == 0)
+      {
+         if (!func(user_data, node_idx, node->proxy_data))
+            break;
+
+         continue;
+      }
+
+      if (!BVH_Push(&stack, node->children[0]) || !BVH_Push(&stack, node->children[1]))
+         break;
+
+   }
+
+   BVH_FreeStack(&stack);
+
+}
+
+void Util_BVHQuerySphere(BVH* bvh, vec3 center, f32 radius, BVHQueryFunc func, void* user_data)
+{
+   if (bvh == NULL || func == NULL || bvh->root == BVH_NULL_NODE)
+      return;
+
+   f32 radius_sqr = radius * radius;
+
+   bvh_Stack stack;
+   BVH_InitStack(&stack);
+   BVH_Push(&stack, bvh->root);
+
+   while (stack.count > 0)
+   {
+      u32 node_idx = stack.items[--stack.count];
+      const bvh_Node* node = &bvh->nodes[node_idx];
+
+      vec3 outside = Util_AddVec3(
+         Util_MaxVec3(Util_SubVec3(node->min, center), VEC3(0, 0, 0)),
+         Util_MaxVec3(Util_SubVec3(center, node->max), VEC3(0, 0, 0))
+      );
+
+      if (Util_MagSqrVec3(outside) > radius_sqr)
+         continue;
+
+      if (node->height == 0)
+      {
+         if (!func(user_data, node_idx, node->proxy_data))
+            break;
+
+         continue;
+      }
+
+      if (!BVH_Push(&stack, node->children[0]) || !BVH_Push(&stack, node->children[1]))
+         break;
+
+   }
+
+   BVH_FreeStack(&stack);
+
+}
+
+static u32 BVH_TestFrustum(const bvh_FrustumPlanes* planes, const bvh_Node* node)
+{
+   vec3 center = Util_ScaleVec3(Util_AddVec3(node->min, node->max), 0.5f);
+   vec3 extents = Util_SubVec3(node->max, center);
+
+   f32x4 center_x = Util_Splat4(center.x);
+   f32x4 center_y = Util_Splat4(center.y);
+   f32x4 center_z = Util_Splat4(center.z);
+   f32x4 extents_x = Util_Splat4(extents.x);
+   f32x4 extents_y = Util_Splat4(extents.y);
+   f32x4 extents_z = Util_Splat4(extents.z);
+   f32x4 zero = Util_Splat4(0.0f);
+
+   bool is_inside = true;
+   for (u32 batch_i = 0; batch_i < 2; batch_i++)
+   {
+      f32x4 distance = Util_Add4(Util_Add4(Util_Mul4(planes->x[batch_i], center_x), Util_Mul4(planes->y[batch_i], center_y)),
+         Util_Add4(Util_Mul4(planes->z[batch_i], center_z), planes->w[batch_i]));
+      f32x4 radius = Util_Add4(Util_Add4(Util_Mul4(planes->abs_x[batch_i], extents_x), Util_Mul4(planes->abs_y[batch_i], extents_y)),
+         Util_Mul4(planes->abs_z[batch_i], extents_z));
+
+      if (Util_AnyLess4(Util_Add4(distance, radius), zero))
+         return BVH_OUTSIDE;
+
+      if (Util_AnyLess4(distance, radius))
+         is_inside = false;
+
+   }
+
+   return (is_inside) ? BVH_INSIDE : BVH_INTERSECTING;
+}
+
+void Util_BVHQueryFrustum(BVH* bvh, Frustum frustum, BVHQueryFunc func, void* user_data)
+{
+   if (bvh == NULL || func == NULL || bvh->root == BVH_NULL_NODE)
+      return;
+
+   // planes go in lanes, the last two lanes are a plane nothing is ever behind
+   vec4 padded[8] = { 0 };
+   for (u32 plane_i = 0; plane_i < 8; plane_i++)
+      padded[plane_i] = (plane_i < 6) ? frustum.planes[plane_i] : VEC4(0, 0, 0, 1);
+
+   bvh_FrustumPlanes planes;
+   for (u32 batch_i = 0; batch_i < 2; batch_i++)
+   {
+      const vec4* p = &padded[batch_i * 4];
+      planes.x[batch_i] = Util_Set4(p[0].x, p[1].x, p[2].x, p[3].x);
+      planes.y[batch_i] = Util_Set4(p[0].y, p[1].y, p[2].y, p[3].y);
+      planes.z[batch_i] = Util_Set4(p[0].z, p[1].z, p[2].z, p[3].z);
+      planes.w[batch_i] = Util_Set4(p[0].w, p[1].w, p[2].w, p[3].w);
+      planes.abs_x[batch_i] = Util_Set4(fabsf(p[0].x), fabsf(p[1].x), fabsf(p[2].x), fabsf(p[3].x));
+      planes.abs_y[batch_i] = Util_Set4(fabsf(p[0].y), fabsf(p[1].y), fabsf(p[2].y), fabsf(p[3].y));
+      planes.abs_z[batch_i] = Util_Set4(fabsf(p[0].z), fabsf(p[1].z), fabsf(p[2].z), fabsf(p[3].z));
+
+   }
+
+   bvh_Stack stack;
+   BVH_InitStack(&stack);
+   BVH_Push(&stack, bvh->root);
+
+   while (stack.count > 0)
+   {
+      u32 entry = stack.items[--stack.count];
+      u32 node_idx = entry & ~BVH_INSIDE_BIT;
+      const bvh_Node* node = &bvh->nodes[node_idx];
+
+      // once a node is fully inside, nothing under it needs testing
+      u32 inside_bit = entry & BVH_INSIDE_BIT;
+      if (inside_bit == 0)
+      {
+         u32 result = BVH_TestFrustum(&planes, node);
+         if (result == BVH_OUTSIDE)
+            continue;
+
+         if (result == BVH_INSIDE)
+            inside_bit = BVH_INSIDE_BIT;
+
+      }
+
+      if (node->height == 0)
+      {
+         if (!func(user_data, node_idx, node->proxy_data))
+            break;
+
+         continue;
+      }
+
+      if (!BVH_Push(&stack, node->children[0] | inside_bit) || !BVH_Push(&stack, node->children[1] | inside_bit))
+         break;
+
+   }
+
+   BVH_FreeStack(&stack);
+
+}
+
+static inline f32 BVH_InverseDirection(f32 d)
+{
+   // a huge but finite value keeps 0 * inf from turning into nan on axis aligned rays
+   if (fabsf(d) > 1e-20f)
+      return 1.0f / d;
+
+   return (d < 0.0f) ? -1e20f : 1e20f;
+}
+
+static inline f32 BVH_RaySlab(f32x4 origin, f32x4 inv_direction, vec3 box_min, vec3 box_max, f32 max_distance)
+{
+   f32x4 t_min = Util_Mul4(Util_Sub4(Util_Set4(box_min.x, box_min.y, box_min.z, 0.0f), origin), inv_direction);
+   f32x4 t_max = Util_Mul4(Util_Sub4(Util_Set4(box_max.x, box_max.y, box_max.z, 0.0f), origin), inv_direction);
+
+   f32 t_near[4], t_far[4];
+   Util_Store4(t_near, Util_Min4(t_min, t_max));
+   Util_Store4(t_far, Util_Max4(t_min, t_max));
+
+   f32 enter = M_MAX(M_MAX(t_near[0], t_near[1]), M_MAX(t_near[2], 0.0f));
+   f32 exit = M_MIN(M_MIN(t_far[0], t_far[1]), M_MIN(t_far[2], max_distance));
+
+   return (enter <= exit) ? enter : -1.0f;
+}
+
+f32 Util_RayBBoxDistance(vec3 origin, vec3 direction, f32 max_distance, BBox bbox)
+{
+   vec3 box_min, box_max;
+   Util_BBoxMinMax(bbox, &box_min, &box_max);
+
+   f32x4 origin4 = Util_Set4(origin.x, origin.y, origin.z, 0.0f);
+   f32x4 inv_direction4 = Util_Set4(BVH_InverseDirection(direction.x), BVH_InverseDirection(direction.y), BVH_InverseDirection(direction.z), 0.0f);
+
+   return BVH_RaySlab(origin4, inv_direction4, box_min, box_max, max_distance);
+}
+
+void Util_BVHRaycast(BVH* bvh, vec3 origin, vec3 direction, f32 max_distance, BVHRayFunc func, void* user_data)
+{
+   if (bvh == NULL || func == NULL || bvh->root == BVH_NULL_NODE || max_distance <= 0.0f)
+      return;
+
+   f32x4 origin4 = Util_Set4(origin.x, origin.y, origin.z, 0.0f);
+   f32x4 inv_direction4 = Util_Set4(BVH_InverseDirection(direction.x), BVH_InverseDirection(direction.y), BVH_InverseDirection(direction.z), 0.0f);
+
+   bvh_Stack stack;
+   BVH_InitStack(&stack);
+   BVH_Push(&stack, bvh->root);
+
+   while (stack.count > 0)
+   {
+      u32 node_idx = stack.items[--stack.count];
+      const bvh_Node* node = &bvh->nodes[node_idx];
+
+      if (BVH_RaySlab(origin4, inv_direction4, node->min, node->max, max_distance) < 0.0f)
+         continue;
+
+      if (node->height == 0)
+      {
+         f32 clip_distance = func(user_data, node_idx, node->proxy_data, origin, direction, max_distance);
+         if (clip_distance == 0.0f)
+            break;
+
+         if (clip_distance > 0.0f)
+            max_distance = M_MIN(max_distance, clip_distance);
+
+         continue;
+      }
+
+      // the child closer to the origin goes on top, so hits there can clip the ray before the other side is visited
+      const bvh_Node* child_a = &bvh->nodes[node->children[0]];
+      const bvh_Node* child_b = &bvh->nodes[node->children[1]];
+      f32 along_a = Util_DotVec3(Util_SubVec3(Util_AddVec3(child_a->min, child_a->max), Util_ScaleVec3(origin, 2.0f)), direction);
+      f32 along_b = Util_DotVec3(Util_SubVec3(Util_AddVec3(child_b->min, child_b->max), Util_ScaleVec3(origin, 2.0f)), direction);
+      u32 near_i = (along_b < along_a) ? 1u : 0u;
+
+      if (!BVH_Push(&stack, node->children[1u - near_i]) || !BVH_Push(&stack, node->children[near_i]))
+         break;
+
+   }
+
+   BVH_FreeStack(&stack);
+
+}
@@ -6,6 +6,18 @@
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 char* Util_ReplaceFileExtension(const char* file_path, const char* extension)
 {
@@ -35,24 +47,54 @@ char* Util_MakeFilePath(const char* base_path, const char* file_name)
    if (base_path == NULL || file_name == NULL)
       return NULL;
 
+   bool has_directory = false;
    i32 directory_length = (i32)strnlen(base_path, PATH_CHARACTER_LIMIT);
    while (directory_length > 0)
    {
       char directory_char = base_path[--directory_length];
       if (directory_char == '/' || directory_char == '\\')
+      {
+         has_directory = true;
          break;
+      }
    }
 
-   i32 full_path_length = snprintf(NULL, 0, "%.*s/%s", directory_length, base_path, file_name) + 1;
+   // a base path without any directory (like argv[0] for something run from PATH) means the working directory,
+   // not the filesystem root
+   const char* path_format = (has_directory) ? "%.*s/%s" : "%.*s%s";
+
+   i32 full_path_length = snprintf(NULL, 0, path_format, directory_length, base_path, file_name) + 1;
    char* file_path = malloc(full_path_length * sizeof(char));
    if (file_path == NULL)
       return NULL;
 
-   snprintf(file_path, full_path_length, "%.*s/%s", directory_length, base_path, file_name);
+   snprintf(file_path, full_path_length, path_format, directory_length, base_path, file_name);
 
    return file_path;
 }
 
+char* Util_MakeDirectoryPath(const char* directory_path)
+{
+   if (directory_path == NULL)
+      return NULL;
+
+   uS directory_length = strnlen(directory_path, PATH_CHARACTER_LIMIT);
+   bool has_slash = (directory_length > 0 && (directory_path[directory_length - 1] == '/' || directory_path[directory_length - 1] == '\\'));
+
+   char* path = malloc(directory_length + 2);
+   if (path == NULL)
+      return NULL;
+
+   memcpy(path, directory_path, directory_length);
+   // an empty directory is the working directory, a slash would make it the root
+   if (directory_length > 0 && !has_slash)
+      path[directory_length++] = '/';
+
+   path[directory_length] = '\0';
+
+   return path;
+}
+
 memblob Util_LoadFileIntoMemory(const char* file_path, bool read_as_binary)
 {
    memblob memory = { .size = 0, .data = NULL };
@@ -89,6 +131,75 @@ memblob Util_LoadFileIntoMemory(const char* file_path, bool read_as_binary)
    return memory;
 }
 
+MmapBlob Util_MapFile(const char* file_path)
+{
+   MmapBlob mapping = { .data = NULL, .size = 0 };
+
+   if (file_path == NULL)
+      return mapping;
+
+#ifdef _WIN32
+   HANDLE file = CreateFileA(file_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+   if (file == INVALID_HANDLE_VALUE)
+      return mapping;
+
+   LARGE_INTEGER file_size = { 0 };
+   HANDLE file_mapping = NULL;
+
+   if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0)
+      file_mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+
+   // the view keeps the file open on its own
+   if (file_mapping != NULL)
+   {
+      mapping.data = MapViewOfFile(file_mapping, FILE_MAP_COPY, 0, 0, 0);
+      mapping.size = (mapping.data != NULL) ? (uS)file_size.QuadPart : 0;
+      CloseHandle(file_mapping);
+
+   }
+
+   CloseHandle(file);
+#else
+   i32 file = open(file_path, O_RDONLY);
+   if (file < 0)
+      return mapping;
+
+   struct stat file_info = { 0 };
+   if (fstat(file, &file_info) == 0 && file_info.st_size > 0)
+   {
+      void* data = mmap(NULL, (uS)file_info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+      if (data != MAP_FAILED)
+      {
+         mapping.data = data;
+         mapping.size = (uS)file_info.st_size;
+
+      }
+
+   }
+
+   // the mapping keeps its own reference to the file
+   close(file);
+#endif
+
+   return mapping;
+}
+
+void Util_UnmapFile(MmapBlob* mapping)
+{
+   if (mapping == NULL || mapping->data == NULL)
+      return;
+
+#ifdef _WIN32
+   UnmapViewOfFile(mapping->data);
+#else
+   munmap(mapping->data, mapping->size);
+#endif
+
+   mapping->data = NULL;
+   mapping->size = 0;
+
+}
+
 memblob Util_LoadFileFromBasePath(const char* base_path, const char* file_name, bool read_as_binary)
 {
    memblob memory = { .size = 0, .data = NULL };
@@ -104,6 +215,49 @@ memblob Util_LoadFileFromBasePath(const char* base_path, const char* file_name,
    return memory;
 }
 
+bool Util_SaveMemoryToFile(const char* file_path, memblob memory)
+{
+   if (file_path == NULL || (memory.data == NULL && memory.size > 0))
+      return false;
+
+   FILE* output_file = fopen(file_path, "wb");
+   if (output_file == NULL)
+      return false;
+
+   uS num_bytes_written = fwrite(memory.data, sizeof(u8), memory.size, output_file);
+   bool is_closed = (fclose(output_file) == 0);
+
+   return is_closed && (num_bytes_written == memory.size);
+}
+
+bool Util_MakeDirectory(const char* directory_path)
+{
+   if (directory_path == NULL)
+      return false;
+
+#ifdef _WIN32
+   i32 result = _mkdir(directory_path);
+#else
+   i32 result = mkdir(directory_path, 0755);
+#endif
+
+   return (result == 0) || (errno == EEXIST);
+}
+
+u64 Util_HashBytes(const void* data, uS size, u64 seed)
+{
+   const u8* bytes = data;
+   u64 hash = seed;
+
+   for (uS byte_i = 0; byte_i < size; byte_i++)
+   {
+      hash ^= (u64)bytes[byte_i];
+      hash *= 0x100000001b3ull;
+
+   }
+
+   return hash;
+}
 
 memblob Util_PrependShaderDefines(memblob shader_data, const char* defines[], const u32 define_count, const char* extra)
 {
@@ -113,40 +267,54 @@ memblob Util_PrependShaderDefines(memblob shader_data, const char* defines[], co
    if (defines == NULL && define_count != 0)
       return (memblob){ 0 };
 
-   char* shader_code = shader_data.data;
-   char* total_defines = NULL;
-   uS total_defines_size = 0;
+   const char* version_line = "#version 430 core\n";
+   const char* define_prefix = "#define ";
 
-   const char* template = "#define %s\n";
+   uS version_length = strlen(version_line);
+   uS prefix_length = strlen(define_prefix);
+   uS extra_length = (extra != NULL) ? strlen(extra) : 0;
+   uS code_length = strnlen(shader_data.data, shader_data.size);
 
+   // work out the whole size first so it's one allocation and one copy
+   uS shader_size = version_length + extra_length + 1 + code_length + 2;
    for (u32 define_i = 0; define_i < define_count; define_i++)
-   {
-      i32 define_size = snprintf(NULL, 0, template, defines[define_i]);
+      shader_size += prefix_length + strlen(defines[define_i]) + 1;
 
-      char* tmp_defines = realloc(total_defines, total_defines_size + define_size + 1);
-      if (tmp_defines == NULL)
-         break;
+   char* full_shader_code = malloc(shader_size);
+   if (full_shader_code == NULL)
+      return (memblob){ 0 };
+
+   char* write_ptr = full_shader_code;
 
-      total_defines = tmp_defines;
-      char* tmp_define = total_defines + total_defines_size;
-      snprintf(tmp_define, define_size + 1, template, defines[define_i]);
+   memcpy(write_ptr, version_line, version_length);
+   write_ptr += version_length;
+
+   for (u32 define_i = 0; define_i < define_count; define_i++)
+   {
+      uS define_length = strlen(defines[define_i]);
+
+      memcpy(write_ptr, define_prefix, prefix_length);
+      write_ptr += prefix_length;
+      memcpy(write_ptr, defines[define_i], define_length);
+      write_ptr += define_length;
+      *(write_ptr++) = '\n';
 
-      total_defines_size += define_size;
    }
 
-   const char* glsl_shader_stub = "#version 430 core\n%s%s\n%s\n";
-   char* inserted_code = (extra != NULL) ? (char*)extra : "";
-   char* inserted_defs = (total_defines != NULL) ? total_defines : "";
+   if (extra_length > 0)
+   {
+      memcpy(write_ptr, extra, extra_length);
+      write_ptr += extra_length;
+
+   }
 
-   i32 shader_size = snprintf(NULL, 0, glsl_shader_stub, inserted_defs, inserted_code, shader_code) + 1;
+   *(write_ptr++) = '\n';
 
-   char* full_shader_code = malloc(shader_size);
-   if (full_shader_code == NULL)
-      return (memblob){ 0 };
+   memcpy(write_ptr, shader_data.data, code_length);
+   write_ptr += code_length;
 
-   snprintf(full_shader_code, shader_size, glsl_shader_stub, inserted_defs, inserted_code, shader_code);
-   if (total_defines != NULL)
-      free(total_defines);
+   *(write_ptr++) = '\n';
+   *(write_ptr++) = '\0';
 
    return (memblob){ full_shader_code, shader_size };
 }
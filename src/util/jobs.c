@@ -0,0 +1,728 @@
+#include "util/types.h"
+#include "util/math.h"
+#include "util/array.h"
+#include "util/files.h"
+
+#include "util/jobs.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#define JOBS_THREAD_LOCAL __declspec(thread)
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#define JOBS_THREAD_LOCAL _Thread_local
+#endif
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// binary splitting only keeps ~log2(count / grain_size) ranges in a deque at once, so this never fills up in practice.
+// if it does the range just gets processed without splitting any further.
+#define JOBS_DEQUE_SIZE 256
+#define JOBS_DEQUE_MASK (JOBS_DEQUE_SIZE - 1)
+#define JOBS_CACHE_LINE 64
+
+#define JOBS_PACK_RANGE(start, end) (((u64)(end) << 32u) | (u64)(start))
+
+#ifdef _WIN32
+typedef HANDLE jobs_Thread;
+typedef CRITICAL_SECTION jobs_Mutex;
+typedef CONDITION_VARIABLE jobs_Cond;
+#else
+typedef pthread_t jobs_Thread;
+typedef pthread_mutex_t jobs_Mutex;
+typedef pthread_cond_t jobs_Cond;
+#endif
+
+// Chase-Lev work-stealing deque. the owning worker pushes and pops from the bottom, everyone else steals from the top.
+typedef struct jobs_Deque_t
+{
+   _Alignas(JOBS_CACHE_LINE) _Atomic i64 top;
+   _Alignas(JOBS_CACHE_LINE) _Atomic i64 bottom;
+   _Alignas(JOBS_CACHE_LINE) _Atomic u64 ranges[JOBS_DEQUE_SIZE];
+
+} jobs_Deque;
+
+typedef struct jobs_Worker_t
+{
+   JobPool* pool;
+   u32 worker_id;
+
+} jobs_Worker;
+
+struct JobPool_t
+{
+   jobs_Deque* deques;
+   jobs_Thread* threads;
+   jobs_Worker* workers;
+
+   u32 worker_count;
+
+   jobs_Mutex mutex;
+   jobs_Cond wake_cond;
+
+   ParallelForFunc func;
+   void* user_data;
+   u32 grain_size;
+
+   _Atomic u32 remaining;
+   _Atomic u32 generation;
+   _Atomic bool is_running;
+   _Atomic bool is_shutting_down;
+
+};
+
+// which pool's worker slot this thread is using right now, pool threads keep theirs for good
+static JOBS_THREAD_LOCAL JobPool* jobs_current_pool = NULL;
+static JOBS_THREAD_LOCAL u32 jobs_current_worker_id = 0;
+
+static void JOBS_MutexInit(jobs_Mutex* mutex)
+{
+#ifdef _WIN32
+   InitializeCriticalSection(mutex);
+#else
+   pthread_mutex_init(mutex, NULL);
+#endif
+}
+
+static void JOBS_MutexFree(jobs_Mutex* mutex)
+{
+#ifdef _WIN32
+   DeleteCriticalSection(mutex);
+#else
+   pthread_mutex_destroy(mutex);
+#endif
+}
+
+static void JOBS_MutexLock(jobs_Mutex* mutex)
+{
+#ifdef _WIN32
+   EnterCriticalSection(mutex);
+#else
+   pthread_mutex_lock(mutex);
+#endif
+}
+
+static void JOBS_MutexUnlock(jobs_Mutex* mutex)
+{
+#ifdef _WIN32
+   LeaveCriticalSection(mutex);
+#else
+   pthread_mutex_unlock(mutex);
+#endif
+}
+
+static void JOBS_CondInit(jobs_Cond* cond)
+{
+#ifdef _WIN32
+   InitializeConditionVariable(cond);
+#else
+   pthread_cond_init(cond, NULL);
+#endif
+}
+
+static void JOBS_CondFree(jobs_Cond* cond)
+{
+#ifdef _WIN32
+   (void)cond;
+#else
+   pthread_cond_destroy(cond);
+#endif
+}
+
+static void JOBS_CondWait(jobs_Cond* cond, jobs_Mutex* mutex)
+{
+#ifdef _WIN32
+   SleepConditionVariableCS(cond, mutex, INFINITE);
+#else
+   pthread_cond_wait(cond, mutex);
+#endif
+}
+
+static void JOBS_CondBroadcast(jobs_Cond* cond)
+{
+#ifdef _WIN32
+   WakeAllConditionVariable(cond);
+#else
+   pthread_cond_broadcast(cond);
+#endif
+}
+
+typedef struct jobs_QueuedJob_t
+{
+   JobFunc func;
+   void* user_data;
+
+} jobs_QueuedJob;
+
+struct JobQueue_t
+{
+   jobs_Thread* threads;
+   u32 thread_count;
+
+   jobs_Mutex mutex;
+   jobs_Cond wake_cond;
+   jobs_Cond idle_cond;
+
+   jobs_QueuedJob* jobs;
+   u32 next_job;
+   u32 running_count;
+
+   bool is_shutting_down;
+
+};
+
+static void* JOBS_AlignedAlloc(uS size)
+{
+#ifdef _WIN32
+   return _aligned_malloc(size, JOBS_CACHE_LINE);
+#else
+   return aligned_alloc(JOBS_CACHE_LINE, size);
+#endif
+}
+
+static void JOBS_AlignedFree(void* ptr)
+{
+#ifdef _WIN32
+   _aligned_free(ptr);
+#else
+   free(ptr);
+#endif
+}
+
+static void JOBS_Yield(void)
+{
+#ifdef _WIN32
+   SwitchToThread();
+#else
+   sched_yield();
+#endif
+}
+
+static bool JOBS_Push(jobs_Deque* deque, u64 range)
+{
+   i64 bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+   i64 top = atomic_load_explicit(&deque->top, memory_order_acquire);
+   if (bottom - top >= JOBS_DEQUE_SIZE)
+      return false;
+
+   atomic_store_explicit(&deque->ranges[bottom & JOBS_DEQUE_MASK], range, memory_order_relaxed);
+   atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_release);
+
+   return true;
+}
+
+static bool JOBS_Pop(jobs_Deque* deque, u64* out_range)
+{
+   i64 bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+   atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+   atomic_thread_fence(memory_order_seq_cst);
+
+   i64 top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+   if (top > bottom)
+   {
+      atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+
+      return false;
+   }
+
+   (*out_range) = atomic_load_explicit(&deque->ranges[bottom & JOBS_DEQUE_MASK], memory_order_relaxed);
+   if (top != bottom)
+      return true;
+
+   // last item left, race any thieves for it
+   bool won = atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed);
+   atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+
+   return won;
+}
+
+static bool JOBS_Steal(jobs_Deque* deque, u64* out_range)
+{
+   i64 top = atomic_load_explicit(&deque->top, memory_order_acquire);
+   atomic_thread_fence(memory_order_seq_cst);
+   i64 bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+   if (top >= bottom)
+      return false;
+
+   u64 range = atomic_load_explicit(&deque->ranges[top & JOBS_DEQUE_MASK], memory_order_relaxed);
+   if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+      return false;
+
+   (*out_range) = range;
+
+   return true;
+}
+
+static void JOBS_RunRange(JobPool* pool, u32 worker_id, u64 range)
+{
+   u32 start = (u32)range;
+   u32 end = (u32)(range >> 32u);
+
+   // keep the lower half, hand the upper half to whoever is idle
+   while (end - start > pool->grain_size)
+   {
+      u32 middle = start + (end - start) / 2u;
+      if (!JOBS_Push(&pool->deques[worker_id], JOBS_PACK_RANGE(middle, end)))
+         break;
+
+      end = middle;
+
+   }
+
+   pool->func(pool->user_data, start, end, worker_id);
+   atomic_fetch_sub_explicit(&pool->remaining, end - start, memory_order_acq_rel);
+
+}
+
+static bool JOBS_RunNext(JobPool* pool, u32 worker_id)
+{
+   u64 range = 0;
+   bool has_range = JOBS_Pop(&pool->deques[worker_id], &range);
+
+   for (u32 victim_i = 1; victim_i < pool->worker_count && !has_range; victim_i++)
+      has_range = JOBS_Steal(&pool->deques[(worker_id + victim_i) % pool->worker_count], &range);
+
+   if (!has_range)
+      return false;
+
+   JOBS_RunRange(pool, worker_id, range);
+
+   return true;
+}
+
+static void JOBS_WorkerLoop(jobs_Worker* worker)
+{
+   JobPool* pool = worker->pool;
+   u32 seen_generation = 0;
+
+   jobs_current_pool = pool;
+   jobs_current_worker_id = worker->worker_id;
+
+   while (true)
+   {
+      JOBS_MutexLock(&pool->mutex);
+      while (!atomic_load(&pool->is_shutting_down) && atomic_load(&pool->generation) == seen_generation)
+         JOBS_CondWait(&pool->wake_cond, &pool->mutex);
+
+      seen_generation = atomic_load(&pool->generation);
+      JOBS_MutexUnlock(&pool->mutex);
+
+      if (atomic_load(&pool->is_shutting_down))
+         break;
+
+      while (atomic_load_explicit(&pool->remaining, memory_order_acquire) > 0)
+      {
+         if (!JOBS_RunNext(pool, worker->worker_id))
+            JOBS_Yield();
+
+      }
+
+   }
+
+}
+
+#ifdef _WIN32
+static DWORD WINAPI JOBS_ThreadEntry(LPVOID arg)
+{
+   JOBS_WorkerLoop((jobs_Worker*)arg);
+
+   return 0;
+}
+#else
+static void* JOBS_ThreadEntry(void* arg)
+{
+   JOBS_WorkerLoop((jobs_Worker*)arg);
+
+   return NULL;
+}
+#endif
+
+static void JOBS_QueueLoop(JobQueue* queue)
+{
+   while (true)
+   {
+      JOBS_MutexLock(&queue->mutex);
+      while (!queue->is_shutting_down && queue->next_job >= Util_ArrayLength(queue->jobs))
+         JOBS_CondWait(&queue->wake_cond, &queue->mutex);
+
+      if (queue->is_shutting_down)
+      {
+         JOBS_MutexUnlock(&queue->mutex);
+
+         break;
+      }
+
+      jobs_QueuedJob job = queue->jobs[queue->next_job++];
+      queue->running_count++;
+
+      // everything has been handed out, start filling from the front again
+      if (queue->next_job >= Util_ArrayLength(queue->jobs))
+      {
+         SET_ARRAY_LENGTH(queue->jobs, 0);
+         queue->next_job = 0;
+
+      }
+
+      JOBS_MutexUnlock(&queue->mutex);
+
+      job.func(job.user_data);
+
+      JOBS_MutexLock(&queue->mutex);
+      queue->running_count--;
+      if (queue->running_count == 0 && queue->next_job >= Util_ArrayLength(queue->jobs))
+         JOBS_CondBroadcast(&queue->idle_cond);
+      JOBS_MutexUnlock(&queue->mutex);
+
+   }
+
+}
+
+#ifdef _WIN32
+static DWORD WINAPI JOBS_QueueThreadEntry(LPVOID arg)
+{
+   JOBS_QueueLoop((JobQueue*)arg);
+
+   return 0;
+}
+#else
+static void* JOBS_QueueThreadEntry(void* arg)
+{
+   JOBS_QueueLoop((JobQueue*)arg);
+
+   return NULL;
+}
+#endif
+
+static bool JOBS_StartQueueThread(jobs_Thread* thread, JobQueue* queue)
+{
+#ifdef _WIN32
+   (*thread) = CreateThread(NULL, 0, JOBS_QueueThreadEntry, queue, 0, NULL);
+   return ((*thread) != NULL);
+#else
+   return (pthread_create(thread, NULL, JOBS_QueueThreadEntry, queue) == 0);
+#endif
+}
+
+static bool JOBS_StartThread(jobs_Thread* thread, jobs_Worker* worker)
+{
+#ifdef _WIN32
+   (*thread) = CreateThread(NULL, 0, JOBS_ThreadEntry, worker, 0, NULL);
+   return ((*thread) != NULL);
+#else
+   return (pthread_create(thread, NULL, JOBS_ThreadEntry, worker) == 0);
+#endif
+}
+
+static void JOBS_JoinThread(jobs_Thread thread)
+{
+#ifdef _WIN32
+   WaitForSingleObject(thread, INFINITE);
+   CloseHandle(thread);
+#else
+   pthread_join(thread, NULL);
+#endif
+}
+
+u32 Util_LogicalCoreCount(void)
+{
+#ifdef _WIN32
+   SYSTEM_INFO system_info = { 0 };
+   GetSystemInfo(&system_info);
+   i64 core_count = (i64)system_info.dwNumberOfProcessors;
+#else
+   i64 core_count = (i64)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+   return (u32)M_CLAMP(core_count, 1, JOBS_MAX_WORKERS);
+}
+
+f64 Util_MonotonicTime(void)
+{
+#ifdef _WIN32
+   LARGE_INTEGER frequency = { 0 };
+   LARGE_INTEGER counter = { 0 };
+   QueryPerformanceFrequency(&frequency);
+   QueryPerformanceCounter(&counter);
+
+   return (f64)counter.QuadPart / (f64)frequency.QuadPart;
+#else
+   struct timespec now = { 0 };
+   clock_gettime(CLOCK_MONOTONIC, &now);
+
+   return (f64)now.tv_sec + (f64)now.tv_nsec * 1e-9;
+#endif
+}
+
+JobPool* Util_CreateJobPool(u32 worker_count)
+{
+   if (worker_count == 0)
+      worker_count = Util_LogicalCoreCount();
+
+   worker_count = M_CLAMP(worker_count, 1u, JOBS_MAX_WORKERS);
+
+   JobPool* pool = calloc(1, sizeof(JobPool));
+   jobs_Deque* deques = JOBS_AlignedAlloc(sizeof(jobs_Deque) * worker_count);
+   jobs_Thread* threads = calloc(worker_count, sizeof(jobs_Thread));
+   jobs_Worker* workers = calloc(worker_count, sizeof(jobs_Worker));
+
+   if (pool == NULL || deques == NULL || threads == NULL || workers == NULL)
+   {
+      error err = { 0 };
+      err.general = ERR_LEVEL_ERROR;
+      err.extra = ERR_JOBS_OUT_OF_MEMORY;
+      Util_Log(NULL, JOBS_MODULE, err, "Failed to allocate job pool with %u workers", worker_count);
+
+      free(pool);
+      JOBS_AlignedFree(deques);
+      free(threads);
+      free(workers);
+
+      return NULL;
+   }
+
+   memset(deques, 0, sizeof(jobs_Deque) * worker_count);
+
+   pool->deques = deques;
+   pool->threads = threads;
+   pool->workers = workers;
+   pool->worker_count = 1;
+
+   JOBS_MutexInit(&pool->mutex);
+   JOBS_CondInit(&pool->wake_cond);
+
+   // worker 0 is whoever calls Util_ParallelFor, so only the rest get threads
+   for (u32 worker_i = 1; worker_i < worker_count; worker_i++)
+   {
+      workers[worker_i].pool = pool;
+      workers[worker_i].worker_id = worker_i;
+
+      if (!JOBS_StartThread(&threads[worker_i], &workers[worker_i]))
+      {
+         error err = { 0 };
+         err.general = ERR_LEVEL_WARN;
+         err.extra = ERR_JOBS_THREAD_CREATE_FAILED;
+         Util_Log(NULL, JOBS_MODULE, err, "Could only start %u of %u workers", worker_i, worker_count);
+
+         break;
+      }
+
+      pool->worker_count = worker_i + 1;
+
+   }
+
+   return pool;
+}
+
+void Util_FreeJobPool(JobPool* pool)
+{
+   if (pool == NULL)
+      return;
+
+   JOBS_MutexLock(&pool->mutex);
+   atomic_store(&pool->is_shutting_down, true);
+   JOBS_CondBroadcast(&pool->wake_cond);
+   JOBS_MutexUnlock(&pool->mutex);
+
+   for (u32 worker_i = 1; worker_i < pool->worker_count; worker_i++)
+      JOBS_JoinThread(pool->threads[worker_i]);
+
+   JOBS_CondFree(&pool->wake_cond);
+   JOBS_MutexFree(&pool->mutex);
+
+   JOBS_AlignedFree(pool->deques);
+   free(pool->threads);
+   free(pool->workers);
+   free(pool);
+
+}
+
+u32 Util_JobPoolWorkerCount(JobPool* pool)
+{
+   if (pool == NULL)
+      return 1;
+
+   return pool->worker_count;
+}
+
+static void JOBS_RunParallel(JobPool* pool, u32 count, u32 grain_size, ParallelForFunc func, void* user_data)
+{
+   pool->func = func;
+   pool->user_data = user_data;
+   pool->grain_size = grain_size;
+
+   atomic_store_explicit(&pool->remaining, count, memory_order_release);
+   JOBS_Push(&pool->deques[0], JOBS_PACK_RANGE(0, count));
+
+   JOBS_MutexLock(&pool->mutex);
+   atomic_fetch_add(&pool->generation, 1);
+   JOBS_CondBroadcast(&pool->wake_cond);
+   JOBS_MutexUnlock(&pool->mutex);
+
+   while (atomic_load_explicit(&pool->remaining, memory_order_acquire) > 0)
+   {
+      if (!JOBS_RunNext(pool, 0))
+         JOBS_Yield();
+
+   }
+
+}
+
+void Util_ParallelFor(JobPool* pool, u32 count, u32 grain_size, ParallelForFunc func, void* user_data)
+{
+   if (func == NULL || count == 0)
+      return;
+
+   grain_size = M_MAX(grain_size, 1u);
+
+   if (pool == NULL)
+   {
+      func(user_data, 0, count, 0);
+
+      return;
+   }
+
+   // nested calls already own a worker slot in this pool, so they just run inline on it
+   if (jobs_current_pool == pool)
+   {
+      func(user_data, 0, count, jobs_current_worker_id);
+
+      return;
+   }
+
+   // any other thread waits for the pool instead of running inline as worker 0 while the real worker 0 is busy
+   bool was_running = false;
+   while (!atomic_compare_exchange_weak(&pool->is_running, &was_running, true))
+   {
+      was_running = false;
+      JOBS_Yield();
+
+   }
+
+   JobPool* prev_pool = jobs_current_pool;
+   u32 prev_worker_id = jobs_current_worker_id;
+   jobs_current_pool = pool;
+   jobs_current_worker_id = 0;
+
+   if (pool->worker_count < 2 || count <= grain_size)
+      func(user_data, 0, count, 0);
+   else
+      JOBS_RunParallel(pool, count, grain_size, func, user_data);
+
+   jobs_current_pool = prev_pool;
+   jobs_current_worker_id = prev_worker_id;
+
+   atomic_store(&pool->is_running, false);
+
+}
+
+JobQueue* Util_CreateJobQueue(u32 thread_count)
+{
+   thread_count = M_CLAMP(thread_count, 1u, JOBS_MAX_WORKERS);
+
+   JobQueue* queue = calloc(1, sizeof(JobQueue));
+   jobs_Thread* threads = calloc(thread_count, sizeof(jobs_Thread));
+
+   if (queue == NULL || threads == NULL)
+   {
+      error err = { 0 };
+      err.general = ERR_LEVEL_ERROR;
+      err.extra = ERR_JOBS_OUT_OF_MEMORY;
+      Util_Log(NULL, JOBS_MODULE, err, "Failed to allocate job queue with %u threads", thread_count);
+
+      free(queue);
+      free(threads);
+
+      return NULL;
+   }
+
+   queue->threads = threads;
+   queue->jobs = NEW_ARRAY_N(jobs_QueuedJob, 64);
+
+   JOBS_MutexInit(&queue->mutex);
+   JOBS_CondInit(&queue->wake_cond);
+   JOBS_CondInit(&queue->idle_cond);
+
+   for (u32 thread_i = 0; thread_i < thread_count; thread_i++)
+   {
+      if (!JOBS_StartQueueThread(&threads[thread_i], queue))
+      {
+         error err = { 0 };
+         err.general = ERR_LEVEL_WARN;
+         err.extra = ERR_JOBS_THREAD_CREATE_FAILED;
+         Util_Log(NULL, JOBS_MODULE, err, "Could only start %u of %u queue threads", thread_i, thread_count);
+
+         break;
+      }
+
+      queue->thread_count = thread_i + 1;
+
+   }
+
+   if (queue->thread_count == 0)
+   {
+      Util_FreeJobQueue(queue);
+
+      return NULL;
+   }
+
+   return queue;
+}
+
+void Util_FreeJobQueue(JobQueue* queue)
+{
+   if (queue == NULL)
+      return;
+
+   JOBS_MutexLock(&queue->mutex);
+   queue->is_shutting_down = true;
+   JOBS_CondBroadcast(&queue->wake_cond);
+   JOBS_MutexUnlock(&queue->mutex);
+
+   for (u32 thread_i = 0; thread_i < queue->thread_count; thread_i++)
+      JOBS_JoinThread(queue->threads[thread_i]);
+
+   JOBS_CondFree(&queue->wake_cond);
+   JOBS_CondFree(&queue->idle_cond);
+   JOBS_MutexFree(&queue->mutex);
+
+   FREE_ARRAY(queue->jobs);
+   free(queue->threads);
+   free(queue);
+
+}
+
+void Util_WaitJobQueue(JobQueue* queue)
+{
+   if (queue == NULL)
+      return;
+
+   JOBS_MutexLock(&queue->mutex);
+   while (queue->running_count > 0 || queue->next_job < Util_ArrayLength(queue->jobs))
+      JOBS_CondWait(&queue->idle_cond, &queue->mutex);
+   JOBS_MutexUnlock(&queue->mutex);
+
+}
+
+bool Util_PushJob(JobQueue* queue, JobFunc func, void* user_data)
+{
+   if (queue == NULL || func == NULL)
+      return false;
+
+   jobs_QueuedJob job = { .func = func, .user_data = user_data };
+
+   JOBS_MutexLock(&queue->mutex);
+   ADD_BACK_ARRAY(queue->jobs, job);
+   JOBS_CondBroadcast(&queue->wake_cond);
+   JOBS_MutexUnlock(&queue->mutex);
+
+   return true;
+}